@@ -0,0 +1,57 @@
+/**
+ * @file bench_async.cpp
+ * @brief AsyncClient task throughput versus worker count (uds_async.hpp)
+ */
+
+#include "bench_common.hpp"
+#include "uds_async.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace uds;
+
+namespace {
+
+// Submit `tasks` reads and wait until every callback has run; returns tasks/s.
+// The task table is sized to hold the whole batch so no submission is
+// rejected, and only successful completions count towards the rate.
+double tasks_per_second(size_t workers, size_t tasks, std::chrono::microseconds latency) {
+    bench::LoopbackTransport transport(4, latency);
+    Client client(transport);
+    async::AsyncClient async(client, workers, tasks);
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    const auto start = bench::Clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        async.read_did_async(static_cast<uint16_t>(0xF100 + (i & 0xFF)),
+                             [&completed, &failed](const async::AsyncResult<std::vector<uint8_t>>& r) {
+                                 auto& counter = r.status == async::AsyncStatus::Completed ? completed : failed;
+                                 counter.fetch_add(1, std::memory_order_relaxed);
+                             });
+    }
+    while (completed.load(std::memory_order_relaxed) + failed.load(std::memory_order_relaxed) < tasks) {
+        std::this_thread::yield();
+    }
+    const auto elapsed = std::chrono::duration<double>(bench::Clock::now() - start);
+    if (failed.load() != 0) {
+        std::fprintf(stderr, "bench_async: %zu of %zu tasks failed\n", failed.load(), tasks);
+        std::exit(1);
+    }
+    return static_cast<double>(completed.load()) / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    for (size_t workers : {1, 2, 4, 8, 16}) {
+        bench::report("async", "read_did_async loopback, " + std::to_string(workers) + " workers",
+                      tasks_per_second(workers, 200000, std::chrono::microseconds(0)), "tasks/s");
+    }
+    for (size_t workers : {1, 2, 4, 8, 16}) {
+        bench::report("async", "read_did_async 50 us ECU, " + std::to_string(workers) + " workers",
+                      tasks_per_second(workers, 5000, std::chrono::microseconds(50)), "tasks/s");
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file bench_cache.cpp
+ * @brief DIDCache and FlatDIDCache read throughput (uds_cache.hpp)
+ */
+
+#include "bench_common.hpp"
+#include "uds_cache.hpp"
+#include <atomic>
+
+using namespace uds;
+
+namespace {
+
+constexpr uint16_t kDids = 1024;
+
+// Aggregate get() (or get_view()) rate of `threads` readers over a preloaded cache
+template <typename Cache, bool Views = false>
+double gets_per_second(size_t shards, size_t threads, size_t gets_per_thread) {
+    cache::CacheConfig config;
+    config.shard_count = shards;
+    config.max_entries = kDids;
+    Cache cache(config);
+    for (uint16_t did = 0; did < kDids; ++did) {
+        cache.put(static_cast<uint16_t>(0xF000 + did), std::vector<uint8_t>(8, 0x5A));
+    }
+
+    std::atomic<bool> go{false};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < threads; ++t) {
+        readers.emplace_back([&, t] {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            uint32_t x = static_cast<uint32_t>(t * 2654435761u + 1);
+            for (size_t i = 0; i < gets_per_thread; ++i) {
+                x ^= x << 13; x ^= x >> 17; x ^= x << 5;  // xorshift
+                const uint16_t did = static_cast<uint16_t>(0xF000 + (x % kDids));
+                if constexpr (Views) {
+                    bench::do_not_optimize(cache.get_view(did));
+                } else {
+                    bench::do_not_optimize(cache.get(did));
+                }
+            }
+        });
+    }
+    const auto start = bench::Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& r : readers) r.join();
+    const auto elapsed = std::chrono::duration<double>(bench::Clock::now() - start);
+    return static_cast<double>(threads * gets_per_thread) / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    std::printf("# hardware threads: %u\n", std::thread::hardware_concurrency());
+    for (size_t shards : {1, 16}) {
+        for (size_t threads : {1, 2, 4, 8, 16}) {
+            bench::report("cache", "get, " + std::to_string(shards) + " shard(s), " +
+                                       std::to_string(threads) + " threads",
+                          gets_per_second<cache::DIDCache>(shards, threads, 400000 / threads * 4) / 1e6,
+                          "Mget/s");
+        }
+    }
+    for (size_t threads : {1, 4, 16}) {
+        bench::report("cache", "get_view, 16 shard(s), " + std::to_string(threads) + " threads",
+                      gets_per_second<cache::DIDCache, true>(16, threads, 400000 / threads * 4) / 1e6,
+                      "Mget/s");
+    }
+    for (size_t threads : {1, 4}) {
+        bench::report("cache", "get, flat layout, " + std::to_string(threads) + " threads",
+                      gets_per_second<cache::FlatDIDCache>(1, threads, 400000 / threads * 4) / 1e6, "Mget/s");
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+/**
+ * @file bench_common.hpp
+ * @brief Shared helpers for the micro-benchmarks in benchmarks/
+ *
+ * Benchmarks are plain executables built by `make bench`; each prints one
+ * line per measurement so results can be diffed between runs
+ * (see bench_output.txt).
+ */
+
+#include "uds.hpp"
+#include "isotp.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Prevent the optimizer from discarding a value
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Average nanoseconds per call of fn over iterations (after warm-up)
+ */
+template <typename Fn>
+double ns_per_op(size_t iterations, Fn&& fn) {
+    for (size_t i = 0; i < iterations / 10 + 1; ++i) fn();
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) fn();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(iterations);
+}
+
+/**
+ * @brief Print one result line: "<suite>  <name>  <value> <unit>"
+ */
+inline void report(const char* suite, const std::string& name, double value, const char* unit) {
+    std::printf("%-12s %-48s %12.2f %s\n", suite, name.c_str(), value, unit);
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Simulated ECU at the UDS level
+ *
+ * Answers every request with a positive response; ReadDataByIdentifier
+ * requests get `did_size` bytes per requested DID. An optional latency
+ * models ECU processing time.
+ */
+class LoopbackTransport : public uds::Transport {
+public:
+    explicit LoopbackTransport(size_t did_size = 8,
+                               std::chrono::microseconds latency = std::chrono::microseconds(0))
+        : did_size_(did_size), latency_(latency) {
+        addr_.tx_can_id = 0x7E0;
+        addr_.rx_can_id = 0x7E8;
+    }
+
+    void set_address(const uds::Address& a) override { addr_ = a; }
+    const uds::Address& address() const override { return addr_; }
+
+    bool request_response(const std::vector<uint8_t>& tx,
+                          std::vector<uint8_t>& rx,
+                          std::chrono::milliseconds) override {
+        if (tx.empty()) return false;
+        if (latency_.count() > 0) std::this_thread::sleep_for(latency_);
+
+        rx.clear();
+        rx.push_back(static_cast<uint8_t>(tx[0] + 0x40));
+        if (tx[0] == 0x22) {
+            for (size_t i = 1; i + 1 < tx.size(); i += 2) {
+                rx.push_back(tx[i]);
+                rx.push_back(tx[i + 1]);
+                for (size_t b = 0; b < did_size_; ++b) rx.push_back(static_cast<uint8_t>(b + tx[i + 1]));
+            }
+        } else {
+            rx.insert(rx.end(), tx.begin() + 1, tx.begin() + std::min<size_t>(tx.size(), 3));
+        }
+        return true;
+    }
+
+private:
+    uds::Address addr_;
+    size_t did_size_;
+    std::chrono::microseconds latency_;
+};
+
+/**
+ * @brief Simulated ECU at the CAN frame level (single-frame requests only)
+ *
+ * Every single-frame request is answered with a single-frame positive
+ * response echoing up to 6 request bytes.
+ */
+class EchoCanDriver : public isotp::ICanDriver {
+public:
+    bool send(const CANProtocol::CANFrame& f) override {
+        const uint8_t len = f.data[0] & 0x0F;
+        if ((f.data[0] & 0xF0) != 0x00 || len == 0) return true;
+        CANProtocol::CANFrame r;
+        r.id = f.id + 8;
+        r.dlc = 8;
+        const uint8_t n = len < 7 ? len : 7;
+        r.data[0] = n;
+        r.data[1] = static_cast<uint8_t>(f.data[1] + 0x40);
+        std::memcpy(&r.data[2], &f.data[2], n - 1);
+        pending_.push_back(r);
+        return true;
+    }
+
+    bool recv(CANProtocol::CANFrame& f, std::chrono::milliseconds) override {
+        if (pending_.empty()) return false;
+        f = pending_.front();
+        pending_.pop_front();
+        return true;
+    }
+
+private:
+    std::deque<CANProtocol::CANFrame> pending_;
+};
+
+} // namespace bench
@@ -0,0 +1,65 @@
+/**
+ * @file bench_crc.cpp
+ * @brief Throughput of the CRC engines (uds_crc.hpp) over image-sized buffers
+ */
+
+#include "bench_common.hpp"
+#include "uds_crc.hpp"
+#include "uds_block.hpp"
+
+using namespace uds;
+
+namespace {
+
+// GB/s over `passes` runs of fn across a buffer of `size` bytes
+template <typename Fn>
+double gb_per_s(size_t size, size_t passes, Fn&& fn) {
+    const double ns = bench::ns_per_op(passes, fn);
+    return static_cast<double>(size) / ns;
+}
+
+} // namespace
+
+int main() {
+    const crc::Engine engines[] = {crc::Engine::Table, crc::Engine::Slicing8,
+                                   crc::Engine::Slicing16, crc::Engine::Clmul};
+
+    for (size_t size : {size_t(4096), size_t(16) * 1024 * 1024}) {
+        std::vector<uint8_t> image(size);
+        for (size_t i = 0; i < size; ++i) image[i] = static_cast<uint8_t>(i * 131 + (i >> 9));
+        const size_t passes = std::max<size_t>(4, (size_t(256) * 1024 * 1024) / size / 4);
+        const std::string label = size >= 1024 * 1024
+            ? std::to_string(size / (1024 * 1024)) + " MB"
+            : std::to_string(size / 1024) + " KB";
+
+        for (crc::Engine engine : engines) {
+            if (!crc::engine_supported(engine)) {
+                continue;
+            }
+            const std::string name = std::string(crc::engine_name(engine)) + " " + label;
+            bench::report("crc", "crc32 " + name,
+                          gb_per_s(size, passes, [&]() {
+                              bench::do_not_optimize(
+                                  crc::crc32_update(crc::kCrc32Init, image.data(), size, engine));
+                          }), "GB/s");
+            bench::report("crc", "crc32c " + name,
+                          gb_per_s(size, passes, [&]() {
+                              bench::do_not_optimize(
+                                  crc::crc32c_update(crc::kCrc32Init, image.data(), size, engine));
+                          }), "GB/s");
+            if (engine != crc::Engine::Clmul) {
+                bench::report("crc", "crc16-ccitt " + name,
+                              gb_per_s(size, passes, [&]() {
+                                  bench::do_not_optimize(
+                                      crc::crc16_ccitt_update(crc::kCrc16CcittInit, image.data(), size, engine));
+                              }), "GB/s");
+            }
+        }
+
+        bench::report("crc", "block::calculate_crc32 " + label,
+                      gb_per_s(size, passes, [&]() {
+                          bench::do_not_optimize(block::calculate_crc32(image));
+                      }), "GB/s");
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file bench_trace.cpp
+ * @brief Overhead of trace capture (uds_trace.hpp) on the hot path
+ */
+
+#include "bench_common.hpp"
+#include "uds_trace.hpp"
+#include "can_slcan.hpp"
+#include <filesystem>
+#include <unistd.h>
+
+using namespace uds;
+
+int main() {
+    auto& tracer = trace::Tracer::instance();
+    constexpr size_t kIterations = 2000000;
+
+    CANProtocol::CANFrame frame;
+    frame.id = 0x7E0;
+    frame.dlc = 8;
+    for (uint8_t i = 0; i < 8; ++i) frame.data[i] = i;
+
+    std::vector<uint8_t> pdu(4095, 0x5A);
+    pdu[0] = 0x36;
+
+    for (bool enabled : {false, true}) {
+        tracer.set_enabled(enabled);
+        const std::string suffix = enabled ? " (enabled)" : " (disabled)";
+
+        bench::report("trace", "record_can" + suffix,
+                      bench::ns_per_op(kIterations, [&]() {
+                          trace::record_can(trace::Direction::Tx, frame);
+                      }), "ns/op");
+
+        bench::report("trace", "record_pdu 4095 B" + suffix,
+                      bench::ns_per_op(kIterations, [&]() {
+                          trace::record_pdu(trace::Direction::Tx, 0x7E0, pdu);
+                      }), "ns/op");
+
+        bench::LoopbackTransport transport;
+        Client client(transport);
+        bench::report("trace", "Client::exchange 0x22 loopback" + suffix,
+                      bench::ns_per_op(kIterations / 10, [&]() {
+                          auto r = client.read_data_by_identifier(0xF190);
+                          bench::do_not_optimize(r.ok);
+                      }), "ns/op");
+
+        bench::EchoCanDriver driver;
+        isotp::Transport tp(driver);
+        tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+        Client isotp_client(tp);
+        bench::report("trace", "Client::exchange 0x22 over ISO-TP" + suffix,
+                      bench::ns_per_op(kIterations / 10, [&]() {
+                          auto r = isotp_client.read_data_by_identifier(0xF190);
+                          bench::do_not_optimize(r.ok);
+                      }), "ns/op");
+    }
+
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("bench_trace_" + std::to_string(::getpid()) + ".udstrace");
+    const auto start = bench::Clock::now();
+    const bool ok = tracer.dump(path.string());
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(bench::Clock::now() - start);
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    bench::report("trace", std::string("dump ") + std::to_string(tracer.snapshot().size()) + " records",
+                  ok ? static_cast<double>(elapsed.count()) : -1.0, "us");
+    return 0;
+}
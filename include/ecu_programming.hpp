@@ -24,8 +24,11 @@
 */
 
 #include "uds.hpp"
+#include "uds_compression.hpp"
+#include "uds_firmware.hpp"
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 
 namespace uds {
@@ -67,6 +70,36 @@ enum class ProgrammingState : uint8_t {
   Aborted
 };
 
+// ================================================================
+// Flash Manifest (delta flashing)
+// ================================================================
+
+/// Sector CRC32s of an image as flashed at start_address. Saved after a
+/// flash, it tells the next delta flash what the ECU holds without asking.
+struct FlashManifest {
+  uint32_t start_address{0};
+  uint32_t sector_size{0};
+  uint32_t image_size{0};
+  std::vector<uint32_t> sector_crcs;  // One per sector; the last may be short
+  std::vector<bool> unknown;          // Sectors with unknown contents (empty = none)
+  
+  size_t sector_count() const { return sector_crcs.size(); }
+  
+  /// False for a sector left erased or half-written by a failed flash
+  bool sector_known(size_t index) const { return index >= unknown.size() || !unknown[index]; }
+  
+  /// Bytes of sector index (sector_size, or less for the last one)
+  uint32_t sector_length(size_t index) const;
+  
+  /// Hash image sector by sector (reads it once, in order)
+  static bool build(FirmwareSource& image, uint32_t start_address, uint32_t sector_size,
+                    FlashManifest& out);
+  
+  /// Text file: header line, then one CRC32 (or -------- if unknown) per line
+  bool save(const std::string& path) const;
+  bool load(const std::string& path);
+};
+
 // ================================================================
 // Programming Configuration
 // ================================================================
@@ -81,6 +114,23 @@ struct ProgrammingConfig {
   uint8_t address_length_format{0x44};  // 4 bytes addr, 4 bytes size
   uint8_t data_format_identifier{0x00}; // 0x00 = uncompressed/unencrypted
   
+  // Compression (see uds_compression.hpp): if set, the image is compressed
+  // before the session starts and the compressor's method replaces bits 7-4
+  // of data_format_identifier
+  std::shared_ptr<const compression::Compressor> compressor;
+  compression::CompressionOptions compression_options;
+  
+  // Delta flashing: with delta_sector_size set, only sectors whose CRC32
+  // differs from the ECU's contents are erased and downloaded, each run of
+  // changed sectors as one region. The ECU's contents come from
+  // installed_manifest where it covers a sector, else from remote_crc;
+  // sectors known by neither are flashed. Regions are erased with the
+  // record [address_length_format][address][size] in place of
+  // erase_option_record. The firmware source must be seekable.
+  uint32_t delta_sector_size{0};                    // 0 = flash the whole image
+  std::optional<FlashManifest> installed_manifest;  // e.g. saved after the last flash
+  std::function<std::optional<uint32_t>(uint32_t address, uint32_t size)> remote_crc;
+  
   // Erase routine
   RoutineId erase_routine_id{ProgrammingRoutineId::EraseMemory};
   std::vector<uint8_t> erase_option_record;  // Optional parameters for erase
@@ -105,8 +155,12 @@ struct ProgrammingConfig {
   // Safety flags
   bool skip_erase{false};              // Skip erase (dangerous - use for testing only)
   bool skip_security{false};           // Skip security (only if ECU allows)
+  bool skip_dtc_disable{false};        // DTC setting already off (e.g. sent functionally)
   bool skip_communication_disable{false}; // Keep comms enabled (less safe)
   bool perform_reset_after_flash{true}; // ECU reset after completion
+  
+  // Diagnostics
+  std::string trace_dump_path;  // If set, dump the CAN/UDS trace here on failure (see uds_trace.hpp)
 };
 
 // ================================================================
@@ -120,9 +174,17 @@ struct ProgrammingResult {
   
   // Statistics
   uint32_t bytes_transferred{0};
-  uint32_t total_bytes{0};
-  uint16_t blocks_transferred{0};
-  uint16_t total_blocks{0};
+  uint32_t total_bytes{0};         // Bytes sent in TransferData (compressed size if compressing)
+  uint32_t uncompressed_bytes{0};  // Image size
+  uint32_t blocks_transferred{0};
+  uint32_t total_blocks{0};
+  uint32_t sectors_total{0};       // Delta flashing: sectors in the image
+  uint32_t sectors_flashed{0};     // Delta flashing: sectors that differed
+  // Delta flashing: the image now on the ECU. After a failure, sectors the
+  // attempt may have erased or partly written are marked unknown; pass it as
+  // installed_manifest on the retry instead of the previous one. Unset if
+  // the attempt failed before flashing began (the ECU is unchanged).
+  std::optional<FlashManifest> manifest;
   uint8_t retry_count{0};
   std::chrono::milliseconds elapsed_time{};
   
@@ -148,6 +210,13 @@ public:
   ProgrammingResult program_ecu(const std::vector<uint8_t>& firmware_data,
                                 const ProgrammingConfig& config);
   
+  /// Execute complete programming sequence, reading the image block by block
+  /// @param firmware Image source (mapped file, stream, generator, ...)
+  /// @param config Programming configuration
+  /// @return Result with success status and diagnostics
+  ProgrammingResult program_ecu(FirmwareSource& firmware,
+                                const ProgrammingConfig& config);
+  
   /// Abort programming in progress (safe cleanup)
   void abort_programming();
   
@@ -189,6 +258,7 @@ public:
   
   /// Step 7: Transfer data blocks (0x36)
   bool step_transfer_data(const std::vector<uint8_t>& firmware_data);
+  bool step_transfer_data(FirmwareSource& firmware);
   
   /// Step 8: Request transfer exit (0x37)
   bool step_request_transfer_exit();
@@ -226,6 +296,8 @@ private:
   uint8_t block_counter_{1};
   uint16_t max_block_length_{0};
   bool abort_requested_{false};
+  uint32_t progress_offset_{0};  // Bytes sent in earlier delta regions
+  uint32_t progress_total_{0};   // Bytes of all delta regions (0 = single download)
   
   // Helpers
   void log(const std::string& message);
@@ -238,7 +310,10 @@ private:
                                              std::chrono::milliseconds extended_timeout);
   
   /// Transfer single block with retry logic for NRC 0x73 (Wrong Block Sequence)
-  bool transfer_block_with_retry(BlockCounter block, const std::vector<uint8_t>& block_data);
+  bool transfer_block_with_retry(BlockCounter block, ByteSpan block_data);
+  
+  /// Steps 5-8 for each region of changed sectors (delta flashing)
+  bool flash_changed_sectors(FirmwareSource& firmware, const FlashManifest& target);
   
   /// Wait for routine completion (handles NRC 0x78)
   bool wait_for_routine_completion(RoutineId routine_id,
@@ -260,6 +335,18 @@ ProgrammingResult flash_ecu(Client& client,
                             uint32_t start_address,
                             const std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)>& key_calculator);
 
+/// Execute complete ECU flash programming with defaults from an image source
+ProgrammingResult flash_ecu(Client& client,
+                            FirmwareSource& firmware,
+                            uint32_t start_address,
+                            const std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)>& key_calculator);
+
+/// remote_crc for delta flashing from an OEM checksum routine: starts
+/// routine_id with [addr_len_fmt][address][size] as option record and takes
+/// the CRC32 from the last 4 bytes (big-endian) of the status record
+std::function<std::optional<uint32_t>(uint32_t, uint32_t)>
+routine_crc_reader(Client& client, RoutineId routine_id, uint8_t addr_len_fmt = 0x44);
+
 /// Verify ECU memory region (read back and compare)
 /// @param client UDS client instance
 /// @param address Start address
@@ -0,0 +1,148 @@
+#ifndef FLASH_ORCHESTRATOR_HPP
+#define FLASH_ORCHESTRATOR_HPP
+
+/*
+  Flash Orchestrator — Parallel Multi-ECU Programming
+
+  Runs one ECUProgrammer job per ECU concurrently, the way an end-of-line
+  or workshop tool flashes a whole vehicle:
+  1. Per bus, once: ExtendedSession, ControlDTCSetting Off and
+     CommunicationControl DisableRxAndTx sent functionally with the
+     suppressPosRspMsgIndicationBit set (0x10 0x83, 0x85 0x82, 0x28 0x83 0xFF)
+  2. Functional TesterPresent (0x3E 0x80) keeps the other ECUs quiet
+     while the jobs run
+  3. Jobs run in parallel, one thread per Client; a bus caps how many of
+     its jobs run at once and how many TransferData bytes per second
+     they send between them
+  4. Per bus, once: CommunicationControl EnableRxAndTx, ControlDTCSetting
+     On and DefaultSession, again functionally
+
+  Jobs on a bus whose functional pre-steps went through skip steps 3 and 4
+  of the programming sequence; if an ECU answered negatively, its jobs
+  fall back to sending them physically.
+
+  Example:
+    FlashOrchestrator orchestrator;
+    orchestrator.add_bus("PT-CAN", {500000 / 8 / 2, 0, &functional_client});
+    orchestrator.add_job({"ECM", &ecm_client, &ecm_image, ecm_config, "PT-CAN"});
+    orchestrator.add_job({"TCM", &tcm_client, &tcm_image, tcm_config, "PT-CAN"});
+    FlashReport report = orchestrator.run();
+*/
+
+#include "ecu_programming.hpp"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace uds {
+
+// ================================================================
+// Jobs and Buses
+// ================================================================
+
+/// One ECU to flash. Client and firmware must outlive run(); jobs sharing
+/// a Client run one after the other.
+struct FlashJob {
+  std::string name;
+  Client* client{nullptr};
+  FirmwareSource* firmware{nullptr};
+  ProgrammingConfig config;
+  std::string bus;  // FlashBusConfig to run under; unknown names get an unlimited bus
+};
+
+/// Limits and functional addressing shared by the jobs of one bus
+struct FlashBusConfig {
+  uint32_t bytes_per_second{0};   // TransferData payload budget of all jobs; 0 = unlimited
+  uint32_t max_parallel_jobs{0};  // 0 = unlimited
+  Client* functional{nullptr};    // Functionally addressed client for the shared pre/post steps
+};
+
+// ================================================================
+// Progress and Reports
+// ================================================================
+
+/// Aggregate progress over all jobs
+struct FlashProgress {
+  size_t jobs_total{0};
+  size_t jobs_running{0};
+  size_t jobs_succeeded{0};
+  size_t jobs_failed{0};
+  uint64_t bytes_transferred{0};
+  uint64_t total_bytes{0};  // Image sizes until a job reports its wire size
+
+  float fraction() const {
+    return total_bytes > 0 ? static_cast<float>(bytes_transferred) / static_cast<float>(total_bytes) : 0.0f;
+  }
+};
+
+/// Outcome and timing breakdown of one job
+struct FlashJobReport {
+  std::string name;
+  std::string bus;
+  ProgrammingResult result;
+  std::chrono::milliseconds queued{0};     // Waiting for its Client or a bus slot
+  std::chrono::milliseconds throttled{0};  // Paused by the bus byte budget
+  std::chrono::milliseconds total{0};      // Start of programming to completion
+  std::map<ProgrammingState, std::chrono::milliseconds> phases;  // Time spent per step
+};
+
+/// Outcome of the functional steps on one bus
+struct FlashBusReport {
+  std::string name;
+  bool functional_presteps{false};  // Jobs skipped their physical DTC/comms steps
+  std::string error;
+};
+
+struct FlashReport {
+  bool success{false};  // Every job succeeded
+  std::vector<FlashJobReport> jobs;  // In add_job() order
+  std::vector<FlashBusReport> buses;
+  std::chrono::milliseconds elapsed{0};
+};
+
+// ================================================================
+// Orchestrator
+// ================================================================
+
+class FlashOrchestrator {
+public:
+  FlashOrchestrator() = default;
+
+  /// Register a bus; add before the jobs that name it
+  void add_bus(const std::string& name, const FlashBusConfig& config);
+
+  void add_job(FlashJob job);
+
+  /// Called from the job threads (serialized) whenever a job makes progress
+  void set_progress_callback(std::function<void(const FlashProgress&)> callback) {
+    progress_callback_ = std::move(callback);
+  }
+
+  /// Interval of the functional TesterPresent while jobs run
+  void set_tester_present_interval(std::chrono::milliseconds interval) {
+    tester_present_interval_ = interval;
+  }
+
+  /// Flash all jobs; blocks until every job has finished
+  FlashReport run();
+
+private:
+  struct Bus {
+    std::string name;
+    FlashBusConfig config;
+  };
+
+  std::vector<Bus> buses_;
+  std::vector<FlashJob> jobs_;
+  std::function<void(const FlashProgress&)> progress_callback_;
+  std::chrono::milliseconds tester_present_interval_{std::chrono::milliseconds(2000)};
+};
+
+/// Human-readable per-job summary with the phase breakdown
+std::string format_flash_report(const FlashReport& report);
+
+} // namespace uds
+
+#endif // FLASH_ORCHESTRATOR_HPP
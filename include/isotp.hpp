@@ -89,6 +89,12 @@ public:
   virtual ~ICanDriver() = default;
   virtual bool send(const CANProtocol::CANFrame& f) = 0;
   virtual bool recv(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout) = 0;
+
+  // Receive that gives up as soon as cancel is cancelled. The default polls
+  // recv() in short slices; drivers that block on a descriptor should
+  // override it and wake up through a CancelWake hook instead.
+  virtual bool recv_cancellable(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout,
+                                uds::CancellationToken& cancel);
 };
 
 // Professional ISO‑TP transport implementing ISO 15765-2 with full compliance
@@ -109,6 +115,11 @@ public:
                         std::vector<uint8_t>& rx,
                         std::chrono::milliseconds timeout) override;
 
+  // Send, then listen for a negative response only (suppressPosRsp requests)
+  bool send_suppressed(const std::vector<uint8_t>& tx,
+                       std::vector<uint8_t>& rx,
+                       std::chrono::milliseconds timeout) override;
+
   // Receive-only (for RCR-RP continuation after ResponsePending)
   bool recv_only(std::vector<uint8_t>& rx, std::chrono::milliseconds timeout);
   
@@ -118,6 +129,12 @@ public:
     return recv_sdu(rx, timeout);
   }
 
+  // Frame timestamps of the last request_response()/recv_only()
+  bool last_transfer_timing(uds::TransferTiming& timing) const override {
+    timing = last_timing_;
+    return true;
+  }
+
   // ISO-TP Configuration (legacy detailed API)
   void set_timings(const ISOTPTimings& timings) { timings_ = timings; }
   const ISOTPTimings& timings() const { return timings_; }
@@ -150,6 +167,8 @@ public:
   }
 
 private:
+  bool send_frame(const CANProtocol::CANFrame& f);
+  bool recv_frame(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout);
   bool send_sdu(const std::vector<uint8_t>& sdu, std::chrono::milliseconds timeout);
   bool recv_sdu(std::vector<uint8_t>& sdu, std::chrono::milliseconds timeout);
   
@@ -169,6 +188,7 @@ private:
   bool rx_enabled_{true};
   bool tx_enabled_{true};
   bool functional_addressing_{false};
+  uds::TransferTiming last_timing_{};
 };
 
 } // namespace isotp
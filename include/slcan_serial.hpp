@@ -74,6 +74,9 @@ public:
   // ICanDriver interface
   bool send(const CANProtocol::CANFrame& f) override;
   bool recv(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout) override;
+  /// Blocks in select() on the port and a wake pipe written by cancel()
+  bool recv_cancellable(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout,
+                        uds::CancellationToken& cancel) override;
   
   // Enhanced frame operations
   bool send_can_frame(const CanFrame& frame);
@@ -113,6 +116,7 @@ private:
   bool write_command(const std::string& cmd, std::chrono::milliseconds timeout);
   bool read_until_cr(std::string& line, std::chrono::milliseconds timeout);
   ssize_t read_raw(uint8_t* buf, size_t maxlen, std::chrono::milliseconds timeout);
+  void drain_wake_pipe();
 
   // SLCAN initialization
   bool init_slcan(uint32_t bitrate, uint32_t filter_id, uint32_t filter_mask);
@@ -122,6 +126,8 @@ private:
   bool read_and_buffer_frames(std::chrono::milliseconds timeout);
 
   int fd_{-1};
+  int wake_pipe_[2]{-1, -1};                    // Cancellation wake-up (read, write)
+  uds::CancellationToken* cancel_{nullptr};     // Token of the running recv_cancellable()
   struct termios orig_termios_{};
   bool termios_saved_{false};
   
@@ -79,6 +79,10 @@
 #include <string>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace uds {
 
@@ -514,10 +518,28 @@ struct TransferData_Response { BlockCounter block; std::vector<uint8_t> data; };
 // 5) Transport abstraction + Client API
 // ================================================================
 
+// Frame-level timestamps of the most recent transfer (for latency metrics).
+// tx_start/tx_end bracket the request SDU on the wire, rx_first/rx_end the
+// first and last frame of the response SDU.
+struct TransferTiming {
+  std::chrono::steady_clock::time_point tx_start{};
+  std::chrono::steady_clock::time_point tx_end{};
+  std::chrono::steady_clock::time_point rx_first{};
+  std::chrono::steady_clock::time_point rx_end{};
+  bool valid{false};
+};
+
+namespace detail { class ExchangeQueue; }
+
 // ISO‑TP/transport abstraction: a minimal, blocking request‑response channel.
 // Implementations must handle segmentation, flow control, timeouts, etc.
+//
+// Implementations need not be thread-safe: every Client serializes its use of
+// a transport through the transport's exchange queue, so concurrent callers
+// (e.g. AsyncClient workers) never interleave their conversations.
 class Transport {
 public:
+  Transport();
   virtual ~Transport() = default;
   virtual void set_address(const Address&) = 0;
   virtual const Address& address() const = 0;
@@ -528,6 +550,19 @@ public:
                                 std::vector<uint8_t>& rx,
                                 std::chrono::milliseconds timeout) = 0;
   
+  // Send a request carrying the suppressPosRspMsgIndicationBit. Returns
+  // false only if the SDU could not be sent. A response arriving within
+  // `timeout` (a negative response, or a positive one from an ECU that
+  // ignores the bit) is returned in rx; silence leaves rx empty. The default
+  // uses request_response(), which cannot tell a failed send from silence,
+  // so it reports both as failure; transports that can tell them apart
+  // (isotp::Transport) override it.
+  virtual bool send_suppressed(const std::vector<uint8_t>& tx,
+                               std::vector<uint8_t>& rx,
+                               std::chrono::milliseconds timeout) {
+    return request_response(tx, rx, timeout);
+  }
+  
   // Optional: receive unsolicited messages (for periodic data)
   // Returns true if a message was received, false on timeout
   // Default implementation returns false (not supported)
@@ -536,6 +571,113 @@ public:
     (void)rx; (void)timeout;
     return false;
   }
+
+  // Optional: timestamps of the last request_response()/receive.
+  // Returns false if the transport does not record frame timing.
+  virtual bool last_transfer_timing(TransferTiming& timing) const {
+    (void)timing;
+    return false;
+  }
+
+  // FIFO queue arbitrating exchanges on this transport (used by Client)
+  detail::ExchangeQueue& exchange_queue() const { return *queue_; }
+
+  // True if no exchange is running or waiting on this transport (listening
+  // for unsolicited PDUs does not count)
+  bool idle() const;
+
+private:
+  std::shared_ptr<detail::ExchangeQueue> queue_;
+};
+
+namespace metrics { class ExchangeMetrics; struct ExchangeSample; }
+namespace detail { class RequestCoalescer; class UnsolicitedInbox; }
+
+// Thread-scoped exchange deadline. While a scope is alive, every Client
+// exchange issued by this thread is bounded by it: waiting for the transport
+// queue and for the response (including 0x78 response-pending extensions) is
+// clamped to the remaining time, and a request whose deadline has already
+// passed is not sent. Scopes nest; the earliest deadline wins.
+class ExchangeScope {
+public:
+  using time_point = std::chrono::steady_clock::time_point;
+
+  explicit ExchangeScope(time_point deadline);
+  ~ExchangeScope();
+  ExchangeScope(const ExchangeScope&) = delete;
+  ExchangeScope& operator=(const ExchangeScope&) = delete;
+
+  // Deadline in effect on the calling thread (time_point::max() if none)
+  static time_point current();
+  // True if the calling thread's deadline has passed
+  static bool expired();
+
+private:
+  time_point previous_;
+};
+
+// Cooperative cancellation flag shared by a canceller and the code doing the
+// work. cancel() wakes wait_for() and runs the registered wake hooks, so
+// blocking waits (queued exchanges, CAN driver receives) return immediately
+// instead of running into their timeout.
+class CancellationToken {
+public:
+  CancellationToken() = default;
+  CancellationToken(const CancellationToken&) = delete;
+  CancellationToken& operator=(const CancellationToken&) = delete;
+
+  void cancel();
+  bool is_cancelled() const { return cancelled_.load(std::memory_order_acquire); }
+  void reset() { cancelled_.store(false, std::memory_order_release); }
+
+  // Sleep up to timeout; returns true if the token is (or becomes) cancelled
+  bool wait_for(std::chrono::milliseconds timeout);
+
+  // Register a hook run by cancel() (at once if already cancelled). Hooks run
+  // on the cancelling thread with the token locked and must not block.
+  uint64_t add_wake_hook(std::function<void()> hook);
+  void remove_wake_hook(uint64_t id);
+
+private:
+  std::atomic<bool> cancelled_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::pair<uint64_t, std::function<void()>>> hooks_;
+  uint64_t next_hook_ = 1;
+};
+
+// Keeps a wake hook registered for its lifetime (no-op for a null token)
+class CancelWake {
+public:
+  CancelWake(CancellationToken* token, std::function<void()> hook)
+      : token_(token), id_(token ? token->add_wake_hook(std::move(hook)) : 0) {}
+  ~CancelWake() { if (token_) token_->remove_wake_hook(id_); }
+  CancelWake(const CancelWake&) = delete;
+  CancelWake& operator=(const CancelWake&) = delete;
+
+private:
+  CancellationToken* token_;
+  uint64_t id_;
+};
+
+// Thread-scoped cancellation. While a scope is alive, Client exchanges issued
+// by this thread stop waiting for the transport queue, and ISO-TP transfers
+// stop waiting for frames, as soon as the token is cancelled. The innermost
+// non-null token is in effect.
+class CancelScope {
+public:
+  explicit CancelScope(CancellationToken* token);
+  ~CancelScope();
+  CancelScope(const CancelScope&) = delete;
+  CancelScope& operator=(const CancelScope&) = delete;
+
+  // Token in effect on the calling thread (nullptr if none)
+  static CancellationToken* current();
+  // True if the calling thread's token has been cancelled
+  static bool cancelled();
+
+private:
+  CancellationToken* previous_;
 };
 
 // Helper: encode/decode building blocks
@@ -546,12 +688,28 @@ namespace codec {
   inline void be32(std::vector<uint8_t>& v, uint32_t x){ v.push_back(uint8_t(x>>24)); v.push_back(uint8_t(x>>16)); v.push_back(uint8_t(x>>8)); v.push_back(uint8_t(x)); }
 }
 
+// Split a multi-DID ReadDataByIdentifier payload into per-DID data records.
+// lengths[i] is the data size of dids[i], or 0 when unknown; unknown sizes are
+// resolved by locating the next DID echo. Returns false when the payload does
+// not match the requested DIDs or the split is ambiguous.
+bool split_did_records(const std::vector<DID>& dids,
+                       const std::vector<size_t>& lengths,
+                       const std::vector<uint8_t>& payload,
+                       std::vector<std::vector<uint8_t>>& records);
+
 // UDS client: synchronous helpers for common services
 class Client {
 public:
-  Client(Transport& t, Timings timings = {}) : t_(t), timings_(timings) {}
-
-  // Core exchange primitive with NRC parsing
+  Client(Transport& t, Timings timings = {});
+
+  // Core exchange primitive with NRC parsing.
+  // Concurrent identical read-only requests (0x19, 0x22, 0x23, 0x24 with the
+  // same payload) are coalesced: one thread performs the bus exchange and all
+  // callers receive its result (see set_request_coalescing()).
+  // Requests with the suppressPosRspMsgIndicationBit set go through
+  // Transport::send_suppressed(): where the transport overrides it, silence
+  // from the ECU is success (ok=true, empty payload); with the default,
+  // silence still fails like any timeout.
   PositiveOrNegative exchange(SID sid, const std::vector<uint8_t>& req_payload,
                               std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
 
@@ -564,6 +722,9 @@ public:
   PositiveOrNegative security_access_send_key(uint8_t level, const std::vector<uint8_t>& key);
 
   PositiveOrNegative read_data_by_identifier(DID did);
+  // Multi-DID ReadDataByIdentifier: one request carrying several DIDs. The
+  // positive payload is [DID][data][DID][data]...; see split_did_records().
+  PositiveOrNegative read_data_by_identifiers(const std::vector<DID>& dids);
   PositiveOrNegative read_scaling_data_by_identifier(DID did);
   PositiveOrNegative write_data_by_identifier(DID did, const std::vector<uint8_t>& data);
 
@@ -591,6 +752,9 @@ public:
                                     const std::vector<uint8_t>& addr,
                                     const std::vector<uint8_t>& size);
   PositiveOrNegative transfer_data(BlockCounter block, const std::vector<uint8_t>& data);
+  // Block straight from a caller's buffer (e.g. a FirmwareSource span),
+  // copied once into a per-thread request buffer that is reused across blocks
+  PositiveOrNegative transfer_data(BlockCounter block, const uint8_t* data, size_t size);
   PositiveOrNegative request_transfer_exit(const std::vector<uint8_t>& opt = {});
 
   PositiveOrNegative communication_control(uint8_t subFunction, uint8_t communicationType);
@@ -613,12 +777,26 @@ public:
   }
   
   // Receive periodic data (non-blocking with timeout)
-  // Returns true if periodic message received and parsed
+  // Returns true if periodic message received and parsed.
+  // Listens in short slices so requests from other threads are not held up,
+  // and first drains frames parked in the unsolicited inbox.
   bool receive_periodic_data(PeriodicDataMessage& msg, std::chrono::milliseconds timeout);
 
-  // Accessors
-  void set_timings(const Timings& t) { timings_ = t; }
-  const Timings& timings() const { return timings_; }
+  // Receive a ResponseOnEvent notification (complete 0xC6 PDU including the
+  // SID) pushed by the ECU. Same listening rules as receive_periodic_data().
+  bool receive_event(std::vector<uint8_t>& pdu, std::chrono::milliseconds timeout);
+
+  // Unsolicited inbox. ECU-initiated PDUs (0x6A periodic data, 0xC6
+  // ResponseOnEvent) that arrive while an exchange waits for its own response,
+  // or while listening for a different kind, are parked here (bounded, oldest
+  // dropped first) instead of failing the exchange or being lost.
+  static constexpr size_t kUnsolicitedInboxCapacity = 256;
+  bool pop_unsolicited(uint8_t response_sid, std::vector<uint8_t>& pdu);
+  uint64_t unsolicited_dropped() const;
+
+  // Accessors (thread-safe; timings may change after DiagnosticSessionControl)
+  void set_timings(const Timings& t);
+  Timings timings() const;
 
   // Communication state management
   struct CommunicationState {
@@ -627,18 +805,53 @@ public:
     uint8_t active_comm_type{0x01}; // default: normal messages
   };
   
-  const CommunicationState& communication_state() const { return comm_state_; }
-  void reset_communication_state() { comm_state_ = CommunicationState{}; }
+  CommunicationState communication_state() const;
+  void reset_communication_state();
   
   // DTC setting state
-  bool is_dtc_setting_enabled() const { return dtc_setting_enabled_; }
-  void reset_dtc_setting_state() { dtc_setting_enabled_ = true; }
+  bool is_dtc_setting_enabled() const;
+  void reset_dtc_setting_state();
+
+  // True if the underlying transport has no exchange running or queued
+  bool transport_idle() const { return t_.idle(); }
+
+  // Addressing of the underlying transport (the ECU this client talks to)
+  const Address& address() const { return t_.address(); }
+
+  // Latency instrumentation (see uds_metrics.hpp). The registry is not owned
+  // and may be shared between clients; nullptr disables measurement.
+  void set_metrics(metrics::ExchangeMetrics* m) { metrics_ = m; }
+  metrics::ExchangeMetrics* metrics() const { return metrics_; }
+
+  // Single-flight deduplication of concurrent read-only requests (default on).
+  // Waiters share the first caller's result but wait under their own
+  // ExchangeScope deadline and CancelScope token, failing when either ends.
+  // If the first caller's exchange fails because its own deadline passed or
+  // it was cancelled, the waiters retry and one of them goes to the bus.
+  void set_request_coalescing(bool enabled);
+  bool request_coalescing() const;
+  // Number of exchanges that joined an in-flight identical request
+  uint64_t coalesced_exchanges() const;
 
 private:
+  bool receive_unsolicited(uint8_t response_sid, std::vector<uint8_t>& pdu,
+                           std::chrono::milliseconds timeout);
+  // Both take the complete request SDU ([SID | payload])
+  PositiveOrNegative measured_exchange(SID sid, const std::vector<uint8_t>& tx,
+                                       std::chrono::milliseconds timeout);
+  PositiveOrNegative exchange_impl(SID sid, const std::vector<uint8_t>& tx,
+                                   std::chrono::milliseconds timeout,
+                                   std::chrono::steady_clock::time_point deadline,
+                                   metrics::ExchangeSample* sample);
+
   Transport& t_;
+  mutable std::mutex state_mutex_;  // Guards timings_, comm_state_, dtc_setting_enabled_
   Timings timings_{};
   CommunicationState comm_state_{};
   bool dtc_setting_enabled_{true}; // Default: DTC setting is ON
+  metrics::ExchangeMetrics* metrics_{nullptr};
+  std::shared_ptr<detail::RequestCoalescer> coalescer_;
+  std::shared_ptr<detail::UnsolicitedInbox> inbox_;
 };
 
 } // namespace uds
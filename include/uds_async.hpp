@@ -11,6 +11,7 @@
  */
 
 #include "uds.hpp"
+#include "uds_timer_wheel.hpp"
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -85,12 +86,44 @@ enum class Priority {
     Critical = 3
 };
 
+/**
+ * @brief Scheduling options of a task
+ *
+ * Implicitly constructible from Priority, so existing calls passing a
+ * priority keep working. Within a priority class tasks run earliest
+ * deadline first (tasks without deadline last, in submission order). A
+ * task whose deadline has passed before it starts is dropped as TimedOut
+ * without touching the bus; a running task's exchanges are bounded by the
+ * deadline (see ExchangeScope).
+ */
+struct TaskOptions {
+    using time_point = std::chrono::steady_clock::time_point;
+    
+    Priority priority = Priority::Normal;
+    time_point deadline = time_point::max();
+    
+    TaskOptions() = default;
+    TaskOptions(Priority p) : priority(p) {}  // NOLINT: implicit by design
+    TaskOptions(Priority p, time_point d) : priority(p), deadline(d) {}
+    
+    /**
+     * @brief Options with a deadline relative to now
+     */
+    static TaskOptions within(std::chrono::milliseconds timeout, Priority p = Priority::Normal) {
+        return TaskOptions(p, std::chrono::steady_clock::now() + timeout);
+    }
+};
+
 // ============================================================================
 // Async Task
 // ============================================================================
 
 /**
  * @brief Handle to an async operation
+ *
+ * The id encodes the task's status-table slot (low 32 bits) and the slot
+ * generation (high 32 bits), so a handle outlived by its slot is detected
+ * as stale rather than aliasing a newer task.
  */
 class TaskHandle {
 public:
@@ -114,15 +147,32 @@ private:
 
 /**
  * @brief Asynchronous UDS client with task queue
+ *
+ * Each worker owns an earliest-deadline-first heap per priority class.
+ * Tasks submitted from a worker go to that worker's heap, external submits
+ * are spread round-robin. A worker pops from its own heaps (highest
+ * priority class first, earliest deadline within it) and only when they
+ * are all empty steals the top task of the highest-priority class queued
+ * at another worker, so the dispatch path touches no shared lock while a
+ * worker has local work. Priority and deadline order hold per worker.
  */
 class AsyncClient {
 public:
+    /// Default size of the task status table
+    static constexpr size_t kDefaultMaxTasks = 4096;
+    
     /**
      * @brief Construct async client
      * @param client Underlying UDS client
      * @param num_workers Number of worker threads (default: 1)
+     * @param max_tasks Size of the task status table, i.e. the maximum number
+     *        of pending plus running tasks. Submitting beyond it returns an
+     *        invalid handle and reports the task as Failed through its
+     *        callback (from a worker thread the task is queued untracked
+     *        instead, still with an invalid handle).
      */
-    explicit AsyncClient(Client& client, size_t num_workers = 1);
+    explicit AsyncClient(Client& client, size_t num_workers = 1,
+                         size_t max_tasks = kDefaultMaxTasks);
     
     /**
      * @brief Destructor - stops all workers
@@ -141,12 +191,12 @@ public:
      * @brief Async read DID
      * @param did Data identifier
      * @param callback Result callback
-     * @param priority Task priority
+     * @param options Task priority and optional deadline
      * @return Task handle
      */
     TaskHandle read_did_async(uint16_t did,
                               ResultCallback<std::vector<uint8_t>> callback,
-                              Priority priority = Priority::Normal);
+                              TaskOptions options = Priority::Normal);
     
     /**
      * @brief Async read DID with future
@@ -163,7 +213,7 @@ public:
      */
     TaskHandle read_dids_async(const std::vector<uint16_t>& dids,
                                ResultCallback<std::map<uint16_t, std::vector<uint8_t>>> callback,
-                               Priority priority = Priority::Normal);
+                               TaskOptions options = Priority::Normal);
     
     // ========================================================================
     // Async Write Operations
@@ -178,7 +228,7 @@ public:
      */
     TaskHandle write_did_async(uint16_t did, const std::vector<uint8_t>& data,
                                ResultCallback<bool> callback,
-                               Priority priority = Priority::Normal);
+                               TaskOptions options = Priority::Normal);
     
     // ========================================================================
     // Async Service Operations
@@ -189,7 +239,7 @@ public:
      */
     TaskHandle session_control_async(Session session,
                                      ResultCallback<bool> callback,
-                                     Priority priority = Priority::High);
+                                     TaskOptions options = Priority::High);
     
     /**
      * @brief Async security access (seed-key)
@@ -201,7 +251,7 @@ public:
         uint8_t level,
         std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)> key_calculator,
         ResultCallback<bool> callback,
-        Priority priority = Priority::High);
+        TaskOptions options = Priority::High);
     
     /**
      * @brief Async routine control
@@ -209,14 +259,17 @@ public:
     TaskHandle routine_control_async(uint8_t control_type, uint16_t routine_id,
                                      const std::vector<uint8_t>& params,
                                      ResultCallback<std::vector<uint8_t>> callback,
-                                     Priority priority = Priority::Normal);
+                                     TaskOptions options = Priority::Normal);
     
     // ========================================================================
     // Task Management
     // ========================================================================
     
     /**
-     * @brief Cancel a pending task
+     * @brief Cancel a pending or running task
+     *
+     * A pending task is dropped. A running task has its exchange stopped
+     * at the next wire-level wait and finishes as Cancelled.
      * @param handle Task handle
      * @return True if task was cancelled
      */
@@ -241,7 +294,10 @@ public:
     void wait_all(std::chrono::milliseconds timeout);
     
     /**
-     * @brief Get task status
+     * @brief Get task status (lock-free)
+     *
+     * Finished tasks keep their final status until their slot is reused,
+     * which happens round-robin. Unknown or stale handles report Failed.
      */
     AsyncStatus get_status(TaskHandle handle) const;
     
@@ -251,7 +307,7 @@ public:
     size_t pending_count() const;
     
     /**
-     * @brief Check if any tasks are running
+     * @brief Check if any tasks are pending or running
      */
     bool is_busy() const;
     
@@ -261,6 +317,11 @@ public:
     
     /**
      * @brief Set default timeout for operations
+     *
+     * Bounds the execution time of every task. The default of 0 imposes no
+     * bound, so long 0x78-pending routines (erase, checksum) run to
+     * completion unless a deadline is set here or via TaskOptions::within().
+     * When both are set, whichever comes first wins.
      */
     void set_default_timeout(std::chrono::milliseconds timeout) {
         default_timeout_ = timeout;
@@ -282,45 +343,91 @@ public:
     bool is_paused() const { return paused_; }
 
 private:
+    static constexpr uint32_t kUntracked = 0xFFFFFFFFu;
+    
     struct Task {
-        uint64_t id;
-        Priority priority;
-        std::function<void()> execute;
-        std::atomic<AsyncStatus>* status;
+        uint32_t slot = kUntracked;
+        uint32_t generation = 0;
+        Priority priority = Priority::Normal;
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        uint64_t sequence = 0;                          ///< Submission order, EDF tie-break
+        std::function<AsyncStatus()> execute;           ///< Runs the task, returns final status
+        std::function<void(AsyncStatus)> abandon;       ///< Reports a task that will not run
         std::chrono::steady_clock::time_point created;
-        
-        bool operator<(const Task& other) const {
-            // Higher priority first, then earlier creation time
-            if (priority != other.priority) {
-                return static_cast<int>(priority) < static_cast<int>(other.priority);
-            }
-            return created > other.created;
-        }
+    };
+    
+    /// Per-worker EDF heaps, one per priority class (defined in uds_async.cpp)
+    struct WorkerQueue;
+    
+    /// Task a worker is running, cancellable through its token
+    struct RunningTask {
+        std::mutex mutex;
+        uint64_t id = 0;                    ///< Handle id, 0 when idle or untracked
+        CancellationToken token;
     };
     
     Client& client_;
     std::vector<std::thread> workers_;
-    std::priority_queue<Task> task_queue_;
-    mutable std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::unique_ptr<RunningTask[]> running_tasks_;  ///< One per worker
+    std::atomic<size_t> pending_{0};       ///< Tasks queued, not yet taken
+    std::atomic<size_t> active_{0};        ///< Tasks taken by a worker, not yet finished
+    std::atomic<size_t> sleepers_{0};      ///< Workers blocked on sleep_cv_
+    std::atomic<size_t> next_queue_{0};    ///< Round-robin cursor for external submits
+    std::atomic<uint64_t> next_sequence_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
     std::atomic<bool> running_{true};
     std::atomic<bool> paused_{false};
-    std::atomic<uint64_t> next_task_id_{1};
-    std::chrono::milliseconds default_timeout_{5000};
-    
-    std::map<uint64_t, std::atomic<AsyncStatus>> task_statuses_;
-    mutable std::mutex status_mutex_;
-    
-    void worker_loop();
-    uint64_t enqueue_task(Priority priority, std::function<void()> func);
+    std::atomic<std::chrono::milliseconds> default_timeout_{std::chrono::milliseconds(0)};
+    
+    /// Status table: each word is (generation << 8) | AsyncStatus
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    size_t slot_count_;
+    std::atomic<size_t> next_slot_{0};     ///< Round-robin allocation cursor
+    
+    void worker_loop(size_t index);
+    bool try_pop(size_t index, Task& task);
+    void wake_all();
+    bool acquire_slot(Task& task);
+    bool transition(const Task& task, AsyncStatus from, AsyncStatus to);
+    void run_task(Task& task);
+    TaskHandle enqueue_task(const TaskOptions& options, std::function<AsyncStatus()> func,
+                            std::function<void(AsyncStatus)> abandon);
 };
 
 // ============================================================================
 // Periodic Monitor
 // ============================================================================
 
+/**
+ * @brief Arrival statistics of an ECU-pushed periodic identifier
+ */
+struct PeriodicStats {
+    uint64_t samples = 0;
+    double rate_hz = 0.0;                           ///< From the mean interval
+    std::chrono::microseconds mean_interval{0};     ///< Moving average (1/8 weight)
+    std::chrono::microseconds max_interval{0};      ///< Longest interval seen
+    uint64_t gaps = 0;                              ///< Intervals over twice the mean
+    std::chrono::steady_clock::time_point last_sample{};
+};
+
 /**
  * @brief Periodically monitors DIDs and invokes callbacks on change
+ *
+ * Two sources are supported. Polled DIDs (add_did()) are read by the
+ * monitor. Periodic identifiers (add_periodic()) are configured on the ECU
+ * with ReadDataByPeriodicIdentifier (0x2A) and pushed by it; a receive
+ * thread demultiplexes the unsolicited 0x6A frames by identifier, so those
+ * signals cost no request bandwidth.
+ *
+ * Poll times are kept in a timer wheel, so adding, removing and expiring a
+ * DID costs O(1) regardless of how many are monitored. DIDs that fall due
+ * in the same tick are read together in multi-DID ReadDataByIdentifier
+ * requests (see set_max_dids_per_request()); if the ECU rejects a packed
+ * request or its response cannot be split, they are read one by one.
+ * Callbacks run on the monitor thread without the monitor's lock held, so
+ * they may call add_did()/remove_did().
  */
 class PeriodicMonitor {
 public:
@@ -347,6 +454,32 @@ public:
      */
     void remove_did(uint16_t did);
     
+    /**
+     * @brief Add an ECU-pushed periodic identifier
+     *
+     * The ECU is told to start sending at the given rate when the monitor
+     * starts (immediately if it is running). Callbacks receive the DID
+     * 0xF200 | pdid and the record data without identifier.
+     */
+    void add_periodic(PeriodicDID pdid, PeriodicTransmissionMode rate,
+                      std::function<void(uint16_t, const std::vector<uint8_t>&)> on_change,
+                      ErrorCallback on_error = nullptr);
+    
+    /**
+     * @brief Stop and remove a periodic identifier
+     */
+    void remove_periodic(PeriodicDID pdid);
+    
+    /**
+     * @brief Arrival statistics of a periodic identifier
+     */
+    std::optional<PeriodicStats> periodic_stats(PeriodicDID pdid) const;
+    
+    /**
+     * @brief Periodic frames received for identifiers not being monitored
+     */
+    uint64_t unknown_periodic_frames() const { return unknown_periodic_.load(); }
+    
     /**
      * @brief Start monitoring
      */
@@ -370,27 +503,66 @@ public:
     /**
      * @brief Set global error callback
      */
-    void set_error_callback(ErrorCallback callback) { global_error_cb_ = callback; }
+    void set_error_callback(ErrorCallback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        global_error_cb_ = callback;
+    }
+    
+    /**
+     * @brief Limit DIDs per packed read of due DIDs (0 or 1 disables packing)
+     */
+    void set_max_dids_per_request(size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_dids_per_request_ = n;
+    }
+    
+    /**
+     * @brief Number of read requests issued so far
+     */
+    uint64_t read_requests() const { return read_requests_.load(); }
 
 private:
     struct MonitoredDID {
         uint16_t did;
         std::chrono::milliseconds interval;
-        std::chrono::steady_clock::time_point last_poll;
+        std::chrono::steady_clock::time_point next_due;
         std::vector<uint8_t> last_value;
         std::function<void(uint16_t, const std::vector<uint8_t>&)> on_change;
         ErrorCallback on_error;
+        timer::TimerId timer = timer::kInvalidTimer;
+        uint32_t epoch = 0;         ///< Distinguishes re-added DIDs from stale timers
+    };
+    
+    struct PeriodicEntry {
+        PeriodicTransmissionMode rate;
+        std::vector<uint8_t> last_value;
+        std::function<void(uint16_t, const std::vector<uint8_t>&)> on_change;
+        ErrorCallback on_error;
+        PeriodicStats stats;
+        bool configured = false;    ///< Start request accepted by the ECU
     };
     
     Client& client_;
     std::map<uint16_t, MonitoredDID> monitored_;
+    std::map<PeriodicDID, PeriodicEntry> periodic_;
+    std::thread receive_thread_;
+    std::atomic<uint64_t> unknown_periodic_{0};
+    const std::chrono::steady_clock::time_point origin_ = std::chrono::steady_clock::now();
+    timer::TimerWheel wheel_;
+    uint32_t next_epoch_ = 0;
+    size_t max_dids_per_request_ = 8;
+    std::atomic<uint64_t> read_requests_{0};
     mutable std::mutex mutex_;
     std::thread monitor_thread_;
     std::atomic<bool> running_{false};
+    CancellationToken stop_token_;          ///< Wakes both threads' bus waits on stop()
     std::condition_variable cv_;
     ErrorCallback global_error_cb_;
     
     void monitor_loop();
+    void receive_loop();
+    void configure_periodic(const std::vector<PeriodicDID>& pdids);
+    void ensure_receiver();
 };
 
 // ============================================================================
@@ -398,32 +570,88 @@ private:
 // ============================================================================
 
 /**
- * @brief Execute multiple operations in parallel
+ * @brief Execute batches of DID reads/writes across one or more ECUs
+ *
+ * Operations are grouped by target Client. Up to max_concurrent targets are
+ * served in parallel, each by its own thread; operations on one target run
+ * in submission order, so writes are never reordered. Consecutive reads on a
+ * target are packed into multi-DID ReadDataByIdentifier requests and fall
+ * back to single-DID reads when the ECU rejects the packed request or its
+ * response cannot be split unambiguously (see set_did_length()).
+ *
+ * Targets sharing a Transport are still serialized by the transport's
+ * request queue; parallelism comes from distinct transports/buses.
+ *
+ * @code
+ * BatchExecutor batch(engine, 12);
+ * for (auto& ecu : ecus) batch.add_write(ecu, 0xF198, tester_id);
+ * batch.add_read(engine, 0xF190);
+ * auto results = batch.execute();   // results[i] belongs to operation i
+ * @endcode
  */
 class BatchExecutor {
 public:
+    /// Default number of DIDs packed into one multi-DID request
+    static constexpr size_t kDefaultMaxDidsPerRequest = 8;
+
+    /**
+     * @param client Target for add_read()/add_write() without a client
+     * @param max_concurrent Maximum number of targets served in parallel
+     */
     explicit BatchExecutor(Client& client, size_t max_concurrent = 4);
     
     /**
-     * @brief Add read operation to batch
+     * @brief Add read operation on the default client
+     * @return Operation index into the execute() result
      */
-    void add_read(uint16_t did);
+    size_t add_read(uint16_t did);
     
     /**
-     * @brief Add write operation to batch
+     * @brief Add write operation on the default client
+     * @return Operation index into the execute() result
      */
-    void add_write(uint16_t did, const std::vector<uint8_t>& data);
+    size_t add_write(uint16_t did, const std::vector<uint8_t>& data);
+    
+    /**
+     * @brief Add read operation on a specific target
+     * @return Operation index into the execute() result
+     */
+    size_t add_read(Client& target, uint16_t did);
+    
+    /**
+     * @brief Add write operation on a specific target
+     * @return Operation index into the execute() result
+     */
+    size_t add_write(Client& target, uint16_t did, const std::vector<uint8_t>& data);
+    
+    /**
+     * @brief Declare the data length of a DID
+     *
+     * Known lengths let multi-DID responses be split without searching for
+     * the next DID echo inside the data.
+     */
+    void set_did_length(uint16_t did, size_t length) { did_lengths_[did] = length; }
+    
+    /**
+     * @brief Limit DIDs per packed read (0 or 1 disables packing)
+     */
+    void set_max_dids_per_request(size_t n) { max_dids_per_request_ = n; }
     
     /**
      * @brief Execute all operations
-     * @return Map of DID -> result
+     * @return One result per operation, indexed in submission order. Read
+     *         values are the DID echo followed by the record data, as
+     *         returned by Client::read_data_by_identifier().
      */
-    std::map<uint16_t, AsyncResult<std::vector<uint8_t>>> execute();
+    std::vector<AsyncResult<std::vector<uint8_t>>> execute();
     
     /**
      * @brief Execute with progress callback
+     *
+     * The callback is invoked from the worker threads (serialized) as
+     * operations complete.
      */
-    std::map<uint16_t, AsyncResult<std::vector<uint8_t>>> execute(
+    std::vector<AsyncResult<std::vector<uint8_t>>> execute(
         std::function<void(size_t completed, size_t total)> progress);
     
     /**
@@ -440,13 +668,24 @@ private:
     struct Operation {
         enum Type { Read, Write };
         Type type;
+        Client* target;
         uint16_t did;
         std::vector<uint8_t> data;  // For writes
     };
     
+    using Result = AsyncResult<std::vector<uint8_t>>;
+    class Progress;
+    
+    void run_target(const std::vector<size_t>& ops, std::vector<Result>& results,
+                    Progress& progress) const;
+    void run_single(size_t index, std::vector<Result>& results) const;
+    void run_packed(const std::vector<size_t>& indices, std::vector<Result>& results) const;
+    
     Client& client_;
     std::vector<Operation> operations_;
-    [[maybe_unused]] size_t max_concurrent_;
+    size_t max_concurrent_;
+    size_t max_dids_per_request_ = kDefaultMaxDidsPerRequest;
+    std::map<uint16_t, size_t> did_lengths_;
 };
 
 // ============================================================================
@@ -455,29 +694,21 @@ private:
 
 /**
  * @brief Run function with timeout
+ *
+ * Runs func on the calling thread inside an ExchangeScope, so every UDS
+ * exchange it issues stops waiting once the timeout has passed. Nothing is
+ * left running in the background; work that does not wait on the bus is
+ * not interrupted and only counts as late.
  * @return True if completed within timeout
  */
 template<typename Func>
 bool run_with_timeout(Func&& func, std::chrono::milliseconds timeout) {
-    std::promise<void> promise;
-    auto future = promise.get_future();
-    
-    std::thread t([&]() {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    {
+        ExchangeScope scope(deadline);
         func();
-        promise.set_value();
-    });
-    
-    bool completed = future.wait_for(timeout) == std::future_status::ready;
-    
-    if (t.joinable()) {
-        if (completed) {
-            t.join();
-        } else {
-            t.detach();  // Let it finish in background
-        }
     }
-    
-    return completed;
+    return std::chrono::steady_clock::now() <= deadline;
 }
 
 /**
@@ -63,12 +63,15 @@
  */
 
 #include "uds.hpp"
+#include "uds_compression.hpp"
+#include "uds_firmware.hpp"
 #include <cstdint>
 #include <vector>
 #include <string>
 #include <optional>
 #include <functional>
 #include <chrono>
+#include <memory>
 #include <atomic>
 
 namespace uds {
@@ -206,18 +209,11 @@ using ProgressCallback = std::function<void(const TransferProgress&)>;
 
 /**
  * @brief Cancellation token for aborting transfers
+ *
+ * The core token: transfers also run their exchanges under a CancelScope,
+ * so cancel() aborts the block in flight instead of waiting for its response.
  */
-class CancellationToken {
-public:
-    CancellationToken() : cancelled_(false) {}
-    
-    void cancel() { cancelled_ = true; }
-    bool is_cancelled() const { return cancelled_; }
-    void reset() { cancelled_ = false; }
-    
-private:
-    std::atomic<bool> cancelled_;
-};
+using CancellationToken = uds::CancellationToken;
 
 // ============================================================================
 // Transfer Results
@@ -229,7 +225,8 @@ private:
 struct TransferResult {
     bool ok = false;
     TransferState final_state = TransferState::Idle;
-    uint64_t bytes_transferred = 0;
+    uint64_t bytes_transferred = 0;         ///< Bytes sent in TransferData
+    uint64_t uncompressed_bytes = 0;        ///< Image size before compression (upload)
     uint32_t blocks_transferred = 0;
     uint32_t total_retries = 0;
     std::chrono::milliseconds duration{0};
@@ -298,6 +295,19 @@ public:
                          ProgressCallback progress = nullptr,
                          CancellationToken* cancel = nullptr);
     
+    /**
+     * @brief Upload an image read block by block from a source
+     *
+     * Only one block of the image is touched at a time. With verify_blocks
+     * the read-back is compared to a seekable source byte for byte and to
+     * the CRC32 taken while sending otherwise. The source is not kept, so
+     * resume() needs it passed again.
+     */
+    TransferResult upload(uint32_t address, FirmwareSource& source,
+                         const TransferConfig& config = TransferConfig(),
+                         ProgressCallback progress = nullptr,
+                         CancellationToken* cancel = nullptr);
+    
     // ========================================================================
     // Resume Support
     // ========================================================================
@@ -331,6 +341,14 @@ public:
                          ProgressCallback progress = nullptr,
                          CancellationToken* cancel = nullptr);
     
+    /**
+     * @brief Resume an interrupted upload from a FirmwareSource
+     */
+    TransferResult resume(FirmwareSource& source,
+                         const TransferConfig& config = TransferConfig(),
+                         ProgressCallback progress = nullptr,
+                         CancellationToken* cancel = nullptr);
+    
     /**
      * @brief Clear resume state
      */
@@ -350,6 +368,12 @@ public:
     bool verify_upload(uint32_t address, const std::vector<uint8_t>& expected,
                       const TransferConfig& config = TransferConfig());
     
+    /**
+     * @brief Verify uploaded data against a seekable source
+     */
+    bool verify_upload(uint32_t address, FirmwareSource& expected,
+                      const TransferConfig& config = TransferConfig());
+    
     /**
      * @brief Calculate CRC32 of ECU memory region
      * @param address Start address
@@ -367,6 +391,20 @@ public:
      */
     void set_data_format(uint8_t format) { data_format_ = format; }
     
+    /**
+     * @brief Compress uploads with compressor (nullptr = send as is)
+     *
+     * The compressor's method replaces the compressionMethod (bits 7-4) of
+     * the data format; the encryptingMethod is kept.
+     */
+    void set_compressor(std::shared_ptr<const compression::Compressor> compressor,
+                        const compression::CompressionOptions& options = {}) {
+        compressor_ = std::move(compressor);
+        compression_options_ = options;
+    }
+    
+    const compression::Compressor* compressor() const { return compressor_.get(); }
+    
     /**
      * @brief Set address and length format
      */
@@ -391,11 +429,17 @@ private:
     uint8_t address_bytes_ = 4;
     uint8_t length_bytes_ = 4;
     uint8_t block_sequence_ = 0;
+    std::shared_ptr<const compression::Compressor> compressor_;
+    compression::CompressionOptions compression_options_;
     
     // Internal helpers
     bool request_download(uint32_t address, uint32_t size, uint32_t& max_block);
-    bool request_upload(uint32_t address, uint32_t size, uint32_t& max_block);
-    bool transfer_block(const std::vector<uint8_t>& data, bool is_upload);
+    bool request_upload(uint32_t address, uint32_t size, uint8_t dfi, uint32_t& max_block);
+    bool transfer_block(ByteSpan data, bool is_upload);
+    TransferResult upload_from(uint32_t address, FirmwareSource& source,
+                               const TransferConfig& config,
+                               ProgressCallback progress_cb,
+                               CancellationToken* cancel);
     bool request_transfer_exit();
     void update_progress(TransferState state, const std::string& msg = "");
     std::vector<uint8_t> encode_address_and_length(uint32_t address, uint32_t length);
@@ -415,6 +459,11 @@ uint32_t calculate_crc32(const std::vector<uint8_t>& data);
  */
 uint32_t calculate_crc32(const std::vector<uint8_t>& data, uint32_t initial);
 
+/**
+ * @brief Calculate CRC32 of a buffer with initial value (incremental)
+ */
+uint32_t calculate_crc32(const uint8_t* data, size_t size, uint32_t initial);
+
 /**
  * @brief Format transfer result for display
  */
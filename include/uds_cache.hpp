@@ -11,10 +11,21 @@
  * - LRU eviction policy
  * - Cache statistics
  * - Selective invalidation
- * - Thread-safe operations
+ * - Thread-safe operations, lock-striped by DID (CacheConfig::shard_count)
+ * - Flat direct-indexed alternative with CLOCK eviction (FlatDIDCache)
+ * - Memory-mapped snapshots of static DIDs for warm starts (CacheSnapshot)
+ * - Predictive prefetch of likely next DIDs (AccessPredictor, PrefetchConfig)
+ * - Slab-allocated payloads lent out as refcounted views (PayloadArena, PayloadView)
+ *
+ * Snapshot file format (all integers little-endian):
+ *   Header:  "UDSCSN01" | u32 version | u32 identity_size | u32 entry_count | u32 payload_size
+ *   Identity: identity_size bytes (EcuIdentity::serialize())
+ *   Index:   entry_count x { u16 did | u16 reserved | u32 offset | u32 length }, sorted by DID
+ *   Payload: payload_size bytes; entry data at payload + offset
  */
 
 #include "uds.hpp"
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -24,8 +35,13 @@
 #include <optional>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include <list>
 #include <functional>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 namespace uds {
 namespace cache {
@@ -41,7 +57,8 @@ enum class ExpirationPolicy {
     Never,              ///< Never expire (manual invalidation only)
     TimeToLive,         ///< Expire after fixed time from creation
     TimeToIdle,         ///< Expire after fixed time since last access
-    Sliding             ///< Reset TTL on each access
+    Sliding,            ///< Reset TTL on each access
+    StaleWhileRevalidate ///< Past TTL, still served (and refreshed) for up to CacheConfig::max_staleness
 };
 
 /**
@@ -53,6 +70,8 @@ struct CacheConfig {
     std::chrono::milliseconds default_ttl{60000};       ///< Default TTL (60 seconds)
     ExpirationPolicy default_policy = ExpirationPolicy::TimeToLive;
     bool enable_statistics = true;                      ///< Track hit/miss stats
+    size_t shard_count = 16;                            ///< Lock stripes (power of two; 1 = one global LRU)
+    std::chrono::milliseconds max_staleness{10000};     ///< Stale window after TTL (StaleWhileRevalidate)
     
     CacheConfig() = default;
     
@@ -86,6 +105,178 @@ struct CacheConfig {
     }
 };
 
+// ============================================================================
+// Payload Storage
+// ============================================================================
+
+class PayloadArena;
+
+/**
+ * @brief Header of a payload chunk; the payload bytes follow it
+ */
+struct PayloadChunk {
+    std::atomic<uint32_t> refs{1};
+    uint32_t size = 0;                  ///< Payload bytes
+    PayloadArena* arena = nullptr;      ///< Owning arena; nullptr for a standalone chunk
+    void* slab = nullptr;               ///< Owning slab; nullptr for a dedicated allocation
+    
+    uint8_t* bytes() { return reinterpret_cast<uint8_t*>(this + 1); }
+    const uint8_t* bytes() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+};
+
+/**
+ * @brief Immutable, reference-counted view of a payload
+ *
+ * Copying a view shares the bytes; the chunk goes back to its arena when
+ * the last view is gone, so a view stays valid after the entry it was
+ * read from is replaced, evicted or the cache is destroyed.
+ */
+class PayloadView {
+public:
+    PayloadView() = default;
+    PayloadView(const PayloadView& other) : chunk_(other.chunk_) { acquire(); }
+    PayloadView(PayloadView&& other) noexcept : chunk_(other.chunk_) { other.chunk_ = nullptr; }
+    ~PayloadView() { release(); }
+    
+    PayloadView& operator=(const PayloadView& other) {
+        if (chunk_ != other.chunk_) {
+            release();
+            chunk_ = other.chunk_;
+            acquire();
+        }
+        return *this;
+    }
+    PayloadView& operator=(PayloadView&& other) noexcept {
+        if (this != &other) {
+            release();
+            chunk_ = other.chunk_;
+            other.chunk_ = nullptr;
+        }
+        return *this;
+    }
+    
+    /**
+     * @brief View of a heap copy of data, outside any arena
+     */
+    static PayloadView copy_of(const std::vector<uint8_t>& data);
+    
+    const uint8_t* data() const { return chunk_ ? chunk_->bytes() : nullptr; }
+    size_t size() const { return chunk_ ? chunk_->size : 0; }
+    bool empty() const { return size() == 0; }
+    const uint8_t* begin() const { return data(); }
+    const uint8_t* end() const { return data() + size(); }
+    uint8_t operator[](size_t i) const { return data()[i]; }
+    
+    std::vector<uint8_t> to_vector() const { return std::vector<uint8_t>(begin(), end()); }
+    
+    /**
+     * @brief Copy into a vector
+     *
+     * CacheEntry::data used to be a std::vector<uint8_t>; the implicit
+     * conversion keeps code that reads it as one compiling (at the cost of
+     * a copy). Mutating it in place is no longer possible.
+     */
+    operator std::vector<uint8_t>() const { return to_vector(); }
+    
+    bool operator==(const PayloadView& other) const {
+        return size() == other.size() && std::equal(begin(), end(), other.begin());
+    }
+    bool operator==(const std::vector<uint8_t>& other) const {
+        return size() == other.size() && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const PayloadView& other) const { return !(*this == other); }
+    bool operator!=(const std::vector<uint8_t>& other) const { return !(*this == other); }
+
+private:
+    friend class PayloadArena;
+    explicit PayloadView(PayloadChunk* chunk) : chunk_(chunk) {}
+    
+    void acquire() {
+        if (chunk_) chunk_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    void release();
+    
+    PayloadChunk* chunk_ = nullptr;
+};
+
+/**
+ * @brief Size-class slab allocator for cached payloads
+ *
+ * A payload and its PayloadChunk header take one chunk of the smallest
+ * power-of-two class from kMinChunk to kMaxChunk that fits; larger ones
+ * get a dedicated allocation of exactly that size. Each class carves
+ * fixed-size slabs, so churn reuses chunks instead of fragmenting the
+ * heap, and a slab is returned to the heap once all its chunks are free
+ * (one empty slab per class is kept). Thread-safe.
+ *
+ * The owner calls retire() instead of deleting the arena: it is deleted
+ * when the last chunk is freed, which may be after the owner is gone.
+ */
+class PayloadArena {
+public:
+    static constexpr size_t kMinChunk = 32;
+    static constexpr size_t kMaxChunk = 2048;
+    static constexpr size_t kMinSlabBytes = 4096;
+    static constexpr size_t kMinChunksPerSlab = 4;
+    
+    PayloadArena();
+    PayloadArena(const PayloadArena&) = delete;
+    PayloadArena& operator=(const PayloadArena&) = delete;
+    
+    /**
+     * @brief Copy size bytes into a new chunk
+     */
+    PayloadView allocate(const uint8_t* data, size_t size);
+    
+    /**
+     * @brief Bytes a payload of the given size takes from the arena
+     */
+    static size_t chunk_bytes(size_t size);
+    
+    /**
+     * @brief Bytes currently held from the heap (slabs and dedicated chunks)
+     */
+    size_t reserved_bytes() const { return reserved_.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Give up ownership; the arena deletes itself once it is unused
+     */
+    void retire();
+
+private:
+    friend class PayloadView;
+    
+    struct Slab {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t bytes = 0;
+        uint32_t live = 0;
+        PayloadChunk* free = nullptr;   ///< Free list, linked through the payload bytes
+    };
+    struct SizeClass {
+        size_t chunk = 0;
+        std::vector<std::unique_ptr<Slab>> slabs;
+    };
+    
+    ~PayloadArena() = default;
+    
+    static size_t class_index(size_t bytes);
+    static void free_chunk(PayloadChunk* chunk);
+    bool deallocate(PayloadChunk* chunk);
+    
+    mutable std::mutex mutex_;
+    std::vector<SizeClass> classes_;
+    std::atomic<size_t> reserved_{0};
+    size_t live_chunks_ = 0;
+    bool retired_ = false;
+};
+
+inline void PayloadView::release() {
+    if (chunk_ && chunk_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        PayloadArena::free_chunk(chunk_);
+    }
+    chunk_ = nullptr;
+}
+
 // ============================================================================
 // Cache Entry
 // ============================================================================
@@ -94,17 +285,25 @@ struct CacheConfig {
  * @brief Individual cache entry
  */
 struct CacheEntry {
-    std::vector<uint8_t> data;
+    PayloadView data;                           ///< Immutable view (was std::vector<uint8_t>)
     std::chrono::steady_clock::time_point created;
     std::chrono::steady_clock::time_point last_accessed;
     std::chrono::milliseconds ttl;
     ExpirationPolicy policy;
     uint32_t hit_count = 0;
     size_t memory_size = 0;
+    std::chrono::milliseconds max_stale{0};     ///< Stale window after ttl (StaleWhileRevalidate)
+    bool prefetched = false;                    ///< Loaded by a prefetch and not read since
     
     CacheEntry() = default;
     CacheEntry(const std::vector<uint8_t>& d, std::chrono::milliseconds t, ExpirationPolicy p)
-        : data(d), ttl(t), policy(p), memory_size(d.size() + sizeof(CacheEntry)) {
+        : CacheEntry(PayloadView::copy_of(d), sizeof(PayloadChunk) + d.size(), t, p) {}
+    
+    /**
+     * @param bytes Bytes the payload takes in its arena (memory_size adds sizeof(CacheEntry))
+     */
+    CacheEntry(PayloadView d, size_t bytes, std::chrono::milliseconds t, ExpirationPolicy p)
+        : data(std::move(d)), ttl(t), policy(p), memory_size(bytes + sizeof(CacheEntry)) {
         created = std::chrono::steady_clock::now();
         last_accessed = created;
     }
@@ -122,7 +321,20 @@ struct CacheEntry {
                          policy == ExpirationPolicy::Sliding) 
                         ? last_accessed : created;
         
-        return (now - reference) > ttl;
+        auto limit = (policy == ExpirationPolicy::StaleWhileRevalidate) ? ttl + max_stale : ttl;
+        
+        return (now - reference) > limit;
+    }
+    
+    /**
+     * @brief Check if a StaleWhileRevalidate entry is past its TTL
+     *
+     * A stale entry is not expired yet: it may be served while it is
+     * refreshed, until is_expired() becomes true.
+     */
+    bool is_stale() const {
+        return policy == ExpirationPolicy::StaleWhileRevalidate &&
+               (std::chrono::steady_clock::now() - created) > ttl;
     }
     
     /**
@@ -147,8 +359,12 @@ struct CacheStats {
     uint64_t evictions = 0;         ///< Entries evicted
     uint64_t expirations = 0;       ///< Entries expired
     uint64_t invalidations = 0;     ///< Manual invalidations
+    uint64_t snapshot_loads = 0;    ///< Entries restored from an attached snapshot
+    uint64_t prefetches = 0;        ///< Entries stored by a prefetch
+    uint64_t prefetch_hits = 0;     ///< Prefetched entries read before being replaced or dropped
     size_t current_entries = 0;     ///< Current entry count
-    size_t current_memory = 0;      ///< Current memory usage
+    size_t current_memory = 0;      ///< Current memory usage (DIDCache: arena chunks + entry records)
+    size_t reserved_memory = 0;     ///< Bytes the payload arenas hold from the heap (DIDCache)
     size_t peak_entries = 0;        ///< Peak entry count
     size_t peak_memory = 0;         ///< Peak memory usage
     
@@ -160,12 +376,110 @@ struct CacheStats {
         return total > 0 ? static_cast<double>(hits) / total : 0.0;
     }
     
+    /**
+     * @brief Fraction of prefetched entries that were used (0.0 - 1.0)
+     */
+    double prefetch_hit_rate() const {
+        return prefetches > 0 ? static_cast<double>(prefetch_hits) / prefetches : 0.0;
+    }
+    
     /**
      * @brief Reset statistics
      */
     void reset() {
-        hits = misses = evictions = expirations = invalidations = 0;
+        hits = misses = evictions = expirations = invalidations = snapshot_loads = 0;
+        prefetches = prefetch_hits = 0;
+    }
+};
+
+// ============================================================================
+// Cache Snapshots
+// ============================================================================
+
+/**
+ * @brief Identity of the ECU whose data a snapshot holds
+ *
+ * A snapshot is only trusted when the identity read from the ECU matches
+ * the one stored in the file byte for byte.
+ */
+struct EcuIdentity {
+    uint32_t tx_can_id = 0;                 ///< Tester -> ECU address
+    uint32_t rx_can_id = 0;                 ///< ECU -> tester address
+    std::vector<uint8_t> vin;               ///< DID 0xF190
+    std::vector<uint8_t> software_version;  ///< DID 0xF195 (system supplier SW version)
+    
+    /**
+     * @brief Serialized form stored in the snapshot header
+     */
+    std::vector<uint8_t> serialize() const;
+    
+    bool operator==(const EcuIdentity& other) const {
+        return tx_can_id == other.tx_can_id && rx_can_id == other.rx_can_id &&
+               vin == other.vin && software_version == other.software_version;
     }
+    bool operator!=(const EcuIdentity& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Read-only view of a snapshot file, mapped into memory
+ *
+ * open() validates the header, the identity and every index entry, so
+ * find() can read the mapping without further checks. Nothing but the
+ * header and index is touched until an entry is looked up.
+ */
+class CacheSnapshot {
+public:
+    CacheSnapshot() = default;
+    ~CacheSnapshot();
+    
+    CacheSnapshot(const CacheSnapshot&) = delete;
+    CacheSnapshot& operator=(const CacheSnapshot&) = delete;
+    
+    /**
+     * @brief Write entries to path for the given ECU
+     *
+     * The file is written next to path and renamed over it, so a snapshot
+     * mapped by another cache stays intact.
+     */
+    static bool write(const std::string& path, const EcuIdentity& identity,
+                      const std::map<uint16_t, std::vector<uint8_t>>& entries);
+    
+    /**
+     * @brief Map path; fails on I/O error, corruption or identity mismatch
+     */
+    bool open(const std::string& path, const EcuIdentity& expected);
+    
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+    
+    bool is_open() const { return map_ != nullptr; }
+    
+    /**
+     * @brief Number of entries in the snapshot
+     */
+    size_t size() const { return count_; }
+    
+    /**
+     * @brief Data stored for did, if any
+     */
+    std::optional<std::vector<uint8_t>> find(uint16_t did) const;
+
+private:
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    const uint8_t* index_ = nullptr;
+    const uint8_t* payload_ = nullptr;
+    size_t count_ = 0;
+};
+
+/**
+ * @brief Result of DIDCache::lookup()
+ */
+struct CacheLookup {
+    std::optional<PayloadView> data;            ///< Cached value, if any
+    bool stale = false;                         ///< Value is past its TTL (StaleWhileRevalidate)
 };
 
 // ============================================================================
@@ -174,6 +488,18 @@ struct CacheStats {
 
 /**
  * @brief Cache for DID (Data Identifier) values
+ *
+ * DIDs are hashed onto config.shard_count shards, each with its own lock,
+ * entries, LRU list and per-DID settings, so lookups of different DIDs
+ * from concurrent threads rarely contend. The entry and memory limits apply
+ * to the cache as a whole: a new entry is admitted into its shard, then the
+ * least recently used entries across all shards are evicted until the cache
+ * is back within both limits.
+ *
+ * Payloads live in a PayloadArena per shard. get_view() lends the stored
+ * bytes out without copying; get() copies them. memory_usage() is exact:
+ * the arena chunk of every entry plus sizeof(CacheEntry). An entry that
+ * would not fit in max_memory_bytes on its own is not cached.
  */
 class DIDCache {
 public:
@@ -190,6 +516,23 @@ public:
      */
     std::optional<std::vector<uint8_t>> get(uint16_t did);
     
+    /**
+     * @brief get() without copying the payload
+     *
+     * The view shares the cached bytes and stays valid after the entry is
+     * replaced or removed.
+     */
+    std::optional<PayloadView> get_view(uint16_t did);
+    
+    /**
+     * @brief Get cached value, including a stale one
+     *
+     * Like get(), but a StaleWhileRevalidate entry past its TTL and within
+     * its stale window is returned with stale = true. get() and contains()
+     * report such an entry as absent without removing it.
+     */
+    CacheLookup lookup(uint16_t did);
+    
     /**
      * @brief Store value in cache
      * @param did Data identifier
@@ -233,10 +576,26 @@ public:
     std::map<uint16_t, std::vector<uint8_t>> get_multiple(const std::vector<uint16_t>& dids);
     
     /**
-     * @brief Store multiple DIDs at once
+     * @brief Store multiple DIDs at once (each shard is locked once)
      */
     void put_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries);
     
+    /**
+     * @brief put_multiple() for data nobody asked for yet
+     *
+     * Entries are counted in CacheStats::prefetches, and the first read of
+     * each in CacheStats::prefetch_hits.
+     */
+    void put_prefetched(const std::map<uint16_t, std::vector<uint8_t>>& entries);
+    
+    /**
+     * @brief Cacheable DIDs among dids without a fresh entry
+     *
+     * One lock per DID and no hit/miss accounting; used to plan batched
+     * reads of the misses.
+     */
+    std::vector<uint16_t> uncached(const std::vector<uint16_t>& dids);
+    
     // ========================================================================
     // Configuration
     // ========================================================================
@@ -251,16 +610,69 @@ public:
      */
     void set_did_policy(uint16_t did, ExpirationPolicy policy);
     
+    /**
+     * @brief Per-DID policy set with set_did_policy(), if any
+     */
+    std::optional<ExpirationPolicy> did_policy(uint16_t did) const;
+    
+    /**
+     * @brief Drop the per-DID policy (back to the default policy)
+     */
+    void clear_did_policy(uint16_t did);
+    
     /**
      * @brief Mark DID as non-cacheable
      */
     void set_non_cacheable(uint16_t did);
     
+    /**
+     * @brief Undo set_non_cacheable()
+     */
+    void set_cacheable(uint16_t did);
+    
     /**
      * @brief Check if DID is cacheable
      */
     bool is_cacheable(uint16_t did) const;
     
+    /**
+     * @brief Include DID in snapshots written by save_snapshot()
+     */
+    void set_did_persistent(uint16_t did);
+    
+    /**
+     * @brief Check if DID is saved in snapshots
+     */
+    bool is_persistent(uint16_t did) const;
+    
+    // ========================================================================
+    // Snapshots
+    // ========================================================================
+    
+    /**
+     * @brief Write the live entries of persistent DIDs to a snapshot file
+     * @return false on I/O error
+     */
+    bool save_snapshot(const std::string& path, const EcuIdentity& identity) const;
+    
+    /**
+     * @brief Use a snapshot as a lazy second level behind the cache
+     *
+     * The file is mapped and checked against identity; nothing is loaded
+     * yet. A later get()/lookup() miss on a DID found in the snapshot
+     * restores it with the DID's usual TTL and policy. Each DID is restored
+     * at most once: after a put, invalidate or restore, the cache (or the
+     * ECU) is authoritative for it.
+     *
+     * @return false if the file is missing, corrupt or for another ECU
+     */
+    bool attach_snapshot(const std::string& path, const EcuIdentity& identity);
+    
+    /**
+     * @brief Stop consulting the attached snapshot
+     */
+    void detach_snapshot();
+    
     // ========================================================================
     // Statistics
     // ========================================================================
@@ -295,41 +707,321 @@ public:
      */
     size_t memory_usage() const;
 
+    /**
+     * @brief Number of lock stripes in use
+     */
+    size_t shard_count() const { return shards_.size(); }
+
 private:
+    struct ArenaRetirer {
+        void operator()(PayloadArena* arena) const { arena->retire(); }
+    };
+    
+    /// Lock stripe owning the DIDs hashed to it (cache-line aligned)
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        
+        // Payload storage (declared first: outlives the entries' views)
+        std::unique_ptr<PayloadArena, ArenaRetirer> arena{new PayloadArena()};
+        
+        // LRU list (front = most recently used)
+        std::list<uint16_t> lru_list;
+        std::unordered_map<uint16_t, std::list<uint16_t>::iterator> lru_map;
+        
+        // Cache storage
+        std::unordered_map<uint16_t, CacheEntry> entries;
+        
+        // Per-DID configuration
+        std::unordered_map<uint16_t, std::chrono::milliseconds> did_ttls;
+        std::unordered_map<uint16_t, ExpirationPolicy> did_policies;
+        std::set<uint16_t> non_cacheable;
+        std::set<uint16_t> persistent;
+        
+        // DIDs the attached snapshot may no longer supply
+        std::set<uint16_t> snapshot_done;
+        
+        // Statistics (hits, misses, evictions, expirations, invalidations)
+        CacheStats stats;
+        
+        void note_hit(CacheEntry& entry);
+        CacheEntry* find_live(DIDCache& owner, uint16_t did, bool& restored);
+        CacheEntry* insert(DIDCache& owner, uint16_t did, const std::vector<uint8_t>& data,
+                           std::optional<std::chrono::milliseconds> ttl,
+                           std::optional<ExpirationPolicy> policy);
+        CacheEntry* restore(DIDCache& owner, uint16_t did);
+        void update_lru(uint16_t did);
+        void remove_entry(DIDCache& owner, uint16_t did);
+    };
+    
     CacheConfig config_;
-    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shard_mask_ = 0;
     
-    // LRU list (front = most recently used)
-    std::list<uint16_t> lru_list_;
-    std::unordered_map<uint16_t, std::list<uint16_t>::iterator> lru_map_;
+    // Totals across shards, for limits reporting and peaks
+    std::atomic<size_t> current_entries_{0};
+    std::atomic<size_t> current_memory_{0};
+    std::atomic<size_t> peak_entries_{0};
+    std::atomic<size_t> peak_memory_{0};
     
-    // Cache storage
-    std::unordered_map<uint16_t, CacheEntry> entries_;
+    // Attached snapshot; the flag keeps misses lock-free when there is none
+    mutable std::mutex snapshot_mutex_;
+    std::shared_ptr<const CacheSnapshot> snapshot_;
+    std::atomic<bool> has_snapshot_{false};
     
-    // Per-DID configuration
+    size_t shard_index(uint16_t did) const;
+    Shard& shard_for(uint16_t did) const;
+    bool over_limits() const;
+    void enforce_limits();
+    void store_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries, bool prefetched);
+    std::shared_ptr<const CacheSnapshot> snapshot() const;
+};
+
+// ============================================================================
+// Flat DID Cache
+// ============================================================================
+
+/**
+ * @brief DIDCache alternative with a flat, direct-indexed layout
+ *
+ * The 16-bit DID space indexes a table of slot numbers directly, slots are
+ * fixed-size records in one array and payloads live in one contiguous
+ * arena, so a lookup touches the index word, the slot and the payload with
+ * no node allocations. Eviction is CLOCK (second chance) over a reference
+ * bitmap rather than an LRU list. Freed arena space is reclaimed by
+ * compacting once more than half of the arena is dead.
+ *
+ * memory_usage() is exact: payload bytes plus sizeof(Slot) per live entry.
+ * max_entries is capped at 65535 and shard_count is ignored (one lock).
+ * StaleWhileRevalidate entries expire at their TTL (no stale window).
+ */
+class FlatDIDCache {
+public:
+    explicit FlatDIDCache(const CacheConfig& config = CacheConfig());
+
+    // Basic operations (same semantics as DIDCache)
+    std::optional<std::vector<uint8_t>> get(uint16_t did);
+    void put(uint16_t did, const std::vector<uint8_t>& data,
+             std::optional<std::chrono::milliseconds> ttl = std::nullopt,
+             std::optional<ExpirationPolicy> policy = std::nullopt);
+    bool contains(uint16_t did);
+    void invalidate(uint16_t did);
+    void invalidate_range(uint16_t start_did, uint16_t end_did);
+    void clear();
+
+    // Batch operations
+    std::map<uint16_t, std::vector<uint8_t>> get_multiple(const std::vector<uint16_t>& dids);
+    void put_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries);
+
+    // Configuration
+    void set_did_ttl(uint16_t did, std::chrono::milliseconds ttl);
+    void set_did_policy(uint16_t did, ExpirationPolicy policy);
+    void set_non_cacheable(uint16_t did);
+    bool is_cacheable(uint16_t did) const;
+
+    // Statistics and maintenance
+    CacheStats stats() const;
+    void reset_stats();
+    size_t cleanup_expired();
+    size_t size() const;
+    size_t memory_usage() const;
+
+    /**
+     * @brief Maximum number of entries (slots)
+     */
+    size_t capacity() const { return slots_.size(); }
+
+    /**
+     * @brief Bytes currently reserved by the payload arena (live + dead)
+     */
+    size_t arena_bytes() const;
+
+private:
+    /// Fixed-size entry record; the payload is arena_[offset, offset + length)
+    struct Slot {
+        std::chrono::steady_clock::time_point created;
+        std::chrono::steady_clock::time_point last_accessed;
+        std::chrono::milliseconds ttl{0};
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        uint32_t hit_count = 0;
+        uint16_t did = 0;
+        ExpirationPolicy policy = ExpirationPolicy::Never;
+
+        bool is_expired(std::chrono::steady_clock::time_point now) const;
+    };
+
+    // Per-DID flags, one byte per DID
+    static constexpr uint8_t kNonCacheable = 0x01;
+    static constexpr uint8_t kHasTtl = 0x02;
+    static constexpr uint8_t kHasPolicy = 0x04;
+
+    static constexpr uint16_t kNoSlot = 0xFFFF;
+
+    mutable std::mutex mutex_;
+    CacheConfig config_;
+
+    std::vector<uint16_t> index_;           ///< DID -> slot, kNoSlot if absent
+    std::vector<uint8_t> did_flags_;        ///< DID -> kNonCacheable | kHasTtl | kHasPolicy
     std::unordered_map<uint16_t, std::chrono::milliseconds> did_ttls_;
     std::unordered_map<uint16_t, ExpirationPolicy> did_policies_;
-    std::set<uint16_t> non_cacheable_;
+
+    std::vector<Slot> slots_;
+    std::vector<uint16_t> free_slots_;
+    std::vector<uint64_t> live_bits_;       ///< Slot in use
+    std::vector<uint64_t> ref_bits_;        ///< CLOCK reference bit
+    size_t hand_ = 0;
+
+    std::vector<uint8_t> arena_;
+    size_t arena_top_ = 0;                  ///< Bump pointer into arena_
+    size_t arena_dead_ = 0;                 ///< Bytes below arena_top_ no longer referenced
+
+    CacheStats stats_;
+
+    uint16_t slot_of(uint16_t did) const { return index_[did]; }
+    bool live(size_t slot) const { return (live_bits_[slot >> 6] >> (slot & 63)) & 1; }
+    void remove_slot(uint16_t slot);
+    uint16_t clock_victim();
+    size_t arena_alloc(size_t length);
+    void compact_arena();
+};
+
+// ============================================================================
+// Access Prediction
+// ============================================================================
+
+/**
+ * @brief First-order Markov model of DID read order
+ *
+ * observe() counts the transition from the previously observed DID to the
+ * new one. Each DID keeps at most kMaxSuccessors successors; a new one
+ * replaces the least frequent (space-saving), and counts are halved once a
+ * row has seen kAgingThreshold transitions so that changed habits win over
+ * old ones. Thread-safe.
+ */
+class AccessPredictor {
+public:
+    static constexpr size_t kMaxSuccessors = 8;
+    static constexpr uint32_t kAgingThreshold = 1024;
     
-    // Statistics
-    mutable CacheStats stats_;
+    /**
+     * @param max_tracked Maximum number of DIDs with a successor row
+     */
+    explicit AccessPredictor(size_t max_tracked = 4096) : max_tracked_(max_tracked) {}
+    
+    /**
+     * @brief Record a read of did (repeated reads of one DID are ignored)
+     */
+    void observe(uint16_t did);
+    
+    /**
+     * @brief Most likely successors of did, best first
+     * @param max Maximum number of DIDs returned
+     * @param min_probability Minimum share of did's transitions
+     * @param min_count Minimum number of observed transitions
+     */
+    std::vector<uint16_t> predict(uint16_t did, size_t max, double min_probability,
+                                  uint32_t min_count) const;
     
-    // Internal helpers
-    void evict_if_needed();
-    void update_lru(uint16_t did);
-    void remove_entry(uint16_t did);
+    /**
+     * @brief Forget everything learned
+     */
+    void reset();
+    
+    /**
+     * @brief Number of DIDs with a successor row
+     */
+    size_t tracked() const;
+
+private:
+    struct Successor {
+        uint16_t did;
+        uint32_t count;
+    };
+    struct Row {
+        std::vector<Successor> next;
+        uint32_t total = 0;
+    };
+    
+    mutable std::mutex mutex_;
+    std::unordered_map<uint16_t, Row> rows_;
+    std::optional<uint16_t> last_;
+    size_t max_tracked_;
+};
+
+/**
+ * @brief Predictive prefetch settings of a CachedClient
+ */
+struct PrefetchConfig {
+    bool enabled = false;                   ///< Off by default
+    size_t max_predictions = 4;             ///< DIDs prefetched per read
+    double min_probability = 0.3;           ///< Minimum transition share to prefetch
+    uint32_t min_count = 2;                 ///< Minimum observed transitions to prefetch
+    double requests_per_second = 5.0;       ///< Bus request budget for prefetching
+    double burst = 5.0;                     ///< Requests that may be spent at once
 };
 
 // ============================================================================
 // Cached UDS Client
 // ============================================================================
 
+/**
+ * @brief Stale-while-revalidate counters of a CachedClient
+ */
+struct RevalidationStats {
+    uint64_t stale_served = 0;      ///< Reads answered with a stale value
+    uint64_t refreshes = 0;         ///< Background refreshes completed
+    uint64_t refresh_failures = 0;  ///< Background refreshes without a positive response
+    uint64_t refreshes_dropped = 0; ///< Refresh results discarded because of a concurrent write
+};
+
+/**
+ * @brief ResponseOnEvent change-notification counters of a CachedClient
+ */
+struct ChangeEventStats {
+    uint64_t notifications = 0;     ///< Event notifications received
+    uint64_t updates = 0;           ///< Entries replaced with the value carried by the event
+    uint64_t invalidations = 0;     ///< Entries dropped by an event without a value
+    uint64_t ignored = 0;           ///< Notifications for other events or unwatched DIDs
+};
+
 /**
  * @brief UDS client wrapper with automatic caching
+ *
+ * DIDs with ExpirationPolicy::StaleWhileRevalidate (set_did_policy) are
+ * answered from the cache for up to CacheConfig::max_staleness past their
+ * TTL. The first such stale read queues a refresh, and a background thread
+ * (started on first use) re-reads the DID from the ECU; further stale
+ * reads of that DID do not queue another one. Past the stale window the
+ * read blocks on the bus as for any other miss.
+ *
+ * read_dids() and prefetch() collect their misses and read them with
+ * multi-DID ReadDataByIdentifier requests of up to max_dids_per_request()
+ * DIDs. A request the ECU rejects as too long (NRC 0x13/0x14) lowers that
+ * limit for later reads; any other rejection, or a response that cannot be
+ * split, is retried in halves down to single reads.
+ *
+ * With set_prefetch(), every read also feeds an AccessPredictor, and the
+ * likely next DIDs that are not cached are fetched by the background
+ * thread. Prefetches run only while the transport is idle, after pending
+ * refreshes, and within a token-bucket budget of bus requests; their
+ * usefulness shows in CacheStats::prefetch_hit_rate().
+ *
+ * watch_did_changes() sets up a ResponseOnEvent OnChangeOfDataIdentifier
+ * event (0x86 0x03, answered with 0x22) for a DID and caches it with
+ * ExpirationPolicy::Never. A listener thread receives the notifications
+ * and replaces the entry with the value they carry, so watched DIDs stay
+ * correct without polling.
  */
 class CachedClient {
 public:
+    static constexpr size_t kDefaultMaxDidsPerRequest = 8;
+    static constexpr size_t kMaxQueuedPrefetches = 64;
+    
     CachedClient(Client& client, const CacheConfig& config = CacheConfig());
+    ~CachedClient();
+    
+    CachedClient(const CachedClient&) = delete;
+    CachedClient& operator=(const CachedClient&) = delete;
     
     /**
      * @brief Read DID with caching
@@ -372,10 +1064,151 @@ public:
      * @brief Invalidate cache on session change
      */
     void on_session_change();
+    
+    /**
+     * @brief Read the identity (address, VIN, SW version) from the ECU
+     *
+     * VIN and software version are always read from the bus, never from
+     * the cache or a snapshot.
+     */
+    std::optional<EcuIdentity> identify();
+    
+    /**
+     * @brief Attach the snapshot at path if it belongs to this ECU
+     *
+     * Costs two DID reads (identify()); the static DIDs held by the
+     * snapshot are then served without bus traffic on first read.
+     */
+    bool warm_start(const std::string& path);
+    
+    /**
+     * @brief Save the cached static DIDs of this ECU to path
+     */
+    bool save_snapshot(const std::string& path);
+    
+    /**
+     * @brief Stale serve and background refresh counters
+     */
+    RevalidationStats revalidation_stats() const;
+    
+    /**
+     * @brief Number of refreshes queued or running
+     */
+    size_t pending_refreshes() const;
+    
+    /**
+     * @brief Limit DIDs per batched read (0 or 1 disables batching)
+     */
+    void set_max_dids_per_request(size_t n) { max_dids_per_request_.store(n); }
+    
+    /**
+     * @brief Current batch limit (lowered when the ECU rejects a batch as too long)
+     */
+    size_t max_dids_per_request() const { return max_dids_per_request_.load(); }
+    
+    /**
+     * @brief Number of ReadDataByIdentifier requests sent so far
+     */
+    uint64_t read_requests() const { return read_requests_.load(); }
+    
+    /**
+     * @brief Enable, tune or disable predictive prefetch
+     */
+    void set_prefetch(const PrefetchConfig& config);
+    
+    /**
+     * @brief Current prefetch settings
+     */
+    PrefetchConfig prefetch_config() const;
+    
+    /**
+     * @brief Access model fed by every read
+     */
+    AccessPredictor& predictor() { return predictor_; }
+    
+    /**
+     * @brief Number of predicted DIDs waiting to be prefetched
+     */
+    size_t pending_prefetches() const;
+    
+    /**
+     * @brief Keep did up to date from ECU change notifications
+     *
+     * Configures the event and (re)starts event reporting. The DID becomes
+     * cacheable with ExpirationPolicy::Never until the watch ends; its
+     * previous settings are restored then.
+     *
+     * @return false if the ECU rejects the event setup
+     */
+    bool watch_did_changes(uint16_t did);
+    
+    /**
+     * @brief Stop and clear the ECU's events and end all watches
+     *
+     * Watched DIDs are invalidated and get their previous settings back.
+     */
+    void stop_watching();
+    
+    /**
+     * @brief DIDs currently kept up to date by change notifications
+     */
+    std::vector<uint16_t> watched_dids() const;
+    
+    /**
+     * @brief Change notification counters
+     */
+    ChangeEventStats change_event_stats() const;
 
 private:
     Client& client_;
     DIDCache cache_;
+    
+    // Background revalidation
+    mutable std::mutex refresh_mutex_;
+    std::condition_variable refresh_cv_;
+    std::deque<uint16_t> refresh_queue_;
+    std::set<uint16_t> refresh_pending_;        ///< Queued or running
+    std::deque<uint16_t> prefetch_queue_;
+    std::set<uint16_t> prefetch_pending_;       ///< Queued
+    std::thread refresher_;
+    bool stopping_ = false;
+    CancellationToken stop_token_;
+    std::atomic<uint64_t> write_epoch_{0};
+    RevalidationStats revalidation_stats_;
+    
+    // Miss batching
+    std::atomic<size_t> max_dids_per_request_{kDefaultMaxDidsPerRequest};
+    std::atomic<uint64_t> read_requests_{0};
+    
+    // Predictive prefetch (settings and bucket guarded by refresh_mutex_)
+    AccessPredictor predictor_;
+    PrefetchConfig prefetch_config_;
+    std::atomic<bool> prefetch_enabled_{false};
+    double prefetch_tokens_ = 0.0;
+    std::chrono::steady_clock::time_point prefetch_refill_{};
+    
+    // Change notifications (guarded by watch_mutex_)
+    struct Watch {
+        bool was_cacheable = true;
+        std::optional<ExpirationPolicy> policy;
+    };
+    mutable std::mutex watch_mutex_;
+    std::map<uint16_t, Watch> watched_;
+    ChangeEventStats change_event_stats_;
+    std::thread listener_;
+    
+    void note_access(const std::vector<uint16_t>& dids);
+    void start_worker();
+    bool take_prefetch_token(std::chrono::steady_clock::time_point now,
+                             std::chrono::steady_clock::duration& wait);
+    
+    std::map<uint16_t, std::vector<uint8_t>> fetch(const std::vector<uint16_t>& dids);
+    bool fetch_group(const std::vector<uint16_t>& dids, std::map<uint16_t, std::vector<uint8_t>>& out);
+    std::optional<std::vector<uint8_t>> cached_value(uint16_t did);
+    void schedule_refresh(uint16_t did);
+    void refresh_loop();
+    void listen_loop();
+    void end_watches();
 };
 
 // ============================================================================
@@ -0,0 +1,145 @@
+#pragma once
+/**
+ * @file uds_compression.hpp
+ * @brief Compressed downloads - dataFormatIdentifier compressionMethod
+ *
+ * RequestDownload's dataFormatIdentifier carries a compressionMethod in
+ * bits 7-4 (ISO 14229-1 Table 119, values OEM-specific). With a compressor
+ * set, ECUProgrammer and BlockTransferManager compress the image before the
+ * transfer loop, request the download with the compressor's method and the
+ * uncompressed memorySize, and send the compressed stream in TransferData.
+ *
+ * Compression runs in independent chunks on several threads. Each chunk may
+ * still reference the bytes just before it, and chunk outputs concatenate
+ * into a single stream, so the ECU decodes it like a serially built one.
+ *
+ * Built-in codec - LzfCompressor, LZ77 with byte-aligned tokens (LZF):
+ *   000LLLLL <L+1 literals>                   literal run, 1..32 bytes
+ *   LLLooooo oooooooo                         match, length L+2 (3..8)
+ *   111ooooo LLLLLLLL oooooooo                match, length L+9 (9..264)
+ *   Match distance is o+1 (1..8192) bytes back in the output.
+ * This is the stream liblzf's lzf_decompress() reads, a decoder that fits
+ * in a few hundred bytes of bootloader code.
+ */
+
+#include "uds_firmware.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace uds {
+namespace compression {
+
+// ============================================================================
+// Compressor Interface
+// ============================================================================
+
+/**
+ * @brief Codec for one dataFormatIdentifier compressionMethod
+ */
+class Compressor {
+public:
+    virtual ~Compressor() = default;
+
+    /**
+     * @brief compressionMethod for dataFormatIdentifier bits 7-4 (1..15)
+     */
+    virtual uint8_t method() const = 0;
+
+    /**
+     * @brief Bytes before a chunk that compress() may reference
+     */
+    virtual size_t history() const = 0;
+
+    /**
+     * @brief Append the compressed form of data[0, size) to out
+     *
+     * data[-history, 0) holds the image bytes right before the chunk.
+     * Outputs of consecutive chunks must concatenate into one valid stream.
+     * Called from several threads at once.
+     */
+    virtual void compress(const uint8_t* data, size_t size, size_t history,
+                          std::vector<uint8_t>& out) const = 0;
+
+    /**
+     * @brief Decode a whole stream of expected_size bytes (tests, tooling)
+     */
+    virtual bool decompress(const uint8_t* data, size_t size, size_t expected_size,
+                            std::vector<uint8_t>& out) const = 0;
+};
+
+/**
+ * @brief LZF-format LZ77 codec (see file comment)
+ */
+class LzfCompressor : public Compressor {
+public:
+    static constexpr size_t kMaxDistance = 8192;
+    static constexpr size_t kMaxMatch = 264;
+
+    /**
+     * @param method compressionMethod the bootloader maps to LZF
+     */
+    explicit LzfCompressor(uint8_t method = 0x1) : method_(method) {}
+
+    uint8_t method() const override { return method_; }
+    size_t history() const override { return kMaxDistance; }
+    void compress(const uint8_t* data, size_t size, size_t history,
+                  std::vector<uint8_t>& out) const override;
+    bool decompress(const uint8_t* data, size_t size, size_t expected_size,
+                    std::vector<uint8_t>& out) const override;
+
+private:
+    uint8_t method_;
+};
+
+// ============================================================================
+// Image Compression
+// ============================================================================
+
+/**
+ * @brief How an image is split up for compression
+ */
+struct CompressionOptions {
+    size_t chunk_size = 256 * 1024;    ///< Bytes per independently compressed chunk
+    unsigned threads = 0;              ///< Worker threads (0 = hardware concurrency)
+};
+
+/**
+ * @brief Compressed stream of a whole image
+ */
+struct CompressedImage {
+    std::vector<uint8_t> data;
+    uint64_t original_size = 0;
+
+    /**
+     * @brief Compressed size relative to the original (0.4 = 60% saved)
+     */
+    double ratio() const {
+        return original_size == 0 ? 1.0
+            : static_cast<double>(data.size()) / static_cast<double>(original_size);
+    }
+};
+
+/**
+ * @brief Compress source in parallel chunks ahead of a transfer
+ *
+ * The source is read once, in order, a batch of chunks at a time; observe
+ * (optional) sees every block read, e.g. to checksum the original image.
+ * @return false if the source could not be read
+ */
+bool compress_image(FirmwareSource& source, const Compressor& compressor,
+                    const CompressionOptions& options, CompressedImage& out,
+                    const std::function<void(ByteSpan)>& observe = nullptr);
+
+/**
+ * @brief dataFormatIdentifier with the compressor's method in bits 7-4
+ *
+ * Keeps the encryptingMethod in bits 3-0 of dfi.
+ */
+inline uint8_t data_format_identifier(const Compressor& compressor, uint8_t dfi = 0x00) {
+    return static_cast<uint8_t>(((compressor.method() & 0x0F) << 4) | (dfi & 0x0F));
+}
+
+} // namespace compression
+} // namespace uds
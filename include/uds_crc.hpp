@@ -0,0 +1,154 @@
+#pragma once
+/**
+ * @file uds_crc.hpp
+ * @brief Checksums used to verify flashed images - CRC32, CRC32C, CRC16-CCITT
+ *
+ * One implementation behind block::calculate_crc32() and memory::crc32(),
+ * fast enough to run over multi-megabyte images on every verification:
+ *   - Table      byte at a time (reference)
+ *   - Slicing8   8 bytes per step through 8 lookup tables
+ *   - Slicing16  16 bytes per step through 16 lookup tables
+ *   - Clmul      carry-less multiply folding of 64-byte strides (x86-64
+ *                with PCLMULQDQ), the last bytes finished by table
+ * The fastest engine the CPU supports is picked once at first use.
+ *
+ * *_update() functions work on the raw register: start from the algorithm's
+ * initial value (kCrc32Init...), feed chunks in order, then apply the final
+ * XOR - or use the Crc32 / Crc32C / Crc16Ccitt accumulators, which do both.
+ *
+ * Parameters (Rocksoft model), check value over "123456789":
+ *   CRC32        poly 0x04C11DB7 reflected, init/xorout 0xFFFFFFFF  0xCBF43926
+ *   CRC32C       poly 0x1EDC6F41 reflected, init/xorout 0xFFFFFFFF  0xE3069283
+ *   CRC16-CCITT  poly 0x1021, init 0xFFFF, no reflection/xorout     0x29B1
+ *                (CRC-16/CCITT-FALSE, common in bootloader headers)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace uds {
+namespace crc {
+
+// ============================================================================
+// Engines
+// ============================================================================
+
+enum class Engine : uint8_t {
+    Table,
+    Slicing8,
+    Slicing16,
+    Clmul
+};
+
+const char* engine_name(Engine engine);
+
+/**
+ * @brief Whether engine can run on this CPU (Clmul needs PCLMULQDQ)
+ */
+bool engine_supported(Engine engine);
+
+/**
+ * @brief Engine used by the functions without an Engine argument
+ */
+Engine best_engine();
+
+// ============================================================================
+// Raw Register Updates
+// ============================================================================
+
+constexpr uint32_t kCrc32Init = 0xFFFFFFFF;
+constexpr uint32_t kCrc32XorOut = 0xFFFFFFFF;
+constexpr uint16_t kCrc16CcittInit = 0xFFFF;
+
+/**
+ * @brief Feed size bytes into a CRC32 (IEEE 802.3) register
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size);
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size, Engine engine);
+
+/**
+ * @brief Feed size bytes into a CRC32C (Castagnoli) register
+ */
+uint32_t crc32c_update(uint32_t crc, const uint8_t* data, size_t size);
+uint32_t crc32c_update(uint32_t crc, const uint8_t* data, size_t size, Engine engine);
+
+/**
+ * @brief Feed size bytes into a CRC16-CCITT register
+ *
+ * Clmul is not implemented for 16-bit CRCs and runs as Slicing8, which
+ * is also the default.
+ */
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t* data, size_t size);
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t* data, size_t size, Engine engine);
+
+// ============================================================================
+// One-Shot Checksums
+// ============================================================================
+
+inline uint32_t crc32(const uint8_t* data, size_t size) {
+    return crc32_update(kCrc32Init, data, size) ^ kCrc32XorOut;
+}
+
+inline uint32_t crc32(const std::vector<uint8_t>& data) {
+    return crc32(data.data(), data.size());
+}
+
+inline uint32_t crc32c(const uint8_t* data, size_t size) {
+    return crc32c_update(kCrc32Init, data, size) ^ kCrc32XorOut;
+}
+
+inline uint32_t crc32c(const std::vector<uint8_t>& data) {
+    return crc32c(data.data(), data.size());
+}
+
+inline uint16_t crc16_ccitt(const uint8_t* data, size_t size) {
+    return crc16_ccitt_update(kCrc16CcittInit, data, size);
+}
+
+inline uint16_t crc16_ccitt(const std::vector<uint8_t>& data) {
+    return crc16_ccitt(data.data(), data.size());
+}
+
+// ============================================================================
+// Streaming Accumulators
+// ============================================================================
+
+/**
+ * @brief CRC32 over data fed in chunks, e.g. blocks as they are transferred
+ */
+class Crc32 {
+public:
+    void update(const uint8_t* data, size_t size) { state_ = crc32_update(state_, data, size); }
+    void update(const std::vector<uint8_t>& data) { update(data.data(), data.size()); }
+    uint32_t value() const { return state_ ^ kCrc32XorOut; }
+    void reset() { state_ = kCrc32Init; }
+
+private:
+    uint32_t state_ = kCrc32Init;
+};
+
+class Crc32C {
+public:
+    void update(const uint8_t* data, size_t size) { state_ = crc32c_update(state_, data, size); }
+    void update(const std::vector<uint8_t>& data) { update(data.data(), data.size()); }
+    uint32_t value() const { return state_ ^ kCrc32XorOut; }
+    void reset() { state_ = kCrc32Init; }
+
+private:
+    uint32_t state_ = kCrc32Init;
+};
+
+class Crc16Ccitt {
+public:
+    void update(const uint8_t* data, size_t size) { state_ = crc16_ccitt_update(state_, data, size); }
+    void update(const std::vector<uint8_t>& data) { update(data.data(), data.size()); }
+    uint16_t value() const { return state_; }
+    void reset() { state_ = kCrc16CcittInit; }
+
+private:
+    uint16_t state_ = kCrc16CcittInit;
+};
+
+} // namespace crc
+} // namespace uds
@@ -264,6 +264,10 @@ Result<EventResponse> configure_timer_interrupt(
 /**
  * Try to receive an event notification (non-blocking with timeout)
  * 
+ * Notifications parked by concurrent exchanges are returned first.
+ * notification.service_id is the request SID of the triggered service
+ * (e.g. 0x22) and payload its response without the SID.
+ * 
  * @param client UDS client instance
  * @param notification Output: received notification
  * @param timeout Maximum time to wait
@@ -0,0 +1,211 @@
+#pragma once
+/**
+ * @file uds_firmware.hpp
+ * @brief Firmware image sources for TransferData (0x36) loops
+ *
+ * Programming loops read the image block by block through a FirmwareSource
+ * instead of holding it in a std::vector. Each read() lends a ByteSpan over
+ * the block; memory and mapped-file sources point straight into the image,
+ * stream and generator sources refill a single block-sized buffer. A job
+ * flashing a 64 MB image therefore keeps one block resident, not the image.
+ *
+ * Example:
+ *   MappedFirmwareSource image;
+ *   if (image.open("ecu.bin")) {
+ *       ECUProgrammer programmer(client);
+ *       programmer.program_ecu(image, config);
+ *   }
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace uds {
+
+/**
+ * @brief Read-only view of contiguous bytes
+ *
+ * Does not own the bytes; a span returned by FirmwareSource::read() stays
+ * valid until the next read() on the same source.
+ */
+struct ByteSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    bool empty() const { return size == 0; }
+    const uint8_t* begin() const { return data; }
+    const uint8_t* end() const { return data + size; }
+    uint8_t operator[](size_t i) const { return data[i]; }
+};
+
+// ============================================================================
+// Firmware Source Interface
+// ============================================================================
+
+/**
+ * @brief Image read block by block by the programming loops
+ */
+class FirmwareSource {
+public:
+    virtual ~FirmwareSource() = default;
+
+    /**
+     * @brief Total image size in bytes
+     */
+    virtual uint64_t size() const = 0;
+
+    /**
+     * @brief Lend bytes [offset, offset + length) of the image
+     *
+     * Fails if the range is past the end or, for sequential sources, is
+     * neither the next block nor the block read last.
+     */
+    virtual bool read(uint64_t offset, size_t length, ByteSpan& out) = 0;
+
+    /**
+     * @brief Whether read() accepts any offset (read-back verification)
+     */
+    virtual bool seekable() const { return true; }
+};
+
+// ============================================================================
+// Sources
+// ============================================================================
+
+/**
+ * @brief Image already in memory; the bytes must outlive the source
+ */
+class MemoryFirmwareSource : public FirmwareSource {
+public:
+    MemoryFirmwareSource(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    explicit MemoryFirmwareSource(const std::vector<uint8_t>& image)
+        : data_(image.data()), size_(image.size()) {}
+
+    uint64_t size() const override { return size_; }
+    bool read(uint64_t offset, size_t length, ByteSpan& out) override;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+};
+
+/**
+ * @brief Window [offset, offset + size) of another source
+ *
+ * Reads are forwarded with the window's offset added, so the base must be
+ * seekable unless the window is read in order once.
+ */
+class SliceFirmwareSource : public FirmwareSource {
+public:
+    SliceFirmwareSource(FirmwareSource& base, uint64_t offset, uint64_t size)
+        : base_(base), offset_(offset), size_(size) {}
+
+    uint64_t size() const override { return size_; }
+    bool read(uint64_t offset, size_t length, ByteSpan& out) override;
+    bool seekable() const override { return base_.seekable(); }
+
+private:
+    FirmwareSource& base_;
+    uint64_t offset_;
+    uint64_t size_;
+};
+
+/**
+ * @brief Image file mapped read-only
+ *
+ * Pages are faulted in as blocks are read and dropped again once the
+ * transfer has moved past them, so resident memory stays near one window.
+ */
+class MappedFirmwareSource : public FirmwareSource {
+public:
+    MappedFirmwareSource() = default;
+    ~MappedFirmwareSource() override;
+
+    MappedFirmwareSource(const MappedFirmwareSource&) = delete;
+    MappedFirmwareSource& operator=(const MappedFirmwareSource&) = delete;
+
+    /**
+     * @brief Map path; fails on I/O error or an empty file
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+
+    bool is_open() const { return map_ != nullptr; }
+
+    uint64_t size() const override { return map_size_; }
+    bool read(uint64_t offset, size_t length, ByteSpan& out) override;
+
+    /// Pages kept mapped behind the current block before they are dropped
+    static constexpr size_t kReleaseWindow = 1024 * 1024;
+
+private:
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    size_t released_ = 0;   ///< Pages below this offset have been dropped
+};
+
+/**
+ * @brief Image read from a std::istream into one reusable block buffer
+ *
+ * Sequential: blocks must be read in order, though the last block can be
+ * read again (retries).
+ */
+class StreamFirmwareSource : public FirmwareSource {
+public:
+    /**
+     * @brief Stream holding size bytes from its current position
+     */
+    StreamFirmwareSource(std::istream& in, uint64_t size) : in_(in), size_(size) {}
+
+    /**
+     * @brief Seekable stream; the image runs to the end of the stream
+     */
+    explicit StreamFirmwareSource(std::istream& in);
+
+    uint64_t size() const override { return size_; }
+    bool read(uint64_t offset, size_t length, ByteSpan& out) override;
+    bool seekable() const override { return false; }
+
+private:
+    std::istream& in_;
+    uint64_t size_;
+    uint64_t position_ = 0;
+    uint64_t last_offset_ = 0;
+    std::vector<uint8_t> buffer_;
+};
+
+/**
+ * @brief Image produced chunk by chunk, e.g. by a decryptor or unpacker
+ *
+ * The generator fills the buffer with the next length bytes of the image
+ * and returns how many it wrote; fewer than length is an error. Sequential
+ * like StreamFirmwareSource.
+ */
+class GeneratorFirmwareSource : public FirmwareSource {
+public:
+    using Generator = std::function<size_t(uint8_t* out, size_t length)>;
+
+    GeneratorFirmwareSource(uint64_t size, Generator generator)
+        : size_(size), generator_(std::move(generator)) {}
+
+    uint64_t size() const override { return size_; }
+    bool read(uint64_t offset, size_t length, ByteSpan& out) override;
+    bool seekable() const override { return false; }
+
+private:
+    uint64_t size_;
+    Generator generator_;
+    uint64_t position_ = 0;
+    uint64_t last_offset_ = 0;
+    std::vector<uint8_t> buffer_;
+};
+
+} // namespace uds
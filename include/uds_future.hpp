@@ -0,0 +1,541 @@
+#pragma once
+/**
+ * @file uds_future.hpp
+ * @brief Composable futures for chaining asynchronous UDS operations
+ *
+ * Future<T>/Promise<T> are a lightweight alternative to std::future that
+ * can be continued instead of waited on. A continuation attached with
+ * then() runs inline on the thread that fulfils the promise (for
+ * FutureClient, the AsyncClient worker finishing the task), or at once if
+ * the future is already ready. A continuation returning a Future is
+ * flattened, so multi-step flows occupy no thread while they wait on the
+ * bus:
+ *
+ *   async::FutureClient ecu(async_client);
+ *   auto done = ecu.session_control(Session::ExtendedSession)
+ *       .then([&](AsyncResult<bool> r) { return ecu.read_did(0xF190); })
+ *       .then([](AsyncResult<std::vector<uint8_t>> vin) { return vin.value.size(); });
+ *
+ * when_all() and when_any() combine futures the same way. Continuations
+ * are stored in a small inline buffer rather than a std::function, so a
+ * chain step costs one shared state allocation.
+ *
+ * A future has a single consumer: get(), then() and subscribe() consume it.
+ * Exceptions thrown by a continuation travel down the chain and are
+ * rethrown by get(). A promise destroyed unfulfilled breaks its future with
+ * std::future_errc::broken_promise.
+ */
+
+#include "uds_async.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace uds {
+namespace async {
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+namespace detail {
+
+/**
+ * @brief Move-only void() callable with inline storage for small captures
+ */
+class Continuation {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    Continuation() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Continuation>>>
+    Continuation(F&& f) {  // NOLINT: implicit by design
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>()) {
+            new (storage_) Fn(std::forward<F>(f));
+            ops_ = &kInlineOps<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &kHeapOps<Fn>;
+        }
+    }
+
+    Continuation(Continuation&& other) noexcept { take(other); }
+    Continuation& operator=(Continuation&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    ~Continuation() { reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    void operator()() { ops_->invoke(storage_); }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops kHeapOps = {
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+    };
+
+    void take(Continuation& other) {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+/**
+ * @brief State shared by a Promise and its Future
+ */
+template <typename T>
+struct SharedState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool ready = false;
+    std::optional<T> value;
+    std::exception_ptr error;
+    Continuation continuation;
+
+    // Publish the outcome, then run the continuation outside the lock
+    void settle(std::optional<T> v, std::exception_ptr e) {
+        Continuation next;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ready) return;
+            value = std::move(v);
+            error = std::move(e);
+            ready = true;
+            next = std::move(continuation);
+        }
+        cv.notify_all();
+        if (next) next();
+    }
+
+    // Run c once settled: stored, or inline if already ready
+    void on_ready(Continuation c) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ready) {
+                continuation = std::move(c);
+                return;
+            }
+        }
+        c();
+    }
+};
+
+template <typename T> struct IsFuture : std::false_type {};
+template <typename T> struct IsFuture<Future<T>> : std::true_type {};
+
+template <typename T> struct Unwrap { using type = T; };
+template <typename T> struct Unwrap<Future<T>> { using type = T; };
+
+template <size_t... Is, typename F>
+void for_each_index(std::index_sequence<Is...>, F&& f) {
+    (f(std::integral_constant<size_t, Is>{}), ...);
+}
+
+} // namespace detail
+
+// ============================================================================
+// Future
+// ============================================================================
+
+/**
+ * @brief Single-consumer result of an asynchronous operation
+ */
+template <typename T>
+class Future {
+public:
+    static_assert(!std::is_void_v<T>, "Future<void> is not supported; use a status type");
+
+    Future() = default;
+    Future(Future&&) noexcept = default;
+    Future& operator=(Future&&) noexcept = default;
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    /** @brief True until consumed by get(), then() or subscribe() */
+    bool valid() const { return state_ != nullptr; }
+
+    /** @brief True if the value or an exception is available */
+    bool is_ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->ready;
+    }
+
+    /** @brief Block until ready */
+    void wait() const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->cv.wait(lock, [this] { return state_->ready; });
+    }
+
+    /** @brief Block until ready or timeout; true if ready */
+    bool wait_for(std::chrono::milliseconds timeout) const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        return state_->cv.wait_for(lock, timeout, [this] { return state_->ready; });
+    }
+
+    /**
+     * @brief Wait for and take the value (rethrows a stored exception)
+     */
+    T get() {
+        wait();
+        auto state = std::move(state_);
+        if (state->error) std::rethrow_exception(state->error);
+        return std::move(*state->value);
+    }
+
+    /**
+     * @brief Run f(Future<T>) once ready; f receives a ready future
+     *
+     * Lowest-level hook, used by then(), when_all() and when_any(). Runs on
+     * the fulfilling thread, or inline if already ready.
+     */
+    template <typename F>
+    void subscribe(F&& f) {
+        auto state = std::move(state_);
+        auto* raw = state.get();
+        raw->on_ready([state = std::move(state), fn = std::forward<F>(f)]() mutable {
+            fn(Future<T>(std::move(state)));
+        });
+    }
+
+    /**
+     * @brief Chain a continuation on the value
+     *
+     * f is called with the value (T&&) and may return a plain value or a
+     * Future, which is flattened. Exceptions (stored or thrown by f) skip f
+     * and fail the returned future.
+     */
+    template <typename F>
+    auto then(F&& f) -> Future<typename detail::Unwrap<std::invoke_result_t<F, T&&>>::type> {
+        using R = std::invoke_result_t<F, T&&>;
+        using U = typename detail::Unwrap<R>::type;
+        Promise<U> next;
+        Future<U> result = next.get_future();
+        subscribe([fn = std::forward<F>(f), next = std::move(next)](Future<T> ready) mutable {
+            try {
+                if constexpr (detail::IsFuture<R>::value) {
+                    fn(ready.get()).forward_to(std::move(next));
+                } else {
+                    next.set_value(fn(ready.get()));
+                }
+            } catch (...) {
+                next.set_exception(std::current_exception());
+            }
+        });
+        return result;
+    }
+
+    /**
+     * @brief Settle promise with this future's outcome once ready
+     */
+    void forward_to(Promise<T>&& promise) {
+        subscribe([promise = std::move(promise)](Future<T> ready) mutable {
+            try {
+                promise.set_value(ready.get());
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        });
+    }
+
+private:
+    friend class Promise<T>;
+    explicit Future(std::shared_ptr<detail::SharedState<T>> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<detail::SharedState<T>> state_;
+};
+
+// ============================================================================
+// Promise
+// ============================================================================
+
+/**
+ * @brief Producer side of a Future
+ */
+template <typename T>
+class Promise {
+public:
+    Promise() : state_(std::make_shared<detail::SharedState<T>>()) {}
+    Promise(Promise&&) noexcept = default;
+    Promise& operator=(Promise&& other) noexcept {
+        if (this != &other) {
+            abandon();
+            state_ = std::move(other.state_);
+            retrieved_ = other.retrieved_;
+        }
+        return *this;
+    }
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+    ~Promise() { abandon(); }
+
+    /** @brief The future of this promise (may be taken once) */
+    Future<T> get_future() {
+        if (retrieved_) throw std::future_error(std::future_errc::future_already_retrieved);
+        retrieved_ = true;
+        return Future<T>(state_);
+    }
+
+    /** @brief Fulfil; runs the continuation on this thread */
+    void set_value(T value) {
+        auto state = std::move(state_);
+        if (state) state->settle(std::move(value), nullptr);
+    }
+
+    /** @brief Fail; runs the continuation on this thread */
+    void set_exception(std::exception_ptr error) {
+        auto state = std::move(state_);
+        if (state) state->settle(std::nullopt, std::move(error));
+    }
+
+private:
+    void abandon() {
+        if (state_) {
+            set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    std::shared_ptr<detail::SharedState<T>> state_;
+    bool retrieved_ = false;
+};
+
+/**
+ * @brief A future that is already fulfilled
+ */
+template <typename T>
+Future<std::decay_t<T>> make_ready_future(T&& value) {
+    Promise<std::decay_t<T>> promise;
+    auto future = promise.get_future();
+    promise.set_value(std::forward<T>(value));
+    return future;
+}
+
+// ============================================================================
+// Composition
+// ============================================================================
+
+/**
+ * @brief Future of all values, in input order
+ *
+ * Completes once every input is ready. If any input failed, the result
+ * fails with the first exception observed.
+ */
+template <typename T>
+Future<std::vector<T>> when_all(std::vector<Future<T>> futures) {
+    struct State {
+        std::mutex mutex;
+        std::vector<std::optional<T>> values;
+        std::exception_ptr error;
+        size_t remaining;
+        Promise<std::vector<T>> promise;
+    };
+    auto state = std::make_shared<State>();
+    state->values.resize(futures.size());
+    state->remaining = futures.size();
+    auto result = state->promise.get_future();
+
+    if (futures.empty()) {
+        state->promise.set_value({});
+        return result;
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].subscribe([state, i](Future<T> ready) {
+            std::optional<T> value;
+            std::exception_ptr error;
+            try {
+                value = ready.get();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->values[i] = std::move(value);
+                if (error && !state->error) state->error = error;
+                if (--state->remaining != 0) return;
+            }
+            // Last input: nobody else touches the state any more
+            if (state->error) {
+                state->promise.set_exception(state->error);
+                return;
+            }
+            std::vector<T> all;
+            all.reserve(state->values.size());
+            for (auto& v : state->values) all.push_back(std::move(*v));
+            state->promise.set_value(std::move(all));
+        });
+    }
+    return result;
+}
+
+/**
+ * @brief Future of a tuple of heterogeneous values
+ */
+template <typename... Ts>
+Future<std::tuple<Ts...>> when_all(Future<Ts>... futures) {
+    struct State {
+        std::mutex mutex;
+        std::tuple<std::optional<Ts>...> values;
+        std::exception_ptr error;
+        size_t remaining = sizeof...(Ts);
+        Promise<std::tuple<Ts...>> promise;
+    };
+    auto state = std::make_shared<State>();
+    auto result = state->promise.get_future();
+
+    auto finish = [](State& s) {
+        if (s.error) {
+            s.promise.set_exception(s.error);
+        } else {
+            s.promise.set_value(std::apply(
+                [](auto&... v) { return std::tuple<Ts...>(std::move(*v)...); }, s.values));
+        }
+    };
+    auto attach = [&](auto index, auto& future) {
+        constexpr size_t I = decltype(index)::value;
+        using V = std::tuple_element_t<I, std::tuple<Ts...>>;
+        future.subscribe([state, finish](Future<V> ready) {
+            std::optional<V> value;
+            std::exception_ptr error;
+            try {
+                value = ready.get();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                std::get<I>(state->values) = std::move(value);
+                if (error && !state->error) state->error = error;
+                if (--state->remaining != 0) return;
+            }
+            finish(*state);
+        });
+    };
+    detail::for_each_index(std::index_sequence_for<Ts...>{}, [&](auto index) {
+        attach(index, std::get<decltype(index)::value>(std::tie(futures...)));
+    });
+    return result;
+}
+
+/**
+ * @brief Future of the first input to become ready: (index, value)
+ *
+ * The first input to settle decides the result, including a failure. The
+ * other inputs keep running; their outcomes are discarded. An empty input
+ * fails with std::invalid_argument.
+ */
+template <typename T>
+Future<std::pair<size_t, T>> when_any(std::vector<Future<T>> futures) {
+    struct State {
+        std::atomic<bool> decided{false};
+        Promise<std::pair<size_t, T>> promise;
+    };
+    auto state = std::make_shared<State>();
+    auto result = state->promise.get_future();
+
+    if (futures.empty()) {
+        state->promise.set_exception(std::make_exception_ptr(std::invalid_argument("when_any: no futures")));
+        return result;
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].subscribe([state, i](Future<T> ready) {
+            if (state->decided.exchange(true)) return;
+            try {
+                state->promise.set_value({i, ready.get()});
+            } catch (...) {
+                state->promise.set_exception(std::current_exception());
+            }
+        });
+    }
+    return result;
+}
+
+// ============================================================================
+// Future-returning AsyncClient facade
+// ============================================================================
+
+/**
+ * @brief AsyncClient operations returning composable futures
+ *
+ * Each call submits the corresponding AsyncClient task; its future is
+ * fulfilled, and continuations run, on the worker finishing the task.
+ * Tasks dropped by the client (cancelled, deadline shed) still fulfil the
+ * future with that status.
+ */
+class FutureClient {
+public:
+    explicit FutureClient(AsyncClient& client) : client_(client) {}
+
+    Future<AsyncResult<std::vector<uint8_t>>> read_did(uint16_t did,
+                                                       TaskOptions options = Priority::Normal);
+    Future<AsyncResult<std::map<uint16_t, std::vector<uint8_t>>>> read_dids(
+        const std::vector<uint16_t>& dids, TaskOptions options = Priority::Normal);
+    Future<AsyncResult<bool>> write_did(uint16_t did, const std::vector<uint8_t>& data,
+                                        TaskOptions options = Priority::Normal);
+    Future<AsyncResult<bool>> session_control(Session session, TaskOptions options = Priority::High);
+    Future<AsyncResult<bool>> security_access(
+        uint8_t level, std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)> key_calculator,
+        TaskOptions options = Priority::High);
+    Future<AsyncResult<std::vector<uint8_t>>> routine_control(uint8_t control_type, uint16_t routine_id,
+                                                              const std::vector<uint8_t>& params = {},
+                                                              TaskOptions options = Priority::Normal);
+
+    AsyncClient& client() { return client_; }
+
+private:
+    AsyncClient& client_;
+};
+
+} // namespace async
+} // namespace uds
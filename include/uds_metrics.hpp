@@ -0,0 +1,291 @@
+#pragma once
+/**
+ * @file uds_metrics.hpp
+ * @brief Per-service and per-ECU latency histograms for UDS exchanges
+ *
+ * This module records where the time of every Client::exchange() goes so that
+ * slow services and slow ECUs can be identified on a running tester.
+ *
+ * Each exchange is split into phases:
+ * - Tx:           Segmentation and transmission of the request SDU
+ * - EcuThink:     Last request frame sent -> first response frame received
+ * - Pending:      Time spent waiting after NRC 0x78 (ResponsePending)
+ * - RxReassembly: First response frame -> complete response SDU
+ * - Total:        Complete exchange as seen by the caller
+ *
+ * The phase split requires a transport that reports frame-level timestamps
+ * (see Transport::last_transfer_timing); otherwise the whole wire time is
+ * attributed to EcuThink.
+ *
+ * Histograms use HDR-style logarithmic buckets (8 linear sub-buckets per
+ * power of two, <= 12.5% relative error) over microsecond values. Recording
+ * and reading use relaxed atomics only, so a monitoring thread can take
+ * snapshots while exchanges are running without any lock on the hot path.
+ *
+ * Usage:
+ *   uds::metrics::ExchangeMetrics metrics;
+ *   client.set_metrics(&metrics);
+ *   ...
+ *   std::cout << uds::metrics::format_metrics(metrics);
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace uds {
+namespace metrics {
+
+// ============================================================================
+// Exchange Phases
+// ============================================================================
+
+/**
+ * @brief Phases of a single request/response exchange
+ */
+enum class Phase : uint8_t {
+    Tx = 0,             ///< Request segmentation and transmission
+    EcuThink = 1,       ///< Request sent -> first response frame
+    Pending = 2,        ///< Waiting after NRC 0x78
+    RxReassembly = 3,   ///< First response frame -> complete SDU
+    Total = 4           ///< Whole exchange
+};
+
+constexpr size_t kPhaseCount = 5;
+
+/**
+ * @brief Get display name of a phase
+ */
+const char* phase_name(Phase phase);
+
+// ============================================================================
+// Histogram
+// ============================================================================
+
+/**
+ * @brief Point-in-time copy of a LatencyHistogram
+ */
+struct HistogramSnapshot {
+    std::vector<uint64_t> counts;   ///< Per-bucket counts
+    uint64_t count = 0;             ///< Number of samples
+    uint64_t sum_us = 0;            ///< Sum of all samples (microseconds)
+    uint64_t min_us = 0;            ///< Smallest sample (0 if empty)
+    uint64_t max_us = 0;            ///< Largest sample
+
+    /**
+     * @brief Mean value in microseconds
+     */
+    double mean_us() const {
+        return count > 0 ? static_cast<double>(sum_us) / count : 0.0;
+    }
+
+    /**
+     * @brief Value at percentile (0.0 - 100.0), upper bound of its bucket
+     */
+    uint64_t percentile_us(double percentile) const;
+};
+
+/**
+ * @brief Lock-free log-bucketed latency histogram (microsecond resolution)
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr uint64_t kSubBucketCount = 1u << kSubBucketBits;
+    static constexpr unsigned kMaxMagnitude = 32;   ///< Values >= 2^32 us are clamped
+    static constexpr size_t kBucketCount =
+        kSubBucketCount + (kMaxMagnitude - kSubBucketBits) * kSubBucketCount;
+
+    LatencyHistogram() = default;
+
+    // Non-copyable (atomics)
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * @brief Record a sample
+     */
+    void record(std::chrono::nanoseconds value) {
+        const auto ns = value.count();
+        record_us(ns > 0 ? static_cast<uint64_t>(ns) / 1000 : 0);
+    }
+
+    /**
+     * @brief Record a sample given in microseconds
+     */
+    void record_us(uint64_t us);
+
+    /**
+     * @brief Number of recorded samples
+     */
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Copy the current state (safe while other threads record)
+     */
+    HistogramSnapshot snapshot() const;
+
+    /**
+     * @brief Clear all samples
+     */
+    void reset();
+
+    /**
+     * @brief Bucket holding a value
+     */
+    static size_t bucket_index(uint64_t us);
+
+    /**
+     * @brief Smallest value mapped to a bucket
+     */
+    static uint64_t bucket_lower_bound(size_t index);
+
+    /**
+     * @brief Largest value mapped to a bucket
+     */
+    static uint64_t bucket_upper_bound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint64_t> min_us_{UINT64_MAX};
+    std::atomic<uint64_t> max_us_{0};
+};
+
+// ============================================================================
+// Exchange Samples and Aggregates
+// ============================================================================
+
+/**
+ * @brief Timing breakdown of one exchange, produced by Client::exchange()
+ */
+struct ExchangeSample {
+    std::chrono::nanoseconds tx{0};
+    std::chrono::nanoseconds ecu_think{0};
+    std::chrono::nanoseconds pending{0};
+    std::chrono::nanoseconds rx_reassembly{0};
+    std::chrono::nanoseconds total{0};
+    uint32_t pending_responses = 0;     ///< Number of NRC 0x78 received
+    bool ok = false;                    ///< Positive response received
+    bool timed_out = false;             ///< Transport gave up waiting
+};
+
+/**
+ * @brief Histograms for all phases plus outcome counters
+ */
+class PhaseHistograms {
+public:
+    PhaseHistograms() = default;
+    PhaseHistograms(const PhaseHistograms&) = delete;
+    PhaseHistograms& operator=(const PhaseHistograms&) = delete;
+
+    void record(const ExchangeSample& sample);
+    void reset();
+
+    const LatencyHistogram& phase(Phase p) const {
+        return phases_[static_cast<size_t>(p)];
+    }
+
+    uint64_t exchanges() const { return exchanges_.load(std::memory_order_relaxed); }
+    uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+    uint64_t timeouts() const { return timeouts_.load(std::memory_order_relaxed); }
+    uint64_t pending_responses() const { return pending_responses_.load(std::memory_order_relaxed); }
+
+private:
+    std::array<LatencyHistogram, kPhaseCount> phases_;
+    std::atomic<uint64_t> exchanges_{0};
+    std::atomic<uint64_t> failures_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> pending_responses_{0};
+};
+
+// ============================================================================
+// Exchange Metrics Registry
+// ============================================================================
+
+/**
+ * @brief Per-SID and per-ECU latency registry
+ *
+ * Histograms are allocated on first use of a SID/ECU and never freed until
+ * the registry is destroyed, so pointers returned by service()/ecu() stay
+ * valid for the lifetime of the registry. ECUs are keyed by the request
+ * CAN ID (Address::tx_can_id).
+ */
+class ExchangeMetrics {
+public:
+    static constexpr size_t kMaxEcus = 64;
+
+    ExchangeMetrics() = default;
+    ~ExchangeMetrics();
+
+    ExchangeMetrics(const ExchangeMetrics&) = delete;
+    ExchangeMetrics& operator=(const ExchangeMetrics&) = delete;
+
+    /**
+     * @brief Record one exchange
+     * @param sid Request service identifier
+     * @param ecu_id ECU key (request CAN ID)
+     * @param sample Timing breakdown
+     */
+    void record(uint8_t sid, uint32_t ecu_id, const ExchangeSample& sample);
+
+    /**
+     * @brief Histograms for a service, or nullptr if never used
+     */
+    const PhaseHistograms* service(uint8_t sid) const;
+
+    /**
+     * @brief Histograms for an ECU, or nullptr if never used
+     */
+    const PhaseHistograms* ecu(uint32_t ecu_id) const;
+
+    /**
+     * @brief Services that have recorded samples
+     */
+    std::vector<uint8_t> services() const;
+
+    /**
+     * @brief ECUs that have recorded samples
+     */
+    std::vector<uint32_t> ecus() const;
+
+    /**
+     * @brief Samples not attributed to an ECU because the table was full
+     */
+    uint64_t dropped_ecu_samples() const { return dropped_ecu_samples_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Clear all samples (registered SIDs/ECUs are kept)
+     */
+    void reset();
+
+private:
+    struct EcuSlot {
+        std::atomic<uint64_t> key{0};               ///< ecu_id + 1 (0 = empty)
+        std::atomic<PhaseHistograms*> histograms{nullptr};
+    };
+
+    std::array<std::atomic<PhaseHistograms*>, 256> services_{};
+    std::array<EcuSlot, kMaxEcus> ecus_{};
+    std::atomic<uint64_t> dropped_ecu_samples_{0};
+
+    PhaseHistograms* service_slot(uint8_t sid);
+    PhaseHistograms* ecu_slot(uint32_t ecu_id);
+};
+
+// ============================================================================
+// Utility Functions
+// ============================================================================
+
+/**
+ * @brief Format per-service and per-ECU latency summary for display
+ */
+std::string format_metrics(const ExchangeMetrics& metrics);
+
+} // namespace metrics
+} // namespace uds
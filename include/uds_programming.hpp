@@ -41,6 +41,7 @@
 #include <vector>
 #include <string>
 #include "uds.hpp"
+#include "uds_firmware.hpp"
 
 namespace uds {
 
@@ -107,6 +108,9 @@ public:
     // 7) Transfer a full image (split into blocks automatically)
     ProgStatus transfer_image(const std::vector<uint8_t>& image);
 
+    // 7b) Same, reading the image block by block (mapped file, stream, ...)
+    ProgStatus transfer_image(FirmwareSource& image);
+
     // 8) RequestTransferExit
     ProgStatus request_transfer_exit();
 
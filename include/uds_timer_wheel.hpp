@@ -0,0 +1,122 @@
+#pragma once
+/**
+ * @file uds_timer_wheel.hpp
+ * @brief Hashed timer wheel for scheduling periodic work
+ *
+ * Timers are kept in a wheel of slots, each covering one tick of the wheel's
+ * resolution. A timer is linked into the slot of its expiry tick, so
+ * scheduling and cancelling are O(1), and advancing the wheel only visits
+ * the slots that elapsed. Timers further away than one rotation share slots
+ * with nearer ones and are skipped until their tick comes up.
+ *
+ * Timer nodes live in a slab that is reused through a free list; a TimerId
+ * carries the node's generation so cancelling an already-fired timer is a
+ * harmless no-op.
+ *
+ * The wheel is not thread-safe; owners serialize access (PeriodicMonitor
+ * does so under its mutex).
+ *
+ * Usage:
+ *   uds::timer::TimerWheel wheel(std::chrono::milliseconds(1));
+ *   auto id = wheel.schedule(now + std::chrono::milliseconds(100), did);
+ *   std::vector<uint64_t> due;
+ *   wheel.advance(std::chrono::steady_clock::now(), due);
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace uds {
+namespace timer {
+
+/**
+ * @brief Identifies a scheduled timer: (generation << 32) | node index
+ */
+using TimerId = uint64_t;
+
+constexpr TimerId kInvalidTimer = 0;
+
+/**
+ * @brief Hashed timer wheel with O(1) schedule/cancel
+ */
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    /**
+     * @param resolution Tick length; timers fire at most one tick late
+     * @param slots Number of wheel slots (rounded up to a power of two)
+     * @param start Time of tick 0
+     */
+    explicit TimerWheel(std::chrono::microseconds resolution = std::chrono::milliseconds(1),
+                        size_t slots = 512,
+                        Clock::time_point start = Clock::now());
+    
+    /**
+     * @brief Schedule a timer
+     * @param when Expiry time (past times fire on the next advance())
+     * @param data Value reported by advance() when the timer fires
+     */
+    TimerId schedule(Clock::time_point when, uint64_t data);
+    
+    /**
+     * @brief Cancel a pending timer
+     * @return False if the timer already fired or was cancelled
+     */
+    bool cancel(TimerId id);
+    
+    /**
+     * @brief Fire every timer due at or before now
+     * @param expired Receives the data of fired timers (appended)
+     * @return Number of timers fired
+     */
+    size_t advance(Clock::time_point now, std::vector<uint64_t>& expired);
+    
+    /**
+     * @brief Earliest time at which advance() may fire a timer
+     *
+     * Exact for timers within one rotation; otherwise a point one rotation
+     * ahead (waking early is harmless). Empty if no timers are pending.
+     */
+    std::optional<Clock::time_point> next_wakeup() const;
+    
+    /**
+     * @brief Number of pending timers
+     */
+    size_t size() const { return active_; }
+    
+    bool empty() const { return active_ == 0; }
+
+private:
+    static constexpr uint32_t kNil = 0xFFFFFFFFu;
+    
+    struct Node {
+        int64_t tick = 0;
+        uint64_t data = 0;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t generation = 0;
+        bool active = false;
+    };
+    
+    int64_t tick_of(Clock::time_point t) const;
+    Clock::time_point time_of(int64_t tick) const;
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    
+    std::chrono::microseconds resolution_;
+    Clock::time_point start_;
+    size_t mask_;
+    std::vector<uint32_t> slots_;   ///< Head node of each slot
+    std::vector<Node> nodes_;       ///< Slab of timer nodes
+    uint32_t free_ = kNil;          ///< Free list through Node::next
+    int64_t current_tick_ = 0;      ///< First tick not yet processed
+    size_t active_ = 0;
+};
+
+} // namespace timer
+} // namespace uds
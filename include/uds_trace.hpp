@@ -0,0 +1,289 @@
+#pragma once
+/**
+ * @file uds_trace.hpp
+ * @brief Low-overhead binary capture of CAN frames and UDS PDUs
+ *
+ * Every CAN frame passing through isotp::Transport and every UDS PDU passing
+ * through Client::exchange() is recorded with a timestamp and direction into
+ * a preallocated per-thread ring buffer. The hot path performs no allocation,
+ * no locking and no formatting: a record is a fixed-size struct copied into
+ * the next ring slot. Older records are overwritten when a ring wraps, so the
+ * trace always holds the most recent traffic of each thread.
+ *
+ * The rings can be dumped to a compact binary file at any time (for example
+ * when a flash fails, see ProgrammingConfig::trace_dump_path) and converted
+ * offline to candump or Vector ASC text with tools/uds_trace_convert.
+ *
+ * Usage:
+ *   uds::trace::Tracer::instance().set_enabled(true);   // default: enabled
+ *   ...
+ *   uds::trace::Tracer::instance().dump("failure.udstrace");
+ *
+ * File format (all integers little-endian):
+ *   Header:  "UDSTRC01" | u32 version | u32 record_size | u64 record_count
+ *            | u64 steady_anchor_ns | u64 wall_anchor_ns
+ *   Records: u64 timestamp_ns | u32 can_id | u16 length | u8 kind
+ *            | u8 direction | u16 thread_index | u8 captured | u8 reserved
+ *            | u8 data[64]
+ * Timestamps are steady-clock nanoseconds; the anchors map them to wall time.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace CANProtocol { struct CANFrame; }
+
+namespace uds {
+namespace trace {
+
+// ============================================================================
+// Trace Records
+// ============================================================================
+
+/**
+ * @brief What a record describes
+ */
+enum class RecordKind : uint8_t {
+    CanFrame = 0,   ///< Raw CAN frame (data = frame payload)
+    UdsPdu = 1      ///< Complete UDS PDU (data = SID + parameters)
+};
+
+/**
+ * @brief Direction relative to the tester
+ */
+enum class Direction : uint8_t {
+    Tx = 0,         ///< Tester -> ECU
+    Rx = 1          ///< ECU -> Tester
+};
+
+/// Payload bytes stored per record; longer PDUs are truncated
+constexpr size_t kMaxRecordData = 64;
+
+/// Serialized size of one record in a trace file
+constexpr size_t kRecordFileSize = 8 + 4 + 2 + 1 + 1 + 2 + 1 + 1 + kMaxRecordData;
+
+/**
+ * @brief One captured frame or PDU
+ */
+struct TraceRecord {
+    uint64_t timestamp_ns = 0;      ///< steady_clock time since epoch
+    uint32_t can_id = 0;            ///< CAN ID (PDUs: request/response ID)
+    uint16_t length = 0;            ///< Original length in bytes
+    RecordKind kind = RecordKind::CanFrame;
+    Direction direction = Direction::Tx;
+    uint16_t thread_index = 0;      ///< Ring that captured the record
+    uint8_t captured = 0;           ///< Bytes stored in data (<= kMaxRecordData)
+    uint8_t reserved = 0;
+    uint8_t data[kMaxRecordData] = {};
+
+    /**
+     * @brief True if the PDU was longer than the stored data
+     */
+    bool truncated() const { return length > captured; }
+};
+
+// ============================================================================
+// Per-Thread Ring
+// ============================================================================
+
+/**
+ * @brief Single-writer ring of trace records
+ *
+ * Only the owning thread writes; dump() may read concurrently. Each slot
+ * carries a sequence number (odd while being written) so readers can detect
+ * and skip torn records without blocking the writer.
+ */
+class TraceRing {
+public:
+    /**
+     * @param capacity Number of records (rounded up to a power of two)
+     * @param thread_index Index stamped into every record
+     */
+    TraceRing(size_t capacity, uint16_t thread_index);
+
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    /**
+     * @brief Append a record (owning thread only)
+     */
+    void write(RecordKind kind, Direction direction, uint32_t can_id,
+               const uint8_t* data, size_t length);
+
+    /**
+     * @brief Copy all consistent records currently held in the ring
+     */
+    void collect(std::vector<TraceRecord>& out) const;
+
+    size_t capacity() const { return mask_ + 1; }
+    uint16_t thread_index() const { return thread_index_; }
+
+    /**
+     * @brief Total records ever written (including overwritten ones)
+     */
+    uint64_t written() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        TraceRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    uint16_t thread_index_;
+    std::atomic<uint64_t> head_{0};
+};
+
+// ============================================================================
+// Tracer
+// ============================================================================
+
+/**
+ * @brief Process-wide registry of per-thread trace rings
+ */
+class Tracer {
+public:
+    static constexpr size_t kDefaultRingCapacity = 4096;
+    static constexpr size_t kMaxRetiredRings = 16;
+
+    /**
+     * @brief Global tracer used by the transport and client hooks
+     */
+    static Tracer& instance();
+
+    Tracer() = default;
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    /**
+     * @brief Enable/disable capture (enabled by default)
+     */
+    void set_enabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Ring size for threads that start tracing after this call
+     */
+    void set_ring_capacity(size_t records);
+    size_t ring_capacity() const;
+
+    /**
+     * @brief Record a CAN frame from the calling thread
+     */
+    void record_can(Direction direction, const CANProtocol::CANFrame& frame);
+
+    /**
+     * @brief Record a UDS PDU from the calling thread
+     */
+    void record_pdu(Direction direction, uint32_t can_id,
+                    const uint8_t* data, size_t length);
+
+    /**
+     * @brief All buffered records of all threads, ordered by timestamp
+     */
+    std::vector<TraceRecord> snapshot() const;
+
+    /**
+     * @brief Write all buffered records to a binary trace file
+     * @return false on I/O error
+     */
+    bool dump(const std::string& path) const;
+
+    /**
+     * @brief Drop all buffered records
+     *
+     * Rings of live threads stay allocated; their older records are hidden
+     * from snapshot()/dump() rather than erased, so writers are never blocked.
+     */
+    void clear();
+
+    /**
+     * @brief Number of thread rings currently registered
+     */
+    size_t ring_count() const;
+
+private:
+    struct Registration;
+    friend struct Registration;
+
+    TraceRing& local_ring();
+    void retire(const std::shared_ptr<TraceRing>& ring);
+
+    std::atomic<bool> enabled_{true};
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<TraceRing>> rings_;
+    std::vector<std::shared_ptr<TraceRing>> retired_;
+    size_t ring_capacity_{kDefaultRingCapacity};
+    uint16_t next_thread_index_{0};
+    std::atomic<uint64_t> cleared_before_ns_{0};   ///< Set by clear()
+};
+
+/**
+ * @brief Record a CAN frame in the global tracer (no-op when disabled)
+ */
+inline void record_can(Direction direction, const CANProtocol::CANFrame& frame) {
+    Tracer& t = Tracer::instance();
+    if (t.enabled()) t.record_can(direction, frame);
+}
+
+/**
+ * @brief Record a UDS PDU in the global tracer (no-op when disabled)
+ */
+inline void record_pdu(Direction direction, uint32_t can_id,
+                       const std::vector<uint8_t>& pdu) {
+    Tracer& t = Tracer::instance();
+    if (t.enabled()) t.record_pdu(direction, can_id, pdu.data(), pdu.size());
+}
+
+// ============================================================================
+// Trace Files
+// ============================================================================
+
+/**
+ * @brief Contents of a binary trace file
+ */
+struct TraceFile {
+    uint64_t steady_anchor_ns = 0;      ///< steady_clock at dump time
+    uint64_t wall_anchor_ns = 0;        ///< system_clock (Unix ns) at dump time
+    std::vector<TraceRecord> records;
+
+    /**
+     * @brief Wall-clock time of a record in seconds since the Unix epoch
+     */
+    double wall_time_s(const TraceRecord& r) const;
+};
+
+/**
+ * @brief Serialize records to a binary trace file
+ */
+bool write_file(const std::string& path, const std::vector<TraceRecord>& records);
+
+/**
+ * @brief Load a binary trace file
+ * @return false if the file is missing, truncated or has a bad header
+ */
+bool load(const std::string& path, TraceFile& out);
+
+/**
+ * @brief Convert CAN records to candump log format (candump -L)
+ *
+ * UDS PDU records have no candump representation and are skipped.
+ */
+std::string to_candump(const TraceFile& file, const std::string& interface = "can0");
+
+/**
+ * @brief Convert to Vector ASC text
+ *
+ * CAN records become data frames; UDS PDU records are written as comments.
+ */
+std::string to_asc(const TraceFile& file);
+
+} // namespace trace
+} // namespace uds
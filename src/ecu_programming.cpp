@@ -1,7 +1,11 @@
 #include "ecu_programming.hpp"
+#include "uds_block.hpp"
+#include "uds_trace.hpp"
 #include <thread>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
+#include <cstdlib>
 #include <cstring>
 
 namespace uds {
@@ -51,6 +55,11 @@ void ECUProgrammer::update_state(ProgrammingState new_state, const std::string&
 }
 
 void ECUProgrammer::report_progress(uint32_t bytes_transferred, uint32_t total_bytes) {
+  // Delta flashing reports progress over all of its regions
+  if (progress_total_ > 0) {
+    bytes_transferred += progress_offset_;
+    total_bytes = progress_total_;
+  }
   result_.bytes_transferred = bytes_transferred;
   result_.total_bytes = total_bytes;
   
@@ -66,6 +75,14 @@ void ECUProgrammer::handle_failure(const std::string& error, NegativeResponseCod
   result_.last_nrc = nrc;
   update_state(ProgrammingState::Failed, error);
   
+  if (!config_.trace_dump_path.empty()) {
+    if (trace::Tracer::instance().dump(config_.trace_dump_path)) {
+      log("Trace written to " + config_.trace_dump_path);
+    } else {
+      log("Failed to write trace to " + config_.trace_dump_path);
+    }
+  }
+  
   if (config_.completion_callback) {
     config_.completion_callback(false, error);
   }
@@ -296,22 +313,32 @@ bool ECUProgrammer::step_request_download(uint32_t address, uint32_t size,
 // ================================================================
 
 bool ECUProgrammer::step_transfer_data(const std::vector<uint8_t>& firmware_data) {
+  MemoryFirmwareSource firmware(firmware_data);
+  return step_transfer_data(firmware);
+}
+
+bool ECUProgrammer::step_transfer_data(FirmwareSource& firmware) {
   update_state(ProgrammingState::TransferringData);
   
   if (max_block_length_ == 0) {
     handle_failure("Max block length not set", NegativeResponseCode::RequestSequenceError);
     return false;
   }
+  if (firmware.size() > UINT32_MAX) {
+    handle_failure("Firmware image exceeds 4 GB", NegativeResponseCode::RequestOutOfRange);
+    return false;
+  }
   
-  uint32_t total_bytes = firmware_data.size();
-  uint16_t total_blocks = calculate_block_count(total_bytes, max_block_length_);
+  // 32-bit block count: a 64 MB image in small blocks overflows uint16_t
+  uint32_t total_bytes = static_cast<uint32_t>(firmware.size());
+  uint32_t total_blocks = (total_bytes + max_block_length_ - 1) / max_block_length_;
   result_.total_bytes = total_bytes;
   result_.total_blocks = total_blocks;
   
   block_counter_ = config_.block_counter_start;
   uint32_t offset = 0;
   
-  for (uint16_t block_num = 0; block_num < total_blocks; ++block_num) {
+  for (uint32_t block_num = 0; block_num < total_blocks; ++block_num) {
     if (abort_requested_) {
       handle_failure("Transfer aborted by user", NegativeResponseCode::GeneralReject);
       return false;
@@ -321,9 +348,14 @@ bool ECUProgrammer::step_transfer_data(const std::vector<uint8_t>& firmware_data
     uint32_t remaining = total_bytes - offset;
     uint16_t block_size = (remaining < max_block_length_) ? remaining : max_block_length_;
     
-    // Extract block data
-    std::vector<uint8_t> block_data(firmware_data.begin() + offset,
-                                    firmware_data.begin() + offset + block_size);
+    // Borrow the block from the source; no per-block copy
+    ByteSpan block_data;
+    if (!firmware.read(offset, block_size, block_data)) {
+      std::ostringstream oss;
+      oss << "Failed to read firmware at offset " << offset;
+      handle_failure(oss.str());
+      return false;
+    }
     
     // Transfer with retry
     if (!transfer_block_with_retry(block_counter_, block_data)) {
@@ -351,9 +383,9 @@ bool ECUProgrammer::step_transfer_data(const std::vector<uint8_t>& firmware_data
   return true;
 }
 
-bool ECUProgrammer::transfer_block_with_retry(BlockCounter block, const std::vector<uint8_t>& block_data) {
+bool ECUProgrammer::transfer_block_with_retry(BlockCounter block, ByteSpan block_data) {
   for (uint8_t retry = 0; retry < config_.max_transfer_retries; ++retry) {
-    auto resp = client_.transfer_data(block, block_data);
+    auto resp = client_.transfer_data(block, block_data.data, block_data.size);
     
     if (resp.ok) {
       return true;
@@ -449,12 +481,224 @@ bool ECUProgrammer::step_ecu_reset(EcuResetType reset_type) {
   return true;
 }
 
+// ================================================================
+// Delta Flashing
+// ================================================================
+
+uint32_t FlashManifest::sector_length(size_t index) const {
+  const uint64_t offset = static_cast<uint64_t>(index) * sector_size;
+  if (offset >= image_size) {
+    return 0;
+  }
+  return static_cast<uint32_t>(std::min<uint64_t>(sector_size, image_size - offset));
+}
+
+bool FlashManifest::build(FirmwareSource& image, uint32_t start_address, uint32_t sector_size,
+                          FlashManifest& out) {
+  if (sector_size == 0 || image.size() > UINT32_MAX) {
+    return false;
+  }
+  out.start_address = start_address;
+  out.sector_size = sector_size;
+  out.image_size = static_cast<uint32_t>(image.size());
+  out.sector_crcs.clear();
+  for (uint64_t offset = 0; offset < image.size(); offset += sector_size) {
+    ByteSpan sector;
+    if (!image.read(offset, static_cast<size_t>(std::min<uint64_t>(sector_size, image.size() - offset)), sector)) {
+      return false;
+    }
+    out.sector_crcs.push_back(block::calculate_crc32(sector.data, sector.size, 0xFFFFFFFF) ^ 0xFFFFFFFF);
+  }
+  return true;
+}
+
+bool FlashManifest::save(const std::string& path) const {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  out << "uds-flash-manifest 1 " << std::hex << start_address << ' '
+      << std::dec << sector_size << ' ' << image_size << '\n' << std::hex;
+  for (size_t i = 0; i < sector_crcs.size(); ++i) {
+    if (sector_known(i)) {
+      out << std::setw(8) << std::setfill('0') << sector_crcs[i] << '\n';
+    } else {
+      out << "--------\n";
+    }
+  }
+  return static_cast<bool>(out.flush());
+}
+
+bool FlashManifest::load(const std::string& path) {
+  std::ifstream in(path);
+  std::string magic;
+  int version = 0;
+  FlashManifest m;
+  if (!(in >> magic >> version >> std::hex >> m.start_address >> std::dec >> m.sector_size >> m.image_size) ||
+      magic != "uds-flash-manifest" || version != 1 || m.sector_size == 0) {
+    return false;
+  }
+  const size_t count = (static_cast<uint64_t>(m.image_size) + m.sector_size - 1) / m.sector_size;
+  m.sector_crcs.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    std::string word;
+    if (!(in >> word)) {
+      return false;
+    }
+    if (word == "--------") {
+      m.unknown.resize(count);
+      m.unknown[i] = true;
+      continue;
+    }
+    char* end = nullptr;
+    const unsigned long crc = std::strtoul(word.c_str(), &end, 16);
+    if (*end != '\0' || crc > UINT32_MAX) {
+      return false;
+    }
+    m.sector_crcs[i] = static_cast<uint32_t>(crc);
+  }
+  *this = std::move(m);
+  return true;
+}
+
+bool ECUProgrammer::flash_changed_sectors(FirmwareSource& firmware, const FlashManifest& target) {
+  // A manifest only describes the ECU if it was taken with the same layout
+  const auto& installed = config_.installed_manifest;
+  const bool manifest_usable = installed && installed->start_address == target.start_address &&
+                               installed->sector_size == target.sector_size;
+  
+  // Changed sectors, merged into regions of adjacent sectors
+  struct Region { uint32_t offset; uint32_t size; };
+  std::vector<Region> regions;
+  std::vector<std::optional<uint32_t>> before(target.sector_count());
+  for (size_t i = 0; i < target.sector_count(); ++i) {
+    const uint32_t offset = static_cast<uint32_t>(i * target.sector_size);
+    const uint32_t length = target.sector_length(i);
+    
+    std::optional<uint32_t> current;
+    if (manifest_usable && i < installed->sector_count() && installed->sector_length(i) == length &&
+        installed->sector_known(i)) {
+      current = installed->sector_crcs[i];
+    } else if (config_.remote_crc) {
+      current = config_.remote_crc(target.start_address + offset, length);
+    }
+    before[i] = current;
+    if (current && *current == target.sector_crcs[i]) {
+      continue;
+    }
+    
+    result_.sectors_flashed++;
+    if (!regions.empty() && regions.back().offset + regions.back().size == offset) {
+      regions.back().size += length;
+    } else {
+      regions.push_back({offset, length});
+    }
+  }
+  result_.sectors_total = static_cast<uint32_t>(target.sector_count());
+  
+  std::ostringstream oss;
+  oss << "Delta: " << result_.sectors_flashed << " of " << result_.sectors_total
+      << " sectors changed, " << regions.size() << " region(s)";
+  log(oss.str());
+  if (regions.empty()) {
+    log("ECU already holds this image");
+    return true;
+  }
+  
+  // On failure, describe the ECU as the attempt left it: regions before the
+  // failed one hold the target image, the failed one is unknown and later
+  // ones keep their previous contents
+  auto record_failure = [&](size_t failed_region, bool touched) {
+    FlashManifest partial = target;
+    partial.unknown.assign(target.sector_count(), false);
+    for (size_t r = failed_region; r < regions.size(); ++r) {
+      const size_t first = regions[r].offset / target.sector_size;
+      const size_t last = (regions[r].offset + regions[r].size - 1) / target.sector_size;
+      for (size_t i = first; i <= last; ++i) {
+        if ((r == failed_region && touched) || !before[i]) {
+          partial.unknown[i] = true;
+          partial.sector_crcs[i] = 0;
+        } else {
+          partial.sector_crcs[i] = *before[i];
+        }
+      }
+    }
+    result_.manifest = std::move(partial);
+  };
+  
+  // Compress every region ahead of the first erase
+  std::vector<compression::CompressedImage> compressed(config_.compressor ? regions.size() : 0);
+  uint8_t data_format = config_.data_format_identifier;
+  uint32_t wire_total = 0;
+  for (size_t r = 0; r < regions.size(); ++r) {
+    if (config_.compressor) {
+      SliceFirmwareSource slice(firmware, regions[r].offset, regions[r].size);
+      if (!compression::compress_image(slice, *config_.compressor, config_.compression_options,
+                                       compressed[r])) {
+        record_failure(0, false);
+        handle_failure("Failed to read firmware for compression");
+        return false;
+      }
+      wire_total += static_cast<uint32_t>(compressed[r].data.size());
+    } else {
+      wire_total += regions[r].size;
+    }
+  }
+  if (config_.compressor) {
+    data_format = compression::data_format_identifier(*config_.compressor, data_format);
+  }
+  
+  progress_offset_ = 0;
+  progress_total_ = wire_total;
+  uint32_t total_blocks = 0;
+  for (size_t r = 0; r < regions.size(); ++r) {
+    const uint32_t address = target.start_address + regions[r].offset;
+    SliceFirmwareSource slice(firmware, regions[r].offset, regions[r].size);
+    std::optional<MemoryFirmwareSource> packed;
+    if (config_.compressor) {
+      packed.emplace(compressed[r].data);
+    }
+    FirmwareSource& wire = packed ? static_cast<FirmwareSource&>(*packed) : slice;
+    
+    // Step 5: Erase just this region
+    if (!config_.skip_erase &&
+        !step_erase_memory(config_.erase_routine_id,
+                           encode_address_and_size(address, regions[r].size, config_.address_length_format),
+                           config_.erase_timeout)) {
+      record_failure(r, true);
+      return false;
+    }
+    
+    // Steps 6-8 for the region
+    if (!step_request_download(address, regions[r].size, config_.address_length_format, data_format) ||
+        !step_transfer_data(wire) ||
+        !step_request_transfer_exit()) {
+      record_failure(r, true);
+      return false;
+    }
+    total_blocks += result_.total_blocks;
+    progress_offset_ += static_cast<uint32_t>(wire.size());
+  }
+  
+  result_.total_blocks = total_blocks;
+  result_.total_bytes = wire_total;
+  progress_offset_ = 0;
+  progress_total_ = 0;
+  return true;
+}
+
 // ================================================================
 // Main Programming Function
 // ================================================================
 
 ProgrammingResult ECUProgrammer::program_ecu(const std::vector<uint8_t>& firmware_data,
                                              const ProgrammingConfig& config) {
+  MemoryFirmwareSource firmware(firmware_data);
+  return program_ecu(firmware, config);
+}
+
+ProgrammingResult ECUProgrammer::program_ecu(FirmwareSource& firmware,
+                                             const ProgrammingConfig& config) {
   // Initialize
   config_ = config;
   result_ = ProgrammingResult{};
@@ -462,8 +706,47 @@ ProgrammingResult ECUProgrammer::program_ecu(const std::vector<uint8_t>& firmwar
   abort_requested_ = false;
   block_counter_ = config.block_counter_start;
   max_block_length_ = 0;
+  progress_offset_ = 0;
+  progress_total_ = 0;
   
   auto start_time = std::chrono::steady_clock::now();
+  result_.uncompressed_bytes = static_cast<uint32_t>(firmware.size());
+  
+  // Delta flashing: hash the new image's sectors before the session too
+  const bool delta = config.delta_sector_size > 0;
+  FlashManifest target;
+  if (delta) {
+    if (!firmware.seekable()) {
+      handle_failure("Delta flashing needs a seekable firmware source");
+      return result_;
+    }
+    if (!FlashManifest::build(firmware, config.start_address, config.delta_sector_size, target)) {
+      handle_failure("Failed to read firmware for sector hashes");
+      return result_;
+    }
+  }
+  
+  // Compress before opening the session so it cannot run into S3 or P2*
+  // timeouts; the ECU is sent the compressed stream in TransferData.
+  // Delta flashing compresses each changed region instead.
+  compression::CompressedImage compressed;
+  std::unique_ptr<MemoryFirmwareSource> compressed_source;
+  uint8_t data_format = config.data_format_identifier;
+  if (config.compressor && !delta) {
+    if (!compression::compress_image(firmware, *config.compressor, config.compression_options,
+                                     compressed)) {
+      handle_failure("Failed to read firmware for compression");
+      return result_;
+    }
+    compressed_source = std::make_unique<MemoryFirmwareSource>(compressed.data);
+    data_format = compression::data_format_identifier(*config.compressor, data_format);
+    
+    std::ostringstream oss;
+    oss << "Compressed " << compressed.original_size << " bytes to " << compressed.data.size()
+        << " (" << std::fixed << std::setprecision(1) << compressed.ratio() * 100.0 << "%)";
+    log(oss.str());
+  }
+  FirmwareSource& wire = compressed_source ? *compressed_source : firmware;
   
   // Step 1: Enter programming session
   if (!step_enter_programming_session()) {
@@ -478,8 +761,10 @@ ProgrammingResult ECUProgrammer::program_ecu(const std::vector<uint8_t>& firmwar
   }
   
   // Step 3: Disable DTC setting
-  if (!step_disable_dtc_setting()) {
-    return result_;
+  if (!config.skip_dtc_disable) {
+    if (!step_disable_dtc_setting()) {
+      return result_;
+    }
   }
   
   // Step 4: Disable communications (optional)
@@ -489,27 +774,36 @@ ProgrammingResult ECUProgrammer::program_ecu(const std::vector<uint8_t>& firmwar
     }
   }
   
-  // Step 5: Erase memory
-  if (!config.skip_erase) {
-    if (!step_erase_memory(config.erase_routine_id, config.erase_option_record, config.erase_timeout)) {
+  // Steps 5-8: erase, download and transfer the image, or only its
+  // changed sectors in delta mode
+  if (delta) {
+    if (!flash_changed_sectors(firmware, target)) {
+      return result_;
+    }
+  } else {
+    // Step 5: Erase memory
+    if (!config.skip_erase) {
+      if (!step_erase_memory(config.erase_routine_id, config.erase_option_record, config.erase_timeout)) {
+        return result_;
+      }
+    }
+    
+    // Step 6: Request download
+    // memorySize is the uncompressed size
+    if (!step_request_download(config.start_address, static_cast<uint32_t>(firmware.size()),
+                               config.address_length_format, data_format)) {
+      return result_;
+    }
+    
+    // Step 7: Transfer data
+    if (!step_transfer_data(wire)) {
+      return result_;
+    }
+    
+    // Step 8: Request transfer exit
+    if (!step_request_transfer_exit()) {
       return result_;
     }
-  }
-  
-  // Step 6: Request download
-  if (!step_request_download(config.start_address, firmware_data.size(),
-                             config.address_length_format, config.data_format_identifier)) {
-    return result_;
-  }
-  
-  // Step 7: Transfer data
-  if (!step_transfer_data(firmware_data)) {
-    return result_;
-  }
-  
-  // Step 8: Request transfer exit
-  if (!step_request_transfer_exit()) {
-    return result_;
   }
   
   // Step 9: Re-enable services
@@ -525,6 +819,9 @@ ProgrammingResult ECUProgrammer::program_ecu(const std::vector<uint8_t>& firmwar
   result_.elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
   result_.success = true;
   result_.final_state = ProgrammingState::Completed;
+  if (delta) {
+    result_.manifest = std::move(target);
+  }
   update_state(ProgrammingState::Completed, "Programming completed successfully");
   
   if (config.completion_callback) {
@@ -669,6 +966,35 @@ ProgrammingResult flash_ecu(Client& client,
   return programmer.program_ecu(firmware_data, config);
 }
 
+ProgrammingResult flash_ecu(Client& client,
+                            FirmwareSource& firmware,
+                            uint32_t start_address,
+                            const std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)>& key_calculator) {
+  ProgrammingConfig config;
+  config.start_address = start_address;
+  config.memory_size = static_cast<uint32_t>(firmware.size());
+  config.key_calculator = key_calculator;
+  
+  ECUProgrammer programmer(client);
+  return programmer.program_ecu(firmware, config);
+}
+
+std::function<std::optional<uint32_t>(uint32_t, uint32_t)>
+routine_crc_reader(Client& client, RoutineId routine_id, uint8_t addr_len_fmt) {
+  return [&client, routine_id, addr_len_fmt](uint32_t address, uint32_t size) -> std::optional<uint32_t> {
+    auto resp = client.routine_control(
+        RoutineAction::Start, routine_id,
+        ECUProgrammer::encode_address_and_size(address, size, addr_len_fmt));
+    // [routineControlType][routineIdentifier(2)][statusRecord ... CRC32]
+    if (!resp.ok || resp.payload.size() < 7) {
+      return std::nullopt;
+    }
+    const uint8_t* crc = resp.payload.data() + resp.payload.size() - 4;
+    return static_cast<uint32_t>(crc[0]) << 24 | static_cast<uint32_t>(crc[1]) << 16 |
+           static_cast<uint32_t>(crc[2]) << 8 | crc[3];
+  };
+}
+
 bool verify_ecu_memory([[maybe_unused]] Client& client,
                       [[maybe_unused]] uint32_t address,
                       [[maybe_unused]] const std::vector<uint8_t>& expected_data,
@@ -0,0 +1,353 @@
+#include "flash_orchestrator.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace uds {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+milliseconds since(Clock::time_point start) {
+  return std::chrono::duration_cast<milliseconds>(Clock::now() - start);
+}
+
+// Functional requests carry the suppressPosRspMsgIndicationBit, so Client
+// reports silence as success; a negative response means some ECU on the bus
+// refused, no NRC means the request could not be sent
+bool functional_request(Client& client, SID sid, const std::vector<uint8_t>& payload,
+                        const char* what, std::string& error) {
+  auto resp = client.exchange(sid, payload);
+  if (resp.ok) {
+    return true;
+  }
+  std::ostringstream oss;
+  if (resp.nrc.code != NegativeResponseCode{}) {
+    oss << what << " rejected with NRC 0x" << std::hex << std::uppercase << std::setw(2)
+        << std::setfill('0') << static_cast<int>(resp.nrc.code);
+  } else {
+    oss << what << " could not be sent";
+  }
+  if (!error.empty()) {
+    error += "; ";
+  }
+  error += oss.str();
+  return false;
+}
+
+// Shared by the jobs of one bus while run() is in progress
+struct BusState {
+  FlashBusConfig config;
+  FlashBusReport report;
+
+  std::mutex mutex;
+  std::condition_variable slot_freed;
+  uint32_t running{0};
+  Clock::time_point next_send{};  // Byte budget: when the bus is free again
+
+  void acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slot_freed.wait(lock, [&] {
+      return config.max_parallel_jobs == 0 || running < config.max_parallel_jobs;
+    });
+    ++running;
+  }
+
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --running;
+    }
+    slot_freed.notify_one();
+  }
+
+  // Book bytes just sent on the bus and wait until they fit the budget;
+  // jobs take turns because each booking starts where the last one ended
+  milliseconds throttle(uint64_t bytes) {
+    if (config.bytes_per_second == 0 || bytes == 0) {
+      return milliseconds(0);
+    }
+    const auto cost = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(bytes) / config.bytes_per_second));
+    const auto now = Clock::now();
+    Clock::time_point wake;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      next_send = std::max(next_send, now) + cost;
+      wake = next_send;
+    }
+    std::this_thread::sleep_until(wake);
+    return std::chrono::duration_cast<milliseconds>(wake - now);
+  }
+};
+
+struct JobState {
+  FlashJobReport report;
+  BusState* bus{nullptr};
+  bool running{false};
+  bool done{false};
+  uint64_t bytes{0};
+  uint64_t total{0};
+  ProgrammingState phase{ProgrammingState::Idle};
+  Clock::time_point phase_start{};
+
+  void close_phase(Clock::time_point now) {
+    if (phase != ProgrammingState::Idle) {
+      report.phases[phase] += std::chrono::duration_cast<milliseconds>(now - phase_start);
+    }
+    phase = ProgrammingState::Idle;
+  }
+};
+
+bool is_terminal(ProgrammingState state) {
+  return state == ProgrammingState::Completed || state == ProgrammingState::Failed ||
+         state == ProgrammingState::Aborted;
+}
+
+} // namespace
+
+// ================================================================
+// FlashOrchestrator
+// ================================================================
+
+void FlashOrchestrator::add_bus(const std::string& name, const FlashBusConfig& config) {
+  for (auto& bus : buses_) {
+    if (bus.name == name) {
+      bus.config = config;
+      return;
+    }
+  }
+  buses_.push_back({name, config});
+}
+
+void FlashOrchestrator::add_job(FlashJob job) {
+  jobs_.push_back(std::move(job));
+}
+
+FlashReport FlashOrchestrator::run() {
+  const auto run_start = Clock::now();
+  FlashReport report;
+
+  // Buses by name; jobs naming an unknown bus get an unlimited one
+  std::map<std::string, BusState> buses;
+  for (const auto& bus : buses_) {
+    buses[bus.name].config = bus.config;
+  }
+  for (const auto& job : jobs_) {
+    buses[job.bus];
+  }
+  for (auto& [name, bus] : buses) {
+    bus.report.name = name;
+  }
+
+  // Step 1: functional pre-steps, once per bus
+  for (auto& [name, bus] : buses) {
+    Client* functional = bus.config.functional;
+    if (!functional) {
+      continue;
+    }
+    std::string& error = bus.report.error;
+    bus.report.functional_presteps =
+      functional_request(*functional, SID::DiagnosticSessionControl, {0x83}, "ExtendedSession", error) &&
+      functional_request(*functional, SID::ControlDTCSetting, {0x82}, "ControlDTCSetting Off", error) &&
+      functional_request(*functional, SID::CommunicationControl, {0x83, 0xFF},
+                         "CommunicationControl DisableRxAndTx", error);
+  }
+
+  // Jobs in add order; those sharing a Client form one sequential group
+  std::vector<JobState> states(jobs_.size());
+  std::map<Client*, std::vector<size_t>> groups;
+  for (size_t i = 0; i < jobs_.size(); ++i) {
+    states[i].report.name = jobs_[i].name;
+    states[i].report.bus = jobs_[i].bus;
+    states[i].bus = &buses[jobs_[i].bus];
+    states[i].total = jobs_[i].firmware ? jobs_[i].firmware->size() : 0;
+    groups[jobs_[i].client].push_back(i);
+  }
+
+  std::mutex progress_mutex;
+  auto publish = [&](const std::function<void()>& update) {
+    std::lock_guard<std::mutex> lock(progress_mutex);
+    update();
+    if (!progress_callback_) {
+      return;
+    }
+    FlashProgress progress;
+    progress.jobs_total = states.size();
+    for (const auto& state : states) {
+      progress.jobs_running += state.running ? 1 : 0;
+      if (state.done) {
+        (state.report.result.success ? progress.jobs_succeeded : progress.jobs_failed)++;
+      }
+      progress.bytes_transferred += state.bytes;
+      progress.total_bytes += state.total;
+    }
+    progress_callback_(progress);
+  };
+
+  auto run_job = [&](size_t index) {
+    const FlashJob& job = jobs_[index];
+    JobState& state = states[index];
+
+    if (!job.client || !job.firmware) {
+      state.report.result.final_state = ProgrammingState::Failed;
+      state.report.result.error_message = "Job has no client or firmware";
+      publish([&] { state.done = true; });
+      return;
+    }
+
+    state.bus->acquire();
+    state.report.queued = since(run_start);
+    const auto job_start = Clock::now();
+    publish([&] { state.running = true; });
+
+    ProgrammingConfig config = job.config;
+    if (state.bus->report.functional_presteps) {
+      config.skip_dtc_disable = true;
+      config.skip_communication_disable = true;
+    }
+
+    auto user_state_callback = job.config.state_callback;
+    config.state_callback = [&, user_state_callback](ProgrammingState new_state, const std::string& message) {
+      const auto now = Clock::now();
+      state.close_phase(now);
+      if (!is_terminal(new_state)) {
+        state.phase = new_state;
+        state.phase_start = now;
+      }
+      if (user_state_callback) {
+        user_state_callback(new_state, message);
+      }
+    };
+
+    // Throttle by the bytes each block added; delta flashing reports
+    // progress across its regions, so the count only grows
+    auto user_progress_callback = job.config.progress_callback;
+    uint64_t sent = 0;
+    config.progress_callback = [&, user_progress_callback](uint32_t bytes_transferred, uint32_t total_bytes,
+                                                           float progress) {
+      if (user_progress_callback) {
+        user_progress_callback(bytes_transferred, total_bytes, progress);
+      }
+      if (bytes_transferred > sent) {
+        state.report.throttled += state.bus->throttle(bytes_transferred - sent);
+        sent = bytes_transferred;
+      }
+      publish([&] {
+        state.bytes = bytes_transferred;
+        state.total = total_bytes;
+      });
+    };
+
+    ECUProgrammer programmer(*job.client);
+    ProgrammingResult result = programmer.program_ecu(*job.firmware, config);
+    state.close_phase(Clock::now());
+    state.report.total = since(job_start);
+    state.bus->release();
+
+    publish([&] {
+      state.report.result = std::move(result);
+      state.running = false;
+      state.done = true;
+    });
+  };
+
+  // Step 2: functional TesterPresent keeps the bus quiet while jobs run
+  std::mutex keep_alive_mutex;
+  std::condition_variable keep_alive_stop;
+  bool stopping = false;
+  std::thread keep_alive([&] {
+    std::unique_lock<std::mutex> lock(keep_alive_mutex);
+    while (!keep_alive_stop.wait_for(lock, tester_present_interval_, [&] { return stopping; })) {
+      lock.unlock();
+      for (auto& [name, bus] : buses) {
+        if (bus.report.functional_presteps) {
+          bus.config.functional->tester_present(true);
+        }
+      }
+      lock.lock();
+    }
+  });
+
+  // Step 3: one thread per Client
+  std::vector<std::thread> workers;
+  for (const auto& [client, indices] : groups) {
+    workers.emplace_back([&run_job, &indices] {
+      for (size_t index : indices) {
+        run_job(index);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(keep_alive_mutex);
+    stopping = true;
+  }
+  keep_alive_stop.notify_all();
+  keep_alive.join();
+
+  // Step 4: functional post-steps, best effort (ECUs that were reset
+  // are back in the default session anyway)
+  for (auto& [name, bus] : buses) {
+    Client* functional = bus.config.functional;
+    if (!functional) {
+      continue;
+    }
+    std::string& error = bus.report.error;
+    functional_request(*functional, SID::CommunicationControl, {0x80, 0xFF},
+                       "CommunicationControl EnableRxAndTx", error);
+    functional_request(*functional, SID::ControlDTCSetting, {0x81}, "ControlDTCSetting On", error);
+    functional_request(*functional, SID::DiagnosticSessionControl, {0x81}, "DefaultSession", error);
+  }
+
+  report.success = true;
+  for (auto& state : states) {
+    report.success = report.success && state.report.result.success;
+    report.jobs.push_back(std::move(state.report));
+  }
+  for (auto& [name, bus] : buses) {
+    report.buses.push_back(std::move(bus.report));
+  }
+  report.elapsed = since(run_start);
+  return report;
+}
+
+// ================================================================
+// Report Formatting
+// ================================================================
+
+std::string format_flash_report(const FlashReport& report) {
+  std::ostringstream oss;
+  oss << (report.success ? "All jobs succeeded" : "Some jobs failed")
+      << " in " << report.elapsed.count() << " ms\n";
+
+  for (const auto& bus : report.buses) {
+    if (!bus.error.empty()) {
+      oss << "Bus " << (bus.name.empty() ? "(default)" : bus.name) << ": " << bus.error << "\n";
+    }
+  }
+
+  for (const auto& job : report.jobs) {
+    oss << job.name << ": " << (job.result.success ? "OK" : "FAILED");
+    if (!job.result.success && !job.result.error_message.empty()) {
+      oss << " (" << job.result.error_message << ")";
+    }
+    oss << ", " << job.result.bytes_transferred << " bytes in " << job.total.count() << " ms"
+        << " (queued " << job.queued.count() << " ms, throttled " << job.throttled.count() << " ms)\n";
+    for (const auto& [phase, time] : job.phases) {
+      oss << "  " << std::left << std::setw(30) << ECUProgrammer::state_name(phase)
+          << std::right << time.count() << " ms\n";
+    }
+  }
+  return oss.str();
+}
+
+} // namespace uds
@@ -1,4 +1,6 @@
 #include "isotp.hpp"
+#include "uds_trace.hpp"
+#include <algorithm>
 #include <thread>
 #include <cstring>
 
@@ -31,14 +33,59 @@ uint32_t Transport::calculate_stmin_delay(uint8_t stmin_value) const {
   return 0; // Invalid/reserved values
 }
 
+bool ICanDriver::recv_cancellable(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout,
+                                  uds::CancellationToken& cancel) {
+  constexpr std::chrono::milliseconds kSlice{5};
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  for (;;) {
+    if (cancel.is_cancelled()) return false;
+    const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    const auto slice = std::max(std::chrono::milliseconds(0), std::min(left, kSlice));
+    if (recv(f, slice)) return true;
+    if (left <= slice) return false;
+  }
+}
+
+// Driver access with trace capture of every frame on the wire. Receives
+// honour the calling thread's CancelScope.
+bool Transport::send_frame(const CANProtocol::CANFrame& f) {
+  if (!drv_.send(f)) return false;
+  uds::trace::record_can(uds::trace::Direction::Tx, f);
+  return true;
+}
+
+bool Transport::recv_frame(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout) {
+  uds::CancellationToken* cancel = uds::CancelScope::current();
+  if (cancel ? !drv_.recv_cancellable(f, timeout, *cancel) : !drv_.recv(f, timeout)) return false;
+  uds::trace::record_can(uds::trace::Direction::Rx, f);
+  return true;
+}
+
 bool Transport::request_response(const std::vector<uint8_t>& tx,
                                  std::vector<uint8_t>& rx,
                                  std::chrono::milliseconds timeout) {
+  last_timing_ = uds::TransferTiming{};
+  last_timing_.tx_start = std::chrono::steady_clock::now();
   if (!send_sdu(tx, timeout)) return false;
+  last_timing_.tx_end = std::chrono::steady_clock::now();
   return recv_sdu(rx, timeout);
 }
 
+bool Transport::send_suppressed(const std::vector<uint8_t>& tx,
+                                std::vector<uint8_t>& rx,
+                                std::chrono::milliseconds timeout) {
+  last_timing_ = uds::TransferTiming{};
+  last_timing_.tx_start = std::chrono::steady_clock::now();
+  if (!send_sdu(tx, timeout)) return false;
+  last_timing_.tx_end = std::chrono::steady_clock::now();
+  if (!recv_sdu(rx, timeout)) rx.clear();
+  return true;
+}
+
 bool Transport::recv_only(std::vector<uint8_t>& rx, std::chrono::milliseconds timeout) {
+  last_timing_ = uds::TransferTiming{};
+  last_timing_.tx_start = last_timing_.tx_end = std::chrono::steady_clock::now();
   return recv_sdu(rx, timeout);
 }
 
@@ -55,7 +102,7 @@ bool Transport::send_sdu(const std::vector<uint8_t>& sdu, [[maybe_unused]] std::
     CANFrame f{}; f.id = addr_.tx_can_id; f.dlc = 8;
     f.data[0] = uint8_t(PCI_SF | (len & 0x0F));
     std::memcpy(&f.data[1], sdu.data(), len);
-    return drv_.send(f);
+    return send_frame(f);
   }
 
   // First Frame
@@ -66,7 +113,7 @@ bool Transport::send_sdu(const std::vector<uint8_t>& sdu, [[maybe_unused]] std::
   size_t idx = 0;
   const size_t first_copy = 6; // bytes available in FF
   std::memcpy(&f.data[2], &sdu[idx], first_copy); idx += first_copy;
-  if (!drv_.send(f)) return false;
+  if (!send_frame(f)) return false;
 
   // Wait for FC from receiver with N_Bs timeout and WT handling
   auto fc_deadline = std::chrono::steady_clock::now() + timings_.N_Bs;
@@ -96,7 +143,7 @@ bool Transport::send_sdu(const std::vector<uint8_t>& sdu, [[maybe_unused]] std::
     const size_t chunk = std::min(static_cast<size_t>(7), len - idx);
     std::memcpy(&cf.data[1], &sdu[idx], chunk);
     idx += chunk;
-    if (!drv_.send(cf)) return false;
+    if (uds::CancelScope::cancelled() || !send_frame(cf)) return false;
     sn = (uint8_t)((sn + 1) & 0x0F);
 
     ++sent_in_block;
@@ -136,8 +183,8 @@ bool Transport::wait_for_flow_control(CANProtocol::CANFrame& fc,
     const auto now = std::chrono::steady_clock::now();
     if (now >= deadline) return false;
     
-    const auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
-    if (!drv_.recv(fc, remain)) return false;
+    const auto remain = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+    if (!recv_frame(fc, remain)) return false;
     
     // Filter by CAN ID
     if (fc.id != addr_.rx_can_id) continue;
@@ -177,16 +224,19 @@ bool Transport::recv_sdu(std::vector<uint8_t>& sdu, std::chrono::milliseconds ti
   for (;;) {
     const auto now = std::chrono::steady_clock::now();
     if (now >= deadline) return false;
-    const auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
-    if (!drv_.recv(f, remain)) return false;
+    const auto remain = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+    if (!recv_frame(f, remain)) return false;
     if (f.id != addr_.rx_can_id) continue; // filter others
     break;
   }
+  last_timing_.rx_first = std::chrono::steady_clock::now();
 
   const uint8_t pci = f.data[0] & 0xF0;
   if (pci == PCI_SF) {
     const uint8_t len = f.data[0] & 0x0F;
     sdu.assign(&f.data[1], &f.data[1] + len);
+    last_timing_.rx_end = last_timing_.rx_first;
+    last_timing_.valid = true;
     return true;
   }
 
@@ -201,7 +251,7 @@ bool Transport::recv_sdu(std::vector<uint8_t>& sdu, std::chrono::milliseconds ti
   fc.data[0] = uint8_t(PCI_FC | FC_CTS);
   fc.data[1] = block_size_;
   fc.data[2] = stmin_;
-  if (!drv_.send(fc)) return false;
+  if (!send_frame(fc)) return false;
 
   uint8_t expect_sn = 1;
   uint8_t frames_in_block = 0;
@@ -209,11 +259,11 @@ bool Transport::recv_sdu(std::vector<uint8_t>& sdu, std::chrono::milliseconds ti
   while (sdu.size() < total) {
     // Use N_Cr timeout between consecutive frames
     const auto cf_deadline = std::chrono::steady_clock::now() + timings_.N_Cr;
-    const auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+    const auto remain = std::chrono::ceil<std::chrono::milliseconds>(
       cf_deadline - std::chrono::steady_clock::now());
     
     CANFrame cf{};
-    if (!drv_.recv(cf, remain)) return false;
+    if (!recv_frame(cf, remain)) return false;
     if (cf.id != addr_.rx_can_id) continue;
     if ((cf.data[0] & 0xF0) != PCI_CF) continue;
     
@@ -234,10 +284,12 @@ bool Transport::recv_sdu(std::vector<uint8_t>& sdu, std::chrono::milliseconds ti
       fc.data[0] = uint8_t(PCI_FC | FC_CTS);
       fc.data[1] = block_size_;
       fc.data[2] = stmin_;
-      if (!drv_.send(fc)) return false;
+      if (!send_frame(fc)) return false;
     }
   }
 
+  last_timing_.rx_end = std::chrono::steady_clock::now();
+  last_timing_.valid = true;
   return true;
 }
 
@@ -67,6 +67,14 @@ bool SerialDriver::open_serial(const std::string& device) {
   }
 
   tcflush(fd_, TCIOFLUSH);
+
+  // Wake pipe for cancellable receives; without it they fall back to polling
+  if (::pipe(wake_pipe_) == 0) {
+    fcntl(wake_pipe_[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe_[1], F_SETFL, O_NONBLOCK);
+  } else {
+    wake_pipe_[0] = wake_pipe_[1] = -1;
+  }
   return true;
 }
 
@@ -79,6 +87,16 @@ void SerialDriver::close_serial() {
     fd_ = -1;
     termios_saved_ = false;
   }
+  for (int& end : wake_pipe_) {
+    if (end >= 0) ::close(end);
+    end = -1;
+  }
+}
+
+void SerialDriver::drain_wake_pipe() {
+  uint8_t buf[16];
+  while (wake_pipe_[0] >= 0 && ::read(wake_pipe_[0], buf, sizeof(buf)) > 0) {
+  }
 }
 
 ssize_t SerialDriver::read_raw(uint8_t* buf, size_t maxlen, std::chrono::milliseconds timeout) {
@@ -91,9 +109,15 @@ ssize_t SerialDriver::read_raw(uint8_t* buf, size_t maxlen, std::chrono::millise
 
   FD_ZERO(&rfds);
   FD_SET(fd_, &rfds);
+  const int wake_fd = cancel_ ? wake_pipe_[0] : -1;
+  if (wake_fd >= 0) FD_SET(wake_fd, &rfds);
 
-  int ret = select(fd_ + 1, &rfds, nullptr, nullptr, &tv);
+  int ret = select(std::max(fd_, wake_fd) + 1, &rfds, nullptr, nullptr, &tv);
   if (ret <= 0) return ret; // timeout or error
+  if (!FD_ISSET(fd_, &rfds)) {
+    drain_wake_pipe();      // woken by cancel()
+    return -1;
+  }
 
   return ::read(fd_, buf, maxlen);
 }
@@ -214,6 +238,7 @@ bool SerialDriver::recv(CANProtocol::CANFrame& f, std::chrono::milliseconds time
   for (;;) {
     auto now = std::chrono::steady_clock::now();
     if (now >= deadline) return false;
+    if (cancel_ && cancel_->is_cancelled()) return false;
     auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
 
     if (read_and_buffer_frames(remain)) {
@@ -227,6 +252,21 @@ bool SerialDriver::recv(CANProtocol::CANFrame& f, std::chrono::milliseconds time
   }
 }
 
+bool SerialDriver::recv_cancellable(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout,
+                                    uds::CancellationToken& cancel) {
+  if (wake_pipe_[1] < 0) return isotp::ICanDriver::recv_cancellable(f, timeout, cancel);
+
+  drain_wake_pipe();
+  uds::CancelWake wake(&cancel, [this] {
+    const uint8_t byte = 1;
+    (void)!::write(wake_pipe_[1], &byte, 1);
+  });
+  cancel_ = &cancel;
+  const bool ok = recv(f, timeout);
+  cancel_ = nullptr;
+  return ok;
+}
+
 // Enhanced frame operations
 bool SerialDriver::send_can_frame(const CanFrame& frame) {
   // Check TX queue capacity (back-pressure)
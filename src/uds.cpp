@@ -1,34 +1,578 @@
 #include "uds.hpp"
 #include "isotp.hpp"  // For dynamic_cast to isotp::Transport
 #include "nrc.hpp"    // For NRC action-based handling
+#include "uds_metrics.hpp"
+#include "uds_trace.hpp"
 #include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <algorithm>
+#include <exception>
+#include <type_traits>
+#include <deque>
+#include <unordered_map>
 
 namespace uds {
 
 static inline void sleep_for_min_gap(const Timings& t){ if (t.req_gap.count()>0) std::this_thread::sleep_for(t.req_gap); }
 
+// ================================================================
+// Transport arbitration
+// ================================================================
+namespace detail {
+
+// FIFO request queue of one transport. Callers enqueue a job; whoever finds
+// the transport free becomes the drainer and executes queued jobs in order
+// (its own first), completing them on behalf of the waiting callers. After
+// kMaxCombine jobs the drainer hands the queue to the next waiter so no
+// caller is held hostage by a long queue. Jobs live on the callers' stacks,
+// so enqueueing never allocates.
+class ExchangeQueue {
+public:
+  static constexpr size_t kMaxCombine = 16;
+
+  // Runs fn with exclusive use of the transport. Returns false, without
+  // running fn, if the deadline passes or cancel is cancelled while the job
+  // is still queued. A passive job (listening for unsolicited PDUs) does not
+  // make the queue non-idle while it runs.
+  template <typename Fn>
+  bool run(Fn&& fn, std::chrono::steady_clock::time_point deadline =
+                        std::chrono::steady_clock::time_point::max(),
+           CancellationToken* cancel = nullptr, bool passive = false) {
+    Job job;
+    job.passive = passive;
+    job.ctx = &fn;
+    job.invoke = [](void* ctx) { (*static_cast<std::remove_reference_t<Fn>*>(ctx))(); };
+    // Registered before locking: cancel() runs the hook, which takes our lock
+    CancelWake wake(cancel, [this, &job] {
+      std::lock_guard<std::mutex> guard(mutex_);
+      job.cv.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cancel && cancel->is_cancelled()) return false;
+    push_back(&job);
+    if (busy_) {
+      auto ready = [&job] { return job.done || job.promoted; };
+      auto ready_or_cancelled = [&job, cancel] {
+        return job.done || job.promoted || (cancel && cancel->is_cancelled());
+      };
+      if (deadline == std::chrono::steady_clock::time_point::max()) {
+        job.cv.wait(lock, ready_or_cancelled);
+      } else {
+        job.cv.wait_until(lock, deadline, ready_or_cancelled);
+      }
+      if (!ready() && !job.started) {
+        // Deadline passed or cancelled before the drainer reached us
+        unlink(&job);
+        return false;
+      }
+      // Already being executed by the drainer; it must finish with our job
+      job.cv.wait(lock, ready);
+    } else {
+      busy_ = true;
+    }
+    if (!job.done) {
+      drain(lock, job);
+    }
+    if (job.error) {
+      std::rethrow_exception(job.error);
+    }
+    return true;
+  }
+
+  bool idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (!busy_ || passive_running_) && head_ == nullptr;
+  }
+
+  size_t queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (const Job* j = head_; j; j = j->next) ++n;
+    return n;
+  }
+
+private:
+  struct Job {
+    void (*invoke)(void*) = nullptr;
+    void* ctx = nullptr;
+    Job* next = nullptr;
+    bool started = false;
+    bool done = false;
+    bool promoted = false;
+    bool passive = false;
+    std::exception_ptr error;
+    std::condition_variable cv;
+  };
+
+  void push_back(Job* job) {
+    if (tail_) tail_->next = job; else head_ = job;
+    tail_ = job;
+  }
+
+  Job* pop_front() {
+    Job* job = head_;
+    head_ = job->next;
+    if (!head_) tail_ = nullptr;
+    job->started = true;
+    return job;
+  }
+
+  void unlink(Job* job) {
+    Job* prev = nullptr;
+    for (Job* j = head_; j; prev = j, j = j->next) {
+      if (j != job) continue;
+      (prev ? prev->next : head_) = j->next;
+      if (tail_ == j) tail_ = prev;
+      return;
+    }
+  }
+
+  // Called with the lock held and 'own' at the head of the queue
+  void drain(std::unique_lock<std::mutex>& lock, Job& own) {
+    size_t served = 0;
+    while (head_) {
+      if (own.done && served >= kMaxCombine) {
+        // Hand over: the next waiter becomes the drainer (busy_ stays set)
+        head_->promoted = true;
+        head_->cv.notify_one();
+        return;
+      }
+      Job* job = pop_front();
+      passive_running_ = job->passive;
+      lock.unlock();
+      try {
+        job->invoke(job->ctx);
+      } catch (...) {
+        job->error = std::current_exception();
+      }
+      lock.lock();
+      passive_running_ = false;
+      job->done = true;
+      // Notify under the lock: the waiter destroys its Job once it sees done
+      if (job != &own) job->cv.notify_one();
+      ++served;
+    }
+    busy_ = false;
+  }
+
+  mutable std::mutex mutex_;
+  bool busy_ = false;
+  bool passive_running_ = false;
+  Job* head_ = nullptr;
+  Job* tail_ = nullptr;
+};
+
+} // namespace detail
+
+Transport::Transport() : queue_(std::make_shared<detail::ExchangeQueue>()) {}
+
+// ================================================================
+// Exchange deadlines
+// ================================================================
+namespace {
+thread_local ExchangeScope::time_point tls_exchange_deadline = ExchangeScope::time_point::max();
+}
+
+ExchangeScope::ExchangeScope(time_point deadline) : previous_(tls_exchange_deadline) {
+  tls_exchange_deadline = std::min(previous_, deadline);
+}
+
+ExchangeScope::~ExchangeScope() { tls_exchange_deadline = previous_; }
+
+ExchangeScope::time_point ExchangeScope::current() { return tls_exchange_deadline; }
+
+bool ExchangeScope::expired() {
+  return tls_exchange_deadline != time_point::max() &&
+         std::chrono::steady_clock::now() >= tls_exchange_deadline;
+}
+
+// ================================================================
+// Cooperative cancellation
+// ================================================================
+void CancellationToken::cancel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cancelled_.store(true, std::memory_order_release);
+  cv_.notify_all();
+  for (auto& hook : hooks_) hook.second();
+}
+
+bool CancellationToken::wait_for(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return cv_.wait_for(lock, timeout, [this] { return is_cancelled(); });
+}
+
+uint64_t CancellationToken::add_wake_hook(std::function<void()> hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (is_cancelled()) hook();
+  hooks_.emplace_back(next_hook_, std::move(hook));
+  return next_hook_++;
+}
+
+void CancellationToken::remove_wake_hook(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  hooks_.erase(std::remove_if(hooks_.begin(), hooks_.end(),
+                              [id](const auto& h) { return h.first == id; }),
+               hooks_.end());
+}
+
+namespace {
+thread_local CancellationToken* tls_cancel_token = nullptr;
+}
+
+CancelScope::CancelScope(CancellationToken* token) : previous_(tls_cancel_token) {
+  if (token) tls_cancel_token = token;
+}
+
+CancelScope::~CancelScope() { tls_cancel_token = previous_; }
+
+CancellationToken* CancelScope::current() { return tls_cancel_token; }
+
+bool CancelScope::cancelled() { return tls_cancel_token && tls_cancel_token->is_cancelled(); }
+
+// Clamp a wait to the time left before deadline (zero once it has passed)
+static std::chrono::milliseconds clamp_to_deadline(std::chrono::milliseconds wait,
+                                                   std::chrono::steady_clock::time_point deadline) {
+  if (deadline == std::chrono::steady_clock::time_point::max()) return wait;
+  const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+  if (left.count() <= 0) return std::chrono::milliseconds(0);
+  return std::min(wait, left);
+}
+
+bool Transport::idle() const { return queue_->idle(); }
+
+namespace detail {
+// Test hook, declared only in tests/gtest/test_util.hpp: exchanges waiting
+// for the transport behind the one running
+size_t queued_exchanges(const Transport& transport) {
+  return transport.exchange_queue().queued();
+}
+} // namespace detail
+
+// ================================================================
+// Single-flight coalescing of identical read-only requests
+// ================================================================
+namespace detail {
+
+class RequestCoalescer {
+public:
+  // Joiners wait under their own deadline and cancellation token, not the
+  // leader's: each returns a failed result once its own scope ends. A leader
+  // that failed because its deadline passed or it was cancelled does not
+  // publish that failure; its joiners retry, one of them leading.
+  template <typename Fn>
+  PositiveOrNegative run(std::string key, Fn&& fn) {
+    const auto deadline = ExchangeScope::current();
+    CancellationToken* const cancel = CancelScope::current();
+    // Registered before locking: cancel() runs the hook, which takes our lock
+    CancelWake wake(cancel, [this] {
+      std::lock_guard<std::mutex> guard(mutex_);
+      cv_.notify_all();
+    });
+
+    bool joined = false;
+    for (;;) {
+      std::shared_ptr<Flight> flight;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = in_flight_.find(key);
+        if (it != in_flight_.end()) {
+          // Join the running exchange and wait for its result
+          flight = it->second;
+          if (!joined) {
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            joined = true;
+          }
+          auto settled = [&flight, cancel] {
+            return flight->done || (cancel && cancel->is_cancelled());
+          };
+          if (deadline == std::chrono::steady_clock::time_point::max()) {
+            cv_.wait(lock, settled);
+          } else {
+            cv_.wait_until(lock, deadline, settled);
+          }
+          if (!flight->done) return PositiveOrNegative{};  // Own deadline or cancel
+          if (flight->abandoned) continue;
+          return flight->result;
+        }
+        flight = std::make_shared<Flight>();
+        in_flight_.emplace(key, flight);
+      }
+
+      PositiveOrNegative result{};
+      try {
+        result = fn();
+      } catch (...) {
+        complete(key, flight, PositiveOrNegative{}, true);
+        throw;
+      }
+      const bool own_failure = !result.ok && (ExchangeScope::expired() || CancelScope::cancelled());
+      complete(key, flight, result, own_failure);
+      return result;
+    }
+  }
+
+  std::atomic<bool> enabled{true};
+  std::atomic<uint64_t> coalesced{0};
+
+private:
+  struct Flight {
+    bool done{false};
+    bool abandoned{false};  // Result not valid for joiners
+    PositiveOrNegative result{};
+  };
+
+  void complete(const std::string& key, const std::shared_ptr<Flight>& flight,
+                const PositiveOrNegative& result, bool abandoned) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      flight->result = result;
+      flight->abandoned = abandoned;
+      flight->done = true;
+      in_flight_.erase(key);
+    }
+    cv_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, std::shared_ptr<Flight>> in_flight_;
+};
+
+} // namespace detail
+
+// ================================================================
+// Unsolicited inbox
+// ================================================================
+namespace detail {
+
+class UnsolicitedInbox {
+public:
+  void push(std::vector<uint8_t> pdu) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pdus_.size() >= Client::kUnsolicitedInboxCapacity) {
+      pdus_.pop_front();
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    pdus_.push_back(std::move(pdu));
+  }
+
+  bool pop(uint8_t response_sid, std::vector<uint8_t>& pdu) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = pdus_.begin(); it != pdus_.end(); ++it) {
+      if ((*it)[0] != response_sid) continue;
+      pdu = std::move(*it);
+      pdus_.erase(it);
+      return true;
+    }
+    return false;
+  }
+
+  std::atomic<uint64_t> dropped{0};
+
+private:
+  std::mutex mutex_;
+  std::deque<std::vector<uint8_t>> pdus_;
+};
+
+} // namespace detail
+
+// ECU-initiated positive responses that can interleave with a conversation
+static inline bool is_unsolicited_response(uint8_t sid_rx) {
+  return sid_rx == 0x6A || sid_rx == 0xC6;
+}
+
+// Requests whose subfunction has the suppressPosRspMsgIndicationBit set;
+// only services with a subfunction parameter define the bit
+static inline bool suppresses_positive_response(SID sid, const std::vector<uint8_t>& tx) {
+  if (tx.size() < 2 || !(tx[1] & 0x80)) return false;
+  switch (sid) {
+    case SID::DiagnosticSessionControl:
+    case SID::ECUReset:
+    case SID::SecurityAccess:
+    case SID::CommunicationControl:
+    case SID::Authentication:
+    case SID::DynamicallyDefineDataIdentifier:
+    case SID::RoutineControl:
+    case SID::TesterPresent:
+    case SID::AccessTimingParameters:
+    case SID::ControlDTCSetting:
+    case SID::ResponseOnEvent:
+    case SID::LinkControl:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Services without side effects on the ECU; identical concurrent requests
+// must yield the same response and can share one bus exchange.
+static inline bool is_coalescable(SID sid) {
+  switch (sid) {
+    case SID::ReadDataByIdentifier:
+    case SID::ReadDTCInformation:
+    case SID::ReadMemoryByAddress:
+    case SID::ReadScalingDataByIdentifier:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Client::Client(Transport& t, Timings timings)
+  : t_(t), timings_(timings), coalescer_(std::make_shared<detail::RequestCoalescer>()),
+    inbox_(std::make_shared<detail::UnsolicitedInbox>()) {}
+
+bool Client::pop_unsolicited(uint8_t response_sid, std::vector<uint8_t>& pdu) {
+  return inbox_->pop(response_sid, pdu);
+}
+
+uint64_t Client::unsolicited_dropped() const {
+  return inbox_->dropped.load(std::memory_order_relaxed);
+}
+
+void Client::set_timings(const Timings& t) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  timings_ = t;
+}
+
+Timings Client::timings() const {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  return timings_;
+}
+
+Client::CommunicationState Client::communication_state() const {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  return comm_state_;
+}
+
+void Client::reset_communication_state() {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  comm_state_ = CommunicationState{};
+}
+
+bool Client::is_dtc_setting_enabled() const {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  return dtc_setting_enabled_;
+}
+
+void Client::reset_dtc_setting_state() {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  dtc_setting_enabled_ = true;
+}
+
+void Client::set_request_coalescing(bool enabled) { coalescer_->enabled.store(enabled); }
+bool Client::request_coalescing() const { return coalescer_->enabled.load(); }
+uint64_t Client::coalesced_exchanges() const { return coalescer_->coalesced.load(std::memory_order_relaxed); }
+
 // Core exchange: build [SID | payload], perform transport request/response,
 // parse positive or negative response and return structured result.
 // Automatically handles NRC 0x78 (ResponsePending) and 0x21 (BusyRepeatRequest).
 PositiveOrNegative Client::exchange(SID sid,
                                     const std::vector<uint8_t>& req_payload,
                                     std::chrono::milliseconds timeout) {
-  PositiveOrNegative out{};
   std::vector<uint8_t> tx; tx.reserve(1 + req_payload.size());
   tx.push_back(static_cast<uint8_t>(sid));
   tx.insert(tx.end(), req_payload.begin(), req_payload.end());
 
-  if (timeout.count() == 0) timeout = timings_.p2; // default
+  if (!is_coalescable(sid) || !coalescer_->enabled.load(std::memory_order_relaxed)) {
+    return measured_exchange(sid, tx, timeout);
+  }
+
+  // Key: target CAN ID + SID + payload
+  const uint32_t target = t_.address().tx_can_id;
+  std::string key;
+  key.reserve(5 + req_payload.size());
+  key.append(reinterpret_cast<const char*>(&target), sizeof(target));
+  key.push_back(static_cast<char>(sid));
+  key.append(req_payload.begin(), req_payload.end());
+
+  return coalescer_->run(std::move(key), [&]() {
+    return measured_exchange(sid, tx, timeout);
+  });
+}
+
+// Runs one exchange with exclusive use of the transport (queued FIFO behind
+// exchanges of other threads) and records its latency if metrics are set.
+PositiveOrNegative Client::measured_exchange(SID sid,
+                                             const std::vector<uint8_t>& tx,
+                                             std::chrono::milliseconds timeout) {
+  PositiveOrNegative out{};
+  // Deadline and token are thread-scoped, and the exchange may run on the
+  // drainer's thread
+  const auto deadline = ExchangeScope::current();
+  CancellationToken* const cancel = CancelScope::current();
+  t_.exchange_queue().run([&]() {
+    CancelScope scope(cancel);
+    if (!metrics_) {
+      out = exchange_impl(sid, tx, timeout, deadline, nullptr);
+      return;
+    }
+    metrics::ExchangeSample sample{};
+    const auto start = std::chrono::steady_clock::now();
+    out = exchange_impl(sid, tx, timeout, deadline, &sample);
+    sample.total = std::chrono::steady_clock::now() - start;
+    sample.ok = out.ok;
+    metrics_->record(static_cast<uint8_t>(sid), t_.address().tx_can_id, sample);
+  }, deadline, cancel);
+  return out;
+}
+
+PositiveOrNegative Client::exchange_impl(SID sid,
+                                         const std::vector<uint8_t>& tx,
+                                         std::chrono::milliseconds timeout,
+                                         std::chrono::steady_clock::time_point deadline,
+                                         metrics::ExchangeSample* sample) {
+  using clock = std::chrono::steady_clock;
 
-  sleep_for_min_gap(timings_);
+  PositiveOrNegative out{};
+  const Timings timings = this->timings();
+  if (timeout.count() == 0) timeout = timings.p2; // default
+
+  sleep_for_min_gap(timings);
+  timeout = clamp_to_deadline(timeout, deadline);
+  if (CancelScope::cancelled()) return out;
+  if (timeout.count() == 0) {
+    if (sample) sample->timed_out = true;
+    return out; // deadline passed before the request was sent
+  }
   std::vector<uint8_t> rx;
-  if (!t_.request_response(tx, rx, timeout)) {
+  trace::record_pdu(trace::Direction::Tx, t_.address().tx_can_id, tx);
+  const auto wire_start = clock::now();
+  // With the positive response suppressed, only a negative response is
+  // awaited and silence means success
+  const bool suppressed = suppresses_positive_response(sid, tx);
+  const bool got_response = suppressed ? t_.send_suppressed(tx, rx, timeout)
+                                       : t_.request_response(tx, rx, timeout);
+
+  // Split the wire time into phases when the transport reports frame timing;
+  // otherwise everything between request and response counts as ECU time.
+  TransferTiming tt{};
+  clock::time_point pending_start{};
+  if (sample) {
+    if (got_response && t_.last_transfer_timing(tt) && tt.valid) {
+      sample->tx = tt.tx_end - tt.tx_start;
+      sample->ecu_think = tt.rx_first - tt.tx_end;
+      sample->rx_reassembly = tt.rx_end - tt.rx_first;
+    } else {
+      sample->ecu_think = clock::now() - wire_start;
+    }
+  }
+
+  if (!got_response) {
+    if (sample) sample->timed_out = true;
     return out; // ok=false
   }
-  if (rx.empty()) return out;
+  if (rx.empty()) {
+    out.ok = suppressed; // suppressed: sent and no ECU objected
+    return out;
+  }
 
   // Handle NRCs (0x7F) including 0x78 (ResponsePending) and 0x21 (BusyRepeatRequest)
   for (;;) {
+    trace::record_pdu(trace::Direction::Rx, t_.address().rx_can_id, rx);
     const uint8_t sid_rx = rx[0];
 
     if (sid_rx == 0x7F) { // Negative Response
@@ -39,20 +583,36 @@ PositiveOrNegative Client::exchange(SID sid,
         // 0x78 = RequestCorrectlyReceived_ResponsePending → wait P2* and listen
         if (out.nrc.code == NegativeResponseCode::RequestCorrectlyReceived_ResponsePending) {
           rx.clear();
+          if (sample) {
+            if (sample->pending_responses++ == 0) pending_start = clock::now();
+          }
           auto* tp = dynamic_cast<isotp::Transport*>(&t_);
-          if (tp && tp->recv_only(rx, timings_.p2_star)) {
-            if (!rx.empty()) continue; // got another frame, re-evaluate
+          const bool got = tp && tp->recv_only(rx, clamp_to_deadline(timings.p2_star, deadline));
+          if (sample) {
+            if (got && t_.last_transfer_timing(tt) && tt.valid) {
+              sample->pending = tt.rx_first - pending_start;
+              sample->rx_reassembly = tt.rx_end - tt.rx_first;
+            } else {
+              sample->pending = clock::now() - pending_start;
+              sample->rx_reassembly = {};
+              if (!got) sample->timed_out = true;
+            }
           }
+          if (got && !rx.empty()) continue; // got another frame, re-evaluate
           return out; // ok=false, timeout or empty response
         }
 
         // 0x21 = BusyRepeatRequest → wait P2 and listen again once
         if (out.nrc.code == NegativeResponseCode::BusyRepeatRequest) {
           rx.clear();
+          const auto busy_start = clock::now();
           auto* tp = dynamic_cast<isotp::Transport*>(&t_);
-          if (tp && tp->recv_only(rx, timings_.p2)) {
-            if (!rx.empty()) continue; // got another frame, re-evaluate
+          const bool got = tp && tp->recv_only(rx, clamp_to_deadline(timings.p2, deadline));
+          if (sample) {
+            sample->ecu_think += clock::now() - busy_start;
+            if (!got) sample->timed_out = true;
           }
+          if (got && !rx.empty()) continue; // got another frame, re-evaluate
           return out; // ok=false if nothing else shows up
         }
       }
@@ -62,6 +622,18 @@ PositiveOrNegative Client::exchange(SID sid,
 
     // Not a negative response: must be a positive one
     if (!is_positive_response(sid_rx, static_cast<uint8_t>(sid))) {
+      // Periodic data or an event arrived first: park it and keep listening
+      // for our response within the original timeout
+      auto* tp = dynamic_cast<isotp::Transport*>(&t_);
+      if (tp && is_unsolicited_response(sid_rx)) {
+        inbox_->push(std::move(rx));
+        rx.clear();
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            wire_start + timeout - clock::now());
+        if (left.count() > 0 && tp->recv_only(rx, left) && !rx.empty()) continue;
+        if (sample) sample->timed_out = true;
+        return out;
+      }
       return out; // unexpected frame
     }
 
@@ -100,6 +672,7 @@ PositiveOrNegative Client::diagnostic_session_control(Session s) {
     if (p2_ms == 0)       p2_ms = 50;
     if (p2_star_ms < 500) p2_star_ms = 500;
 
+    std::lock_guard<std::mutex> lock(state_mutex_);
     timings_.p2      = std::chrono::milliseconds(p2_ms);
     timings_.p2_star = std::chrono::milliseconds(p2_star_ms);
   }
@@ -134,6 +707,94 @@ PositiveOrNegative Client::read_data_by_identifier(DID did) {
   return exchange(SID::ReadDataByIdentifier, p);
 }
 
+PositiveOrNegative Client::read_data_by_identifiers(const std::vector<DID>& dids) {
+  std::vector<uint8_t> p; p.reserve(2 * dids.size());
+  for (DID did : dids) codec::be16(p, did);
+  return exchange(SID::ReadDataByIdentifier, p);
+}
+
+namespace {
+
+// Resolves multi-DID payload layouts. count(i, pos) is the number of ways
+// (capped at two) payload[pos..] splits into records for dids[i..]; results
+// are memoised so repeated DID-echo bytes inside data cannot blow up.
+class DidRecordSplitter {
+public:
+  DidRecordSplitter(const std::vector<DID>& dids, const std::vector<size_t>& lengths,
+                    const std::vector<uint8_t>& payload)
+      : dids_(dids), lengths_(lengths), payload_(payload),
+        memo_((dids.size() + 1) * (payload.size() + 1), -1) {}
+
+  int count(size_t i, size_t pos) {
+    int8_t& m = memo_[i * (payload_.size() + 1) + pos];
+    if (m < 0) {
+      int n = 0;
+      if (i == dids_.size()) {
+        n = pos == payload_.size() ? 1 : 0;
+      } else if (echo_at(i, pos)) {
+        size_t lo, hi;
+        if (data_range(i, pos + 2, lo, hi)) {
+          for (size_t end = lo; end <= hi && n < 2; ++end) n += count(i + 1, end);
+        }
+      }
+      m = static_cast<int8_t>(std::min(n, 2));
+    }
+    return m;
+  }
+
+  // Walk the unique split; only valid when count(0, 0) == 1.
+  void extract(std::vector<std::vector<uint8_t>>& records) {
+    records.clear();
+    size_t pos = 0;
+    for (size_t i = 0; i < dids_.size(); ++i) {
+      size_t lo = 0, hi = 0;
+      data_range(i, pos + 2, lo, hi);
+      size_t end = lo;
+      while (count(i + 1, end) == 0) ++end;
+      records.emplace_back(payload_.begin() + static_cast<std::ptrdiff_t>(pos + 2),
+                           payload_.begin() + static_cast<std::ptrdiff_t>(end));
+      pos = end;
+    }
+  }
+
+private:
+  bool echo_at(size_t i, size_t pos) const {
+    return pos + 2 <= payload_.size() &&
+           payload_[pos] == uint8_t(dids_[i] >> 8) && payload_[pos + 1] == uint8_t(dids_[i]);
+  }
+
+  // Candidate end offsets for the data of dids[i] starting at begin
+  bool data_range(size_t i, size_t begin, size_t& lo, size_t& hi) const {
+    if (begin > payload_.size()) return false;
+    if (lengths_[i] != 0) {
+      lo = hi = begin + lengths_[i];
+      return hi <= payload_.size();
+    }
+    lo = begin;
+    hi = payload_.size();
+    if (i + 1 == dids_.size()) lo = hi;  // last record takes the remainder
+    return true;
+  }
+
+  const std::vector<DID>& dids_;
+  const std::vector<size_t>& lengths_;
+  const std::vector<uint8_t>& payload_;
+  std::vector<int8_t> memo_;
+};
+
+} // namespace
+
+bool split_did_records(const std::vector<DID>& dids,
+                       const std::vector<size_t>& lengths,
+                       const std::vector<uint8_t>& payload,
+                       std::vector<std::vector<uint8_t>>& records) {
+  if (dids.empty() || lengths.size() != dids.size()) return false;
+  DidRecordSplitter splitter(dids, lengths, payload);
+  if (splitter.count(0, 0) != 1) return false;
+  splitter.extract(records);
+  return true;
+}
+
 PositiveOrNegative Client::read_scaling_data_by_identifier(DID did) {
   // ReadScalingDataByIdentifier (0x24) - same format as ReadDataByIdentifier
   // Returns scaling information for the specified DID
@@ -146,7 +807,7 @@ PositiveOrNegative Client::write_data_by_identifier(DID did, const std::vector<u
   std::vector<uint8_t> p; p.reserve(2 + data.size());
   codec::be16(p, did);
   p.insert(p.end(), data.begin(), data.end());
-  return exchange(SID::WriteDataByIdentifier, p, timings_.p2_star);
+  return exchange(SID::WriteDataByIdentifier, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::dynamically_define_data_identifier_by_did(
@@ -210,7 +871,7 @@ PositiveOrNegative Client::read_memory_by_address(uint32_t address, uint32_t siz
   // Append size (big-endian)
   codec::be32(p, size);
   
-  return exchange(SID::ReadMemoryByAddress, p, timings_.p2_star);
+  return exchange(SID::ReadMemoryByAddress, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::read_memory_by_address(const std::vector<uint8_t>& addr,
@@ -225,7 +886,7 @@ PositiveOrNegative Client::read_memory_by_address(const std::vector<uint8_t>& ad
   p.insert(p.end(), addr.begin(), addr.end());
   p.insert(p.end(), size.begin(), size.end());
 
-  return exchange(SID::ReadMemoryByAddress, p, timings_.p2_star);
+  return exchange(SID::ReadMemoryByAddress, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::write_memory_by_address(uint32_t address, const std::vector<uint8_t>& data) {
@@ -247,7 +908,7 @@ PositiveOrNegative Client::write_memory_by_address(uint32_t address, const std::
   // Append data
   p.insert(p.end(), data.begin(), data.end());
   
-  return exchange(SID::WriteMemoryByAddress, p, timings_.p2_star);
+  return exchange(SID::WriteMemoryByAddress, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::write_memory_by_address(const std::vector<uint8_t>& addr,
@@ -264,7 +925,7 @@ PositiveOrNegative Client::write_memory_by_address(const std::vector<uint8_t>& a
   p.insert(p.end(), size.begin(), size.end());
   p.insert(p.end(), data.begin(), data.end());
 
-  return exchange(SID::WriteMemoryByAddress, p, timings_.p2_star);
+  return exchange(SID::WriteMemoryByAddress, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::routine_control(RoutineAction action, RoutineId id, const std::vector<uint8_t>& record) {
@@ -272,18 +933,18 @@ PositiveOrNegative Client::routine_control(RoutineAction action, RoutineId id, c
   p.push_back(static_cast<uint8_t>(action));
   codec::be16(p, id);
   p.insert(p.end(), record.begin(), record.end());
-  return exchange(SID::RoutineControl, p, timings_.p2_star);
+  return exchange(SID::RoutineControl, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::clear_diagnostic_information(const std::vector<uint8_t>& group_of_dtc) {
   // groupOfDTC length is typically 3 bytes (mask), but leave generic
-  return exchange(SID::ClearDiagnosticInformation, group_of_dtc, timings_.p2_star);
+  return exchange(SID::ClearDiagnosticInformation, group_of_dtc, timings().p2_star);
 }
 
 PositiveOrNegative Client::read_dtc_information(uint8_t subFunction, const std::vector<uint8_t>& record) {
   std::vector<uint8_t> p{ subFunction };
   p.insert(p.end(), record.begin(), record.end());
-  return exchange(SID::ReadDTCInformation, p, timings_.p2_star);
+  return exchange(SID::ReadDTCInformation, p, timings().p2_star);
 }
 
 // Unused helper - kept for reference
@@ -305,7 +966,7 @@ PositiveOrNegative Client::request_download(uint8_t dfi,
   p.push_back(static_cast<uint8_t>((al << 4) | sl));
   p.insert(p.end(), addr.begin(), addr.end());
   p.insert(p.end(), size.begin(), size.end());
-  return exchange(SID::RequestDownload, p, timings_.p2_star);
+  return exchange(SID::RequestDownload, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::request_upload(uint8_t dfi,
@@ -322,18 +983,28 @@ PositiveOrNegative Client::request_upload(uint8_t dfi,
   p.push_back(static_cast<uint8_t>((al << 4) | sl));
   p.insert(p.end(), addr.begin(), addr.end());
   p.insert(p.end(), size.begin(), size.end());
-  return exchange(SID::RequestUpload, p, timings_.p2_star);
+  return exchange(SID::RequestUpload, p, timings().p2_star);
 }
 
 PositiveOrNegative Client::transfer_data(BlockCounter block, const std::vector<uint8_t>& data) {
-  std::vector<uint8_t> p; p.reserve(1 + data.size());
-  p.push_back(block);
-  p.insert(p.end(), data.begin(), data.end());
-  return exchange(SID::TransferData, p, timings_.p2_star);
+  return transfer_data(block, data.data(), data.size());
+}
+
+PositiveOrNegative Client::transfer_data(BlockCounter block, const uint8_t* data, size_t size) {
+  // Blocks are built straight into the SDU; after the first block the
+  // buffer's capacity is reused, so a download allocates no request memory.
+  // TransferData is never coalesced, so the exchange can start right here.
+  thread_local std::vector<uint8_t> tx;
+  tx.clear();
+  tx.reserve(2 + size);
+  tx.push_back(static_cast<uint8_t>(SID::TransferData));
+  tx.push_back(block);
+  tx.insert(tx.end(), data, data + size);
+  return measured_exchange(SID::TransferData, tx, timings().p2_star);
 }
 
 PositiveOrNegative Client::request_transfer_exit(const std::vector<uint8_t>& opt) {
-  return exchange(SID::RequestTransferExit, opt, timings_.p2_star);
+  return exchange(SID::RequestTransferExit, opt, timings().p2_star);
 }
 
 PositiveOrNegative Client::communication_control(uint8_t subFunction, uint8_t communicationType) {
@@ -344,6 +1015,7 @@ PositiveOrNegative Client::communication_control(uint8_t subFunction, uint8_t co
   if (result.ok) {
     // Decode the subfunction to update state
     const uint8_t sf = subFunction & 0x7F; // strip suppress positive response bit
+    std::lock_guard<std::mutex> lock(state_mutex_);
     
     switch (sf) {
       case 0x00: // EnableRxAndTx
@@ -384,6 +1056,7 @@ PositiveOrNegative Client::control_dtc_setting(uint8_t settingType) {
   // Update internal DTC setting state on success
   if (result.ok) {
     const uint8_t st = settingType & 0x7F; // strip suppress positive response bit
+    std::lock_guard<std::mutex> lock(state_mutex_);
     
     switch (st) {
       case 0x01: // On - enable DTC logging
@@ -426,6 +1099,7 @@ PositiveOrNegative Client::access_timing_parameters(AccessTimingParametersType t
                                static_cast<uint16_t>(result.payload[4]);
       
       // Update client timings
+      std::lock_guard<std::mutex> lock(state_mutex_);
       timings_.p2 = std::chrono::milliseconds(p2_ms);
       timings_.p2_star = std::chrono::milliseconds(p2_star_10ms * 10);
     }
@@ -451,23 +1125,55 @@ PositiveOrNegative Client::read_data_by_periodic_identifier(
   return exchange(SID::ReadDataByPeriodicIdentifier, p);
 }
 
+// Listen for an unsolicited PDU starting with response_sid. Parked PDUs are
+// served first; the transport is then polled in short slices through the
+// exchange queue so concurrent requests are only delayed by one slice.
+// Unsolicited PDUs of another kind are parked for their own consumer.
+bool Client::receive_unsolicited(uint8_t response_sid, std::vector<uint8_t>& pdu,
+                                 std::chrono::milliseconds timeout) {
+  using clock = std::chrono::steady_clock;
+  constexpr std::chrono::milliseconds kSlice{10};
+
+  if (inbox_->pop(response_sid, pdu)) return true;
+
+  CancellationToken* const cancel = CancelScope::current();
+  const auto end = clock::now() + timeout;
+  for (;;) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(end - clock::now());
+    const auto slice = std::max(std::chrono::milliseconds(0), std::min(left, kSlice));
+    std::vector<uint8_t> rx;
+    bool received = false;
+    const bool ran = t_.exchange_queue().run([&]() {
+      CancelScope scope(cancel);
+      received = t_.recv_unsolicited(rx, slice);
+    }, std::chrono::steady_clock::time_point::max(), cancel, true);
+    if (!ran) return false;  // cancelled
+
+    if (received && !rx.empty()) {
+      trace::record_pdu(trace::Direction::Rx, t_.address().rx_can_id, rx);
+      if (rx[0] == response_sid) {
+        pdu = std::move(rx);
+        return true;
+      }
+      if (is_unsolicited_response(rx[0])) inbox_->push(std::move(rx));
+    }
+    // Another thread's exchange may have parked what we are waiting for
+    if (inbox_->pop(response_sid, pdu)) return true;
+    if (left <= slice || (cancel && cancel->is_cancelled())) return false;
+  }
+}
+
+bool Client::receive_event(std::vector<uint8_t>& pdu, std::chrono::milliseconds timeout) {
+  // 0xC6 = 0x86 + 0x40 (ResponseOnEvent positive response)
+  return receive_unsolicited(0xC6, pdu, timeout);
+}
+
 bool Client::receive_periodic_data(PeriodicDataMessage& msg,
                                    std::chrono::milliseconds timeout) {
-  std::vector<uint8_t> rx;
-  
-  // Try to receive unsolicited message from transport
-  if (!t_.recv_unsolicited(rx, timeout)) {
-    return false;
-  }
-  
-  if (rx.empty()) {
-    return false;
-  }
-  
   // Periodic data response format: [0x6A][PeriodicDID][data...]
   // where 0x6A = 0x2A + 0x40 (positive response)
-  const uint8_t sid = rx[0];
-  if (sid != 0x6A) { // Not a periodic data message
+  std::vector<uint8_t> rx;
+  if (!receive_unsolicited(0x6A, rx, timeout)) {
     return false;
   }
   
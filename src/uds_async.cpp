@@ -1,5 +1,6 @@
 #include "uds_async.hpp"
 #include <algorithm>
+#include <cstdint>
 
 namespace uds {
 namespace async {
@@ -8,17 +9,121 @@ namespace async {
 // AsyncClient Implementation
 // ============================================================================
 
-AsyncClient::AsyncClient(Client& client, size_t num_workers)
-    : client_(client) {
+namespace {
+
+constexpr size_t kPriorityClasses = 4;
+
+// Identifies the AsyncClient worker running on this thread, if any
+struct WorkerIdentity {
+    const void* owner = nullptr;
+    size_t index = 0;
+};
+thread_local WorkerIdentity tls_worker;
+
+// Status table word layout: (generation << 8) | status
+constexpr uint64_t make_slot_word(uint32_t generation, AsyncStatus status) {
+    return (static_cast<uint64_t>(generation) << 8) | static_cast<uint64_t>(status);
+}
+constexpr uint32_t slot_generation(uint64_t word) { return static_cast<uint32_t>(word >> 8); }
+constexpr AsyncStatus slot_status(uint64_t word) { return static_cast<AsyncStatus>(word & 0xFF); }
+
+bool is_finished(AsyncStatus status) {
+    return status != AsyncStatus::Pending && status != AsyncStatus::Running;
+}
+
+// Build the callback used when a task is dropped without running
+template <typename T>
+std::function<void(AsyncStatus)> abandon_with(ResultCallback<T> callback) {
+    return [callback](AsyncStatus status) {
+        if (!callback) return;
+        AsyncResult<T> result;
+        result.status = status;
+        result.error_message = status == AsyncStatus::Cancelled ? "Task cancelled"
+                             : status == AsyncStatus::TimedOut ? "Deadline exceeded"
+                             : "Task not run";
+        callback(result);
+    };
+}
+
+// Report a finished task; a failure after cancel() or after the task's
+// deadline is reported as such
+template <typename T>
+AsyncStatus deliver(AsyncResult<T>& result, const ResultCallback<T>& callback) {
+    if (result.status == AsyncStatus::Failed && CancelScope::cancelled()) {
+        result.status = AsyncStatus::Cancelled;
+        result.error_message = "Task cancelled";
+    } else if (result.status == AsyncStatus::Failed && ExchangeScope::expired()) {
+        result.status = AsyncStatus::TimedOut;
+        result.error_message = "Deadline exceeded";
+    }
+    if (callback) {
+        callback(result);
+    }
+    return result.status;
+}
+
+} // namespace
+
+struct AsyncClient::WorkerQueue {
+    // Heap order: earliest deadline first, then submission order
+    struct Later {
+        bool operator()(const Task& a, const Task& b) const {
+            if (a.deadline != b.deadline) return a.deadline > b.deadline;
+            return a.sequence > b.sequence;
+        }
+    };
+    
+    std::mutex mutex;
+    std::vector<Task> lanes[kPriorityClasses];
+    std::atomic<size_t> sizes[kPriorityClasses] = {};   ///< Lock-free emptiness hints
+    
+    void push(size_t p, Task task) {
+        lanes[p].push_back(std::move(task));
+        std::push_heap(lanes[p].begin(), lanes[p].end(), Later());
+        publish(p);
+    }
+    
+    Task pop(size_t p) {
+        std::pop_heap(lanes[p].begin(), lanes[p].end(), Later());
+        Task task = std::move(lanes[p].back());
+        lanes[p].pop_back();
+        publish(p);
+        return task;
+    }
+    
+    void publish(size_t p) {
+        sizes[p].store(lanes[p].size(), std::memory_order_relaxed);
+    }
+    
+    bool has_work() const {
+        for (const auto& size : sizes) {
+            if (size.load(std::memory_order_relaxed) != 0) return true;
+        }
+        return false;
+    }
+};
+
+AsyncClient::AsyncClient(Client& client, size_t num_workers, size_t max_tasks)
+    : client_(client),
+      slots_(new std::atomic<uint64_t>[std::max<size_t>(max_tasks, 1)]),
+      slot_count_(std::min<size_t>(std::max<size_t>(max_tasks, 1), kUntracked)) {
+    // Generation 0 is never handed out; a finished status marks the slot free
+    for (size_t i = 0; i < slot_count_; ++i) {
+        slots_[i].store(make_slot_word(0, AsyncStatus::Completed), std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < std::max<size_t>(num_workers, 1); ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    running_tasks_.reset(new RunningTask[queues_.size()]);
     // Start worker threads
     for (size_t i = 0; i < num_workers; ++i) {
-        workers_.emplace_back(&AsyncClient::worker_loop, this);
+        workers_.emplace_back(&AsyncClient::worker_loop, this, i);
     }
 }
 
 AsyncClient::~AsyncClient() {
     running_ = false;
-    queue_cv_.notify_all();
+    wake_all();
     
     for (auto& worker : workers_) {
         if (worker.joinable()) {
@@ -27,71 +132,193 @@ AsyncClient::~AsyncClient() {
     }
 }
 
-void AsyncClient::worker_loop() {
-    while (running_) {
-        Task task;
+void AsyncClient::wake_all() {
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    sleep_cv_.notify_all();
+}
+
+bool AsyncClient::acquire_slot(Task& task) {
+    // Round-robin so a finished task's status survives as long as possible
+    const size_t start = next_slot_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t k = 0; k < slot_count_; ++k) {
+        const size_t index = (start + k) % slot_count_;
+        uint64_t word = slots_[index].load(std::memory_order_acquire);
+        if (!is_finished(slot_status(word))) continue;
         
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait(lock, [this] {
-                return !running_ || (!task_queue_.empty() && !paused_);
-            });
-            
-            if (!running_) break;
-            if (task_queue_.empty() || paused_) continue;
+        uint32_t generation = slot_generation(word) + 1;
+        if (generation == 0) generation = 1;
+        if (slots_[index].compare_exchange_strong(word, make_slot_word(generation, AsyncStatus::Pending),
+                                                  std::memory_order_acq_rel)) {
+            task.slot = static_cast<uint32_t>(index);
+            task.generation = generation;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AsyncClient::transition(const Task& task, AsyncStatus from, AsyncStatus to) {
+    if (task.slot == kUntracked) return true;
+    uint64_t expected = make_slot_word(task.generation, from);
+    return slots_[task.slot].compare_exchange_strong(expected, make_slot_word(task.generation, to),
+                                                     std::memory_order_acq_rel);
+}
+
+bool AsyncClient::try_pop(size_t index, Task& task) {
+    // Own heaps first: highest priority class with work, earliest deadline in it
+    WorkerQueue& own = *queues_[index];
+    if (own.has_work()) {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        for (size_t p = kPriorityClasses; p-- > 0;) {
+            if (own.lanes[p].empty()) continue;
+            task = own.pop(p);
+            active_.fetch_add(1);
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+    
+    // Out of local work: steal the top task of the highest priority class
+    // queued elsewhere, visiting victims in order starting after this worker
+    const size_t n = queues_.size();
+    for (size_t p = kPriorityClasses; p-- > 0;) {
+        for (size_t k = 1; k < n; ++k) {
+            WorkerQueue& victim = *queues_[(index + k) % n];
+            if (victim.sizes[p].load(std::memory_order_relaxed) == 0) continue;
             
-            task = task_queue_.top();
-            task_queue_.pop();
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.lanes[p].empty()) continue;  // Raced with another worker
+            task = victim.pop(p);
+            active_.fetch_add(1);
+            pending_.fetch_sub(1);
+            return true;
         }
-        
-        // Update status to running
-        if (task.status) {
-            task.status->store(AsyncStatus::Running);
+    }
+    return false;
+}
+
+void AsyncClient::worker_loop(size_t index) {
+    tls_worker = {this, index};
+    
+    while (running_) {
+        if (pending_.load() == 0 || paused_) {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleepers_.fetch_add(1);
+            sleep_cv_.wait(lock, [this] {
+                return !running_ || (pending_.load() > 0 && !paused_);
+            });
+            sleepers_.fetch_sub(1);
+            continue;
         }
         
-        // Execute task
-        try {
-            task.execute();
-        } catch (...) {
-            if (task.status) {
-                task.status->store(AsyncStatus::Failed);
-            }
+        Task task;
+        if (!try_pop(index, task)) {
+            // Another worker took it between the counter check and the scan
+            std::this_thread::yield();
+            continue;
         }
+        run_task(task);
+        active_.fetch_sub(1);
     }
 }
 
-uint64_t AsyncClient::enqueue_task(Priority priority, std::function<void()> func) {
-    uint64_t id = next_task_id_++;
+void AsyncClient::run_task(Task& task) {
+    const auto now = std::chrono::steady_clock::now();
     
+    // Shed tasks whose deadline passed while queued, before they touch the bus
+    if (now >= task.deadline) {
+        const bool timed_out = transition(task, AsyncStatus::Pending, AsyncStatus::TimedOut);
+        if (task.abandon) task.abandon(timed_out ? AsyncStatus::TimedOut : AsyncStatus::Cancelled);
+        return;
+    }
+    // Published before the task turns Running: once cancel() fails to catch
+    // it as Pending, it is guaranteed to find it here
+    RunningTask& running = running_tasks_[tls_worker.index];
     {
-        std::lock_guard<std::mutex> status_lock(status_mutex_);
-        task_statuses_[id].store(AsyncStatus::Pending);
+        std::lock_guard<std::mutex> lock(running.mutex);
+        running.id = task.slot == kUntracked
+            ? 0 : (static_cast<uint64_t>(task.generation) << 32) | task.slot;
+        running.token.reset();
+    }
+    if (!transition(task, AsyncStatus::Pending, AsyncStatus::Running)) {
+        // Cancelled while queued
+        {
+            std::lock_guard<std::mutex> lock(running.mutex);
+            running.id = 0;
+        }
+        if (task.abandon) task.abandon(AsyncStatus::Cancelled);
+        return;
+    }
+    
+    auto deadline = task.deadline;
+    const auto limit = default_timeout_.load();
+    if (limit.count() > 0) {
+        deadline = std::min(deadline, now + limit);
     }
     
+    AsyncStatus final_status = AsyncStatus::Failed;
+    try {
+        ExchangeScope scope(deadline);
+        CancelScope cancel_scope(&running.token);
+        final_status = task.execute();
+    } catch (...) {
+        final_status = AsyncStatus::Failed;
+    }
+    {
+        std::lock_guard<std::mutex> lock(running.mutex);
+        running.id = 0;
+    }
+    if (!is_finished(final_status)) final_status = AsyncStatus::Completed;
+    transition(task, AsyncStatus::Running, final_status);
+}
+
+TaskHandle AsyncClient::enqueue_task(const TaskOptions& options, std::function<AsyncStatus()> func,
+                                     std::function<void(AsyncStatus)> abandon) {
     Task task;
-    task.id = id;
-    task.priority = priority;
+    task.priority = options.priority;
+    task.deadline = options.deadline;
+    task.sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
     task.execute = std::move(func);
+    task.abandon = std::move(abandon);
     task.created = std::chrono::steady_clock::now();
     
-    {
-        std::lock_guard<std::mutex> status_lock(status_mutex_);
-        task.status = &task_statuses_[id];
+    const bool on_worker = tls_worker.owner == this;
+    if (!acquire_slot(task) && !on_worker) {
+        // Table full: reject rather than wait on workers that may never
+        // finish. A worker's own follow-up task runs untracked instead, so
+        // a task chain is never cut short by a busy table.
+        if (task.abandon) task.abandon(AsyncStatus::Failed);
+        return TaskHandle();
     }
     
+    // Workers keep their own follow-up tasks local; others are spread out
+    const size_t target = on_worker
+        ? tls_worker.index
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    const size_t p = std::min(static_cast<size_t>(options.priority), kPriorityClasses - 1);
+    const TaskHandle handle = task.slot == kUntracked
+        ? TaskHandle()
+        : TaskHandle((static_cast<uint64_t>(task.generation) << 32) | task.slot);
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        task_queue_.push(std::move(task));
+        // Counted under the queue lock, before the push: a worker can only
+        // pop (and decrement) once the lock is released, so the counter
+        // never drops below the number of queued tasks
+        WorkerQueue& q = *queues_[target];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        pending_.fetch_add(1);
+        q.push(p, std::move(task));
     }
-    
-    queue_cv_.notify_one();
-    return id;
+    if (sleepers_.load() > 0) {
+        { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+        sleep_cv_.notify_one();
+    }
+    return handle;
 }
 
 TaskHandle AsyncClient::read_did_async(uint16_t did,
                                        ResultCallback<std::vector<uint8_t>> callback,
-                                       Priority priority) {
-    auto id = enqueue_task(priority, [this, did, callback]() {
+                                       TaskOptions options) {
+    return enqueue_task(options, [this, did, callback]() -> AsyncStatus {
         AsyncResult<std::vector<uint8_t>> result;
         auto start = std::chrono::steady_clock::now();
         
@@ -109,19 +336,8 @@ TaskHandle AsyncClient::read_did_async(uint16_t did,
             result.error_message = "Read DID failed";
         }
         
-        {
-            std::lock_guard<std::mutex> lock(status_mutex_);
-            if (task_statuses_.count(0)) {  // Simplified - would need proper task ID tracking
-                task_statuses_[0].store(result.status);
-            }
-        }
-        
-        if (callback) {
-            callback(result);
-        }
-    });
-    
-    return TaskHandle(id);
+        return deliver(result, callback);
+    }, abandon_with(callback));
 }
 
 std::future<AsyncResult<std::vector<uint8_t>>> AsyncClient::read_did_future(uint16_t did) {
@@ -137,8 +353,8 @@ std::future<AsyncResult<std::vector<uint8_t>>> AsyncClient::read_did_future(uint
 
 TaskHandle AsyncClient::read_dids_async(const std::vector<uint16_t>& dids,
                                         ResultCallback<std::map<uint16_t, std::vector<uint8_t>>> callback,
-                                        Priority priority) {
-    auto id = enqueue_task(priority, [this, dids, callback]() {
+                                        TaskOptions options) {
+    return enqueue_task(options, [this, dids, callback]() -> AsyncStatus {
         AsyncResult<std::map<uint16_t, std::vector<uint8_t>>> result;
         auto start = std::chrono::steady_clock::now();
         
@@ -158,18 +374,14 @@ TaskHandle AsyncClient::read_dids_async(const std::vector<uint16_t>& dids,
         auto end = std::chrono::steady_clock::now();
         result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
         
-        if (callback) {
-            callback(result);
-        }
-    });
-    
-    return TaskHandle(id);
+        return deliver(result, callback);
+    }, abandon_with(callback));
 }
 
 TaskHandle AsyncClient::write_did_async(uint16_t did, const std::vector<uint8_t>& data,
                                         ResultCallback<bool> callback,
-                                        Priority priority) {
-    auto id = enqueue_task(priority, [this, did, data, callback]() {
+                                        TaskOptions options) {
+    return enqueue_task(options, [this, did, data, callback]() -> AsyncStatus {
         AsyncResult<bool> result;
         auto start = std::chrono::steady_clock::now();
         
@@ -188,18 +400,14 @@ TaskHandle AsyncClient::write_did_async(uint16_t did, const std::vector<uint8_t>
             result.error_message = "Write DID failed";
         }
         
-        if (callback) {
-            callback(result);
-        }
-    });
-    
-    return TaskHandle(id);
+        return deliver(result, callback);
+    }, abandon_with(callback));
 }
 
 TaskHandle AsyncClient::session_control_async(Session session,
                                               ResultCallback<bool> callback,
-                                              Priority priority) {
-    auto id = enqueue_task(priority, [this, session, callback]() {
+                                              TaskOptions options) {
+    return enqueue_task(options, [this, session, callback]() -> AsyncStatus {
         AsyncResult<bool> result;
         auto start = std::chrono::steady_clock::now();
         
@@ -217,21 +425,17 @@ TaskHandle AsyncClient::session_control_async(Session session,
             result.nrc = response.nrc.code;
         }
         
-        if (callback) {
-            callback(result);
-        }
-    });
-    
-    return TaskHandle(id);
+        return deliver(result, callback);
+    }, abandon_with(callback));
 }
 
 TaskHandle AsyncClient::security_access_async(
     uint8_t level,
     std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)> key_calculator,
     ResultCallback<bool> callback,
-    Priority priority) {
+    TaskOptions options) {
     
-    auto id = enqueue_task(priority, [this, level, key_calculator, callback]() {
+    return enqueue_task(options, [this, level, key_calculator, callback]() -> AsyncStatus {
         AsyncResult<bool> result;
         auto start = std::chrono::steady_clock::now();
         
@@ -242,8 +446,7 @@ TaskHandle AsyncClient::security_access_async(
             result.value = false;
             result.nrc = seed_response.nrc.code;
             result.error_message = "Failed to get seed";
-            if (callback) callback(result);
-            return;
+            return deliver(result, callback);
         }
         
         // Calculate key
@@ -265,19 +468,15 @@ TaskHandle AsyncClient::security_access_async(
             result.error_message = "Key rejected";
         }
         
-        if (callback) {
-            callback(result);
-        }
-    });
-    
-    return TaskHandle(id);
+        return deliver(result, callback);
+    }, abandon_with(callback));
 }
 
 TaskHandle AsyncClient::routine_control_async(uint8_t control_type, uint16_t routine_id,
                                               const std::vector<uint8_t>& params,
                                               ResultCallback<std::vector<uint8_t>> callback,
-                                              Priority priority) {
-    auto id = enqueue_task(priority, [this, control_type, routine_id, params, callback]() {
+                                              TaskOptions options) {
+    return enqueue_task(options, [this, control_type, routine_id, params, callback]() -> AsyncStatus {
         AsyncResult<std::vector<uint8_t>> result;
         auto start = std::chrono::steady_clock::now();
         
@@ -294,29 +493,38 @@ TaskHandle AsyncClient::routine_control_async(uint8_t control_type, uint16_t rou
             result.nrc = response.nrc.code;
         }
         
-        if (callback) {
-            callback(result);
-        }
-    });
-    
-    return TaskHandle(id);
+        return deliver(result, callback);
+    }, abandon_with(callback));
 }
 
 bool AsyncClient::cancel(TaskHandle handle) {
-    std::lock_guard<std::mutex> lock(status_mutex_);
-    auto it = task_statuses_.find(handle.id());
-    if (it != task_statuses_.end()) {
-        AsyncStatus expected = AsyncStatus::Pending;
-        return it->second.compare_exchange_strong(expected, AsyncStatus::Cancelled);
+    if (!handle.is_valid()) return false;
+    Task task;
+    task.slot = static_cast<uint32_t>(handle.id() & 0xFFFFFFFFu);
+    task.generation = static_cast<uint32_t>(handle.id() >> 32);
+    if (task.slot >= slot_count_) return false;
+    if (transition(task, AsyncStatus::Pending, AsyncStatus::Cancelled)) return true;
+    
+    // Already running: interrupt its wire-level wait
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        RunningTask& running = running_tasks_[i];
+        std::lock_guard<std::mutex> lock(running.mutex);
+        if (running.id == handle.id()) {
+            running.token.cancel();
+            return true;
+        }
     }
     return false;
 }
 
 void AsyncClient::cancel_all() {
-    std::lock_guard<std::mutex> lock(status_mutex_);
-    for (auto& [id, status] : task_statuses_) {
-        AsyncStatus expected = AsyncStatus::Pending;
-        status.compare_exchange_strong(expected, AsyncStatus::Cancelled);
+    for (size_t i = 0; i < slot_count_; ++i) {
+        uint64_t word = slots_[i].load(std::memory_order_acquire);
+        while (slot_status(word) == AsyncStatus::Pending &&
+               !slots_[i].compare_exchange_weak(
+                   word, make_slot_word(slot_generation(word), AsyncStatus::Cancelled),
+                   std::memory_order_acq_rel)) {
+        }
     }
 }
 
@@ -341,7 +549,7 @@ bool AsyncClient::wait(TaskHandle handle, std::chrono::milliseconds timeout) {
 void AsyncClient::wait_all(std::chrono::milliseconds timeout) {
     auto start = std::chrono::steady_clock::now();
     
-    while (pending_count() > 0) {
+    while (is_busy()) {
         auto elapsed = std::chrono::steady_clock::now() - start;
         if (elapsed >= timeout) {
             break;
@@ -351,27 +559,23 @@ void AsyncClient::wait_all(std::chrono::milliseconds timeout) {
 }
 
 AsyncStatus AsyncClient::get_status(TaskHandle handle) const {
-    std::lock_guard<std::mutex> lock(status_mutex_);
-    auto it = task_statuses_.find(handle.id());
-    if (it != task_statuses_.end()) {
-        return it->second.load();
+    const size_t index = static_cast<size_t>(handle.id() & 0xFFFFFFFFu);
+    if (!handle.is_valid() || index >= slot_count_) {
+        return AsyncStatus::Failed;
+    }
+    const uint64_t word = slots_[index].load(std::memory_order_acquire);
+    if (slot_generation(word) != static_cast<uint32_t>(handle.id() >> 32)) {
+        return AsyncStatus::Failed;  // Stale handle, slot reused
     }
-    return AsyncStatus::Failed;
+    return slot_status(word);
 }
 
 size_t AsyncClient::pending_count() const {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    return task_queue_.size();
+    return pending_.load();
 }
 
 bool AsyncClient::is_busy() const {
-    std::lock_guard<std::mutex> lock(status_mutex_);
-    for (const auto& [id, status] : task_statuses_) {
-        if (status.load() == AsyncStatus::Running) {
-            return true;
-        }
-    }
-    return pending_count() > 0;
+    return pending_.load() > 0 || active_.load() > 0;
 }
 
 void AsyncClient::pause() {
@@ -380,15 +584,62 @@ void AsyncClient::pause() {
 
 void AsyncClient::resume() {
     paused_ = false;
-    queue_cv_.notify_all();
+    wake_all();
 }
 
 // ============================================================================
 // PeriodicMonitor Implementation
 // ============================================================================
 
+namespace {
+
+// Read dids from target in one multi-DID request. Returns one response per
+// DID with the payload of a single read_data_by_identifier() (DID echo +
+// data). Falls back to single reads when the ECU rejects the packed request
+// or its response cannot be split; without any response every DID fails.
+std::vector<PositiveOrNegative> read_dids_packed(Client& target, const std::vector<DID>& dids,
+                                                 const std::vector<size_t>& lengths,
+                                                 size_t& exchanges) {
+    std::vector<PositiveOrNegative> out(dids.size());
+    if (dids.size() == 1) {
+        ++exchanges;
+        out[0] = target.read_data_by_identifier(dids[0]);
+        return out;
+    }
+    
+    ++exchanges;
+    const auto response = target.read_data_by_identifiers(dids);
+    std::vector<std::vector<uint8_t>> records;
+    if (response.ok && split_did_records(dids, lengths, response.payload, records)) {
+        for (size_t k = 0; k < dids.size(); ++k) {
+            out[k].ok = true;
+            codec::be16(out[k].payload, dids[k]);
+            out[k].payload.insert(out[k].payload.end(), records[k].begin(), records[k].end());
+        }
+        return out;
+    }
+    if (!response.ok && static_cast<uint8_t>(response.nrc.code) == 0) {
+        // Target did not answer; single reads would only time out again
+        std::fill(out.begin(), out.end(), response);
+        return out;
+    }
+    
+    // Rejected (e.g. too many DIDs, one unsupported) or unsplittable: read singly
+    for (size_t k = 0; k < dids.size(); ++k) {
+        ++exchanges;
+        out[k] = target.read_data_by_identifier(dids[k]);
+    }
+    return out;
+}
+
+constexpr uint64_t timer_data(uint16_t did, uint32_t epoch) {
+    return (static_cast<uint64_t>(epoch) << 16) | did;
+}
+
+} // namespace
+
 PeriodicMonitor::PeriodicMonitor(Client& client)
-    : client_(client) {
+    : client_(client), wheel_(std::chrono::milliseconds(1), 512, origin_) {
 }
 
 PeriodicMonitor::~PeriodicMonitor() {
@@ -398,39 +649,154 @@ PeriodicMonitor::~PeriodicMonitor() {
 void PeriodicMonitor::add_did(uint16_t did, std::chrono::milliseconds interval,
                               std::function<void(uint16_t, const std::vector<uint8_t>&)> on_change,
                               ErrorCallback on_error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto& entry = monitored_[did];
+        wheel_.cancel(entry.timer);
+        entry = MonitoredDID{};
+        entry.did = did;
+        entry.interval = interval;
+        entry.next_due = std::chrono::steady_clock::now();  // Poll immediately
+        entry.on_change = on_change;
+        entry.on_error = on_error;
+        entry.epoch = ++next_epoch_;
+        entry.timer = wheel_.schedule(entry.next_due, timer_data(did, entry.epoch));
+    }
+    cv_.notify_all();
+}
+
+void PeriodicMonitor::remove_did(uint16_t did) {
     std::lock_guard<std::mutex> lock(mutex_);
+    auto it = monitored_.find(did);
+    if (it == monitored_.end()) return;
+    wheel_.cancel(it->second.timer);
+    monitored_.erase(it);
+}
+
+void PeriodicMonitor::add_periodic(PeriodicDID pdid, PeriodicTransmissionMode rate,
+                                   std::function<void(uint16_t, const std::vector<uint8_t>&)> on_change,
+                                   ErrorCallback on_error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PeriodicEntry entry;
+        entry.rate = rate;
+        entry.on_change = std::move(on_change);
+        entry.on_error = std::move(on_error);
+        periodic_[pdid] = std::move(entry);
+    }
+    if (running_) {
+        configure_periodic({pdid});
+        ensure_receiver();
+    }
+}
+
+void PeriodicMonitor::remove_periodic(PeriodicDID pdid) {
+    bool configured = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = periodic_.find(pdid);
+        if (it == periodic_.end()) return;
+        configured = it->second.configured;
+        periodic_.erase(it);
+    }
+    if (configured) {
+        client_.stop_periodic_transmission({pdid});
+    }
+}
+
+std::optional<PeriodicStats> PeriodicMonitor::periodic_stats(PeriodicDID pdid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = periodic_.find(pdid);
+    if (it == periodic_.end()) return std::nullopt;
+    return it->second.stats;
+}
+
+// Ask the ECU to start sending the given identifiers, one request per rate
+void PeriodicMonitor::configure_periodic(const std::vector<PeriodicDID>& pdids) {
+    std::map<PeriodicTransmissionMode, std::vector<PeriodicDID>> by_rate;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (PeriodicDID pdid : pdids) {
+            auto it = periodic_.find(pdid);
+            if (it != periodic_.end()) by_rate[it->second.rate].push_back(pdid);
+        }
+    }
     
-    MonitoredDID entry;
-    entry.did = did;
-    entry.interval = interval;
-    entry.last_poll = std::chrono::steady_clock::now() - interval;  // Poll immediately
-    entry.on_change = on_change;
-    entry.on_error = on_error;
-    
-    monitored_[did] = entry;
+    for (const auto& [rate, group] : by_rate) {
+        const auto response = client_.start_periodic_transmission(rate, group);
+        
+        std::vector<ErrorCallback> errors;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (PeriodicDID pdid : group) {
+                auto it = periodic_.find(pdid);
+                if (it == periodic_.end()) continue;
+                it->second.configured = response.ok;
+                ErrorCallback cb = it->second.on_error ? it->second.on_error : global_error_cb_;
+                if (!response.ok && cb) errors.push_back(cb);
+            }
+        }
+        for (auto& cb : errors) {
+            cb("Failed to start periodic transmission");
+        }
+    }
 }
 
-void PeriodicMonitor::remove_did(uint16_t did) {
+void PeriodicMonitor::ensure_receiver() {
     std::lock_guard<std::mutex> lock(mutex_);
-    monitored_.erase(did);
+    if (!receive_thread_.joinable() && running_) {
+        receive_thread_ = std::thread(&PeriodicMonitor::receive_loop, this);
+    }
 }
 
 void PeriodicMonitor::start() {
     if (running_) return;
     
     running_ = true;
+    stop_token_.reset();
     monitor_thread_ = std::thread(&PeriodicMonitor::monitor_loop, this);
+    
+    std::vector<PeriodicDID> pdids;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [pdid, entry] : periodic_) pdids.push_back(pdid);
+    }
+    if (!pdids.empty()) {
+        configure_periodic(pdids);
+        ensure_receiver();
+    }
 }
 
 void PeriodicMonitor::stop() {
     if (!running_) return;
     
-    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
     cv_.notify_all();
+    stop_token_.cancel();
     
     if (monitor_thread_.joinable()) {
         monitor_thread_.join();
     }
+    if (receive_thread_.joinable()) {
+        receive_thread_.join();
+    }
+    
+    // Tell the ECU to stop pushing what we configured
+    std::vector<PeriodicDID> configured;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [pdid, entry] : periodic_) {
+            if (entry.configured) configured.push_back(pdid);
+            entry.configured = false;
+        }
+    }
+    if (!configured.empty()) {
+        client_.stop_periodic_transmission(configured);
+    }
 }
 
 std::optional<std::vector<uint8_t>> PeriodicMonitor::get_current_value(uint16_t did) const {
@@ -439,64 +805,173 @@ std::optional<std::vector<uint8_t>> PeriodicMonitor::get_current_value(uint16_t
     if (it != monitored_.end() && !it->second.last_value.empty()) {
         return it->second.last_value;
     }
+    if ((did & 0xFF00) == 0xF200) {
+        auto p = periodic_.find(static_cast<PeriodicDID>(did & 0xFF));
+        if (p != periodic_.end() && p->second.stats.samples > 0) {
+            return p->second.last_value;
+        }
+    }
     return std::nullopt;
 }
 
-void PeriodicMonitor::monitor_loop() {
+void PeriodicMonitor::receive_loop() {
+    constexpr std::chrono::milliseconds kListen{50};
+    CancelScope scope(&stop_token_);
+    
     while (running_) {
-        auto now = std::chrono::steady_clock::now();
-        std::chrono::milliseconds min_wait{1000};
-        
-        std::vector<std::pair<uint16_t, MonitoredDID*>> to_poll;
+        PeriodicDataMessage msg;
+        if (!client_.receive_periodic_data(msg, kListen)) continue;
+        const auto now = std::chrono::steady_clock::now();
         
+        std::function<void()> notify;
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            for (auto& [did, entry] : monitored_) {
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - entry.last_poll);
-                
-                if (elapsed >= entry.interval) {
-                    to_poll.emplace_back(did, &entry);
+            auto it = periodic_.find(msg.identifier);
+            if (it == periodic_.end()) {
+                unknown_periodic_.fetch_add(1);
+                continue;
+            }
+            PeriodicEntry& entry = it->second;
+            PeriodicStats& stats = entry.stats;
+            
+            if (stats.samples > 0) {
+                const auto interval = std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - stats.last_sample);
+                if (stats.samples == 1) {
+                    stats.mean_interval = interval;
                 } else {
-                    auto remaining = entry.interval - elapsed;
-                    min_wait = std::min(min_wait, remaining);
+                    if (stats.samples > 2 && interval > 2 * stats.mean_interval) ++stats.gaps;
+                    stats.mean_interval += (interval - stats.mean_interval) / 8;
+                }
+                stats.max_interval = std::max(stats.max_interval, interval);
+                if (stats.mean_interval.count() > 0) {
+                    stats.rate_hz = 1e6 / static_cast<double>(stats.mean_interval.count());
+                }
+            }
+            stats.last_sample = now;
+            ++stats.samples;
+            
+            if (entry.last_value != msg.data || stats.samples == 1) {
+                entry.last_value = msg.data;
+                if (entry.on_change) {
+                    notify = [cb = entry.on_change, did = static_cast<uint16_t>(0xF200 | msg.identifier),
+                              value = msg.data]() { cb(did, value); };
                 }
             }
         }
+        if (notify) notify();
+    }
+}
+
+void PeriodicMonitor::monitor_loop() {
+    struct Due {
+        uint16_t did;
+        uint32_t epoch;
+    };
+    std::vector<uint64_t> expired;
+    std::vector<Due> due;
+    std::vector<std::function<void()>> notifications;
+    CancelScope scope(&stop_token_);
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        expired.clear();
+        due.clear();
+        wheel_.advance(std::chrono::steady_clock::now(), expired);
+        for (uint64_t data : expired) {
+            const uint16_t did = static_cast<uint16_t>(data & 0xFFFF);
+            const uint32_t epoch = static_cast<uint32_t>(data >> 16);
+            auto it = monitored_.find(did);
+            if (it == monitored_.end() || it->second.epoch != epoch) continue;
+            it->second.timer = timer::kInvalidTimer;
+            due.push_back({did, epoch});
+        }
+        
+        if (due.empty()) {
+            // Sleep until the next timer, or until add_did()/stop() wakes us
+            if (auto wake = wheel_.next_wakeup()) {
+                cv_.wait_until(lock, *wake);
+            } else {
+                cv_.wait(lock, [this] { return !running_ || !wheel_.empty(); });
+            }
+            continue;
+        }
+        
+        // Read due DIDs in packed groups, outside the lock
+        const size_t group = std::max<size_t>(max_dids_per_request_, 1);
+        std::vector<std::vector<Due>> batches;
+        std::vector<std::vector<size_t>> lengths;
+        for (size_t i = 0; i < due.size(); ++i) {
+            if (i % group == 0) {
+                batches.emplace_back();
+                lengths.emplace_back();
+            }
+            const auto& last = monitored_[due[i].did].last_value;
+            batches.back().push_back(due[i]);
+            lengths.back().push_back(last.size() > 2 ? last.size() - 2 : 0);
+        }
         
-        // Poll outside of lock
-        for (auto& [did, entry] : to_poll) {
+        lock.unlock();
+        std::vector<std::vector<PositiveOrNegative>> responses(batches.size());
+        std::vector<std::string> failures(batches.size());
+        for (size_t b = 0; b < batches.size(); ++b) {
+            std::vector<DID> dids;
+            for (const auto& d : batches[b]) dids.push_back(d.did);
+            size_t exchanges = 0;
             try {
-                auto response = client_.read_data_by_identifier(did);
+                responses[b] = read_dids_packed(client_, dids, lengths[b], exchanges);
+            } catch (const std::exception& e) {
+                failures[b] = e.what();
+            }
+            read_requests_.fetch_add(exchanges);
+        }
+        lock.lock();
+        
+        // Apply results and reschedule; callbacks run after unlocking
+        const auto now = std::chrono::steady_clock::now();
+        notifications.clear();
+        for (size_t b = 0; b < batches.size(); ++b) {
+            if (!failures[b].empty()) {
+                if (global_error_cb_) {
+                    notifications.push_back([cb = global_error_cb_, error = failures[b]]() { cb(error); });
+                }
+            }
+            for (size_t k = 0; k < batches[b].size(); ++k) {
+                auto it = monitored_.find(batches[b][k].did);
+                if (it == monitored_.end() || it->second.epoch != batches[b][k].epoch) continue;
+                MonitoredDID& entry = it->second;
                 
-                std::lock_guard<std::mutex> lock(mutex_);
-                entry->last_poll = std::chrono::steady_clock::now();
+                // Next multiple of the interval since origin_: DIDs with equal
+                // or harmonic intervals fall due together and share a request
+                const auto interval = std::max(entry.interval, std::chrono::milliseconds(1));
+                entry.next_due = origin_ + interval * ((now - origin_) / interval + 1);
+                entry.timer = wheel_.schedule(entry.next_due, timer_data(entry.did, entry.epoch));
                 
+                if (!failures[b].empty()) continue;
+                const PositiveOrNegative& response = responses[b][k];
                 if (response.ok) {
-                    if (entry->last_value != response.payload) {
-                        entry->last_value = response.payload;
-                        if (entry->on_change) {
-                            entry->on_change(did, response.payload);
+                    if (entry.last_value != response.payload) {
+                        entry.last_value = response.payload;
+                        if (entry.on_change) {
+                            notifications.push_back([cb = entry.on_change, did = entry.did,
+                                                     value = response.payload]() { cb(did, value); });
                         }
                     }
                 } else {
-                    std::string error = "Read failed for DID 0x" + std::to_string(did);
-                    if (entry->on_error) {
-                        entry->on_error(error);
-                    } else if (global_error_cb_) {
-                        global_error_cb_(error);
+                    std::string error = "Read failed for DID 0x" + std::to_string(entry.did);
+                    ErrorCallback cb = entry.on_error ? entry.on_error : global_error_cb_;
+                    if (cb) {
+                        notifications.push_back([cb, error]() { cb(error); });
                     }
                 }
-            } catch (const std::exception& e) {
-                if (global_error_cb_) {
-                    global_error_cb_(e.what());
-                }
             }
         }
         
-        // Wait for next poll or stop signal
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait_for(lock, min_wait, [this] { return !running_; });
+        lock.unlock();
+        for (auto& notify : notifications) {
+            notify();
+        }
+        lock.lock();
     }
 }
 
@@ -504,74 +979,195 @@ void PeriodicMonitor::monitor_loop() {
 // BatchExecutor Implementation
 // ============================================================================
 
+class BatchExecutor::Progress {
+public:
+    Progress(std::function<void(size_t, size_t)> fn, size_t total)
+        : fn_(std::move(fn)), total_(total) {}
+    
+    void advance(size_t n) {
+        if (!fn_) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed_ += n;
+        fn_(completed_, total_);
+    }
+
+private:
+    std::function<void(size_t, size_t)> fn_;
+    size_t total_;
+    size_t completed_ = 0;
+    std::mutex mutex_;
+};
+
+namespace {
+
+void fill_result(AsyncResult<std::vector<uint8_t>>& result, const PositiveOrNegative& response,
+                 std::chrono::steady_clock::time_point start) {
+    if (response.ok) {
+        result.status = AsyncStatus::Completed;
+    } else {
+        result.status = AsyncStatus::Failed;
+        result.nrc = response.nrc.code;
+        if (static_cast<uint8_t>(response.nrc.code) == 0) {
+            result.error_message = "No response";
+        }
+    }
+    result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+}
+
+} // namespace
+
 BatchExecutor::BatchExecutor(Client& client, size_t max_concurrent)
     : client_(client), max_concurrent_(max_concurrent) {
 }
 
-void BatchExecutor::add_read(uint16_t did) {
+size_t BatchExecutor::add_read(uint16_t did) {
+    return add_read(client_, did);
+}
+
+size_t BatchExecutor::add_write(uint16_t did, const std::vector<uint8_t>& data) {
+    return add_write(client_, did, data);
+}
+
+size_t BatchExecutor::add_read(Client& target, uint16_t did) {
     Operation op;
     op.type = Operation::Read;
+    op.target = &target;
     op.did = did;
-    operations_.push_back(op);
+    operations_.push_back(std::move(op));
+    return operations_.size() - 1;
 }
 
-void BatchExecutor::add_write(uint16_t did, const std::vector<uint8_t>& data) {
+size_t BatchExecutor::add_write(Client& target, uint16_t did, const std::vector<uint8_t>& data) {
     Operation op;
     op.type = Operation::Write;
+    op.target = &target;
     op.did = did;
     op.data = data;
-    operations_.push_back(op);
+    operations_.push_back(std::move(op));
+    return operations_.size() - 1;
 }
 
-std::map<uint16_t, AsyncResult<std::vector<uint8_t>>> BatchExecutor::execute() {
+std::vector<AsyncResult<std::vector<uint8_t>>> BatchExecutor::execute() {
     return execute(nullptr);
 }
 
-std::map<uint16_t, AsyncResult<std::vector<uint8_t>>> BatchExecutor::execute(
+std::vector<AsyncResult<std::vector<uint8_t>>> BatchExecutor::execute(
     std::function<void(size_t, size_t)> progress) {
     
-    std::map<uint16_t, AsyncResult<std::vector<uint8_t>>> results;
-    size_t completed = 0;
-    size_t total = operations_.size();
+    std::vector<Result> results(operations_.size());
+    Progress tracker(std::move(progress), operations_.size());
     
-    // For simplicity, execute sequentially
-    // A full implementation would use thread pool for concurrent execution
-    for (const auto& op : operations_) {
-        AsyncResult<std::vector<uint8_t>> result;
-        auto start = std::chrono::steady_clock::now();
+    // Group operation indices by target, keeping submission order per target
+    std::vector<std::vector<size_t>> groups;
+    std::map<Client*, size_t> group_of;
+    for (size_t i = 0; i < operations_.size(); ++i) {
+        auto it = group_of.find(operations_[i].target);
+        if (it == group_of.end()) {
+            it = group_of.emplace(operations_[i].target, groups.size()).first;
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(i);
+    }
+    
+    const size_t num_threads = std::min(std::max<size_t>(max_concurrent_, 1), groups.size());
+    std::atomic<size_t> next_group{0};
+    auto drain = [&]() {
+        for (size_t g; (g = next_group.fetch_add(1)) < groups.size();) {
+            run_target(groups[g], results, tracker);
+        }
+    };
+    
+    if (num_threads <= 1) {
+        drain();
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1);
+        for (size_t t = 1; t < num_threads; ++t) {
+            threads.emplace_back(drain);
+        }
+        drain();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    
+    return results;
+}
+
+void BatchExecutor::run_target(const std::vector<size_t>& ops, std::vector<Result>& results,
+                               Progress& progress) const {
+    size_t i = 0;
+    while (i < ops.size()) {
+        // Collect a run of consecutive reads of distinct DIDs
+        std::vector<size_t> run;
+        while (i < ops.size() && run.size() < std::max<size_t>(max_dids_per_request_, 1) &&
+               operations_[ops[i]].type == Operation::Read &&
+               std::none_of(run.begin(), run.end(), [&](size_t r) {
+                   return operations_[r].did == operations_[ops[i]].did;
+               })) {
+            run.push_back(ops[i++]);
+        }
         
-        if (op.type == Operation::Read) {
-            auto response = client_.read_data_by_identifier(op.did);
-            if (response.ok) {
-                result.status = AsyncStatus::Completed;
-                result.value = response.payload;
+        if (run.empty()) {
+            run.push_back(ops[i++]);
+        }
+        
+        // Transport exceptions must not escape a worker thread
+        try {
+            if (run.size() > 1) {
+                run_packed(run, results);
             } else {
-                result.status = AsyncStatus::Failed;
-                result.nrc = response.nrc.code;
+                run_single(run.front(), results);
             }
-        } else {
-            auto response = client_.write_data_by_identifier(op.did, op.data);
-            if (response.ok) {
-                result.status = AsyncStatus::Completed;
-                result.value = op.data;
-            } else {
-                result.status = AsyncStatus::Failed;
-                result.nrc = response.nrc.code;
+        } catch (const std::exception& e) {
+            for (size_t index : run) {
+                if (!results[index].is_ready()) {
+                    results[index].status = AsyncStatus::Failed;
+                    results[index].error_message = e.what();
+                }
             }
         }
-        
-        auto end = std::chrono::steady_clock::now();
-        result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        
-        results[op.did] = result;
-        completed++;
-        
-        if (progress) {
-            progress(completed, total);
-        }
+        progress.advance(run.size());
+    }
+}
+
+void BatchExecutor::run_single(size_t index, std::vector<Result>& results) const {
+    const Operation& op = operations_[index];
+    Result& result = results[index];
+    const auto start = std::chrono::steady_clock::now();
+    
+    if (op.type == Operation::Read) {
+        const auto response = op.target->read_data_by_identifier(op.did);
+        if (response.ok) result.value = response.payload;
+        fill_result(result, response, start);
+    } else {
+        const auto response = op.target->write_data_by_identifier(op.did, op.data);
+        if (response.ok) result.value = op.data;
+        fill_result(result, response, start);
+    }
+}
+
+void BatchExecutor::run_packed(const std::vector<size_t>& indices,
+                               std::vector<Result>& results) const {
+    Client& target = *operations_[indices.front()].target;
+    std::vector<DID> dids;
+    std::vector<size_t> lengths;
+    for (size_t index : indices) {
+        const uint16_t did = operations_[index].did;
+        dids.push_back(did);
+        auto it = did_lengths_.find(did);
+        lengths.push_back(it != did_lengths_.end() ? it->second : 0);
     }
     
-    return results;
+    const auto start = std::chrono::steady_clock::now();
+    size_t exchanges = 0;
+    const auto responses = read_dids_packed(target, dids, lengths, exchanges);
+    for (size_t k = 0; k < indices.size(); ++k) {
+        Result& result = results[indices[k]];
+        if (responses[k].ok) result.value = responses[k].payload;
+        fill_result(result, responses[k], start);
+    }
 }
 
 void BatchExecutor::clear() {
@@ -1,7 +1,16 @@
 #include "uds_cache.hpp"
+#include "uds_event.hpp"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace uds {
 namespace cache {
@@ -10,254 +19,1348 @@ namespace cache {
 // DIDCache Implementation
 // ============================================================================
 
+namespace {
+
+size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+void raise_peak(std::atomic<size_t>& peak, size_t value) {
+    size_t seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+constexpr char kSnapshotMagic[8] = {'U', 'D', 'S', 'C', 'S', 'N', '0', '1'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr size_t kSnapshotHeaderSize = 8 + 4 + 4 + 4 + 4;
+constexpr size_t kSnapshotIndexEntrySize = 2 + 2 + 4 + 4;
+
+template <typename T>
+void put_le(std::vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+template <typename T>
+T get_le(const uint8_t* p) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return static_cast<T>(v);
+}
+
+} // namespace
+
+// ============================================================================
+// CacheSnapshot Implementation
+// ============================================================================
+
+std::vector<uint8_t> EcuIdentity::serialize() const {
+    std::vector<uint8_t> out;
+    put_le<uint32_t>(out, tx_can_id);
+    put_le<uint32_t>(out, rx_can_id);
+    put_le<uint16_t>(out, static_cast<uint16_t>(vin.size()));
+    out.insert(out.end(), vin.begin(), vin.end());
+    put_le<uint16_t>(out, static_cast<uint16_t>(software_version.size()));
+    out.insert(out.end(), software_version.begin(), software_version.end());
+    return out;
+}
+
+CacheSnapshot::~CacheSnapshot() {
+    close();
+}
+
+bool CacheSnapshot::write(const std::string& path, const EcuIdentity& identity,
+                          const std::map<uint16_t, std::vector<uint8_t>>& entries) {
+    const std::vector<uint8_t> id = identity.serialize();
+    size_t payload_size = 0;
+    for (const auto& [did, data] : entries) {
+        payload_size += data.size();
+    }
+    
+    std::vector<uint8_t> buf;
+    buf.reserve(kSnapshotHeaderSize + id.size() + entries.size() * kSnapshotIndexEntrySize + payload_size);
+    buf.insert(buf.end(), kSnapshotMagic, kSnapshotMagic + sizeof(kSnapshotMagic));
+    put_le<uint32_t>(buf, kSnapshotVersion);
+    put_le<uint32_t>(buf, static_cast<uint32_t>(id.size()));
+    put_le<uint32_t>(buf, static_cast<uint32_t>(entries.size()));
+    put_le<uint32_t>(buf, static_cast<uint32_t>(payload_size));
+    buf.insert(buf.end(), id.begin(), id.end());
+    
+    // std::map iterates in DID order, as find() requires
+    uint32_t offset = 0;
+    for (const auto& [did, data] : entries) {
+        put_le<uint16_t>(buf, did);
+        put_le<uint16_t>(buf, 0);
+        put_le<uint32_t>(buf, offset);
+        put_le<uint32_t>(buf, static_cast<uint32_t>(data.size()));
+        offset += static_cast<uint32_t>(data.size());
+    }
+    for (const auto& [did, data] : entries) {
+        buf.insert(buf.end(), data.begin(), data.end());
+    }
+    
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        if (!file) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CacheSnapshot::open(const std::string& path, const EcuIdentity& expected) {
+    close();
+    
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kSnapshotHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    map_ = map;
+    map_size_ = size;
+    
+    const uint8_t* base = static_cast<const uint8_t*>(map_);
+    const uint32_t version = get_le<uint32_t>(base + 8);
+    const size_t id_size = get_le<uint32_t>(base + 12);
+    const size_t count = get_le<uint32_t>(base + 16);
+    const size_t payload_size = get_le<uint32_t>(base + 20);
+    const size_t index_offset = kSnapshotHeaderSize + id_size;
+    const size_t payload_offset = index_offset + count * kSnapshotIndexEntrySize;
+    
+    bool valid = std::memcmp(base, kSnapshotMagic, sizeof(kSnapshotMagic)) == 0 &&
+                 version == kSnapshotVersion &&
+                 payload_offset + payload_size == size;
+    
+    // Do not trust any data recorded for a different ECU or software
+    if (valid) {
+        const std::vector<uint8_t> id = expected.serialize();
+        valid = id.size() == id_size && std::memcmp(base + kSnapshotHeaderSize, id.data(), id_size) == 0;
+    }
+    
+    // Bounds and ordering of every entry, so find() needs no checks
+    for (size_t i = 0; valid && i < count; ++i) {
+        const uint8_t* e = base + index_offset + i * kSnapshotIndexEntrySize;
+        const uint64_t end = static_cast<uint64_t>(get_le<uint32_t>(e + 4)) + get_le<uint32_t>(e + 8);
+        valid = end <= payload_size &&
+                (i == 0 || get_le<uint16_t>(e) > get_le<uint16_t>(e - kSnapshotIndexEntrySize));
+    }
+    
+    if (!valid) {
+        close();
+        return false;
+    }
+    index_ = base + index_offset;
+    payload_ = base + payload_offset;
+    count_ = count;
+    return true;
+}
+
+void CacheSnapshot::close() {
+    if (map_) {
+        ::munmap(map_, map_size_);
+    }
+    map_ = nullptr;
+    map_size_ = 0;
+    index_ = nullptr;
+    payload_ = nullptr;
+    count_ = 0;
+}
+
+std::optional<std::vector<uint8_t>> CacheSnapshot::find(uint16_t did) const {
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const uint8_t* e = index_ + mid * kSnapshotIndexEntrySize;
+        const uint16_t entry_did = get_le<uint16_t>(e);
+        if (entry_did == did) {
+            const uint8_t* data = payload_ + get_le<uint32_t>(e + 4);
+            return std::vector<uint8_t>(data, data + get_le<uint32_t>(e + 8));
+        }
+        if (entry_did < did) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+// ============================================================================
+// PayloadArena Implementation
+// ============================================================================
+
+PayloadView PayloadView::copy_of(const std::vector<uint8_t>& data) {
+    void* memory = ::operator new(sizeof(PayloadChunk) + data.size());
+    auto* chunk = new (memory) PayloadChunk();
+    chunk->size = static_cast<uint32_t>(data.size());
+    std::copy(data.begin(), data.end(), chunk->bytes());
+    return PayloadView(chunk);
+}
+
+PayloadArena::PayloadArena() {
+    for (size_t chunk = kMinChunk; chunk <= kMaxChunk; chunk <<= 1) {
+        classes_.emplace_back();
+        classes_.back().chunk = chunk;
+    }
+}
+
+size_t PayloadArena::chunk_bytes(size_t size) {
+    const size_t needed = sizeof(PayloadChunk) + size;
+    return needed > kMaxChunk ? needed : round_up_pow2(std::max(needed, kMinChunk));
+}
+
+size_t PayloadArena::class_index(size_t bytes) {
+    size_t index = 0;
+    for (size_t chunk = kMinChunk; chunk < bytes; chunk <<= 1) {
+        ++index;
+    }
+    return index;
+}
+
+PayloadView PayloadArena::allocate(const uint8_t* data, size_t size) {
+    const size_t bytes = chunk_bytes(size);
+    PayloadChunk* chunk = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        void* memory = nullptr;
+        Slab* owner = nullptr;
+        
+        if (bytes > kMaxChunk) {
+            memory = ::operator new(bytes);
+            reserved_.fetch_add(bytes, std::memory_order_relaxed);
+        } else {
+            SizeClass& cls = classes_[class_index(bytes)];
+            for (auto& slab : cls.slabs) {
+                if (slab->free) {
+                    owner = slab.get();
+                    break;
+                }
+            }
+            if (!owner) {
+                auto slab = std::make_unique<Slab>();
+                slab->bytes = std::max(kMinSlabBytes, cls.chunk * kMinChunksPerSlab);
+                slab->memory.reset(new uint8_t[slab->bytes]);
+                // Thread the free list front to back so chunks are handed out in address order
+                for (size_t offset = slab->bytes; offset >= cls.chunk; offset -= cls.chunk) {
+                    auto* spare = reinterpret_cast<PayloadChunk*>(slab->memory.get() + offset - cls.chunk);
+                    std::memcpy(spare->bytes(), &slab->free, sizeof(PayloadChunk*));
+                    slab->free = spare;
+                }
+                reserved_.fetch_add(slab->bytes, std::memory_order_relaxed);
+                owner = slab.get();
+                cls.slabs.push_back(std::move(slab));
+            }
+            memory = owner->free;
+            std::memcpy(&owner->free, owner->free->bytes(), sizeof(PayloadChunk*));
+            owner->live++;
+        }
+        
+        chunk = new (memory) PayloadChunk();
+        chunk->arena = this;
+        chunk->slab = owner;
+        live_chunks_++;
+    }
+    chunk->size = static_cast<uint32_t>(size);
+    if (size > 0) {
+        std::memcpy(chunk->bytes(), data, size);
+    }
+    return PayloadView(chunk);
+}
+
+void PayloadArena::free_chunk(PayloadChunk* chunk) {
+    PayloadArena* arena = chunk->arena;
+    if (!arena) {
+        chunk->~PayloadChunk();
+        ::operator delete(chunk);
+        return;
+    }
+    if (arena->deallocate(chunk)) {
+        delete arena;
+    }
+}
+
+bool PayloadArena::deallocate(PayloadChunk* chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t bytes = chunk_bytes(chunk->size);
+    auto* slab = static_cast<Slab*>(chunk->slab);
+    chunk->~PayloadChunk();
+    
+    if (!slab) {
+        ::operator delete(chunk);
+        reserved_.fetch_sub(bytes, std::memory_order_relaxed);
+    } else {
+        std::memcpy(chunk->bytes(), &slab->free, sizeof(PayloadChunk*));
+        slab->free = chunk;
+        
+        // Hand an empty slab back to the heap unless it is the class's last spare
+        if (--slab->live == 0) {
+            SizeClass& cls = classes_[class_index(bytes)];
+            const size_t empty = static_cast<size_t>(std::count_if(
+                cls.slabs.begin(), cls.slabs.end(), [](const auto& s) { return s->live == 0; }));
+            if (empty > 1) {
+                reserved_.fetch_sub(slab->bytes, std::memory_order_relaxed);
+                cls.slabs.erase(std::find_if(cls.slabs.begin(), cls.slabs.end(),
+                                             [slab](const auto& s) { return s.get() == slab; }));
+            }
+        }
+    }
+    return --live_chunks_ == 0 && retired_;
+}
+
+void PayloadArena::retire() {
+    bool unused = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired_ = true;
+        unused = live_chunks_ == 0;
+    }
+    if (unused) {
+        delete this;
+    }
+}
+
+// ============================================================================
+// DIDCache
+// ============================================================================
+
 DIDCache::DIDCache(const CacheConfig& config)
     : config_(config) {
+    const size_t count = round_up_pow2(std::max<size_t>(config_.shard_count, 1));
+    shard_mask_ = count - 1;
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+size_t DIDCache::shard_index(uint16_t did) const {
+    // DIDs cluster in ranges (0xF1xx, ...): spread them with a multiplicative hash
+    const uint32_t h = (static_cast<uint32_t>(did) * 0x9E3779B1u) >> 16;
+    return h & shard_mask_;
+}
+
+DIDCache::Shard& DIDCache::shard_for(uint16_t did) const {
+    return *shards_[shard_index(did)];
 }
 
 std::optional<std::vector<uint8_t>> DIDCache::get(uint16_t did) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::optional<PayloadView> view = get_view(did);
+    if (!view) {
+        return std::nullopt;
+    }
+    return view->to_vector();
+}
+
+std::optional<PayloadView> DIDCache::get_view(uint16_t did) {
+    std::optional<PayloadView> view;
+    bool restored = false;
+    {
+        Shard& shard = shard_for(did);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        
+        CacheEntry* entry = shard.find_live(*this, did, restored);
+        if (!entry) {
+            return std::nullopt;
+        }
+        view = entry->data;
+    }
+    // A snapshot restore adds an entry, which may push the cache over its limits
+    if (restored) {
+        enforce_limits();
+    }
+    return view;
+}
+
+CacheLookup DIDCache::lookup(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::unique_lock<std::mutex> lock(shard.mutex);
     
-    auto it = entries_.find(did);
-    if (it == entries_.end()) {
+    auto it = shard.entries.find(did);
+    if (it == shard.entries.end()) {
+        if (CacheEntry* restored = shard.restore(*this, did)) {
+            restored->touch();
+            if (config_.enable_statistics) {
+                shard.stats.hits++;
+            }
+            CacheLookup result{restored->data, false};
+            lock.unlock();
+            enforce_limits();
+            return result;
+        }
         if (config_.enable_statistics) {
-            stats_.misses++;
+            shard.stats.misses++;
         }
-        return std::nullopt;
+        return {};
     }
     
-    // Check expiration
     if (it->second.is_expired()) {
-        remove_entry(did);
+        shard.remove_entry(*this, did);
         if (config_.enable_statistics) {
-            stats_.misses++;
-            stats_.expirations++;
+            shard.stats.misses++;
+            shard.stats.expirations++;
+        }
+        return {};
+    }
+    
+    it->second.touch();
+    shard.update_lru(did);
+    
+    if (config_.enable_statistics) {
+        shard.stats.hits++;
+    }
+    shard.note_hit(it->second);
+    
+    return {it->second.data, it->second.is_stale()};
+}
+
+void DIDCache::put(uint16_t did, const std::vector<uint8_t>& data,
+                   std::optional<std::chrono::milliseconds> ttl,
+                   std::optional<ExpirationPolicy> policy) {
+    {
+        Shard& shard = shard_for(did);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        
+        if (has_snapshot_.load(std::memory_order_acquire)) {
+            shard.snapshot_done.insert(did);
         }
+        shard.insert(*this, did, data, ttl, policy);
+    }
+    enforce_limits();
+}
+
+bool DIDCache::contains(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.entries.find(did);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    
+    if (it->second.is_expired()) {
+        shard.remove_entry(*this, did);
+        shard.stats.expirations++;
+        return false;
+    }
+    
+    return !it->second.is_stale();
+}
+
+void DIDCache::invalidate(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    if (has_snapshot_.load(std::memory_order_acquire)) {
+        shard.snapshot_done.insert(did);
+    }
+    
+    if (shard.entries.count(did)) {
+        shard.remove_entry(*this, did);
+        shard.stats.invalidations++;
+    }
+}
+
+void DIDCache::invalidate_range(uint16_t start_did, uint16_t end_did) {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        
+        std::vector<uint16_t> to_remove;
+        for (const auto& [did, entry] : shard->entries) {
+            if (did >= start_did && did <= end_did) {
+                to_remove.push_back(did);
+            }
+        }
+        
+        for (uint16_t did : to_remove) {
+            shard->remove_entry(*this, did);
+            shard->stats.invalidations++;
+        }
+    }
+}
+
+void DIDCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        
+        std::vector<uint16_t> all;
+        all.reserve(shard->entries.size());
+        for (const auto& [did, entry] : shard->entries) all.push_back(did);
+        for (uint16_t did : all) shard->remove_entry(*this, did);
+    }
+}
+
+std::map<uint16_t, std::vector<uint8_t>> DIDCache::get_multiple(const std::vector<uint16_t>& dids) {
+    std::map<uint16_t, std::vector<uint8_t>> result;
+    
+    for (uint16_t did : dids) {
+        auto data = get(did);
+        if (data) {
+            result[did] = *data;
+        }
+    }
+    
+    return result;
+}
+
+void DIDCache::put_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries) {
+    store_multiple(entries, false);
+}
+
+void DIDCache::put_prefetched(const std::map<uint16_t, std::vector<uint8_t>>& entries) {
+    store_multiple(entries, true);
+}
+
+void DIDCache::store_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries, bool prefetched) {
+    // Bucket by shard so each shard is locked once
+    std::vector<std::vector<uint16_t>> buckets(shards_.size());
+    for (const auto& [did, data] : entries) {
+        buckets[shard_index(did)].push_back(did);
+    }
+    
+    const bool snapshot_attached = has_snapshot_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i].empty()) {
+            continue;
+        }
+        {
+            Shard& shard = *shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (uint16_t did : buckets[i]) {
+                if (snapshot_attached) {
+                    shard.snapshot_done.insert(did);
+                }
+                CacheEntry* entry = shard.insert(*this, did, entries.at(did), std::nullopt, std::nullopt);
+                if (entry && prefetched) {
+                    entry->prefetched = true;
+                    shard.stats.prefetches++;
+                }
+            }
+        }
+        enforce_limits();
+    }
+}
+
+std::vector<uint16_t> DIDCache::uncached(const std::vector<uint16_t>& dids) {
+    std::vector<uint16_t> missing;
+    bool restored = false;
+    for (uint16_t did : dids) {
+        Shard& shard = shard_for(did);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        
+        if (shard.non_cacheable.count(did)) {
+            continue;
+        }
+        auto it = shard.entries.find(did);
+        if (it == shard.entries.end()) {
+            if (shard.restore(*this, did)) {
+                restored = true;
+            } else {
+                missing.push_back(did);
+            }
+            continue;
+        }
+        if (it->second.is_expired()) {
+            shard.remove_entry(*this, did);
+            shard.stats.expirations++;
+            missing.push_back(did);
+        } else if (it->second.is_stale()) {
+            missing.push_back(did);
+        }
+    }
+    if (restored) {
+        enforce_limits();
+    }
+    return missing;
+}
+
+void DIDCache::set_did_ttl(uint16_t did, std::chrono::milliseconds ttl) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.did_ttls[did] = ttl;
+}
+
+void DIDCache::set_did_policy(uint16_t did, ExpirationPolicy policy) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.did_policies[did] = policy;
+}
+
+std::optional<ExpirationPolicy> DIDCache::did_policy(uint16_t did) const {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.did_policies.find(did);
+    if (it == shard.did_policies.end()) {
         return std::nullopt;
     }
+    return it->second;
+}
+
+void DIDCache::clear_did_policy(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.did_policies.erase(did);
+}
+
+void DIDCache::set_non_cacheable(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.non_cacheable.insert(did);
+    
+    // Remove from cache if present
+    if (shard.entries.count(did)) {
+        shard.remove_entry(*this, did);
+    }
+}
+
+void DIDCache::set_cacheable(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.non_cacheable.erase(did);
+}
+
+bool DIDCache::is_cacheable(uint16_t did) const {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.non_cacheable.count(did) == 0;
+}
+
+void DIDCache::set_did_persistent(uint16_t did) {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.persistent.insert(did);
+}
+
+bool DIDCache::is_persistent(uint16_t did) const {
+    Shard& shard = shard_for(did);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.persistent.count(did) != 0;
+}
+
+bool DIDCache::save_snapshot(const std::string& path, const EcuIdentity& identity) const {
+    std::map<uint16_t, std::vector<uint8_t>> entries;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& [did, entry] : shard->entries) {
+            if (shard->persistent.count(did) && !entry.is_expired()) {
+                entries.emplace(did, entry.data.to_vector());
+            }
+        }
+    }
+    return CacheSnapshot::write(path, identity, entries);
+}
+
+bool DIDCache::attach_snapshot(const std::string& path, const EcuIdentity& identity) {
+    auto snapshot = std::make_shared<CacheSnapshot>();
+    if (!snapshot->open(path, identity)) {
+        return false;
+    }
+    
+    // Every DID may be restored once from the new snapshot
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->snapshot_done.clear();
+    }
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    snapshot_ = std::move(snapshot);
+    has_snapshot_.store(true, std::memory_order_release);
+    return true;
+}
+
+void DIDCache::detach_snapshot() {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    has_snapshot_.store(false, std::memory_order_release);
+    snapshot_.reset();
+}
+
+std::shared_ptr<const CacheSnapshot> DIDCache::snapshot() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    return snapshot_;
+}
+
+CacheStats DIDCache::stats() const {
+    CacheStats total;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total.hits += shard->stats.hits;
+        total.misses += shard->stats.misses;
+        total.evictions += shard->stats.evictions;
+        total.expirations += shard->stats.expirations;
+        total.invalidations += shard->stats.invalidations;
+        total.snapshot_loads += shard->stats.snapshot_loads;
+        total.prefetches += shard->stats.prefetches;
+        total.prefetch_hits += shard->stats.prefetch_hits;
+    }
+    total.current_entries = current_entries_.load(std::memory_order_relaxed);
+    total.current_memory = current_memory_.load(std::memory_order_relaxed);
+    for (const auto& shard : shards_) {
+        total.reserved_memory += shard->arena->reserved_bytes();
+    }
+    total.peak_entries = peak_entries_.load(std::memory_order_relaxed);
+    total.peak_memory = peak_memory_.load(std::memory_order_relaxed);
+    return total;
+}
+
+void DIDCache::reset_stats() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->stats.reset();
+    }
+}
+
+size_t DIDCache::cleanup_expired() {
+    size_t removed = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        
+        std::vector<uint16_t> expired;
+        for (const auto& [did, entry] : shard->entries) {
+            if (entry.is_expired()) {
+                expired.push_back(did);
+            }
+        }
+        
+        for (uint16_t did : expired) {
+            shard->remove_entry(*this, did);
+            shard->stats.expirations++;
+        }
+        removed += expired.size();
+    }
+    
+    return removed;
+}
+
+size_t DIDCache::size() const {
+    return current_entries_.load(std::memory_order_relaxed);
+}
+
+size_t DIDCache::memory_usage() const {
+    return current_memory_.load(std::memory_order_relaxed);
+}
+
+bool DIDCache::over_limits() const {
+    return current_entries_.load(std::memory_order_relaxed) > std::max<size_t>(config_.max_entries, 1) ||
+           current_memory_.load(std::memory_order_relaxed) > config_.max_memory_bytes;
+}
+
+void DIDCache::enforce_limits() {
+    // Evict the least recently used entry across all shards until the cache
+    // is back within its limits, holding at most one shard lock at a time
+    while (over_limits()) {
+        Shard* victim = nullptr;
+        auto oldest = std::chrono::steady_clock::time_point::max();
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            if (shard->lru_list.empty()) {
+                continue;
+            }
+            const CacheEntry& tail = shard->entries.at(shard->lru_list.back());
+            if (tail.last_accessed <= oldest) {
+                oldest = tail.last_accessed;
+                victim = shard.get();
+            }
+        }
+        if (!victim) {
+            break;
+        }
+        
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->lru_list.empty() && over_limits()) {
+            victim->remove_entry(*this, victim->lru_list.back());
+            victim->stats.evictions++;
+        }
+    }
+    raise_peak(peak_entries_, current_entries_.load(std::memory_order_relaxed));
+    raise_peak(peak_memory_, current_memory_.load(std::memory_order_relaxed));
+}
+
+void DIDCache::Shard::note_hit(CacheEntry& entry) {
+    if (entry.prefetched) {
+        entry.prefetched = false;
+        stats.prefetch_hits++;
+    }
+}
+
+CacheEntry* DIDCache::Shard::find_live(DIDCache& owner, uint16_t did, bool& restored) {
+    const bool counting = owner.config_.enable_statistics;
+    
+    auto it = entries.find(did);
+    if (it == entries.end()) {
+        if (CacheEntry* entry = restore(owner, did)) {
+            restored = true;
+            entry->touch();
+            if (counting) {
+                stats.hits++;
+            }
+            return entry;
+        }
+        if (counting) {
+            stats.misses++;
+        }
+        return nullptr;
+    }
+    
+    // Check expiration
+    if (it->second.is_expired()) {
+        remove_entry(owner, did);
+        if (counting) {
+            stats.misses++;
+            stats.expirations++;
+        }
+        return nullptr;
+    }
+    
+    // Stale entries are left in place for lookup()
+    if (it->second.is_stale()) {
+        if (counting) {
+            stats.misses++;
+        }
+        return nullptr;
+    }
     
     // Update access
     it->second.touch();
     update_lru(did);
     
+    if (counting) {
+        stats.hits++;
+    }
+    note_hit(it->second);
+    
+    return &it->second;
+}
+
+CacheEntry* DIDCache::Shard::insert(DIDCache& owner, uint16_t did, const std::vector<uint8_t>& data,
+                                    std::optional<std::chrono::milliseconds> ttl,
+                                    std::optional<ExpirationPolicy> policy) {
+    // Check if non-cacheable
+    if (non_cacheable.count(did)) {
+        return nullptr;
+    }
+    
+    // Determine TTL and policy
+    auto ttl_it = did_ttls.find(did);
+    auto policy_it = did_policies.find(did);
+    auto effective_ttl = ttl.value_or(
+        ttl_it != did_ttls.end() ? ttl_it->second : owner.config_.default_ttl);
+    auto effective_policy = policy.value_or(
+        policy_it != did_policies.end() ? policy_it->second : owner.config_.default_policy);
+    
+    // Remove existing entry if present
+    if (entries.count(did)) {
+        remove_entry(owner, did);
+    }
+    
+    // An entry larger than the whole budget would only flush the cache
+    const size_t bytes = PayloadArena::chunk_bytes(data.size());
+    if (bytes + sizeof(CacheEntry) > owner.config_.max_memory_bytes) {
+        return nullptr;
+    }
+    
+    // Create entry
+    CacheEntry entry(arena->allocate(data.data(), data.size()), bytes, effective_ttl, effective_policy);
+    if (effective_policy == ExpirationPolicy::StaleWhileRevalidate) {
+        entry.max_stale = owner.config_.max_staleness;
+    }
+    const size_t entry_size = entry.memory_size;
+    auto inserted = entries.emplace(did, std::move(entry)).first;
+    
+    // Add to LRU
+    lru_list.push_front(did);
+    lru_map[did] = lru_list.begin();
+    
+    // Update totals
+    stats.current_entries = entries.size();
+    stats.current_memory += entry_size;
+    // Limits and peaks are settled by enforce_limits() once the lock is released
+    owner.current_entries_.fetch_add(1, std::memory_order_relaxed);
+    owner.current_memory_.fetch_add(entry_size, std::memory_order_relaxed);
+    return &inserted->second;
+}
+
+CacheEntry* DIDCache::Shard::restore(DIDCache& owner, uint16_t did) {
+    if (!owner.has_snapshot_.load(std::memory_order_acquire) || non_cacheable.count(did) ||
+        !snapshot_done.insert(did).second) {
+        return nullptr;
+    }
+    auto snapshot = owner.snapshot();
+    if (!snapshot) {
+        return nullptr;
+    }
+    auto data = snapshot->find(did);
+    if (!data) {
+        return nullptr;
+    }
+    stats.snapshot_loads++;
+    return insert(owner, did, *data, std::nullopt, std::nullopt);
+}
+
+void DIDCache::Shard::update_lru(uint16_t did) {
+    auto it = lru_map.find(did);
+    if (it != lru_map.end()) {
+        // Move to front without reallocating the node
+        lru_list.splice(lru_list.begin(), lru_list, it->second);
+    }
+}
+
+void DIDCache::Shard::remove_entry(DIDCache& owner, uint16_t did) {
+    auto entry_it = entries.find(did);
+    if (entry_it != entries.end()) {
+        const size_t size = entry_it->second.memory_size;
+        stats.current_memory -= size;
+        owner.current_memory_.fetch_sub(size, std::memory_order_relaxed);
+        owner.current_entries_.fetch_sub(1, std::memory_order_relaxed);
+        entries.erase(entry_it);
+    }
+    
+    auto lru_it = lru_map.find(did);
+    if (lru_it != lru_map.end()) {
+        lru_list.erase(lru_it->second);
+        lru_map.erase(lru_it);
+    }
+    
+    stats.current_entries = entries.size();
+}
+
+// ============================================================================
+// FlatDIDCache Implementation
+// ============================================================================
+
+bool FlatDIDCache::Slot::is_expired(std::chrono::steady_clock::time_point now) const {
+    if (policy == ExpirationPolicy::Never) {
+        return false;
+    }
+    auto reference = (policy == ExpirationPolicy::TimeToIdle ||
+                      policy == ExpirationPolicy::Sliding)
+                     ? last_accessed : created;
+    return (now - reference) > ttl;
+}
+
+FlatDIDCache::FlatDIDCache(const CacheConfig& config)
+    : config_(config), index_(0x10000, kNoSlot), did_flags_(0x10000, 0) {
+    const size_t capacity = std::clamp<size_t>(config_.max_entries, 1, kNoSlot);
+    slots_.resize(capacity);
+    free_slots_.reserve(capacity);
+    // Hand out low slots first so live entries stay dense
+    for (size_t i = capacity; i-- > 0;) {
+        free_slots_.push_back(static_cast<uint16_t>(i));
+    }
+    live_bits_.assign((capacity + 63) / 64, 0);
+    ref_bits_.assign((capacity + 63) / 64, 0);
+}
+
+std::optional<std::vector<uint8_t>> FlatDIDCache::get(uint16_t did) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const uint16_t slot = slot_of(did);
+    if (slot == kNoSlot) {
+        if (config_.enable_statistics) {
+            stats_.misses++;
+        }
+        return std::nullopt;
+    }
+
+    Slot& s = slots_[slot];
+    const auto now = std::chrono::steady_clock::now();
+    if (s.is_expired(now)) {
+        remove_slot(slot);
+        if (config_.enable_statistics) {
+            stats_.misses++;
+            stats_.expirations++;
+        }
+        return std::nullopt;
+    }
+
+    s.last_accessed = now;
+    s.hit_count++;
+    ref_bits_[slot >> 6] |= uint64_t{1} << (slot & 63);
+
     if (config_.enable_statistics) {
         stats_.hits++;
     }
-    
-    return it->second.data;
+
+    const uint8_t* payload = arena_.data() + s.offset;
+    return std::vector<uint8_t>(payload, payload + s.length);
 }
 
-void DIDCache::put(uint16_t did, const std::vector<uint8_t>& data,
-                   std::optional<std::chrono::milliseconds> ttl,
-                   std::optional<ExpirationPolicy> policy) {
-    // Check if non-cacheable
-    if (non_cacheable_.count(did)) {
+void FlatDIDCache::put(uint16_t did, const std::vector<uint8_t>& data,
+                       std::optional<std::chrono::milliseconds> ttl,
+                       std::optional<ExpirationPolicy> policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const uint8_t flags = did_flags_[did];
+    if (flags & kNonCacheable) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Determine TTL and policy
+
+    // Per-DID overrides are only looked up for DIDs that have one
     auto effective_ttl = ttl.value_or(
-        did_ttls_.count(did) ? did_ttls_[did] : config_.default_ttl);
+        (flags & kHasTtl) ? did_ttls_.at(did) : config_.default_ttl);
     auto effective_policy = policy.value_or(
-        did_policies_.count(did) ? did_policies_[did] : config_.default_policy);
-    
-    // Remove existing entry if present
-    if (entries_.count(did)) {
-        remove_entry(did);
+        (flags & kHasPolicy) ? did_policies_.at(did) : config_.default_policy);
+
+    const size_t entry_size = data.size() + sizeof(Slot);
+    uint16_t slot = slot_of(did);
+
+    if (slot != kNoSlot && data.size() <= slots_[slot].length) {
+        // Refresh in place; the tail of the old payload becomes dead space
+        Slot& s = slots_[slot];
+        arena_dead_ += s.length - data.size();
+        stats_.current_memory -= s.length - data.size();
+        s.length = static_cast<uint32_t>(data.size());
+    } else {
+        if (slot != kNoSlot) {
+            remove_slot(slot);
+        }
+        if (entry_size > config_.max_memory_bytes) {
+            return;
+        }
+
+        // Make room by count and by memory
+        while (free_slots_.empty() ||
+               stats_.current_memory + entry_size > config_.max_memory_bytes) {
+            remove_slot(clock_victim());
+            stats_.evictions++;
+        }
+
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        Slot& s = slots_[slot];
+        s.did = did;
+        s.length = static_cast<uint32_t>(data.size());
+        s.offset = static_cast<uint32_t>(arena_alloc(data.size()));
+        index_[did] = slot;
+        live_bits_[slot >> 6] |= uint64_t{1} << (slot & 63);
+        stats_.current_entries++;
+        stats_.current_memory += entry_size;
     }
-    
-    // Evict if needed
-    evict_if_needed();
-    
-    // Create entry
-    CacheEntry entry(data, effective_ttl, effective_policy);
-    entries_[did] = entry;
-    
-    // Add to LRU
-    lru_list_.push_front(did);
-    lru_map_[did] = lru_list_.begin();
-    
-    // Update stats
-    stats_.current_entries = entries_.size();
-    stats_.current_memory += entry.memory_size;
+
+    Slot& s = slots_[slot];
+    if (!data.empty()) {
+        std::memcpy(arena_.data() + s.offset, data.data(), data.size());
+    }
+    s.created = std::chrono::steady_clock::now();
+    s.last_accessed = s.created;
+    s.ttl = effective_ttl;
+    s.policy = effective_policy;
+    s.hit_count = 0;
+    // A new entry starts without a second chance, as at the LRU tail
+    ref_bits_[slot >> 6] &= ~(uint64_t{1} << (slot & 63));
+
     stats_.peak_entries = std::max(stats_.peak_entries, stats_.current_entries);
     stats_.peak_memory = std::max(stats_.peak_memory, stats_.current_memory);
 }
 
-bool DIDCache::contains(uint16_t did) {
+bool FlatDIDCache::contains(uint16_t did) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = entries_.find(did);
-    if (it == entries_.end()) {
+
+    const uint16_t slot = slot_of(did);
+    if (slot == kNoSlot) {
         return false;
     }
-    
-    if (it->second.is_expired()) {
-        remove_entry(did);
+    if (slots_[slot].is_expired(std::chrono::steady_clock::now())) {
+        remove_slot(slot);
         stats_.expirations++;
         return false;
     }
-    
     return true;
 }
 
-void DIDCache::invalidate(uint16_t did) {
+void FlatDIDCache::invalidate(uint16_t did) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (entries_.count(did)) {
-        remove_entry(did);
+
+    const uint16_t slot = slot_of(did);
+    if (slot != kNoSlot) {
+        remove_slot(slot);
         stats_.invalidations++;
     }
 }
 
-void DIDCache::invalidate_range(uint16_t start_did, uint16_t end_did) {
+void FlatDIDCache::invalidate_range(uint16_t start_did, uint16_t end_did) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::vector<uint16_t> to_remove;
-    for (const auto& [did, entry] : entries_) {
-        if (did >= start_did && did <= end_did) {
-            to_remove.push_back(did);
+
+    // The index is ordered by DID, so a range is a linear scan of it
+    for (uint32_t did = start_did; did <= end_did; ++did) {
+        const uint16_t slot = index_[did];
+        if (slot != kNoSlot) {
+            remove_slot(slot);
+            stats_.invalidations++;
         }
     }
-    
-    for (uint16_t did : to_remove) {
-        remove_entry(did);
-        stats_.invalidations++;
-    }
 }
 
-void DIDCache::clear() {
+void FlatDIDCache::clear() {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    entries_.clear();
-    lru_list_.clear();
-    lru_map_.clear();
-    stats_.current_entries = 0;
-    stats_.current_memory = 0;
+
+    for (size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (live(slot)) {
+            remove_slot(static_cast<uint16_t>(slot));
+        }
+    }
+    arena_top_ = 0;
+    arena_dead_ = 0;
 }
 
-std::map<uint16_t, std::vector<uint8_t>> DIDCache::get_multiple(const std::vector<uint16_t>& dids) {
+std::map<uint16_t, std::vector<uint8_t>> FlatDIDCache::get_multiple(const std::vector<uint16_t>& dids) {
     std::map<uint16_t, std::vector<uint8_t>> result;
-    
+
     for (uint16_t did : dids) {
         auto data = get(did);
         if (data) {
-            result[did] = *data;
+            result[did] = std::move(*data);
         }
     }
-    
+
     return result;
 }
 
-void DIDCache::put_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries) {
+void FlatDIDCache::put_multiple(const std::map<uint16_t, std::vector<uint8_t>>& entries) {
     for (const auto& [did, data] : entries) {
         put(did, data);
     }
 }
 
-void DIDCache::set_did_ttl(uint16_t did, std::chrono::milliseconds ttl) {
+void FlatDIDCache::set_did_ttl(uint16_t did, std::chrono::milliseconds ttl) {
     std::lock_guard<std::mutex> lock(mutex_);
     did_ttls_[did] = ttl;
+    did_flags_[did] |= kHasTtl;
 }
 
-void DIDCache::set_did_policy(uint16_t did, ExpirationPolicy policy) {
+void FlatDIDCache::set_did_policy(uint16_t did, ExpirationPolicy policy) {
     std::lock_guard<std::mutex> lock(mutex_);
     did_policies_[did] = policy;
+    did_flags_[did] |= kHasPolicy;
 }
 
-void DIDCache::set_non_cacheable(uint16_t did) {
+void FlatDIDCache::set_non_cacheable(uint16_t did) {
     std::lock_guard<std::mutex> lock(mutex_);
-    non_cacheable_.insert(did);
-    
-    // Remove from cache if present
-    if (entries_.count(did)) {
-        remove_entry(did);
+    did_flags_[did] |= kNonCacheable;
+
+    const uint16_t slot = slot_of(did);
+    if (slot != kNoSlot) {
+        remove_slot(slot);
     }
 }
 
-bool DIDCache::is_cacheable(uint16_t did) const {
+bool FlatDIDCache::is_cacheable(uint16_t did) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return non_cacheable_.count(did) == 0;
+    return (did_flags_[did] & kNonCacheable) == 0;
 }
 
-CacheStats DIDCache::stats() const {
+CacheStats FlatDIDCache::stats() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return stats_;
 }
 
-void DIDCache::reset_stats() {
+void FlatDIDCache::reset_stats() {
     std::lock_guard<std::mutex> lock(mutex_);
     stats_.reset();
 }
 
-size_t DIDCache::cleanup_expired() {
+size_t FlatDIDCache::cleanup_expired() {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::vector<uint16_t> expired;
-    for (const auto& [did, entry] : entries_) {
-        if (entry.is_expired()) {
-            expired.push_back(did);
+
+    const auto now = std::chrono::steady_clock::now();
+    size_t removed = 0;
+    for (size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (live(slot) && slots_[slot].is_expired(now)) {
+            remove_slot(static_cast<uint16_t>(slot));
+            stats_.expirations++;
+            removed++;
         }
     }
-    
-    for (uint16_t did : expired) {
-        remove_entry(did);
-        stats_.expirations++;
-    }
-    
-    return expired.size();
+    return removed;
 }
 
-size_t DIDCache::size() const {
+size_t FlatDIDCache::size() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return entries_.size();
+    return stats_.current_entries;
 }
 
-size_t DIDCache::memory_usage() const {
+size_t FlatDIDCache::memory_usage() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return stats_.current_memory;
 }
 
-void DIDCache::evict_if_needed() {
-    // Evict by count
-    while (entries_.size() >= config_.max_entries && !lru_list_.empty()) {
-        uint16_t lru_did = lru_list_.back();
-        remove_entry(lru_did);
-        stats_.evictions++;
+size_t FlatDIDCache::arena_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arena_.size();
+}
+
+void FlatDIDCache::remove_slot(uint16_t slot) {
+    Slot& s = slots_[slot];
+    index_[s.did] = kNoSlot;
+    live_bits_[slot >> 6] &= ~(uint64_t{1} << (slot & 63));
+    ref_bits_[slot >> 6] &= ~(uint64_t{1} << (slot & 63));
+    arena_dead_ += s.length;
+    stats_.current_entries--;
+    stats_.current_memory -= s.length + sizeof(Slot);
+    s.length = 0;
+    free_slots_.push_back(slot);
+}
+
+uint16_t FlatDIDCache::clock_victim() {
+    // Callers guarantee at least one live slot, so this ends within two sweeps
+    for (;;) {
+        const size_t word = hand_ >> 6;
+        const uint64_t bit = uint64_t{1} << (hand_ & 63);
+        const size_t slot = hand_;
+        hand_ = (hand_ + 1 == slots_.size()) ? 0 : hand_ + 1;
+
+        if (!(live_bits_[word] & bit)) {
+            continue;
+        }
+        if (ref_bits_[word] & bit) {
+            ref_bits_[word] &= ~bit;  // second chance
+            continue;
+        }
+        return static_cast<uint16_t>(slot);
     }
-    
-    // Evict by memory
-    while (stats_.current_memory > config_.max_memory_bytes && !lru_list_.empty()) {
-        uint16_t lru_did = lru_list_.back();
-        remove_entry(lru_did);
-        stats_.evictions++;
+}
+
+size_t FlatDIDCache::arena_alloc(size_t length) {
+    if (arena_dead_ > arena_top_ / 2) {
+        compact_arena();
     }
+    if (arena_top_ + length > arena_.size()) {
+        arena_.resize(std::max(arena_top_ + length, arena_.size() * 2));
+    }
+    const size_t offset = arena_top_;
+    arena_top_ += length;
+    return offset;
 }
 
-void DIDCache::update_lru(uint16_t did) {
-    auto it = lru_map_.find(did);
-    if (it != lru_map_.end()) {
-        lru_list_.erase(it->second);
-        lru_list_.push_front(did);
-        lru_map_[did] = lru_list_.begin();
+void FlatDIDCache::compact_arena() {
+    // Slide live payloads down in address order; each move is to a lower offset
+    std::vector<uint16_t> order;
+    order.reserve(stats_.current_entries);
+    for (size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (live(slot)) {
+            order.push_back(static_cast<uint16_t>(slot));
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](uint16_t a, uint16_t b) {
+        return slots_[a].offset < slots_[b].offset;
+    });
+
+    size_t top = 0;
+    for (uint16_t slot : order) {
+        Slot& s = slots_[slot];
+        if (s.offset != top && s.length > 0) {
+            std::memmove(arena_.data() + top, arena_.data() + s.offset, s.length);
+        }
+        s.offset = static_cast<uint32_t>(top);
+        top += s.length;
     }
+    arena_top_ = top;
+    arena_dead_ = 0;
+    arena_.resize(std::max(top * 2, size_t{256}));
+    arena_.shrink_to_fit();
 }
 
-void DIDCache::remove_entry(uint16_t did) {
-    auto entry_it = entries_.find(did);
-    if (entry_it != entries_.end()) {
-        stats_.current_memory -= entry_it->second.memory_size;
-        entries_.erase(entry_it);
+// ============================================================================
+// AccessPredictor Implementation
+// ============================================================================
+
+void AccessPredictor::observe(uint16_t did) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    const std::optional<uint16_t> previous = last_;
+    last_ = did;
+    if (!previous || *previous == did) {
+        return;
+    }
+    
+    auto it = rows_.find(*previous);
+    if (it == rows_.end()) {
+        if (rows_.size() >= max_tracked_) {
+            return;
+        }
+        it = rows_.emplace(*previous, Row{}).first;
+    }
+    Row& row = it->second;
+    
+    auto next = std::find_if(row.next.begin(), row.next.end(),
+                             [did](const Successor& s) { return s.did == did; });
+    if (next != row.next.end()) {
+        next->count++;
+    } else if (row.next.size() < kMaxSuccessors) {
+        row.next.push_back({did, 1});
+    } else {
+        // Space-saving: the newcomer inherits the weakest slot's count
+        auto weakest = std::min_element(row.next.begin(), row.next.end(),
+                                        [](const Successor& a, const Successor& b) { return a.count < b.count; });
+        *weakest = {did, weakest->count + 1};
+    }
+    
+    if (++row.total >= kAgingThreshold) {
+        row.total = 0;
+        for (auto& s : row.next) {
+            s.count = (s.count + 1) / 2;
+            row.total += s.count;
+        }
     }
+}
+
+std::vector<uint16_t> AccessPredictor::predict(uint16_t did, size_t max, double min_probability,
+                                               uint32_t min_count) const {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    auto lru_it = lru_map_.find(did);
-    if (lru_it != lru_map_.end()) {
-        lru_list_.erase(lru_it->second);
-        lru_map_.erase(lru_it);
+    std::vector<uint16_t> result;
+    auto it = rows_.find(did);
+    if (it == rows_.end() || it->second.total == 0) {
+        return result;
     }
     
-    stats_.current_entries = entries_.size();
+    std::vector<Successor> ranked = it->second.next;
+    std::sort(ranked.begin(), ranked.end(),
+              [](const Successor& a, const Successor& b) { return a.count > b.count; });
+    for (const auto& s : ranked) {
+        if (result.size() >= max) {
+            break;
+        }
+        const double share = static_cast<double>(s.count) / it->second.total;
+        if (s.count >= min_count && share >= min_probability) {
+            result.push_back(s.did);
+        }
+    }
+    return result;
+}
+
+void AccessPredictor::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rows_.clear();
+    last_.reset();
+}
+
+size_t AccessPredictor::tracked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rows_.size();
 }
 
 // ============================================================================
@@ -272,10 +1375,11 @@ CachedClient::CachedClient(Client& client, const CacheConfig& config)
         cache_.set_non_cacheable(did);
     }
     
-    // Configure static DIDs with long TTL
+    // Configure static DIDs with long TTL, kept across restarts in snapshots
     for (uint16_t did : did_categories::static_dids()) {
         cache_.set_did_ttl(did, std::chrono::hours(24));
         cache_.set_did_policy(did, ExpirationPolicy::TimeToIdle);
+        cache_.set_did_persistent(did);
     }
     
     // Configure session DIDs
@@ -284,19 +1388,228 @@ CachedClient::CachedClient(Client& client, const CacheConfig& config)
     }
 }
 
+CachedClient::~CachedClient() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex_);
+        stopping_ = true;
+    }
+    stop_token_.cancel();   // abandons a refresh waiting on the bus
+    refresh_cv_.notify_all();
+    if (refresher_.joinable()) {
+        refresher_.join();
+    }
+    if (listener_.joinable()) {
+        listener_.join();
+    }
+}
+
+std::optional<std::vector<uint8_t>> CachedClient::cached_value(uint16_t did) {
+    auto found = cache_.lookup(did);
+    if (found.data && found.stale) {
+        {
+            std::lock_guard<std::mutex> lock(refresh_mutex_);
+            revalidation_stats_.stale_served++;
+        }
+        schedule_refresh(did);
+    }
+    if (!found.data) {
+        return std::nullopt;
+    }
+    return found.data->to_vector();   // copied outside the shard lock
+}
+
+void CachedClient::schedule_refresh(uint16_t did) {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    if (stopping_ || !refresh_pending_.insert(did).second) {
+        return;   // already queued or running
+    }
+    refresh_queue_.push_back(did);
+    start_worker();
+    refresh_cv_.notify_one();
+}
+
+void CachedClient::start_worker() {
+    if (!refresher_.joinable()) {
+        refresher_ = std::thread([this] { refresh_loop(); });
+    }
+}
+
+void CachedClient::note_access(const std::vector<uint16_t>& dids) {
+    for (uint16_t did : dids) {
+        predictor_.observe(did);
+    }
+    if (!prefetch_enabled_.load(std::memory_order_relaxed) || dids.empty()) {
+        return;
+    }
+    
+    PrefetchConfig config = prefetch_config();
+    std::vector<uint16_t> candidates;
+    for (uint16_t next : predictor_.predict(dids.back(), config.max_predictions,
+                                            config.min_probability, config.min_count)) {
+        if (std::find(dids.begin(), dids.end(), next) == dids.end()) {
+            candidates.push_back(next);
+        }
+    }
+    candidates = cache_.uncached(candidates);
+    if (candidates.empty()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    if (stopping_) {
+        return;
+    }
+    for (uint16_t did : candidates) {
+        if (!prefetch_pending_.insert(did).second) {
+            continue;
+        }
+        prefetch_queue_.push_back(did);
+        // Keep only the most recent predictions
+        if (prefetch_queue_.size() > kMaxQueuedPrefetches) {
+            prefetch_pending_.erase(prefetch_queue_.front());
+            prefetch_queue_.pop_front();
+        }
+    }
+    start_worker();
+    refresh_cv_.notify_one();
+}
+
+bool CachedClient::take_prefetch_token(std::chrono::steady_clock::time_point now,
+                                       std::chrono::steady_clock::duration& wait) {
+    const PrefetchConfig& config = prefetch_config_;
+    if (config.requests_per_second <= 0.0) {
+        wait = std::chrono::seconds(1);
+        return false;
+    }
+    const double elapsed = std::chrono::duration<double>(now - prefetch_refill_).count();
+    prefetch_tokens_ = std::min(config.burst, prefetch_tokens_ + elapsed * config.requests_per_second);
+    prefetch_refill_ = now;
+    if (prefetch_tokens_ >= 1.0) {
+        prefetch_tokens_ -= 1.0;
+        return true;
+    }
+    wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>((1.0 - prefetch_tokens_) / config.requests_per_second));
+    return false;
+}
+
+void CachedClient::set_prefetch(const PrefetchConfig& config) {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    prefetch_config_ = config;
+    prefetch_tokens_ = config.burst;
+    prefetch_refill_ = std::chrono::steady_clock::now();
+    prefetch_enabled_.store(config.enabled);
+    if (!config.enabled) {
+        prefetch_queue_.clear();
+        prefetch_pending_.clear();
+    }
+}
+
+PrefetchConfig CachedClient::prefetch_config() const {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    return prefetch_config_;
+}
+
+size_t CachedClient::pending_prefetches() const {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    return prefetch_pending_.size();
+}
+
+void CachedClient::refresh_loop() {
+    CancelScope cancel_scope(&stop_token_);
+    std::unique_lock<std::mutex> lock(refresh_mutex_);
+    
+    while (true) {
+        refresh_cv_.wait(lock, [this] {
+            return stopping_ || !refresh_queue_.empty() || !prefetch_queue_.empty();
+        });
+        if (stopping_) {
+            return;
+        }
+        
+        if (refresh_queue_.empty()) {
+            // Prefetch: lowest priority, only on an idle bus and within budget
+            std::chrono::steady_clock::duration wait = std::chrono::milliseconds(2);
+            if (!client_.transport_idle() || !take_prefetch_token(std::chrono::steady_clock::now(), wait)) {
+                refresh_cv_.wait_for(lock, wait, [this] { return stopping_ || !refresh_queue_.empty(); });
+                continue;
+            }
+            
+            const size_t limit = std::max<size_t>(max_dids_per_request_.load(), 1);
+            std::vector<uint16_t> batch;
+            while (!prefetch_queue_.empty() && batch.size() < limit) {
+                batch.push_back(prefetch_queue_.front());
+                prefetch_pending_.erase(prefetch_queue_.front());
+                prefetch_queue_.pop_front();
+            }
+            const uint64_t epoch = write_epoch_.load();
+            lock.unlock();
+            
+            const uint64_t before = read_requests_.load();
+            auto fetched = fetch(cache_.uncached(batch));
+            const uint64_t sent = read_requests_.load() - before;
+            if (write_epoch_.load() == epoch) {
+                cache_.put_prefetched(fetched);
+            }
+            
+            lock.lock();
+            // One token was taken up front; a split batch may cost more
+            if (sent > 1) {
+                prefetch_tokens_ -= static_cast<double>(sent - 1);
+            }
+            continue;
+        }
+        
+        const uint16_t did = refresh_queue_.front();
+        refresh_queue_.pop_front();
+        const uint64_t epoch = write_epoch_.load();
+        lock.unlock();
+        
+        read_requests_++;
+        auto result = client_.read_data_by_identifier(did);
+        // A write issued meanwhile may be newer than what we read
+        const bool current = write_epoch_.load() == epoch;
+        if (result.ok && current && cache_.is_cacheable(did)) {
+            cache_.put(did, result.payload);
+        }
+        
+        lock.lock();
+        refresh_pending_.erase(did);
+        if (!result.ok) {
+            revalidation_stats_.refresh_failures++;
+        } else if (!current) {
+            revalidation_stats_.refreshes_dropped++;
+        } else {
+            revalidation_stats_.refreshes++;
+        }
+    }
+}
+
+RevalidationStats CachedClient::revalidation_stats() const {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    return revalidation_stats_;
+}
+
+size_t CachedClient::pending_refreshes() const {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    return refresh_pending_.size();
+}
+
 PositiveOrNegative CachedClient::read_did(uint16_t did, bool force_refresh) {
     // Check cache first (unless force refresh)
     if (!force_refresh && cache_.is_cacheable(did)) {
-        auto cached = cache_.get(did);
+        auto cached = cached_value(did);
         if (cached) {
             PositiveOrNegative result;
             result.ok = true;
-            result.payload = *cached;
+            result.payload = std::move(*cached);
+            note_access({did});
             return result;
         }
     }
     
     // Read from ECU
+    read_requests_++;
     auto result = client_.read_data_by_identifier(did);
     
     // Cache successful reads
@@ -304,6 +1617,7 @@ PositiveOrNegative CachedClient::read_did(uint16_t did, bool force_refresh) {
         cache_.put(did, result.payload);
     }
     
+    note_access({did});
     return result;
 }
 
@@ -317,9 +1631,9 @@ std::map<uint16_t, std::vector<uint8_t>> CachedClient::read_dids(
     if (!force_refresh) {
         for (uint16_t did : dids) {
             if (cache_.is_cacheable(did)) {
-                auto cached = cache_.get(did);
+                auto cached = cached_value(did);
                 if (cached) {
-                    result[did] = *cached;
+                    result[did] = std::move(*cached);
                     continue;
                 }
             }
@@ -329,22 +1643,18 @@ std::map<uint16_t, std::vector<uint8_t>> CachedClient::read_dids(
         to_fetch = dids;
     }
     
-    // Fetch remaining from ECU
-    for (uint16_t did : to_fetch) {
-        auto response = client_.read_data_by_identifier(did);
-        if (response.ok) {
-            result[did] = response.payload;
-            if (cache_.is_cacheable(did)) {
-                cache_.put(did, response.payload);
-            }
-        }
-    }
+    // Fetch remaining from ECU in batches; non-cacheable DIDs are skipped by put_multiple
+    auto fetched = fetch(to_fetch);
+    cache_.put_multiple(fetched);
+    result.insert(fetched.begin(), fetched.end());
     
+    note_access(dids);
     return result;
 }
 
 PositiveOrNegative CachedClient::write_did(uint16_t did, const std::vector<uint8_t>& data) {
-    // Invalidate cache before write
+    // Invalidate cache before write; in-flight refreshes are now outdated
+    write_epoch_.fetch_add(1);
     cache_.invalidate(did);
     
     // Perform write
@@ -359,11 +1669,78 @@ PositiveOrNegative CachedClient::write_did(uint16_t did, const std::vector<uint8
 }
 
 void CachedClient::prefetch(const std::vector<uint16_t>& dids) {
+    cache_.put_multiple(fetch(cache_.uncached(dids)));
+}
+
+std::map<uint16_t, std::vector<uint8_t>> CachedClient::fetch(const std::vector<uint16_t>& dids) {
+    std::map<uint16_t, std::vector<uint8_t>> out;
+    
+    // Drop duplicates, keeping request order
+    std::vector<uint16_t> pending;
+    std::set<uint16_t> seen;
     for (uint16_t did : dids) {
-        if (!cache_.contains(did)) {
-            read_did(did);
+        if (seen.insert(did).second) {
+            pending.push_back(did);
+        }
+    }
+    
+    size_t i = 0;
+    while (i < pending.size()) {
+        // Re-read the limit: a rejected batch may have lowered it
+        const size_t group = std::min(std::max<size_t>(max_dids_per_request_.load(), 1), pending.size() - i);
+        std::vector<uint16_t> batch(pending.begin() + i, pending.begin() + i + group);
+        if (!fetch_group(batch, out)) {
+            break;   // ECU not answering; the remaining reads would time out too
+        }
+        i += group;
+    }
+    return out;
+}
+
+bool CachedClient::fetch_group(const std::vector<uint16_t>& dids,
+                               std::map<uint16_t, std::vector<uint8_t>>& out) {
+    read_requests_++;
+    if (dids.size() == 1) {
+        auto response = client_.read_data_by_identifier(dids[0]);
+        if (response.ok) {
+            out[dids[0]] = std::move(response.payload);
+        }
+        return response.ok || static_cast<uint8_t>(response.nrc.code) != 0;
+    }
+    
+    const auto response = client_.read_data_by_identifiers(dids);
+    std::vector<std::vector<uint8_t>> records;
+    if (response.ok &&
+        split_did_records(dids, std::vector<size_t>(dids.size(), 0), response.payload, records)) {
+        // Same layout as a single read: DID echo + data
+        for (size_t k = 0; k < dids.size(); ++k) {
+            std::vector<uint8_t> payload;
+            payload.reserve(2 + records[k].size());
+            codec::be16(payload, dids[k]);
+            payload.insert(payload.end(), records[k].begin(), records[k].end());
+            out[dids[k]] = std::move(payload);
         }
+        return true;
     }
+    if (!response.ok) {
+        const auto code = response.nrc.code;
+        if (static_cast<uint8_t>(code) == 0) {
+            return false;
+        }
+        if (code == NegativeResponseCode::IncorrectMessageLengthOrFormat ||
+            code == NegativeResponseCode::ResponseTooLong) {
+            // Too many DIDs for this ECU: remember a smaller batch size
+            size_t limit = max_dids_per_request_.load();
+            const size_t lower = std::max<size_t>(dids.size() / 2, 1);
+            while (limit > lower && !max_dids_per_request_.compare_exchange_weak(limit, lower)) {
+            }
+        }
+    }
+    
+    // Rejected (e.g. one DID unsupported) or unsplittable: retry in halves
+    const size_t half = dids.size() / 2;
+    return fetch_group({dids.begin(), dids.begin() + half}, out) &&
+           fetch_group({dids.begin() + half, dids.end()}, out);
 }
 
 void CachedClient::on_session_change() {
@@ -371,6 +1748,135 @@ void CachedClient::on_session_change() {
     for (uint16_t did : did_categories::session_dids()) {
         cache_.invalidate(did);
     }
+    
+    // The ECU ends ResponseOnEvent on a session change: nothing keeps
+    // watched DIDs fresh any more
+    end_watches();
+}
+
+bool CachedClient::watch_did_changes(uint16_t did) {
+    auto configured = event::configure_did_change(client_, did);
+    if (!configured.ok || !event::start(client_).ok) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    if (!watched_.count(did)) {
+        Watch watch;
+        watch.was_cacheable = cache_.is_cacheable(did);
+        watch.policy = cache_.did_policy(did);
+        watched_.emplace(did, watch);
+        
+        // A value cached before the event was set up may have changed unseen
+        cache_.invalidate(did);
+        cache_.set_cacheable(did);
+        cache_.set_did_policy(did, ExpirationPolicy::Never);
+    }
+    if (!listener_.joinable() && !stop_token_.is_cancelled()) {
+        listener_ = std::thread([this] { listen_loop(); });
+    }
+    return true;
+}
+
+void CachedClient::stop_watching() {
+    event::stop(client_);
+    event::clear(client_);
+    end_watches();
+}
+
+void CachedClient::end_watches() {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    for (const auto& [did, watch] : watched_) {
+        cache_.invalidate(did);
+        if (watch.policy) {
+            cache_.set_did_policy(did, *watch.policy);
+        } else {
+            cache_.clear_did_policy(did);
+        }
+        if (!watch.was_cacheable) {
+            cache_.set_non_cacheable(did);
+        }
+    }
+    watched_.clear();
+}
+
+std::vector<uint16_t> CachedClient::watched_dids() const {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    std::vector<uint16_t> dids;
+    for (const auto& [did, watch] : watched_) {
+        dids.push_back(did);
+    }
+    return dids;
+}
+
+ChangeEventStats CachedClient::change_event_stats() const {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    return change_event_stats_;
+}
+
+void CachedClient::listen_loop() {
+    CancelScope cancel_scope(&stop_token_);
+    
+    while (!stop_token_.is_cancelled()) {
+        event::EventNotification notification;
+        if (!event::try_receive_event(client_, notification, std::chrono::milliseconds(100))) {
+            continue;
+        }
+        
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        change_event_stats_.notifications++;
+        
+        // eventTypeRecord of 0x03 answered by 0x22: [DID_High][DID_Low][data...]
+        if (notification.event_type != event::EventType::OnChangeOfDataIdentifier ||
+            notification.service_id != static_cast<uint8_t>(SID::ReadDataByIdentifier) ||
+            notification.payload.size() < 2) {
+            change_event_stats_.ignored++;
+            continue;
+        }
+        const uint16_t did = static_cast<uint16_t>((notification.payload[0] << 8) | notification.payload[1]);
+        if (!watched_.count(did)) {
+            change_event_stats_.ignored++;
+            continue;
+        }
+        
+        // Refreshes and prefetches in flight read the old value
+        write_epoch_.fetch_add(1);
+        if (notification.payload.size() > 2) {
+            cache_.put(did, notification.payload);   // same layout as a read (DID echo + data)
+            change_event_stats_.updates++;
+        } else {
+            cache_.invalidate(did);
+            change_event_stats_.invalidations++;
+        }
+    }
+}
+
+std::optional<EcuIdentity> CachedClient::identify() {
+    auto vin = read_did(0xF190, true);
+    if (!vin.ok) {
+        return std::nullopt;
+    }
+    auto software = read_did(0xF195, true);
+    if (!software.ok) {
+        return std::nullopt;
+    }
+    
+    EcuIdentity identity;
+    identity.tx_can_id = client_.address().tx_can_id;
+    identity.rx_can_id = client_.address().rx_can_id;
+    identity.vin = std::move(vin.payload);
+    identity.software_version = std::move(software.payload);
+    return identity;
+}
+
+bool CachedClient::warm_start(const std::string& path) {
+    auto identity = identify();
+    return identity && cache_.attach_snapshot(path, *identity);
+}
+
+bool CachedClient::save_snapshot(const std::string& path) {
+    auto identity = identify();
+    return identity && cache_.save_snapshot(path, *identity);
 }
 
 // ============================================================================
@@ -392,6 +1898,9 @@ std::string format_cache_stats(const CacheStats& stats) {
     ss << "  Evictions: " << stats.evictions << "\n";
     ss << "  Expirations: " << stats.expirations << "\n";
     ss << "  Invalidations: " << stats.invalidations << "\n";
+    ss << "  Snapshot loads: " << stats.snapshot_loads << "\n";
+    ss << "  Prefetches: " << stats.prefetches << " (hit rate: "
+       << (stats.prefetch_hit_rate() * 100) << "%)\n";
     
     return ss.str();
 }
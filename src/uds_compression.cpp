@@ -0,0 +1,191 @@
+#include "uds_compression.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace uds {
+namespace compression {
+
+namespace {
+
+constexpr unsigned kHashBits = 14;
+constexpr size_t kMaxLiteralRun = 32;
+
+inline uint32_t hash3(const uint8_t* p) {
+    const uint32_t v = (static_cast<uint32_t>(p[0]) << 16) |
+                       (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+void flush_literals(const uint8_t* data, size_t begin, size_t end, std::vector<uint8_t>& out) {
+    while (begin < end) {
+        const size_t run = std::min(end - begin, kMaxLiteralRun);
+        out.push_back(static_cast<uint8_t>(run - 1));
+        out.insert(out.end(), data + begin, data + begin + run);
+        begin += run;
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// LzfCompressor
+// ============================================================================
+
+void LzfCompressor::compress(const uint8_t* data, size_t size, size_t history,
+                             std::vector<uint8_t>& out) const {
+    // Positions are relative to base, which includes the history window
+    history = std::min(history, kMaxDistance);
+    const uint8_t* base = data - history;
+    const size_t end = history + size;
+    std::vector<int32_t> table(size_t(1) << kHashBits, -1);
+
+    for (size_t pos = 0; pos + 2 < history; ++pos) {
+        table[hash3(base + pos)] = static_cast<int32_t>(pos);
+    }
+
+    size_t literals = history;
+    size_t pos = history;
+    while (pos + 2 < end) {
+        const uint32_t h = hash3(base + pos);
+        const int32_t ref = table[h];
+        table[h] = static_cast<int32_t>(pos);
+
+        const size_t distance = ref < 0 ? 0 : pos - static_cast<size_t>(ref);
+        if (distance == 0 || distance > kMaxDistance ||
+            std::memcmp(base + ref, base + pos, 3) != 0) {
+            ++pos;
+            continue;
+        }
+
+        const size_t max_len = std::min(kMaxMatch, end - pos);
+        size_t len = 3;
+        while (len < max_len && base[ref + len] == base[pos + len]) {
+            ++len;
+        }
+
+        flush_literals(base, literals, pos, out);
+        const size_t off = distance - 1;
+        if (len < 9) {
+            out.push_back(static_cast<uint8_t>(((len - 2) << 5) | (off >> 8)));
+        } else {
+            out.push_back(static_cast<uint8_t>((7 << 5) | (off >> 8)));
+            out.push_back(static_cast<uint8_t>(len - 9));
+        }
+        out.push_back(static_cast<uint8_t>(off & 0xFF));
+
+        // Index the matched bytes so later matches can start inside them
+        const size_t next = pos + len;
+        for (++pos; pos < next && pos + 2 < end; ++pos) {
+            table[hash3(base + pos)] = static_cast<int32_t>(pos);
+        }
+        pos = next;
+        literals = next;
+    }
+    flush_literals(base, literals, end, out);
+}
+
+bool LzfCompressor::decompress(const uint8_t* data, size_t size, size_t expected_size,
+                               std::vector<uint8_t>& out) const {
+    out.clear();
+    out.reserve(expected_size);
+    size_t ip = 0;
+    while (ip < size) {
+        const uint8_t ctrl = data[ip++];
+        if (ctrl < 32) {
+            const size_t run = ctrl + 1u;
+            if (ip + run > size || out.size() + run > expected_size) {
+                return false;
+            }
+            out.insert(out.end(), data + ip, data + ip + run);
+            ip += run;
+            continue;
+        }
+        size_t len = ctrl >> 5;
+        if (len == 7) {
+            if (ip >= size) return false;
+            len += data[ip++];
+        }
+        len += 2;
+        if (ip >= size) return false;
+        const size_t distance = ((static_cast<size_t>(ctrl & 0x1F) << 8) | data[ip++]) + 1;
+        if (distance > out.size() || out.size() + len > expected_size) {
+            return false;
+        }
+        // Byte by byte: a match may overlap the bytes it produces
+        size_t from = out.size() - distance;
+        for (size_t i = 0; i < len; ++i) {
+            out.push_back(out[from + i]);
+        }
+    }
+    return out.size() == expected_size;
+}
+
+// ============================================================================
+// Image Compression
+// ============================================================================
+
+bool compress_image(FirmwareSource& source, const Compressor& compressor,
+                    const CompressionOptions& options, CompressedImage& out,
+                    const std::function<void(ByteSpan)>& observe) {
+    const size_t chunk_size = std::max<size_t>(options.chunk_size, 1);
+    const unsigned threads = options.threads != 0
+        ? options.threads
+        : std::max(1u, std::thread::hardware_concurrency());
+    const size_t history = compressor.history();
+    const uint64_t total = source.size();
+
+    out.data.clear();
+    out.original_size = total;
+
+    // buffer = [history kept from the previous batch][batch of chunks]
+    std::vector<uint8_t> buffer;
+    std::vector<std::vector<uint8_t>> outputs(threads);
+    size_t kept = 0;
+    uint64_t offset = 0;
+
+    while (offset < total) {
+        const size_t batch = static_cast<size_t>(
+            std::min<uint64_t>(static_cast<uint64_t>(chunk_size) * threads, total - offset));
+        buffer.resize(kept + batch);
+        for (size_t done = 0; done < batch; done += chunk_size) {
+            const size_t len = std::min(chunk_size, batch - done);
+            ByteSpan span;
+            if (!source.read(offset + done, len, span)) {
+                return false;
+            }
+            std::memcpy(buffer.data() + kept + done, span.data, len);
+            if (observe) observe(span);
+        }
+
+        // Chunk i references up to history bytes before it, across chunk
+        // and batch boundaries
+        const size_t chunks = (batch + chunk_size - 1) / chunk_size;
+        auto compress_chunk = [&](size_t i) {
+            const size_t start = kept + i * chunk_size;
+            const size_t len = std::min(chunk_size, batch - i * chunk_size);
+            outputs[i].clear();
+            compressor.compress(buffer.data() + start, len, std::min(history, start), outputs[i]);
+        };
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < chunks; ++i) {
+            workers.emplace_back(compress_chunk, i);
+        }
+        compress_chunk(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (size_t i = 0; i < chunks; ++i) {
+            out.data.insert(out.data.end(), outputs[i].begin(), outputs[i].end());
+        }
+
+        offset += batch;
+        const size_t keep = std::min(history, buffer.size());
+        std::memmove(buffer.data(), buffer.data() + buffer.size() - keep, keep);
+        kept = keep;
+    }
+    return true;
+}
+
+} // namespace compression
+} // namespace uds
@@ -0,0 +1,333 @@
+#include "uds_crc.hpp"
+#include <array>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define UDS_CRC_CLMUL 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace uds {
+namespace crc {
+
+namespace {
+
+constexpr uint32_t kCrc32Poly = 0xEDB88320;   // 0x04C11DB7 reflected
+constexpr uint32_t kCrc32CPoly = 0x82F63B78;  // 0x1EDC6F41 reflected
+constexpr uint16_t kCrc16CcittPoly = 0x1021;
+
+// Shortest buffer worth setting up the four folding lanes for
+constexpr size_t kClmulMinSize = 64;
+
+// ============================================================================
+// Lookup Tables
+// ============================================================================
+
+// Table s holds the CRC of byte b followed by s zero bytes, so slicing
+// looks up every byte of a 16-byte step independently
+using ReflectedTables = std::array<std::array<uint32_t, 256>, 16>;
+using NormalTables = std::array<std::array<uint16_t, 256>, 16>;
+
+constexpr ReflectedTables make_reflected_tables(uint32_t poly) {
+    ReflectedTables t{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t c = b;
+        for (int bit = 0; bit < 8; ++bit) {
+            c = (c & 1) ? (c >> 1) ^ poly : c >> 1;
+        }
+        t[0][b] = c;
+    }
+    for (size_t s = 1; s < 16; ++s) {
+        for (uint32_t b = 0; b < 256; ++b) {
+            t[s][b] = (t[s - 1][b] >> 8) ^ t[0][t[s - 1][b] & 0xFF];
+        }
+    }
+    return t;
+}
+
+constexpr NormalTables make_normal_tables(uint16_t poly) {
+    NormalTables t{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t c = b << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            c = (c & 0x8000) ? (c << 1) ^ poly : c << 1;
+        }
+        t[0][b] = static_cast<uint16_t>(c);
+    }
+    for (size_t s = 1; s < 16; ++s) {
+        for (uint32_t b = 0; b < 256; ++b) {
+            t[s][b] = static_cast<uint16_t>((t[s - 1][b] << 8) ^ t[0][t[s - 1][b] >> 8]);
+        }
+    }
+    return t;
+}
+
+constexpr ReflectedTables kCrc32Tables = make_reflected_tables(kCrc32Poly);
+constexpr ReflectedTables kCrc32CTables = make_reflected_tables(kCrc32CPoly);
+constexpr NormalTables kCrc16CcittTables = make_normal_tables(kCrc16CcittPoly);
+
+// ============================================================================
+// Reflected CRC32 Engines
+// ============================================================================
+
+inline uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+uint32_t reflected_table(const ReflectedTables& t, uint32_t crc, const uint8_t* p, size_t n) {
+    for (; n > 0; --n, ++p) {
+        crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint32_t reflected_slicing8(const ReflectedTables& t, uint32_t crc, const uint8_t* p, size_t n) {
+    for (; n >= 8; n -= 8, p += 8) {
+        const uint32_t a = load_le32(p) ^ crc;
+        const uint32_t b = load_le32(p + 4);
+        crc = t[7][a & 0xFF] ^ t[6][(a >> 8) & 0xFF] ^ t[5][(a >> 16) & 0xFF] ^ t[4][a >> 24] ^
+              t[3][b & 0xFF] ^ t[2][(b >> 8) & 0xFF] ^ t[1][(b >> 16) & 0xFF] ^ t[0][b >> 24];
+    }
+    return reflected_table(t, crc, p, n);
+}
+
+uint32_t reflected_slicing16(const ReflectedTables& t, uint32_t crc, const uint8_t* p, size_t n) {
+    for (; n >= 16; n -= 16, p += 16) {
+        const uint32_t a = load_le32(p) ^ crc;
+        const uint32_t b = load_le32(p + 4);
+        const uint32_t c = load_le32(p + 8);
+        const uint32_t d = load_le32(p + 12);
+        crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^ t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24] ^
+              t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^ t[9][(b >> 16) & 0xFF] ^ t[8][b >> 24] ^
+              t[7][c & 0xFF] ^ t[6][(c >> 8) & 0xFF] ^ t[5][(c >> 16) & 0xFF] ^ t[4][c >> 24] ^
+              t[3][d & 0xFF] ^ t[2][(d >> 8) & 0xFF] ^ t[1][(d >> 16) & 0xFF] ^ t[0][d >> 24];
+    }
+    return reflected_table(t, crc, p, n);
+}
+
+// ============================================================================
+// Carry-Less Multiply Folding (x86-64 PCLMULQDQ)
+// ============================================================================
+
+#ifdef UDS_CRC_CLMUL
+
+constexpr uint32_t reflect32(uint32_t v) {
+    uint32_t r = 0;
+    for (int bit = 0; bit < 32; ++bit) {
+        r = (r << 1) | ((v >> bit) & 1);
+    }
+    return r;
+}
+
+// x^n mod P, bit-reflected and shifted left by one: the 33-bit multiplier
+// that moves a 64-bit lane n - 32 bits further down the message
+constexpr uint64_t fold_constant(uint32_t reflected_poly, unsigned n) {
+    const uint32_t poly = reflect32(reflected_poly);
+    uint32_t r = 1;
+    for (unsigned i = 0; i < n; ++i) {
+        r = (r & 0x80000000u) ? (r << 1) ^ poly : r << 1;
+    }
+    return static_cast<uint64_t>(reflect32(r)) << 1;
+}
+
+struct FoldConstants {
+    uint64_t k1, k2;  // Fold a lane across 512 bits (four lanes in flight)
+    uint64_t k3, k4;  // Fold a lane across 128 bits
+};
+
+constexpr FoldConstants make_fold_constants(uint32_t reflected_poly) {
+    return {fold_constant(reflected_poly, 4 * 128 + 32), fold_constant(reflected_poly, 4 * 128 - 32),
+            fold_constant(reflected_poly, 128 + 32), fold_constant(reflected_poly, 128 - 32)};
+}
+
+constexpr FoldConstants kCrc32Fold = make_fold_constants(kCrc32Poly);
+constexpr FoldConstants kCrc32CFold = make_fold_constants(kCrc32CPoly);
+
+static_assert(kCrc32Fold.k1 == 0x154442BD4 && kCrc32Fold.k4 == 0x0CCAA009E,
+              "CRC32 folding constants");
+
+bool cpu_has_clmul() {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) != 0;
+}
+
+__attribute__((target("pclmul,sse2")))
+inline __m128i fold(__m128i lane, __m128i k, __m128i next) {
+    const __m128i lo = _mm_clmulepi64_si128(lane, k, 0x00);
+    const __m128i hi = _mm_clmulepi64_si128(lane, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+__attribute__((target("pclmul,sse2")))
+inline __m128i load128(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// Folding keeps the message's remainder modulo P while shrinking it to
+// 128 bits, which the tables then reduce; n must be at least 64
+__attribute__((target("pclmul,sse2")))
+uint32_t reflected_clmul(const ReflectedTables& t, const FoldConstants& k,
+                         uint32_t crc, const uint8_t* p, size_t n) {
+    const __m128i k1k2 = _mm_set_epi64x(static_cast<long long>(k.k2), static_cast<long long>(k.k1));
+    const __m128i k3k4 = _mm_set_epi64x(static_cast<long long>(k.k4), static_cast<long long>(k.k3));
+
+    // The register goes into the first four message bytes
+    __m128i x0 = _mm_xor_si128(load128(p), _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i x1 = load128(p + 16);
+    __m128i x2 = load128(p + 32);
+    __m128i x3 = load128(p + 48);
+    p += 64;
+    n -= 64;
+
+    for (; n >= 64; n -= 64, p += 64) {
+        x0 = fold(x0, k1k2, load128(p));
+        x1 = fold(x1, k1k2, load128(p + 16));
+        x2 = fold(x2, k1k2, load128(p + 32));
+        x3 = fold(x3, k1k2, load128(p + 48));
+    }
+
+    x0 = fold(x0, k3k4, x1);
+    x0 = fold(x0, k3k4, x2);
+    x0 = fold(x0, k3k4, x3);
+    for (; n >= 16; n -= 16, p += 16) {
+        x0 = fold(x0, k3k4, load128(p));
+    }
+
+    uint8_t folded[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(folded), x0);
+    crc = reflected_slicing16(t, 0, folded, sizeof(folded));
+    return reflected_slicing16(t, crc, p, n);
+}
+
+#endif // UDS_CRC_CLMUL
+
+struct Reflected {
+    const ReflectedTables& tables;
+#ifdef UDS_CRC_CLMUL
+    const FoldConstants& fold;
+#endif
+};
+
+uint32_t reflected_update(const Reflected& crc_type, uint32_t crc, const uint8_t* p, size_t n,
+                          Engine engine) {
+    switch (engine) {
+        case Engine::Table:
+            return reflected_table(crc_type.tables, crc, p, n);
+        case Engine::Slicing8:
+            return reflected_slicing8(crc_type.tables, crc, p, n);
+        case Engine::Clmul:
+#ifdef UDS_CRC_CLMUL
+            if (n >= kClmulMinSize && engine_supported(Engine::Clmul)) {
+                return reflected_clmul(crc_type.tables, crc_type.fold, crc, p, n);
+            }
+#endif
+            return reflected_slicing16(crc_type.tables, crc, p, n);
+        case Engine::Slicing16:
+        default:
+            return reflected_slicing16(crc_type.tables, crc, p, n);
+    }
+}
+
+#ifdef UDS_CRC_CLMUL
+const Reflected kCrc32{kCrc32Tables, kCrc32Fold};
+const Reflected kCrc32C{kCrc32CTables, kCrc32CFold};
+#else
+const Reflected kCrc32{kCrc32Tables};
+const Reflected kCrc32C{kCrc32CTables};
+#endif
+
+// ============================================================================
+// CRC16-CCITT Engines (MSB first)
+// ============================================================================
+
+uint16_t normal_table(const NormalTables& t, uint16_t crc, const uint8_t* p, size_t n) {
+    for (; n > 0; --n, ++p) {
+        crc = static_cast<uint16_t>((crc << 8) ^ t[0][(crc >> 8) ^ *p]);
+    }
+    return crc;
+}
+
+template <size_t Stride>
+uint16_t normal_slicing(const NormalTables& t, uint16_t crc, const uint8_t* p, size_t n) {
+    for (; n >= Stride; n -= Stride, p += Stride) {
+        uint16_t next = static_cast<uint16_t>(t[Stride - 1][(crc >> 8) ^ p[0]] ^
+                                              t[Stride - 2][(crc & 0xFF) ^ p[1]]);
+        for (size_t i = 2; i < Stride; ++i) {
+            next ^= t[Stride - 1 - i][p[i]];
+        }
+        crc = next;
+    }
+    return normal_table(t, crc, p, n);
+}
+
+} // namespace
+
+// ============================================================================
+// Engine Selection
+// ============================================================================
+
+const char* engine_name(Engine engine) {
+    switch (engine) {
+        case Engine::Table: return "table";
+        case Engine::Slicing8: return "slicing-by-8";
+        case Engine::Slicing16: return "slicing-by-16";
+        case Engine::Clmul: return "pclmulqdq";
+        default: return "unknown";
+    }
+}
+
+bool engine_supported(Engine engine) {
+    if (engine != Engine::Clmul) {
+        return true;
+    }
+#ifdef UDS_CRC_CLMUL
+    static const bool supported = cpu_has_clmul();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+Engine best_engine() {
+    return engine_supported(Engine::Clmul) ? Engine::Clmul : Engine::Slicing16;
+}
+
+// ============================================================================
+// Public Updates
+// ============================================================================
+
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size) {
+    return reflected_update(kCrc32, crc, data, size, best_engine());
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size, Engine engine) {
+    return reflected_update(kCrc32, crc, data, size, engine);
+}
+
+uint32_t crc32c_update(uint32_t crc, const uint8_t* data, size_t size) {
+    return reflected_update(kCrc32C, crc, data, size, best_engine());
+}
+
+uint32_t crc32c_update(uint32_t crc, const uint8_t* data, size_t size, Engine engine) {
+    return reflected_update(kCrc32C, crc, data, size, engine);
+}
+
+// 16-bit lookups leave slicing-by-16 no faster than by 8 here
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t* data, size_t size) {
+    return normal_slicing<8>(kCrc16CcittTables, crc, data, size);
+}
+
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t* data, size_t size, Engine engine) {
+    switch (engine) {
+        case Engine::Table:
+            return normal_table(kCrc16CcittTables, crc, data, size);
+        case Engine::Slicing16:
+            return normal_slicing<16>(kCrc16CcittTables, crc, data, size);
+        default:
+            return normal_slicing<8>(kCrc16CcittTables, crc, data, size);
+    }
+}
+
+} // namespace crc
+} // namespace uds
@@ -242,21 +242,27 @@ bool try_receive_event(Client& client,
   // ResponseOnEvent notifications come as positive responses with SID 0xC6 (0x86 + 0x40)
   // Format: [0xC6][eventType][numberOfIdentifiedEvents][eventTypeRecord...]
   // where eventTypeRecord contains [serviceId][serviceResponse...]
+  std::vector<uint8_t> rx;
+  if (!client.receive_event(rx, timeout)) {
+    return false;
+  }
   
-  // We need to receive without sending - use the transport's recv_unsolicited
-  // This requires access to the underlying transport, which we don't have directly
-  // from the Client API. For now, we'll use a workaround.
+  if (rx.size() < 4) { // Need at least SID + eventType + count + serviceId
+    return false;
+  }
   
-  // Note: In a full implementation, you'd add a method to Client for receiving
-  // unsolicited messages, or the event module would have direct transport access.
+  // Bit 6 of eventType is storageState, bit 7 suppressPosRspMsgIndicationBit
+  notification.event_type = static_cast<EventType>(rx[1] & 0x3F);
+  notification.number_of_events = rx[2];
   
-  // Placeholder implementation - returns false (no event received)
-  // Real implementation would poll the transport for incoming messages
-  (void)client;
-  (void)notification;
-  (void)timeout;
+  // Report the triggered service by its request SID, whether the ECU
+  // echoes the request SID or the positive response SID
+  const uint8_t sid = rx[3];
+  const bool response_sid = (sid >= 0x50 && sid <= 0x7E) || (sid >= 0xC3 && sid <= 0xC7);
+  notification.service_id = response_sid ? static_cast<uint8_t>(sid - 0x40) : sid;
+  notification.payload.assign(rx.begin() + 4, rx.end());
   
-  return false;
+  return true;
 }
 
 // ============================================================================
@@ -0,0 +1,162 @@
+#include "uds_firmware.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uds {
+
+namespace {
+
+bool in_range(uint64_t offset, size_t length, uint64_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+} // namespace
+
+// ============================================================================
+// MemoryFirmwareSource
+// ============================================================================
+
+bool MemoryFirmwareSource::read(uint64_t offset, size_t length, ByteSpan& out) {
+    if (!in_range(offset, length, size_)) {
+        return false;
+    }
+    out = ByteSpan{data_ + offset, length};
+    return true;
+}
+
+// ============================================================================
+// SliceFirmwareSource
+// ============================================================================
+
+bool SliceFirmwareSource::read(uint64_t offset, size_t length, ByteSpan& out) {
+    if (!in_range(offset, length, size_)) {
+        return false;
+    }
+    return base_.read(offset_ + offset, length, out);
+}
+
+// ============================================================================
+// MappedFirmwareSource
+// ============================================================================
+
+MappedFirmwareSource::~MappedFirmwareSource() {
+    close();
+}
+
+bool MappedFirmwareSource::open(const std::string& path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(map, size, MADV_SEQUENTIAL);
+    map_ = map;
+    map_size_ = size;
+    released_ = 0;
+    return true;
+}
+
+void MappedFirmwareSource::close() {
+    if (map_) {
+        ::munmap(map_, map_size_);
+    }
+    map_ = nullptr;
+    map_size_ = 0;
+    released_ = 0;
+}
+
+bool MappedFirmwareSource::read(uint64_t offset, size_t length, ByteSpan& out) {
+    if (!map_ || !in_range(offset, length, map_size_)) {
+        return false;
+    }
+    uint8_t* base = static_cast<uint8_t*>(map_);
+
+    // Drop clean pages well behind this block; reading them again (e.g. for
+    // verification) faults them back in from the file and restarts the scan
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    if (offset < released_) {
+        released_ = static_cast<size_t>(offset) / page * page;
+    } else if (offset > released_ + kReleaseWindow) {
+        const size_t end = (static_cast<size_t>(offset) - kReleaseWindow) / page * page;
+        if (end > released_) {
+            ::madvise(base + released_, end - released_, MADV_DONTNEED);
+            released_ = end;
+        }
+    }
+
+    out = ByteSpan{base + offset, length};
+    return true;
+}
+
+// ============================================================================
+// StreamFirmwareSource
+// ============================================================================
+
+StreamFirmwareSource::StreamFirmwareSource(std::istream& in) : in_(in), size_(0) {
+    const auto start = in_.tellg();
+    if (start != std::istream::pos_type(-1) && in_.seekg(0, std::ios::end)) {
+        const auto end = in_.tellg();
+        in_.seekg(start);
+        if (end != std::istream::pos_type(-1) && end >= start) {
+            size_ = static_cast<uint64_t>(end - start);
+        }
+    }
+    in_.clear();
+}
+
+bool StreamFirmwareSource::read(uint64_t offset, size_t length, ByteSpan& out) {
+    // Same block again, e.g. a retried TransferData
+    if (offset == last_offset_ && position_ > offset && length <= position_ - offset) {
+        out = ByteSpan{buffer_.data(), length};
+        return true;
+    }
+    if (offset != position_ || !in_range(offset, length, size_)) {
+        return false;
+    }
+    buffer_.resize(length);
+    if (!in_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(length))) {
+        return false;
+    }
+    last_offset_ = offset;
+    position_ = offset + length;
+    out = ByteSpan{buffer_.data(), length};
+    return true;
+}
+
+// ============================================================================
+// GeneratorFirmwareSource
+// ============================================================================
+
+bool GeneratorFirmwareSource::read(uint64_t offset, size_t length, ByteSpan& out) {
+    if (offset == last_offset_ && position_ > offset && length <= position_ - offset) {
+        out = ByteSpan{buffer_.data(), length};
+        return true;
+    }
+    if (offset != position_ || !in_range(offset, length, size_) || !generator_) {
+        return false;
+    }
+    buffer_.resize(length);
+    if (generator_(buffer_.data(), length) != length) {
+        return false;
+    }
+    last_offset_ = offset;
+    position_ = offset + length;
+    out = ByteSpan{buffer_.data(), length};
+    return true;
+}
+
+} // namespace uds
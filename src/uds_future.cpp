@@ -0,0 +1,64 @@
+#include "uds_future.hpp"
+
+namespace uds {
+namespace async {
+
+namespace {
+
+// Submit a callback-style AsyncClient task whose callback fulfils a promise.
+// ResultCallback must be copyable, so the promise is shared.
+template <typename T, typename Submit>
+Future<AsyncResult<T>> bridge(Submit&& submit) {
+    auto promise = std::make_shared<Promise<AsyncResult<T>>>();
+    auto future = promise->get_future();
+    submit([promise](const AsyncResult<T>& result) { promise->set_value(result); });
+    return future;
+}
+
+} // namespace
+
+Future<AsyncResult<std::vector<uint8_t>>> FutureClient::read_did(uint16_t did, TaskOptions options) {
+    return bridge<std::vector<uint8_t>>([&](auto callback) {
+        client_.read_did_async(did, callback, options);
+    });
+}
+
+Future<AsyncResult<std::map<uint16_t, std::vector<uint8_t>>>> FutureClient::read_dids(
+    const std::vector<uint16_t>& dids, TaskOptions options) {
+    return bridge<std::map<uint16_t, std::vector<uint8_t>>>([&](auto callback) {
+        client_.read_dids_async(dids, callback, options);
+    });
+}
+
+Future<AsyncResult<bool>> FutureClient::write_did(uint16_t did, const std::vector<uint8_t>& data,
+                                                  TaskOptions options) {
+    return bridge<bool>([&](auto callback) {
+        client_.write_did_async(did, data, callback, options);
+    });
+}
+
+Future<AsyncResult<bool>> FutureClient::session_control(Session session, TaskOptions options) {
+    return bridge<bool>([&](auto callback) {
+        client_.session_control_async(session, callback, options);
+    });
+}
+
+Future<AsyncResult<bool>> FutureClient::security_access(
+    uint8_t level, std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)> key_calculator,
+    TaskOptions options) {
+    return bridge<bool>([&](auto callback) {
+        client_.security_access_async(level, std::move(key_calculator), callback, options);
+    });
+}
+
+Future<AsyncResult<std::vector<uint8_t>>> FutureClient::routine_control(uint8_t control_type,
+                                                                        uint16_t routine_id,
+                                                                        const std::vector<uint8_t>& params,
+                                                                        TaskOptions options) {
+    return bridge<std::vector<uint8_t>>([&](auto callback) {
+        client_.routine_control_async(control_type, routine_id, params, callback, options);
+    });
+}
+
+} // namespace async
+} // namespace uds
@@ -0,0 +1,340 @@
+#include "uds_metrics.hpp"
+#include <sstream>
+#include <iomanip>
+#include <thread>
+
+namespace uds {
+namespace metrics {
+
+const char* phase_name(Phase phase) {
+    switch (phase) {
+        case Phase::Tx: return "Tx";
+        case Phase::EcuThink: return "EcuThink";
+        case Phase::Pending: return "Pending";
+        case Phase::RxReassembly: return "RxReassembly";
+        case Phase::Total: return "Total";
+        default: return "Unknown";
+    }
+}
+
+// ============================================================================
+// LatencyHistogram Implementation
+// ============================================================================
+
+static inline unsigned most_significant_bit(uint64_t v) {
+    return 63u - static_cast<unsigned>(__builtin_clzll(v));
+}
+
+static inline void atomic_store_min(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+static inline void atomic_store_max(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t us) {
+    if (us < kSubBucketCount) {
+        return static_cast<size_t>(us);
+    }
+    const unsigned msb = most_significant_bit(us);
+    if (msb >= kMaxMagnitude) {
+        return kBucketCount - 1;
+    }
+    const unsigned shift = msb - kSubBucketBits;
+    const uint64_t sub = (us >> shift) & (kSubBucketCount - 1);
+    return static_cast<size_t>((msb - kSubBucketBits + 1) * kSubBucketCount + sub);
+}
+
+uint64_t LatencyHistogram::bucket_lower_bound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const unsigned msb = static_cast<unsigned>(index / kSubBucketCount) + kSubBucketBits - 1;
+    const uint64_t sub = index % kSubBucketCount;
+    return (kSubBucketCount + sub) << (msb - kSubBucketBits);
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const unsigned msb = static_cast<unsigned>(index / kSubBucketCount) + kSubBucketBits - 1;
+    return bucket_lower_bound(index) + (uint64_t(1) << (msb - kSubBucketBits)) - 1;
+}
+
+void LatencyHistogram::record_us(uint64_t us) {
+    counts_[bucket_index(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+    atomic_store_min(min_us_, us);
+    atomic_store_max(max_us_, us);
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot snap;
+    snap.counts.resize(kBucketCount);
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snap.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        total += snap.counts[i];
+    }
+    // Use the bucket sum so that percentiles are consistent with the counts
+    // even if a sample is recorded concurrently.
+    snap.count = total;
+    snap.sum_us = sum_us_.load(std::memory_order_relaxed);
+    const uint64_t min_us = min_us_.load(std::memory_order_relaxed);
+    snap.min_us = (min_us == UINT64_MAX) ? 0 : min_us;
+    snap.max_us = max_us_.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : counts_) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_us_.store(0, std::memory_order_relaxed);
+    min_us_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t HistogramSnapshot::percentile_us(double percentile) const {
+    if (count == 0 || counts.empty()) {
+        return 0;
+    }
+    if (percentile <= 0.0) {
+        return min_us;
+    }
+    if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+
+    uint64_t target = static_cast<uint64_t>((percentile / 100.0) * static_cast<double>(count) + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            const uint64_t upper = LatencyHistogram::bucket_upper_bound(i);
+            return (max_us > 0 && upper > max_us) ? max_us : upper;
+        }
+    }
+    return max_us;
+}
+
+// ============================================================================
+// PhaseHistograms Implementation
+// ============================================================================
+
+void PhaseHistograms::record(const ExchangeSample& sample) {
+    phases_[static_cast<size_t>(Phase::Tx)].record(sample.tx);
+    phases_[static_cast<size_t>(Phase::EcuThink)].record(sample.ecu_think);
+    if (sample.pending_responses > 0) {
+        phases_[static_cast<size_t>(Phase::Pending)].record(sample.pending);
+    }
+    phases_[static_cast<size_t>(Phase::RxReassembly)].record(sample.rx_reassembly);
+    phases_[static_cast<size_t>(Phase::Total)].record(sample.total);
+
+    exchanges_.fetch_add(1, std::memory_order_relaxed);
+    if (!sample.ok) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (sample.timed_out) {
+        timeouts_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (sample.pending_responses > 0) {
+        pending_responses_.fetch_add(sample.pending_responses, std::memory_order_relaxed);
+    }
+}
+
+void PhaseHistograms::reset() {
+    for (auto& h : phases_) {
+        h.reset();
+    }
+    exchanges_.store(0, std::memory_order_relaxed);
+    failures_.store(0, std::memory_order_relaxed);
+    timeouts_.store(0, std::memory_order_relaxed);
+    pending_responses_.store(0, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// ExchangeMetrics Implementation
+// ============================================================================
+
+ExchangeMetrics::~ExchangeMetrics() {
+    for (auto& s : services_) {
+        delete s.load(std::memory_order_acquire);
+    }
+    for (auto& e : ecus_) {
+        delete e.histograms.load(std::memory_order_acquire);
+    }
+}
+
+PhaseHistograms* ExchangeMetrics::service_slot(uint8_t sid) {
+    auto& slot = services_[sid];
+    PhaseHistograms* existing = slot.load(std::memory_order_acquire);
+    if (existing) {
+        return existing;
+    }
+
+    auto* created = new PhaseHistograms();
+    if (slot.compare_exchange_strong(existing, created, std::memory_order_acq_rel)) {
+        return created;
+    }
+    delete created;  // Another thread won the race
+    return existing;
+}
+
+PhaseHistograms* ExchangeMetrics::ecu_slot(uint32_t ecu_id) {
+    const uint64_t key = static_cast<uint64_t>(ecu_id) + 1;
+    const size_t start = static_cast<size_t>(ecu_id * 2654435761u) % kMaxEcus;
+
+    for (size_t probe = 0; probe < kMaxEcus; ++probe) {
+        EcuSlot& slot = ecus_[(start + probe) % kMaxEcus];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+
+        if (current == 0) {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                auto* created = new PhaseHistograms();
+                slot.histograms.store(created, std::memory_order_release);
+                return created;
+            }
+            // Lost the race; 'current' now holds the winner's key
+        }
+
+        if (current == key) {
+            // The claiming thread publishes the histograms right after the key
+            PhaseHistograms* h = slot.histograms.load(std::memory_order_acquire);
+            while (!h) {
+                std::this_thread::yield();
+                h = slot.histograms.load(std::memory_order_acquire);
+            }
+            return h;
+        }
+    }
+    return nullptr;
+}
+
+void ExchangeMetrics::record(uint8_t sid, uint32_t ecu_id, const ExchangeSample& sample) {
+    service_slot(sid)->record(sample);
+
+    if (PhaseHistograms* ecu_hist = ecu_slot(ecu_id)) {
+        ecu_hist->record(sample);
+    } else {
+        dropped_ecu_samples_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+const PhaseHistograms* ExchangeMetrics::service(uint8_t sid) const {
+    return services_[sid].load(std::memory_order_acquire);
+}
+
+const PhaseHistograms* ExchangeMetrics::ecu(uint32_t ecu_id) const {
+    const uint64_t key = static_cast<uint64_t>(ecu_id) + 1;
+    const size_t start = static_cast<size_t>(ecu_id * 2654435761u) % kMaxEcus;
+
+    for (size_t probe = 0; probe < kMaxEcus; ++probe) {
+        const EcuSlot& slot = ecus_[(start + probe) % kMaxEcus];
+        const uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0) {
+            return nullptr;
+        }
+        if (current == key) {
+            return slot.histograms.load(std::memory_order_acquire);
+        }
+    }
+    return nullptr;
+}
+
+std::vector<uint8_t> ExchangeMetrics::services() const {
+    std::vector<uint8_t> result;
+    for (size_t sid = 0; sid < services_.size(); ++sid) {
+        const PhaseHistograms* h = services_[sid].load(std::memory_order_acquire);
+        if (h && h->exchanges() > 0) {
+            result.push_back(static_cast<uint8_t>(sid));
+        }
+    }
+    return result;
+}
+
+std::vector<uint32_t> ExchangeMetrics::ecus() const {
+    std::vector<uint32_t> result;
+    for (const auto& slot : ecus_) {
+        const uint64_t key = slot.key.load(std::memory_order_acquire);
+        const PhaseHistograms* h = slot.histograms.load(std::memory_order_acquire);
+        if (key != 0 && h && h->exchanges() > 0) {
+            result.push_back(static_cast<uint32_t>(key - 1));
+        }
+    }
+    return result;
+}
+
+void ExchangeMetrics::reset() {
+    for (auto& s : services_) {
+        if (PhaseHistograms* h = s.load(std::memory_order_acquire)) {
+            h->reset();
+        }
+    }
+    for (auto& e : ecus_) {
+        if (PhaseHistograms* h = e.histograms.load(std::memory_order_acquire)) {
+            h->reset();
+        }
+    }
+    dropped_ecu_samples_.store(0, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Utility Functions
+// ============================================================================
+
+static void format_histograms(std::ostringstream& ss, const PhaseHistograms& h) {
+    const auto total = h.phase(Phase::Total).snapshot();
+    ss << "n=" << h.exchanges()
+       << " fail=" << h.failures()
+       << " timeout=" << h.timeouts()
+       << " rcrrp=" << h.pending_responses() << "\n";
+    ss << "      total us: p50=" << total.percentile_us(50.0)
+       << " p95=" << total.percentile_us(95.0)
+       << " p99=" << total.percentile_us(99.0)
+       << " max=" << total.max_us << "\n";
+    ss << "      mean us:";
+    for (Phase p : {Phase::Tx, Phase::EcuThink, Phase::Pending, Phase::RxReassembly}) {
+        ss << " " << phase_name(p) << "="
+           << std::fixed << std::setprecision(0) << h.phase(p).snapshot().mean_us();
+    }
+    ss << "\n";
+}
+
+std::string format_metrics(const ExchangeMetrics& metrics) {
+    std::ostringstream ss;
+
+    ss << "Exchange Latency by Service:\n";
+    for (uint8_t sid : metrics.services()) {
+        ss << "  SID 0x" << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
+           << static_cast<int>(sid) << std::dec << std::setfill(' ') << ": ";
+        format_histograms(ss, *metrics.service(sid));
+    }
+
+    ss << "Exchange Latency by ECU:\n";
+    for (uint32_t ecu : metrics.ecus()) {
+        ss << "  ECU 0x" << std::hex << std::uppercase << ecu << std::dec << ": ";
+        format_histograms(ss, *metrics.ecu(ecu));
+    }
+
+    if (metrics.dropped_ecu_samples() > 0) {
+        ss << "  (" << metrics.dropped_ecu_samples() << " samples without ECU slot)\n";
+    }
+
+    return ss.str();
+}
+
+} // namespace metrics
+} // namespace uds
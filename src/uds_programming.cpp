@@ -111,7 +111,7 @@ ProgStatus ProgrammingSession::request_download(uint8_t dfi,
 
     // Positive response payload layout (0x74):
     // res.payload[0] = lengthFormatIdentifier (FL)
-    // res.payload[1..] = maxNumberOfBlockLength (FL's lower nibble is length)
+    // res.payload[1..] = maxNumberOfBlockLength (FL's high nibble is length)
     //
     // We decode "maxNumberOfBlockLength" as a big-endian integer.
     if (res.payload.empty()) {
@@ -119,7 +119,7 @@ ProgStatus ProgrammingSession::request_download(uint8_t dfi,
     }
 
     const uint8_t fl = res.payload[0];
-    const uint8_t len = static_cast<uint8_t>(fl & 0x0F);
+    const uint8_t len = static_cast<uint8_t>(fl >> 4);
 
     if (len == 0 || res.payload.size() < 1 + len) {
         return ProgStatus::failure("RequestDownload response has invalid lengthFormatIdentifier");
@@ -142,31 +142,38 @@ ProgStatus ProgrammingSession::request_download(uint8_t dfi,
 }
 
 ProgStatus ProgrammingSession::transfer_image(const std::vector<uint8_t>& image)
+{
+    MemoryFirmwareSource source(image);
+    return transfer_image(source);
+}
+
+ProgStatus ProgrammingSession::transfer_image(FirmwareSource& image)
 {
     if (max_block_size_ == 0) {
         return ProgStatus::failure("transfer_image called before request_download");
     }
 
-    if (image.empty()) {
+    if (image.size() == 0) {
         return ProgStatus::failure("transfer_image called with empty image");
     }
 
     uint8_t block_counter = 1;
-    std::size_t offset = 0;
+    uint64_t offset = 0;
 
     while (offset < image.size()) {
-        const std::size_t remaining = image.size() - offset;
+        const uint64_t remaining = image.size() - offset;
         const std::size_t chunk_size = remaining > max_block_size_
                                      ? max_block_size_
-                                     : remaining;
+                                     : static_cast<std::size_t>(remaining);
 
-        std::vector<uint8_t> chunk;
-        chunk.reserve(chunk_size);
-        chunk.insert(chunk.end(),
-                     image.begin() + static_cast<std::ptrdiff_t>(offset),
-                     image.begin() + static_cast<std::ptrdiff_t>(offset + chunk_size));
+        ByteSpan chunk;
+        if (!image.read(offset, chunk_size, chunk)) {
+            std::ostringstream oss;
+            oss << "Failed to read image at offset " << offset;
+            return ProgStatus::failure(oss.str());
+        }
 
-        auto res = client_.transfer_data(block_counter, chunk);
+        auto res = client_.transfer_data(block_counter, chunk.data, chunk.size);
         auto st = check_pn(res, "TransferData");
         if (!st.ok) {
             std::ostringstream oss;
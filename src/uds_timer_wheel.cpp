@@ -0,0 +1,130 @@
+#include "uds_timer_wheel.hpp"
+#include <algorithm>
+
+namespace uds {
+namespace timer {
+
+static size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+TimerWheel::TimerWheel(std::chrono::microseconds resolution, size_t slots, Clock::time_point start)
+    : resolution_(std::max(resolution, std::chrono::microseconds(1))),
+      start_(start),
+      mask_(round_up_pow2(std::max<size_t>(slots, 1)) - 1),
+      slots_(mask_ + 1, kNil) {
+}
+
+int64_t TimerWheel::tick_of(Clock::time_point t) const {
+    if (t <= start_) return 0;
+    // Round up so a timer never fires before its expiry time
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t - start_).count();
+    return (us + resolution_.count() - 1) / resolution_.count();
+}
+
+TimerWheel::Clock::time_point TimerWheel::time_of(int64_t tick) const {
+    return start_ + resolution_ * tick;
+}
+
+void TimerWheel::link(uint32_t index) {
+    Node& node = nodes_[index];
+    uint32_t& head = slots_[static_cast<size_t>(node.tick) & mask_];
+    node.prev = kNil;
+    node.next = head;
+    if (head != kNil) nodes_[head].prev = index;
+    head = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.prev != kNil) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        slots_[static_cast<size_t>(node.tick) & mask_] = node.next;
+    }
+    if (node.next != kNil) nodes_[node.next].prev = node.prev;
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.active = false;
+    ++node.generation;
+    if (node.generation == 0) node.generation = 1;
+    node.next = free_;
+    free_ = index;
+    --active_;
+}
+
+TimerId TimerWheel::schedule(Clock::time_point when, uint64_t data) {
+    uint32_t index;
+    if (free_ != kNil) {
+        index = free_;
+        free_ = nodes_[index].next;
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+        nodes_.back().generation = 1;
+    }
+    
+    Node& node = nodes_[index];
+    node.tick = std::max(tick_of(when), current_tick_);
+    node.data = data;
+    node.active = true;
+    link(index);
+    ++active_;
+    return (static_cast<TimerId>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    const uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFFu);
+    if (index >= nodes_.size()) return false;
+    Node& node = nodes_[index];
+    if (!node.active || node.generation != static_cast<uint32_t>(id >> 32)) return false;
+    unlink(index);
+    release(index);
+    return true;
+}
+
+size_t TimerWheel::advance(Clock::time_point now, std::vector<uint64_t>& expired) {
+    if (now < start_) return 0;
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count();
+    const int64_t target = us / resolution_.count();
+    if (target < current_tick_) return 0;
+    
+    // Each slot needs visiting at most once, however far the wheel jumps
+    const int64_t steps = std::min<int64_t>(target - current_tick_ + 1,
+                                            static_cast<int64_t>(slots_.size()));
+    size_t fired = 0;
+    for (int64_t i = 0; i < steps && active_ > 0; ++i) {
+        uint32_t index = slots_[static_cast<size_t>(current_tick_ + i) & mask_];
+        while (index != kNil) {
+            const uint32_t next = nodes_[index].next;
+            if (nodes_[index].tick <= target) {
+                expired.push_back(nodes_[index].data);
+                unlink(index);
+                release(index);
+                ++fired;
+            }
+            index = next;
+        }
+    }
+    current_tick_ = target + 1;
+    return fired;
+}
+
+std::optional<TimerWheel::Clock::time_point> TimerWheel::next_wakeup() const {
+    if (active_ == 0) return std::nullopt;
+    const int64_t horizon = current_tick_ + static_cast<int64_t>(slots_.size());
+    for (int64_t tick = current_tick_; tick < horizon; ++tick) {
+        for (uint32_t index = slots_[static_cast<size_t>(tick) & mask_]; index != kNil;
+             index = nodes_[index].next) {
+            if (nodes_[index].tick <= tick) return time_of(tick);
+        }
+    }
+    return time_of(horizon);
+}
+
+} // namespace timer
+} // namespace uds
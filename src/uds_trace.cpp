@@ -0,0 +1,384 @@
+#include "uds_trace.hpp"
+#include "can_slcan.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace uds {
+namespace trace {
+
+static constexpr char kFileMagic[8] = {'U', 'D', 'S', 'T', 'R', 'C', '0', '1'};
+static constexpr uint32_t kFileVersion = 1;
+static constexpr size_t kHeaderSize = 8 + 4 + 4 + 8 + 8 + 8;
+
+static inline uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static inline uint64_t wall_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// ============================================================================
+// TraceRing Implementation
+// ============================================================================
+
+static size_t round_up_pow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+TraceRing::TraceRing(size_t capacity, uint16_t thread_index)
+    : slots_(new Slot[round_up_pow2(capacity < 2 ? 2 : capacity)]),
+      mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+      thread_index_(thread_index) {}
+
+void TraceRing::write(RecordKind kind, Direction direction, uint32_t can_id,
+                      const uint8_t* data, size_t length) {
+    const uint64_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+
+    // Odd sequence marks the slot as being written
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TraceRecord& r = slot.record;
+    r.timestamp_ns = steady_now_ns();
+    r.can_id = can_id;
+    r.length = static_cast<uint16_t>(length > UINT16_MAX ? UINT16_MAX : length);
+    r.kind = kind;
+    r.direction = direction;
+    r.thread_index = thread_index_;
+    r.captured = static_cast<uint8_t>(length < kMaxRecordData ? length : kMaxRecordData);
+    if (r.captured > 0) {
+        std::memcpy(r.data, data, r.captured);
+    }
+
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    head_.store(index + 1, std::memory_order_release);
+}
+
+void TraceRing::collect(std::vector<TraceRecord>& out) const {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t count = std::min<uint64_t>(head, capacity());
+
+    for (uint64_t index = head - count; index < head; ++index) {
+        const Slot& slot = slots_[index & mask_];
+        const uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != 2 * index + 2) {
+            continue;  // Being written or already overwritten
+        }
+        TraceRecord copy = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) {
+            continue;  // Overwritten while copying
+        }
+        out.push_back(copy);
+    }
+}
+
+// ============================================================================
+// Tracer Implementation
+// ============================================================================
+
+// Unregisters the calling thread's ring when the thread exits
+struct Tracer::Registration {
+    std::shared_ptr<TraceRing> ring;
+
+    ~Registration() {
+        if (ring) {
+            Tracer::instance().retire(ring);
+        }
+    }
+};
+
+Tracer& Tracer::instance() {
+    // Intentionally leaked: threads may still record (and retire their rings)
+    // while static objects are being destroyed at process exit.
+    static Tracer* tracer = new Tracer();
+    return *tracer;
+}
+
+void Tracer::set_ring_capacity(size_t records) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring_capacity_ = records;
+}
+
+size_t Tracer::ring_capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ring_capacity_;
+}
+
+TraceRing& Tracer::local_ring() {
+    thread_local Registration registration;
+    if (!registration.ring) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        registration.ring = std::make_shared<TraceRing>(ring_capacity_, next_thread_index_++);
+        rings_.push_back(registration.ring);
+    }
+    return *registration.ring;
+}
+
+void Tracer::retire(const std::shared_ptr<TraceRing>& ring) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.erase(std::remove(rings_.begin(), rings_.end(), ring), rings_.end());
+    if (ring->written() == 0) {
+        return;
+    }
+    // Keep the traffic of recently finished threads for post-mortem dumps
+    retired_.push_back(ring);
+    if (retired_.size() > kMaxRetiredRings) {
+        retired_.erase(retired_.begin());
+    }
+}
+
+void Tracer::record_can(Direction direction, const CANProtocol::CANFrame& frame) {
+    const size_t len = frame.dlc <= frame.data.size() ? frame.dlc : frame.data.size();
+    local_ring().write(RecordKind::CanFrame, direction, frame.id, frame.data.data(), len);
+}
+
+void Tracer::record_pdu(Direction direction, uint32_t can_id,
+                        const uint8_t* data, size_t length) {
+    local_ring().write(RecordKind::UdsPdu, direction, can_id, data, length);
+}
+
+std::vector<TraceRecord> Tracer::snapshot() const {
+    std::vector<TraceRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& ring : retired_) ring->collect(records);
+        for (const auto& ring : rings_) ring->collect(records);
+    }
+
+    const uint64_t cutoff = cleared_before_ns_.load(std::memory_order_relaxed);
+    if (cutoff > 0) {
+        records.erase(std::remove_if(records.begin(), records.end(),
+                                     [cutoff](const TraceRecord& r) { return r.timestamp_ns < cutoff; }),
+                      records.end());
+    }
+
+    std::stable_sort(records.begin(), records.end(),
+                     [](const TraceRecord& a, const TraceRecord& b) {
+                         return a.timestamp_ns < b.timestamp_ns;
+                     });
+    return records;
+}
+
+bool Tracer::dump(const std::string& path) const {
+    return write_file(path, snapshot());
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_.clear();
+    cleared_before_ns_.store(steady_now_ns(), std::memory_order_relaxed);
+}
+
+size_t Tracer::ring_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rings_.size();
+}
+
+// ============================================================================
+// Trace File I/O
+// ============================================================================
+
+namespace {
+
+template <typename T>
+void put_le(std::vector<uint8_t>& buf, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        buf.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+template <typename T>
+T get_le(const uint8_t* p) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return static_cast<T>(v);
+}
+
+} // namespace
+
+bool write_file(const std::string& path, const std::vector<TraceRecord>& records) {
+    std::vector<uint8_t> buf;
+    buf.reserve(kHeaderSize + records.size() * kRecordFileSize);
+
+    buf.insert(buf.end(), kFileMagic, kFileMagic + sizeof(kFileMagic));
+    put_le<uint32_t>(buf, kFileVersion);
+    put_le<uint32_t>(buf, static_cast<uint32_t>(kRecordFileSize));
+    put_le<uint64_t>(buf, records.size());
+    put_le<uint64_t>(buf, steady_now_ns());
+    put_le<uint64_t>(buf, wall_now_ns());
+
+    for (const auto& r : records) {
+        put_le<uint64_t>(buf, r.timestamp_ns);
+        put_le<uint32_t>(buf, r.can_id);
+        put_le<uint16_t>(buf, r.length);
+        buf.push_back(static_cast<uint8_t>(r.kind));
+        buf.push_back(static_cast<uint8_t>(r.direction));
+        put_le<uint16_t>(buf, r.thread_index);
+        buf.push_back(r.captured);
+        buf.push_back(r.reserved);
+        buf.insert(buf.end(), r.data, r.data + kMaxRecordData);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+    return static_cast<bool>(file);
+}
+
+bool load(const std::string& path, TraceFile& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    uint8_t header[kHeaderSize];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header, kFileMagic, sizeof(kFileMagic)) != 0) {
+        return false;
+    }
+    const uint32_t version = get_le<uint32_t>(header + 8);
+    const uint32_t record_size = get_le<uint32_t>(header + 12);
+    const uint64_t count = get_le<uint64_t>(header + 16);
+    if (version != kFileVersion || record_size != kRecordFileSize) {
+        return false;
+    }
+
+    out.steady_anchor_ns = get_le<uint64_t>(header + 24);
+    out.wall_anchor_ns = get_le<uint64_t>(header + 32);
+    out.records.clear();
+
+    uint8_t raw[kRecordFileSize];
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!file.read(reinterpret_cast<char*>(raw), sizeof(raw))) {
+            return false;  // Truncated file
+        }
+        TraceRecord r;
+        r.timestamp_ns = get_le<uint64_t>(raw);
+        r.can_id = get_le<uint32_t>(raw + 8);
+        r.length = get_le<uint16_t>(raw + 12);
+        r.kind = static_cast<RecordKind>(raw[14]);
+        r.direction = static_cast<Direction>(raw[15]);
+        r.thread_index = get_le<uint16_t>(raw + 16);
+        r.captured = std::min<uint8_t>(raw[18], static_cast<uint8_t>(kMaxRecordData));
+        r.reserved = raw[19];
+        std::memcpy(r.data, raw + 20, kMaxRecordData);
+        out.records.push_back(r);
+    }
+    return true;
+}
+
+double TraceFile::wall_time_s(const TraceRecord& r) const {
+    const int64_t offset = static_cast<int64_t>(r.timestamp_ns) - static_cast<int64_t>(steady_anchor_ns);
+    return (static_cast<double>(wall_anchor_ns) + static_cast<double>(offset)) / 1e9;
+}
+
+// ============================================================================
+// Text Conversion
+// ============================================================================
+
+static void append_hex_id(std::ostringstream& ss, uint32_t can_id, bool asc) {
+    const bool extended = (can_id & CANProtocol::CAN_EFF_FLAG) != 0;
+    const uint32_t id = can_id & (extended ? CANProtocol::CAN_EFF_MASK : CANProtocol::CAN_SFF_MASK);
+    ss << std::hex << std::uppercase << std::setfill('0');
+    if (asc) {
+        ss << id << (extended ? "x" : "");
+    } else {
+        ss << std::setw(extended ? 8 : 3) << id;
+    }
+    ss << std::dec << std::setfill(' ');
+}
+
+std::string to_candump(const TraceFile& file, const std::string& interface) {
+    std::ostringstream ss;
+    for (const auto& r : file.records) {
+        if (r.kind != RecordKind::CanFrame) {
+            continue;
+        }
+        ss << "(" << std::fixed << std::setprecision(6) << file.wall_time_s(r) << ") "
+           << interface << " ";
+        append_hex_id(ss, r.can_id, false);
+        ss << (r.captured > 8 ? "##0" : "#");
+        ss << std::hex << std::uppercase << std::setfill('0');
+        for (uint8_t i = 0; i < r.captured; ++i) {
+            ss << std::setw(2) << static_cast<int>(r.data[i]);
+        }
+        ss << std::dec << std::setfill(' ') << "\n";
+    }
+    return ss.str();
+}
+
+// ASC header date in local time, e.g. "Fri Oct 17 10:00:00.000 am 2026"
+static std::string asc_date(double wall_s) {
+    const auto secs = static_cast<std::time_t>(std::floor(wall_s));
+    const int ms = std::min(999, static_cast<int>((wall_s - static_cast<double>(secs)) * 1000.0));
+    const std::tm* tm = std::localtime(&secs);
+    if (!tm) {
+        return "Thu Jan 01 12:00:00.000 am 1970";
+    }
+    char time_part[32];
+    char year[8];
+    std::strftime(time_part, sizeof(time_part), "%a %b %d %I:%M:%S", tm);
+    std::strftime(year, sizeof(year), "%Y", tm);
+    char out[64];
+    std::snprintf(out, sizeof(out), "%s.%03d %s %s", time_part, ms, tm->tm_hour < 12 ? "am" : "pm", year);
+    return out;
+}
+
+std::string to_asc(const TraceFile& file) {
+    std::ostringstream ss;
+    const uint64_t base_ns = file.records.empty() ? 0 : file.records.front().timestamp_ns;
+
+    ss << "date " << asc_date(file.records.empty()
+                                  ? static_cast<double>(file.wall_anchor_ns) / 1e9
+                                  : file.wall_time_s(file.records.front()))
+       << "\n";
+    ss << "base hex  timestamps absolute\n";
+    ss << "internal events logged\n";
+    ss << "Begin Triggerblock\n";
+
+    for (const auto& r : file.records) {
+        const double t = static_cast<double>(r.timestamp_ns - base_ns) / 1e9;
+        const char* dir = r.direction == Direction::Tx ? "Tx" : "Rx";
+
+        if (r.kind == RecordKind::UdsPdu) {
+            ss << "// " << std::fixed << std::setprecision(6) << t << " UDS " << dir << " ";
+            append_hex_id(ss, r.can_id, true);
+            ss << " len=" << r.length << (r.truncated() ? " (truncated)" : "") << ":";
+        } else {
+            ss << std::setw(11) << std::fixed << std::setprecision(6) << t << " 1  ";
+            append_hex_id(ss, r.can_id, true);
+            ss << "             " << dir << "   d " << static_cast<int>(r.captured);
+        }
+
+        ss << std::hex << std::uppercase << std::setfill('0');
+        for (uint8_t i = 0; i < r.captured; ++i) {
+            ss << " " << std::setw(2) << static_cast<int>(r.data[i]);
+        }
+        ss << std::dec << std::setfill(' ') << "\n";
+    }
+
+    ss << "End TriggerBlock\n";
+    return ss.str();
+}
+
+} // namespace trace
+} // namespace uds
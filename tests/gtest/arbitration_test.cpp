@@ -0,0 +1,218 @@
+/**
+ * @file arbitration_test.cpp
+ * @brief Tests for concurrent Client use and transport arbitration (uds.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "uds_async.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace uds;
+using namespace uds::async;
+
+// Transport that detects overlapping conversations. Each request is
+// answered with the requested DID after a short "bus" delay.
+class ExclusiveTransport : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    if (in_use_.fetch_add(1) != 0) overlaps_++;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return open_; });
+      order_.push_back(tx.size() >= 3 ? static_cast<uint16_t>((tx[1] << 8) | tx[2]) : 0);
+    }
+    std::this_thread::sleep_for(delay_);
+    in_use_.fetch_sub(1);
+
+    if (tx.size() >= 3 && tx[1] == 0xDE && tx[2] == 0xAD) {
+      throw std::runtime_error("bus off");
+    }
+    rx = {static_cast<uint8_t>(tx[0] + 0x40)};
+    rx.insert(rx.end(), tx.begin() + 1, tx.end());
+    return true;
+  }
+
+  void set_open(bool open) {
+    { std::lock_guard<std::mutex> lock(mutex_); open_ = open; }
+    cv_.notify_all();
+  }
+  void set_delay(std::chrono::microseconds d) { delay_ = d; }
+  int overlaps() const { return overlaps_.load(); }
+  std::vector<uint16_t> order() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return order_;
+  }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::atomic<int> in_use_{0};
+  std::atomic<int> overlaps_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = true;
+  std::vector<uint16_t> order_;
+  std::chrono::microseconds delay_{200};
+};
+
+using test::wait_until;
+
+TEST(ArbitrationTest, ConcurrentCallersNeverOverlap) {
+  ExclusiveTransport transport;
+  Client client(transport);
+
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 25; ++i) {
+        const uint16_t did = static_cast<uint16_t>(0x1000 + t * 0x100 + i);
+        auto r = client.read_data_by_identifier(did);
+        if (!r.ok || r.payload.size() != 2 ||
+            ((r.payload[0] << 8) | r.payload[1]) != did) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+
+  EXPECT_EQ(transport.overlaps(), 0);
+  EXPECT_EQ(mismatches.load(), 0);
+  EXPECT_EQ(transport.order().size(), 200u);
+  EXPECT_TRUE(client.transport_idle());
+}
+
+TEST(ArbitrationTest, AsyncClientWithMultipleWorkers) {
+  ExclusiveTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 4);
+
+  std::vector<std::future<AsyncResult<std::vector<uint8_t>>>> futures;
+  for (uint16_t did = 0xF100; did < 0xF140; ++did) {
+    futures.push_back(async.read_did_future(did));
+  }
+  uint16_t did = 0xF100;
+  for (auto& f : futures) {
+    auto r = f.get();
+    ASSERT_TRUE(r.is_success());
+    ASSERT_EQ(r.value.size(), 2u);
+    EXPECT_EQ((r.value[0] << 8) | r.value[1], did);
+    ++did;
+  }
+  EXPECT_EQ(transport.overlaps(), 0);
+}
+
+TEST(ArbitrationTest, QueuedRequestsRunInArrivalOrder) {
+  ExclusiveTransport transport;
+  Client client(transport);
+  transport.set_open(false);
+
+  std::vector<std::thread> threads;
+  for (uint16_t i = 0; i < 5; ++i) {
+    threads.emplace_back([&client, i]() { client.write_data_by_identifier(0x0100 + i, {0x00}); });
+    // Give each caller time to enqueue before the next one arrives
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_FALSE(client.transport_idle());
+
+  transport.set_open(true);
+  for (auto& th : threads) th.join();
+
+  EXPECT_EQ(transport.order(), (std::vector<uint16_t>{0x0100, 0x0101, 0x0102, 0x0103, 0x0104}));
+}
+
+TEST(ArbitrationTest, LongQueueIsHandedOver) {
+  ExclusiveTransport transport;
+  transport.set_delay(std::chrono::microseconds(0));
+  Client client(transport);
+  transport.set_open(false);
+
+  std::atomic<int> completed{0};
+  std::vector<std::thread> threads;
+  threads.emplace_back([&]() { client.routine_control(RoutineAction::Start, 0x0000); completed++; });
+  ASSERT_TRUE(wait_until([&] { return !client.transport_idle(); }));
+  for (int i = 1; i < 50; ++i) {
+    threads.emplace_back([&, i]() {
+      client.routine_control(RoutineAction::Start, static_cast<RoutineId>(i));
+      completed++;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  transport.set_open(true);
+  for (auto& th : threads) th.join();
+
+  EXPECT_EQ(completed.load(), 50);
+  EXPECT_EQ(transport.overlaps(), 0);
+  EXPECT_TRUE(client.transport_idle());
+}
+
+TEST(ArbitrationTest, TransportExceptionReachesCaller) {
+  ExclusiveTransport transport;
+  Client client(transport);
+
+  EXPECT_THROW(client.read_data_by_identifier(0xDEAD), std::runtime_error);
+  EXPECT_TRUE(client.read_data_by_identifier(0xF190).ok);
+  EXPECT_TRUE(client.transport_idle());
+}
+
+TEST(ArbitrationTest, TimingAccessorsAreThreadSafe) {
+  ExclusiveTransport transport;
+  Client client(transport);
+
+  std::thread writer([&]() {
+    for (int i = 0; i < 1000; ++i) {
+      Timings t;
+      t.p2 = std::chrono::milliseconds(50 + (i % 2) * 50);
+      t.p2_star = t.p2 * 100;
+      client.set_timings(t);
+    }
+  });
+  for (int i = 0; i < 1000; ++i) {
+    const Timings t = client.timings();
+    EXPECT_EQ(t.p2_star, t.p2 * 100);
+  }
+  writer.join();
+}
+
+TEST(ArbitrationTest, ExpiredScopeSkipsTheBus) {
+  ExclusiveTransport transport;
+  Client client(transport);
+
+  ExchangeScope scope(std::chrono::steady_clock::now() - std::chrono::milliseconds(1));
+  EXPECT_TRUE(ExchangeScope::expired());
+  EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok);
+  EXPECT_TRUE(transport.order().empty());
+}
+
+TEST(ArbitrationTest, DeadlineAbandonsQueuedExchange) {
+  ExclusiveTransport transport;
+  Client client(transport);
+  transport.set_open(false);
+
+  std::thread holder([&]() { client.read_data_by_identifier(0x0001); });
+  ASSERT_TRUE(wait_until([&] { return !client.transport_idle(); }));
+
+  const auto start = std::chrono::steady_clock::now();
+  {
+    ExchangeScope scope(start + std::chrono::milliseconds(50));
+    EXPECT_FALSE(client.write_data_by_identifier(0x0002, {0x00}).ok);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+  transport.set_open(true);
+  holder.join();
+  EXPECT_EQ(transport.order(), (std::vector<uint16_t>{0x0001}));
+  EXPECT_EQ(ExchangeScope::current(), std::chrono::steady_clock::time_point::max());
+}
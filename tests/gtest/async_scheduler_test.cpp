@@ -0,0 +1,353 @@
+/**
+ * @file async_scheduler_test.cpp
+ * @brief Tests for AsyncClient task scheduling (uds_async.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "uds_async.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::async;
+
+// ECU answering every request immediately with a positive echo
+class EchoTransport : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    rx = {static_cast<uint8_t>(tx[0] + 0x40)};
+    rx.insert(rx.end(), tx.begin() + 1, tx.end());
+    return true;
+  }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+};
+
+using test::wait_until;
+
+TEST(AsyncSchedulerTest, HigherPriorityRunsFirst) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1);
+  async.pause();
+
+  std::mutex mutex;
+  std::vector<uint16_t> order;
+  auto record = [&](uint16_t did) {
+    return [&, did](const AsyncResult<std::vector<uint8_t>>&) {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(did);
+    };
+  };
+  async.read_did_async(0x0001, record(0x0001), Priority::Low);
+  async.read_did_async(0x0002, record(0x0002), Priority::Normal);
+  async.read_did_async(0x0003, record(0x0003), Priority::Critical);
+  async.read_did_async(0x0004, record(0x0004), Priority::Normal);
+  EXPECT_EQ(async.pending_count(), 4u);
+
+  async.resume();
+  ASSERT_TRUE(wait_until([&] { std::lock_guard<std::mutex> l(mutex); return order.size() == 4; }));
+  EXPECT_EQ(order, (std::vector<uint16_t>{0x0003, 0x0002, 0x0004, 0x0001}));
+  EXPECT_EQ(async.pending_count(), 0u);
+}
+
+TEST(AsyncSchedulerTest, IdleWorkersStealFollowUpTasks) {
+  EchoTransport transport;
+  Client client(transport);
+  constexpr int kWorkers = 4;
+  AsyncClient async(client, kWorkers);
+
+  // Follow-up tasks land on the submitting worker's deque. Each one blocks
+  // until all of them run at once, which needs the other workers to steal.
+  std::mutex mutex;
+  std::condition_variable cv;
+  int arrived = 0;
+  std::atomic<int> met{0};
+  auto rendezvous = [&](const AsyncResult<std::vector<uint8_t>>&) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++arrived;
+    cv.notify_all();
+    if (cv.wait_for(lock, std::chrono::seconds(2), [&] { return arrived == kWorkers; })) met++;
+  };
+
+  async.read_did_async(0xF190, [&](const AsyncResult<std::vector<uint8_t>>&) {
+    for (int i = 0; i < kWorkers; ++i) {
+      async.read_did_async(static_cast<uint16_t>(0xF200 + i), rendezvous);
+    }
+  });
+
+  ASSERT_TRUE(wait_until([&] { return met.load() == kWorkers; }));
+}
+
+TEST(AsyncSchedulerTest, ManyProducersAllTasksRun) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 4);
+
+  std::atomic<int> done{0};
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 4; ++p) {
+    producers.emplace_back([&]() {
+      for (int i = 0; i < 500; ++i) {
+        async.read_did_async(0xF190, [&](const AsyncResult<std::vector<uint8_t>>& r) {
+          if (r.is_success()) done++;
+        });
+      }
+    });
+  }
+  for (auto& t : producers) t.join();
+
+  ASSERT_TRUE(wait_until([&] { return done.load() == 2000; }));
+  EXPECT_EQ(async.pending_count(), 0u);
+}
+
+TEST(AsyncSchedulerTest, StatusTracksEachTask) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1);
+  async.pause();
+
+  auto read = async.read_did_async(0xF190, nullptr);
+  auto session = async.session_control_async(Session::ExtendedSession, nullptr);
+  EXPECT_NE(read, session);
+  EXPECT_EQ(async.get_status(read), AsyncStatus::Pending);
+  EXPECT_TRUE(async.is_busy());
+
+  async.resume();
+  EXPECT_TRUE(async.wait(read, std::chrono::milliseconds(2000)));
+  EXPECT_TRUE(async.wait(session, std::chrono::milliseconds(2000)));
+  EXPECT_EQ(async.get_status(read), AsyncStatus::Completed);
+  EXPECT_EQ(async.get_status(session), AsyncStatus::Completed);
+  EXPECT_EQ(async.get_status(TaskHandle()), AsyncStatus::Failed);
+  ASSERT_TRUE(wait_until([&] { return !async.is_busy(); }));
+}
+
+TEST(AsyncSchedulerTest, SlotsAreReusedAndStaleHandlesDetected) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 2, 4);
+
+  std::atomic<int> done{0};
+  std::vector<TaskHandle> handles;
+  for (int i = 0; i < 100; ++i) {
+    handles.push_back(async.read_did_async(0xF190, [&](const AsyncResult<std::vector<uint8_t>>&) { done++; }));
+    ASSERT_TRUE(handles.back().is_valid());
+    ASSERT_TRUE(wait_until([&] { return done.load() == i + 1; }));
+  }
+  ASSERT_TRUE(wait_until([&] { return !async.is_busy(); }));
+
+  // Only the most recent task per slot is still known
+  EXPECT_EQ(async.get_status(handles.front()), AsyncStatus::Failed);
+  EXPECT_EQ(async.get_status(handles.back()), AsyncStatus::Completed);
+}
+
+TEST(AsyncSchedulerTest, FullTableRejectsInsteadOfBlocking) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1, 2);
+  async.pause();
+
+  std::atomic<int> completed{0};
+  std::atomic<int> failed{0};
+  auto callback = [&](const AsyncResult<std::vector<uint8_t>>& r) {
+    if (r.status == AsyncStatus::Completed) completed++;
+    if (r.status == AsyncStatus::Failed) failed++;
+  };
+  auto first = async.read_did_async(0xF190, callback);
+  auto second = async.read_did_async(0xF191, callback);
+  ASSERT_TRUE(first.is_valid());
+  ASSERT_TRUE(second.is_valid());
+
+  // No worker can free a slot while paused; the caller gets an answer anyway
+  auto third = async.read_did_async(0xF192, callback);
+  EXPECT_FALSE(third.is_valid());
+  EXPECT_EQ(failed.load(), 1);
+  EXPECT_EQ(async.pending_count(), 2u);
+
+  async.resume();
+  EXPECT_TRUE(async.wait(first, std::chrono::milliseconds(2000)));
+  EXPECT_TRUE(async.wait(second, std::chrono::milliseconds(2000)));
+  ASSERT_TRUE(wait_until([&] { return completed.load() == 2; }));
+  EXPECT_TRUE(async.read_did_async(0xF193, callback).is_valid());
+  ASSERT_TRUE(wait_until([&] { return completed.load() == 3; }));
+}
+
+TEST(AsyncSchedulerTest, CancelledTaskNeverRuns) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1);
+  async.pause();
+
+  std::atomic<int> ran{0};
+  std::atomic<int> cancelled{0};
+  auto callback = [&](const AsyncResult<std::vector<uint8_t>>& r) {
+    if (r.status == AsyncStatus::Cancelled) cancelled++;
+    else ran++;
+  };
+  auto first = async.read_did_async(0xF190, callback);
+  auto second = async.read_did_async(0xF191, callback);
+  auto third = async.read_did_async(0xF192, callback);
+
+  EXPECT_TRUE(async.cancel(second));
+  EXPECT_FALSE(async.cancel(second));
+  EXPECT_EQ(async.get_status(second), AsyncStatus::Cancelled);
+
+  async.resume();
+  async.wait_all(std::chrono::milliseconds(2000));
+  EXPECT_EQ(ran.load(), 2);
+  EXPECT_EQ(cancelled.load(), 1);
+  EXPECT_EQ(async.get_status(first), AsyncStatus::Completed);
+  EXPECT_EQ(async.get_status(third), AsyncStatus::Completed);
+  EXPECT_FALSE(async.cancel(first));
+}
+
+TEST(AsyncSchedulerTest, CancelAllResolvesFutures) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1);
+  async.pause();
+
+  std::vector<std::future<AsyncResult<std::vector<uint8_t>>>> futures;
+  for (uint16_t did = 0xF190; did < 0xF195; ++did) {
+    futures.push_back(async.read_did_future(did));
+  }
+  async.cancel_all();
+  async.resume();
+
+  for (auto& f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(f.get().status, AsyncStatus::Cancelled);
+  }
+}
+
+// ECU that never answers; it waits out the timeout it is given
+class SilentTransport : public Transport {
+public:
+  explicit SilentTransport(bool block = true) : block_(block) {}
+
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>&, std::vector<uint8_t>&,
+                        std::chrono::milliseconds timeout) override {
+    requests_++;
+    last_timeout_ms_ = static_cast<int>(timeout.count());
+    if (block_) std::this_thread::sleep_for(timeout);
+    return false;
+  }
+
+  int requests() const { return requests_.load(); }
+  int last_timeout_ms() const { return last_timeout_ms_.load(); }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  bool block_;
+  std::atomic<int> requests_{0};
+  std::atomic<int> last_timeout_ms_{0};
+};
+
+TEST(AsyncSchedulerTest, EarliestDeadlineFirstWithinPriority) {
+  EchoTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1);
+  async.pause();
+
+  std::mutex mutex;
+  std::vector<uint16_t> order;
+  auto record = [&](uint16_t did) {
+    return [&, did](const AsyncResult<std::vector<uint8_t>>&) {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(did);
+    };
+  };
+  using std::chrono::milliseconds;
+  async.read_did_async(0x0001, record(0x0001));
+  async.read_did_async(0x0002, record(0x0002), TaskOptions::within(milliseconds(3000)));
+  async.read_did_async(0x0003, record(0x0003), TaskOptions::within(milliseconds(1000)));
+  async.read_did_async(0x0004, record(0x0004), TaskOptions::within(milliseconds(2000)));
+  async.read_did_async(0x0005, record(0x0005), TaskOptions::within(milliseconds(5000), Priority::High));
+
+  async.resume();
+  ASSERT_TRUE(wait_until([&] { std::lock_guard<std::mutex> l(mutex); return order.size() == 5; }));
+  EXPECT_EQ(order, (std::vector<uint16_t>{0x0005, 0x0003, 0x0004, 0x0002, 0x0001}));
+}
+
+TEST(AsyncSchedulerTest, ExpiredTaskIsShedWithoutTouchingTheBus) {
+  SilentTransport transport;
+  Client client(transport);
+  AsyncClient async(client, 1);
+  async.pause();
+
+  auto future_status = std::make_shared<std::promise<AsyncStatus>>();
+  auto handle = async.read_did_async(0xF190, [future_status](const AsyncResult<std::vector<uint8_t>>& r) {
+    future_status->set_value(r.status);
+  }, TaskOptions::within(std::chrono::milliseconds(10)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  async.resume();
+
+  auto f = future_status->get_future();
+  ASSERT_EQ(f.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+  EXPECT_EQ(f.get(), AsyncStatus::TimedOut);
+  EXPECT_TRUE(async.wait(handle, std::chrono::milliseconds(1000)));
+  EXPECT_EQ(async.get_status(handle), AsyncStatus::TimedOut);
+  EXPECT_EQ(transport.requests(), 0);
+}
+
+TEST(AsyncSchedulerTest, DeadlineBoundsInFlightExchange) {
+  SilentTransport transport;
+  Timings timings;
+  timings.p2 = std::chrono::milliseconds(5000);
+  Client client(transport, timings);
+  AsyncClient async(client, 1);
+
+  const auto start = std::chrono::steady_clock::now();
+  auto future_result = std::make_shared<std::promise<AsyncResult<std::vector<uint8_t>>>>();
+  async.read_did_async(0xF190, [future_result](const AsyncResult<std::vector<uint8_t>>& r) {
+    future_result->set_value(r);
+  }, TaskOptions::within(std::chrono::milliseconds(100)));
+
+  auto f = future_result->get_future();
+  ASSERT_EQ(f.wait_for(std::chrono::seconds(3)), std::future_status::ready);
+  const auto r = f.get();
+  EXPECT_EQ(r.status, AsyncStatus::TimedOut);
+  EXPECT_LE(transport.last_timeout_ms(), 100);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(AsyncSchedulerTest, DefaultTimeoutBoundsExecution) {
+  SilentTransport transport;
+  Timings timings;
+  timings.p2 = std::chrono::milliseconds(5000);
+  Client client(transport, timings);
+  AsyncClient async(client, 1);
+  async.set_default_timeout(std::chrono::milliseconds(50));
+
+  auto handle = async.read_did_async(0xF190, nullptr);
+  EXPECT_TRUE(async.wait(handle, std::chrono::milliseconds(2000)));
+  EXPECT_EQ(async.get_status(handle), AsyncStatus::TimedOut);
+  EXPECT_LE(transport.last_timeout_ms(), 50);
+}
+
+TEST(AsyncSchedulerTest, NoDeadlineUnlessRequested) {
+  SilentTransport transport(false);
+  Timings timings;
+  timings.p2 = std::chrono::milliseconds(30000);
+  timings.p2_star = std::chrono::milliseconds(30000);
+  Client client(transport, timings);
+  AsyncClient async(client, 1);
+
+  // Long 0x78-pending routines must not be cut short by a hidden default
+  auto handle = async.read_did_async(0xF190, nullptr);
+  EXPECT_TRUE(async.wait(handle, std::chrono::milliseconds(2000)));
+  EXPECT_EQ(transport.last_timeout_ms(), 30000);
+}
@@ -0,0 +1,243 @@
+/**
+ * @file batch_test.cpp
+ * @brief Tests for BatchExecutor and multi-DID reads (uds_async.cpp, uds.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "uds_async.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::async;
+
+// Number of simulated ECUs answering at the same time, and its peak
+static std::atomic<int> g_active{0};
+static std::atomic<int> g_peak{0};
+
+// Simulated ECU holding a DID store. Answers single- and multi-DID reads and
+// writes, and records the order of requests it receives.
+class DidServerTransport : public Transport {
+public:
+  explicit DidServerTransport(uint32_t tx_id = 0x7E0) : addr_{AddressType::Physical, tx_id, tx_id + 8} {}
+
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    const int now = g_active.fetch_add(1) + 1;
+    for (int peak = g_peak.load(); now > peak && !g_peak.compare_exchange_weak(peak, now);) {}
+    std::this_thread::sleep_for(delay_);
+    g_active.fetch_sub(1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_.push_back(tx);
+    rx.clear();
+    if (tx[0] == 0x22) {
+      const size_t count = (tx.size() - 1) / 2;
+      if (count > 1 && reject_multi_) { rx = {0x7F, 0x22, 0x13}; return true; }
+      rx.push_back(0x62);
+      for (size_t i = 0; i < count; ++i) {
+        const uint16_t did = static_cast<uint16_t>((tx[1 + 2 * i] << 8) | tx[2 + 2 * i]);
+        auto it = store_.find(did);
+        if (it == store_.end()) {
+          if (count == 1) { rx = {0x7F, 0x22, 0x31}; return true; }
+          continue;  // unsupported DIDs are omitted from multi-DID responses
+        }
+        rx.push_back(tx[1 + 2 * i]);
+        rx.push_back(tx[2 + 2 * i]);
+        rx.insert(rx.end(), it->second.begin(), it->second.end());
+      }
+      return true;
+    }
+    if (tx[0] == 0x2E) {
+      const uint16_t did = static_cast<uint16_t>((tx[1] << 8) | tx[2]);
+      store_[did].assign(tx.begin() + 3, tx.end());
+      rx = {0x6E, tx[1], tx[2]};
+      return true;
+    }
+    rx = {0x7F, tx[0], 0x11};
+    return true;
+  }
+
+  void set(uint16_t did, std::vector<uint8_t> data) { store_[did] = std::move(data); }
+  void set_reject_multi(bool reject) { reject_multi_ = reject; }
+  void set_delay(std::chrono::milliseconds d) { delay_ = d; }
+  std::vector<std::vector<uint8_t>> log() { std::lock_guard<std::mutex> lock(mutex_); return log_; }
+
+private:
+  Address addr_;
+  std::mutex mutex_;
+  std::map<uint16_t, std::vector<uint8_t>> store_;
+  std::vector<std::vector<uint8_t>> log_;
+  bool reject_multi_ = false;
+  std::chrono::milliseconds delay_{0};
+};
+
+TEST(SplitDidRecordsTest, SplitsKnownAndUnknownLengths) {
+  const std::vector<uint8_t> payload = {0xF1, 0x90, 'V', 'I', 'N', 0xF1, 0x8C, 0x01, 0x02};
+  std::vector<std::vector<uint8_t>> records;
+
+  ASSERT_TRUE(split_did_records({0xF190, 0xF18C}, {0, 0}, payload, records));
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0], (std::vector<uint8_t>{'V', 'I', 'N'}));
+  EXPECT_EQ(records[1], (std::vector<uint8_t>{0x01, 0x02}));
+
+  ASSERT_TRUE(split_did_records({0xF190, 0xF18C}, {3, 2}, payload, records));
+  EXPECT_FALSE(split_did_records({0xF190, 0xF18C}, {2, 0}, payload, records));
+  EXPECT_FALSE(split_did_records({0xF190, 0xF186}, {0, 0}, payload, records));
+}
+
+TEST(SplitDidRecordsTest, AmbiguousEchoInDataIsRejected) {
+  // Data of the first DID contains the second DID's echo bytes
+  const std::vector<uint8_t> payload = {0x01, 0x00, 0x02, 0x00, 0xAA, 0x02, 0x00, 0xBB};
+  std::vector<std::vector<uint8_t>> records;
+  EXPECT_FALSE(split_did_records({0x0100, 0x0200}, {0, 0}, payload, records));
+  ASSERT_TRUE(split_did_records({0x0100, 0x0200}, {3, 0}, payload, records));
+  EXPECT_EQ(records[1], (std::vector<uint8_t>{0xBB}));
+}
+
+TEST(BatchExecutorTest, PacksReadsAndIndexesResultsByOperation) {
+  DidServerTransport ecu;
+  ecu.set(0xF190, {'W', '0', 'L'});
+  ecu.set(0xF18C, {0x12, 0x34});
+  ecu.set(0xF187, {0x99});
+  Client client(ecu);
+
+  BatchExecutor batch(client);
+  EXPECT_EQ(batch.add_read(0xF190), 0u);
+  EXPECT_EQ(batch.add_read(0xF18C), 1u);
+  EXPECT_EQ(batch.add_read(0xF187), 2u);
+  auto results = batch.execute();
+
+  ASSERT_EQ(results.size(), 3u);
+  EXPECT_EQ(ecu.log().size(), 1u);
+  for (const auto& r : results) EXPECT_TRUE(r.is_success());
+  EXPECT_EQ(results[0].value, (std::vector<uint8_t>{0xF1, 0x90, 'W', '0', 'L'}));
+  EXPECT_EQ(results[1].value, (std::vector<uint8_t>{0xF1, 0x8C, 0x12, 0x34}));
+  EXPECT_EQ(results[2].value, (std::vector<uint8_t>{0xF1, 0x87, 0x99}));
+}
+
+TEST(BatchExecutorTest, ReadAndWriteOfSameDidDoNotCollide) {
+  DidServerTransport ecu;
+  ecu.set(0x0101, {0x00});
+  Client client(ecu);
+
+  BatchExecutor batch(client);
+  batch.add_read(0x0101);
+  batch.add_write(0x0101, {0x55});
+  batch.add_read(0x0101);
+  auto results = batch.execute();
+
+  ASSERT_EQ(results.size(), 3u);
+  EXPECT_EQ(results[0].value, (std::vector<uint8_t>{0x01, 0x01, 0x00}));
+  EXPECT_EQ(results[1].value, (std::vector<uint8_t>{0x55}));
+  EXPECT_EQ(results[2].value, (std::vector<uint8_t>{0x01, 0x01, 0x55}));
+  EXPECT_EQ(ecu.log().size(), 3u);
+}
+
+TEST(BatchExecutorTest, WritesKeepSubmissionOrderPerTarget) {
+  DidServerTransport ecu;
+  Client client(ecu);
+
+  BatchExecutor batch(client);
+  for (uint16_t did = 0x0200; did < 0x0210; ++did) {
+    batch.add_write(did, {static_cast<uint8_t>(did)});
+  }
+  auto results = batch.execute();
+  for (const auto& r : results) EXPECT_TRUE(r.is_success());
+
+  auto log = ecu.log();
+  ASSERT_EQ(log.size(), 16u);
+  for (size_t i = 0; i < log.size(); ++i) {
+    EXPECT_EQ((log[i][1] << 8) | log[i][2], 0x0200 + static_cast<int>(i));
+  }
+}
+
+TEST(BatchExecutorTest, RejectedPackedReadFallsBackToSingleReads) {
+  DidServerTransport ecu;
+  ecu.set(0xF190, {0x01});
+  ecu.set(0xF18C, {0x02});
+  ecu.set_reject_multi(true);
+  Client client(ecu);
+
+  BatchExecutor batch(client);
+  batch.add_read(0xF190);
+  batch.add_read(0xF18C);
+  batch.add_read(0xF1A0);  // unsupported
+  auto results = batch.execute();
+
+  EXPECT_EQ(ecu.log().size(), 4u);  // one packed attempt + three singles
+  EXPECT_TRUE(results[0].is_success());
+  EXPECT_TRUE(results[1].is_success());
+  EXPECT_EQ(results[2].status, AsyncStatus::Failed);
+  EXPECT_EQ(results[2].nrc, NegativeResponseCode::RequestOutOfRange);
+}
+
+TEST(BatchExecutorTest, OmittedDidInPackedResponseIsReadSingly) {
+  DidServerTransport ecu;
+  ecu.set(0xF190, {0x01});
+  Client client(ecu);
+
+  BatchExecutor batch(client);
+  batch.add_read(0xF190);
+  batch.add_read(0xF1A0);  // omitted by the ECU
+  auto results = batch.execute();
+
+  EXPECT_TRUE(results[0].is_success());
+  EXPECT_EQ(results[1].status, AsyncStatus::Failed);
+  EXPECT_EQ(results[1].nrc, NegativeResponseCode::RequestOutOfRange);
+}
+
+TEST(BatchExecutorTest, TargetsRunInParallel) {
+  constexpr int kEcus = 4;
+  std::vector<std::unique_ptr<DidServerTransport>> ecus;
+  std::vector<std::unique_ptr<Client>> clients;
+  for (int i = 0; i < kEcus; ++i) {
+    ecus.push_back(std::make_unique<DidServerTransport>(0x7E0 + i));
+    ecus.back()->set_delay(std::chrono::milliseconds(20));
+    clients.push_back(std::make_unique<Client>(*ecus.back()));
+  }
+  g_peak = 0;
+
+  BatchExecutor batch(*clients[0], kEcus);
+  for (int i = 0; i < kEcus; ++i) {
+    for (uint16_t did = 0x0300; did < 0x0303; ++did) {
+      batch.add_write(*clients[i], did, {static_cast<uint8_t>(i)});
+    }
+  }
+
+  std::atomic<size_t> last_progress{0};
+  auto results = batch.execute([&](size_t completed, size_t total) {
+    EXPECT_EQ(total, static_cast<size_t>(kEcus * 3));
+    last_progress = completed;
+  });
+
+  ASSERT_EQ(results.size(), static_cast<size_t>(kEcus * 3));
+  for (const auto& r : results) EXPECT_TRUE(r.is_success());
+  EXPECT_EQ(last_progress.load(), results.size());
+  EXPECT_GT(g_peak.load(), 1);
+  for (auto& ecu : ecus) EXPECT_EQ(ecu->log().size(), 3u);
+}
+
+TEST(BatchExecutorTest, MaxConcurrentOneRunsTargetsSerially) {
+  DidServerTransport a(0x7E0), b(0x7E1);
+  a.set_delay(std::chrono::milliseconds(5));
+  b.set_delay(std::chrono::milliseconds(5));
+  Client ca(a), cb(b);
+  g_peak = 0;
+
+  BatchExecutor batch(ca, 1);
+  batch.add_write(ca, 0x0400, {0x01});
+  batch.add_write(cb, 0x0400, {0x02});
+  batch.add_write(ca, 0x0401, {0x03});
+  auto results = batch.execute();
+
+  for (const auto& r : results) EXPECT_TRUE(r.is_success());
+  EXPECT_EQ(g_peak.load(), 1);
+}
@@ -0,0 +1,139 @@
+/**
+ * @file cache_batching_test.cpp
+ * @brief Tests for batched cache-miss reads in CachedClient (uds_cache.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_cache.hpp"
+#include <atomic>
+#include <set>
+
+using namespace uds;
+using namespace uds::cache;
+
+// ECU answering single and multi-DID ReadDataByIdentifier. Each DID's data
+// is its low byte repeated (did & 3) + 1 times. Requests with more than
+// max_dids DIDs are rejected with IncorrectMessageLengthOrFormat;
+// unsupported DIDs are left out of the response (NRC 0x31 if none remain).
+class MultiDidEcu : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    requests_++;
+    const size_t count = (tx.size() - 1) / 2;
+    if (count > max_dids) {
+      rx = {0x7F, 0x22, 0x13};
+      return true;
+    }
+    rx = {0x62};
+    for (size_t i = 0; i < count; ++i) {
+      const uint16_t did = static_cast<uint16_t>((tx[1 + 2 * i] << 8) | tx[2 + 2 * i]);
+      if (unsupported.count(did)) continue;
+      rx.push_back(static_cast<uint8_t>(did >> 8));
+      rx.push_back(static_cast<uint8_t>(did));
+      rx.insert(rx.end(), (did & 3) + 1, static_cast<uint8_t>(did));
+    }
+    if (rx.size() == 1) rx = {0x7F, 0x22, 0x31};
+    return true;
+  }
+
+  int requests() const { return requests_.load(); }
+
+  size_t max_dids = 64;
+  std::set<uint16_t> unsupported;
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::atomic<int> requests_{0};
+};
+
+static std::vector<uint16_t> dashboard(uint16_t first, size_t n) {
+  std::vector<uint16_t> dids;
+  for (size_t i = 0; i < n; ++i) dids.push_back(static_cast<uint16_t>(first + i));
+  return dids;
+}
+
+static std::vector<uint8_t> expected(uint16_t did) {
+  std::vector<uint8_t> v = {static_cast<uint8_t>(did >> 8), static_cast<uint8_t>(did)};
+  v.insert(v.end(), (did & 3) + 1, static_cast<uint8_t>(did));
+  return v;
+}
+
+TEST(CacheBatchingTest, ColdDashboardReadIsBatched) {
+  MultiDidEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+
+  const auto dids = dashboard(0x1000, 100);
+  auto values = cached.read_dids(dids);
+  ASSERT_EQ(values.size(), 100u);
+  for (uint16_t did : dids) EXPECT_EQ(values[did], expected(did));
+  EXPECT_EQ(ecu.requests(), 13);  // ceil(100 / 8)
+  EXPECT_EQ(cached.read_requests(), 13u);
+
+  // Warm: served from the cache, single reads agree with batched ones
+  EXPECT_EQ(cached.read_dids(dids).size(), 100u);
+  EXPECT_EQ(ecu.requests(), 13);
+  EXPECT_EQ(cached.read_did(0x1003).payload, expected(0x1003));
+  EXPECT_EQ(ecu.requests(), 13);
+}
+
+TEST(CacheBatchingTest, RejectedBatchLowersTheLimit) {
+  MultiDidEcu ecu;
+  ecu.max_dids = 3;
+  Client client(ecu);
+  CachedClient cached(client);
+
+  auto values = cached.read_dids(dashboard(0x2000, 16));
+  EXPECT_EQ(values.size(), 16u);
+  EXPECT_EQ(cached.max_dids_per_request(), 2u);
+
+  const int before = ecu.requests();
+  EXPECT_EQ(cached.read_dids(dashboard(0x3000, 16)).size(), 16u);
+  EXPECT_EQ(ecu.requests() - before, 8);
+}
+
+TEST(CacheBatchingTest, UnsupportedDidDoesNotFailTheBatch) {
+  MultiDidEcu ecu;
+  ecu.unsupported = {0x4003};
+  Client client(ecu);
+  CachedClient cached(client);
+
+  auto values = cached.read_dids(dashboard(0x4000, 8));
+  EXPECT_EQ(values.size(), 7u);
+  EXPECT_EQ(values.count(0x4003), 0u);
+  EXPECT_EQ(values[0x4007], expected(0x4007));
+  EXPECT_EQ(cached.max_dids_per_request(), CachedClient::kDefaultMaxDidsPerRequest);
+}
+
+TEST(CacheBatchingTest, PrefetchFetchesOnlyMisses) {
+  MultiDidEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+
+  ASSERT_TRUE(cached.read_did(0x5000).ok);
+  const int before = ecu.requests();
+  auto dids = dashboard(0x5000, 9);
+  dids.push_back(0xF40C);  // volatile: never cached, so not prefetched
+  cached.prefetch(dids);
+  EXPECT_EQ(ecu.requests() - before, 1);  // 0x5001..0x5008 in one request
+  EXPECT_EQ(cached.cache().size(), 9u);
+  EXPECT_TRUE(cached.cache().uncached(dids).empty());
+
+  cached.prefetch(dids);
+  EXPECT_EQ(ecu.requests() - before, 1);
+}
+
+TEST(CacheBatchingTest, BatchingCanBeDisabled) {
+  MultiDidEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+  cached.set_max_dids_per_request(1);
+
+  EXPECT_EQ(cached.read_dids(dashboard(0x6000, 5), true).size(), 5u);
+  EXPECT_EQ(ecu.requests(), 5);
+}
@@ -0,0 +1,207 @@
+/**
+ * @file cache_events_test.cpp
+ * @brief Tests for ResponseOnEvent reception and event-driven updates of CachedClient (uds_cache.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_cache.hpp"
+#include "uds_event.hpp"
+#include "test_util.hpp"
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::cache;
+
+// ECU with DID values that can change, reporting changes of DIDs set up
+// with ResponseOnEvent OnChangeOfDataIdentifier as 0xC6 notifications
+class ChangingEcu : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(tx);
+    if (tx[0] == 0x22 && tx.size() == 3) {
+      const uint16_t did = static_cast<uint16_t>(tx[1] << 8 | tx[2]);
+      rx = {0x62, tx[1], tx[2], values_[did]};
+      return true;
+    }
+    if (tx[0] == 0x86 && tx.size() >= 2) {
+      if (reject_setup_ && tx[1] == 0x03) { rx = {0x7F, 0x86, 0x31}; return true; }
+      if (tx[1] == 0x03 && tx.size() >= 6) events_[static_cast<uint16_t>(tx[4] << 8 | tx[5])] = true;
+      if (tx[1] == 0x05) started_ = true;
+      if (tx[1] == 0x00) started_ = false;
+      if (tx[1] == 0x06) events_.clear();
+      rx = {0xC6, tx[1], 0x00, 0x02};
+      return true;
+    }
+    rx = {0x7F, tx[0], 0x11};
+    return true;
+  }
+
+  bool recv_unsolicited(std::vector<uint8_t>& rx, std::chrono::milliseconds timeout) override {
+    const auto end = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pushed_.empty()) {
+          rx = std::move(pushed_.front());
+          pushed_.pop_front();
+          return true;
+        }
+      }
+      if (std::chrono::steady_clock::now() >= end) return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  // Change a value; reported if its event is set up and reporting started
+  void change(uint16_t did, uint8_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    values_[did] = value;
+    if (started_ && events_[did]) {
+      push_locked({0xC6, 0x03, 0x01, 0x62, static_cast<uint8_t>(did >> 8),
+                   static_cast<uint8_t>(did & 0xFF), value});
+    }
+  }
+
+  void push(std::vector<uint8_t> pdu) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    push_locked(std::move(pdu));
+  }
+
+  size_t reads() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (const auto& r : requests_) n += r[0] == 0x22;
+    return n;
+  }
+  std::vector<std::vector<uint8_t>> requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+  void set_reject_setup(bool reject) { reject_setup_ = reject; }
+
+private:
+  void push_locked(std::vector<uint8_t> pdu) { pushed_.push_back(std::move(pdu)); }
+
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  std::map<uint16_t, uint8_t> values_;
+  std::map<uint16_t, bool> events_;
+  bool started_ = false;
+  bool reject_setup_ = false;
+  std::deque<std::vector<uint8_t>> pushed_;
+  std::vector<std::vector<uint8_t>> requests_;
+};
+
+using test::wait_until;
+
+TEST(CacheEventsTest, TryReceiveEventParsesNotification) {
+  ChangingEcu ecu;
+  Client client(ecu);
+
+  event::EventNotification n;
+  EXPECT_FALSE(event::try_receive_event(client, n, std::chrono::milliseconds(5)));
+
+  // storageState bit set, response SID echoed
+  ecu.push({0xC6, 0x43, 0x01, 0x62, 0xF4, 0x0C, 0x20});
+  ASSERT_TRUE(event::try_receive_event(client, n, std::chrono::milliseconds(50)));
+  EXPECT_EQ(n.event_type, event::EventType::OnChangeOfDataIdentifier);
+  EXPECT_EQ(n.number_of_events, 1u);
+  EXPECT_EQ(n.service_id, 0x22);
+  EXPECT_EQ(n.payload, (std::vector<uint8_t>{0xF4, 0x0C, 0x20}));
+
+  // Request SID echoed
+  ecu.push({0xC6, 0x01, 0x01, 0x19, 0x02, 0xFF});
+  ASSERT_TRUE(event::try_receive_event(client, n, std::chrono::milliseconds(50)));
+  EXPECT_EQ(n.event_type, event::EventType::OnDTCStatusChange);
+  EXPECT_EQ(n.service_id, 0x19);
+
+  // Periodic data is left for its own consumer
+  ecu.push({0x6A, 0x01, 0x55});
+  EXPECT_FALSE(event::try_receive_event(client, n, std::chrono::milliseconds(20)));
+  PeriodicDataMessage msg;
+  EXPECT_TRUE(client.receive_periodic_data(msg, std::chrono::milliseconds(5)));
+}
+
+TEST(CacheEventsTest, WatchedDidIsUpdatedWithoutPolling) {
+  ChangingEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+  ecu.change(0xF40C, 0x10);
+
+  // Engine RPM is volatile (never cached) until watched
+  EXPECT_FALSE(cached.cache().is_cacheable(0xF40C));
+  ASSERT_TRUE(cached.watch_did_changes(0xF40C));
+  EXPECT_TRUE(cached.cache().is_cacheable(0xF40C));
+  EXPECT_EQ(cached.watched_dids(), (std::vector<uint16_t>{0xF40C}));
+
+  ASSERT_TRUE(cached.read_did(0xF40C).ok);
+  ASSERT_TRUE(cached.read_did(0xF40C).ok);
+  EXPECT_EQ(ecu.reads(), 1u);
+
+  ecu.change(0xF40C, 0x20);
+  ASSERT_TRUE(wait_until([&] { return cached.change_event_stats().updates == 1; }));
+  auto rpm = cached.read_did(0xF40C);
+  ASSERT_TRUE(rpm.ok);
+  EXPECT_EQ(rpm.payload, (std::vector<uint8_t>{0xF4, 0x0C, 0x20}));
+  EXPECT_EQ(ecu.reads(), 1u);
+
+  // Notifications for other DIDs or without a value
+  ecu.push({0xC6, 0x03, 0x01, 0x62, 0xF4, 0x0D, 0x01});
+  ecu.push({0xC6, 0x03, 0x01, 0x62, 0xF4, 0x0C});
+  ASSERT_TRUE(wait_until([&] { return cached.change_event_stats().notifications == 3; }));
+  auto stats = cached.change_event_stats();
+  EXPECT_EQ(stats.ignored, 1u);
+  EXPECT_EQ(stats.invalidations, 1u);
+  EXPECT_FALSE(cached.cache().contains(0xF40C));
+}
+
+TEST(CacheEventsTest, StopWatchingRestoresSettings) {
+  ChangingEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+  cached.cache().set_did_policy(0x1234, ExpirationPolicy::Sliding);
+
+  ASSERT_TRUE(cached.watch_did_changes(0xF40C));
+  ASSERT_TRUE(cached.watch_did_changes(0x1234));
+  EXPECT_EQ(cached.cache().did_policy(0x1234), ExpirationPolicy::Never);
+  ASSERT_TRUE(cached.read_did(0x1234).ok);
+
+  cached.stop_watching();
+  EXPECT_TRUE(cached.watched_dids().empty());
+  EXPECT_FALSE(cached.cache().contains(0x1234));
+  EXPECT_EQ(cached.cache().did_policy(0x1234), ExpirationPolicy::Sliding);
+  EXPECT_FALSE(cached.cache().did_policy(0xF40C).has_value());
+  EXPECT_FALSE(cached.cache().is_cacheable(0xF40C));
+
+  auto requests = ecu.requests();
+  ASSERT_GE(requests.size(), 2u);
+  EXPECT_EQ(requests[requests.size() - 2], (std::vector<uint8_t>{0x86, 0x00}));
+  EXPECT_EQ(requests.back(), (std::vector<uint8_t>{0x86, 0x06}));
+
+  // A session change ends the ECU's events as well
+  ASSERT_TRUE(cached.watch_did_changes(0x1234));
+  cached.on_session_change();
+  EXPECT_TRUE(cached.watched_dids().empty());
+  EXPECT_EQ(cached.cache().did_policy(0x1234), ExpirationPolicy::Sliding);
+}
+
+TEST(CacheEventsTest, RejectedSetupLeavesDidUnwatched) {
+  ChangingEcu ecu;
+  ecu.set_reject_setup(true);
+  Client client(ecu);
+  CachedClient cached(client);
+
+  EXPECT_FALSE(cached.watch_did_changes(0xF40C));
+  EXPECT_TRUE(cached.watched_dids().empty());
+  EXPECT_FALSE(cached.cache().is_cacheable(0xF40C));
+}
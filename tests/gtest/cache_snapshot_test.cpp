@@ -0,0 +1,195 @@
+/**
+ * @file cache_snapshot_test.cpp
+ * @brief Tests for memory-mapped DID cache snapshots (uds_cache.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_cache.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+using namespace uds;
+using namespace uds::cache;
+
+// ECU answering ReadDataByIdentifier from a DID table
+class TableTransport : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    requests_++;
+    const uint16_t did = static_cast<uint16_t>((tx[1] << 8) | tx[2]);
+    auto it = table.find(did);
+    if (tx[0] != 0x22 || it == table.end()) {
+      rx = {0x7F, tx[0], 0x31};
+      return true;
+    }
+    rx = {0x62, tx[1], tx[2]};
+    rx.insert(rx.end(), it->second.begin(), it->second.end());
+    return true;
+  }
+
+  int requests() const { return requests_.load(); }
+
+  std::map<uint16_t, std::vector<uint8_t>> table = {
+      {0xF190, {'W', 'V', 'W', '1', '2', '3'}},
+      {0xF195, {0x01, 0x02}},
+      {0xF18C, {0x53, 0x4E}},
+      {0xF191, {0x48, 0x57}},
+      {0xF40C, {0x0F, 0xA0}},
+  };
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::atomic<int> requests_{0};
+};
+
+class CacheSnapshotTest : public ::testing::Test {
+protected:
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  static EcuIdentity identity() {
+    EcuIdentity id;
+    id.tx_can_id = 0x7E0;
+    id.rx_can_id = 0x7E8;
+    id.vin = {'W', 'V', 'W'};
+    id.software_version = {0x01, 0x02};
+    return id;
+  }
+
+  std::string path_ = "cache_snapshot_test.udscache";
+};
+
+TEST_F(CacheSnapshotTest, WriteAndMapRoundTrip) {
+  std::map<uint16_t, std::vector<uint8_t>> entries = {
+      {0xF18C, {0x01, 0x02, 0x03}}, {0x0001, {}}, {0xF190, std::vector<uint8_t>(17, 'X')}};
+  ASSERT_TRUE(CacheSnapshot::write(path_, identity(), entries));
+
+  CacheSnapshot snapshot;
+  ASSERT_TRUE(snapshot.open(path_, identity()));
+  EXPECT_EQ(snapshot.size(), 3u);
+  EXPECT_EQ(*snapshot.find(0xF18C), (std::vector<uint8_t>{0x01, 0x02, 0x03}));
+  EXPECT_EQ(*snapshot.find(0xF190), std::vector<uint8_t>(17, 'X'));
+  EXPECT_TRUE(snapshot.find(0x0001)->empty());
+  EXPECT_FALSE(snapshot.find(0xF191).has_value());
+}
+
+TEST_F(CacheSnapshotTest, RejectsOtherEcuAndCorruptFiles) {
+  ASSERT_TRUE(CacheSnapshot::write(path_, identity(), {{0xF18C, {0x01}}}));
+
+  CacheSnapshot snapshot;
+  EcuIdentity other = identity();
+  other.software_version = {0x01, 0x03};
+  EXPECT_FALSE(snapshot.open(path_, other));
+  other = identity();
+  other.rx_can_id = 0x7E9;
+  EXPECT_FALSE(snapshot.open(path_, other));
+  EXPECT_FALSE(snapshot.open("does_not_exist.udscache", identity()));
+
+  // Truncated file
+  {
+    std::ifstream in(path_, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 1));
+  }
+  EXPECT_FALSE(snapshot.open(path_, identity()));
+  EXPECT_FALSE(snapshot.is_open());
+}
+
+TEST_F(CacheSnapshotTest, EntriesAreRestoredLazilyOnce) {
+  {
+    DIDCache cache;
+    cache.set_did_persistent(0xF18C);
+    cache.set_did_persistent(0xF191);
+    cache.put(0xF18C, {0x01});
+    cache.put(0xF191, {0x02});
+    cache.put(0x1234, {0x03});  // not persistent
+    ASSERT_TRUE(cache.save_snapshot(path_, identity()));
+  }
+
+  DIDCache cache;
+  ASSERT_TRUE(cache.attach_snapshot(path_, identity()));
+  EXPECT_EQ(cache.size(), 0u);
+
+  EXPECT_EQ(*cache.get(0xF18C), (std::vector<uint8_t>{0x01}));
+  EXPECT_FALSE(cache.get(0x1234).has_value());
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.stats().snapshot_loads, 1u);
+
+  // Once invalidated, the ECU is authoritative again
+  cache.invalidate(0xF18C);
+  EXPECT_FALSE(cache.get(0xF18C).has_value());
+  cache.invalidate(0xF191);
+  EXPECT_FALSE(cache.get(0xF191).has_value());
+  EXPECT_EQ(cache.stats().snapshot_loads, 1u);
+
+  cache.detach_snapshot();
+  EXPECT_FALSE(cache.attach_snapshot(path_, EcuIdentity{}));
+}
+
+TEST_F(CacheSnapshotTest, RestoresStayWithinLimits) {
+  {
+    DIDCache cache;
+    for (uint16_t did : {0xF18C, 0xF190, 0xF191}) {
+      cache.set_did_persistent(did);
+      cache.put(did, {static_cast<uint8_t>(did)});
+    }
+    ASSERT_TRUE(cache.save_snapshot(path_, identity()));
+  }
+
+  CacheConfig config;
+  config.max_entries = 2;
+  DIDCache cache(config);
+  ASSERT_TRUE(cache.attach_snapshot(path_, identity()));
+  cache.put(0x1234, {0x01});
+
+  // Plain hits leave the cache alone; each restore evicts the oldest entry
+  ASSERT_TRUE(cache.get(0x1234).has_value());
+  EXPECT_EQ(cache.stats().evictions, 0u);
+  ASSERT_TRUE(cache.get(0xF18C).has_value());
+  EXPECT_EQ(cache.stats().evictions, 0u);
+  ASSERT_TRUE(cache.lookup(0xF190).data.has_value());
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_FALSE(cache.contains(0x1234));
+  EXPECT_TRUE(cache.uncached({0xF191}).empty());
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.stats().evictions, 2u);
+  EXPECT_EQ(cache.stats().peak_entries, 2u);
+}
+
+TEST_F(CacheSnapshotTest, WarmStartSkipsStaticReads) {
+  TableTransport ecu;
+  {
+    Client client(ecu);
+    CachedClient cached(client);
+    ASSERT_TRUE(cached.read_did(0xF18C).ok);
+    ASSERT_TRUE(cached.read_did(0xF191).ok);
+    ASSERT_TRUE(cached.read_did(0xF40C).ok);  // volatile: never persisted
+    ASSERT_TRUE(cached.save_snapshot(path_));
+  }
+
+  Client client(ecu);
+  CachedClient cached(client);
+  const int before = ecu.requests();
+  ASSERT_TRUE(cached.warm_start(path_));
+  EXPECT_EQ(ecu.requests(), before + 2);  // VIN + software version
+
+  auto serial = cached.read_did(0xF18C);
+  ASSERT_TRUE(serial.ok);
+  EXPECT_EQ(serial.payload, (std::vector<uint8_t>{0xF1, 0x8C, 0x53, 0x4E}));
+  EXPECT_TRUE(cached.read_did(0xF191).ok);
+  EXPECT_EQ(ecu.requests(), before + 2);
+  EXPECT_TRUE(cached.read_did(0xF40C).ok);
+  EXPECT_EQ(ecu.requests(), before + 3);
+
+  // New software: the snapshot no longer applies
+  ecu.table[0xF195] = {0x02, 0x00};
+  CachedClient reflashed(client);
+  EXPECT_FALSE(reflashed.warm_start(path_));
+}
@@ -0,0 +1,247 @@
+/**
+ * @file cancellation_test.cpp
+ * @brief Tests for cooperative cancellation of exchanges (uds.cpp, isotp.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "isotp.hpp"
+#include "uds_async.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::async;
+using std::chrono::milliseconds;
+using clock_type = std::chrono::steady_clock;
+
+// CAN driver attached to an ECU that never answers
+class SilentCan : public isotp::ICanDriver {
+public:
+  bool send(const CANProtocol::CANFrame&) override { sent_++; return true; }
+  bool recv(CANProtocol::CANFrame&, milliseconds timeout) override {
+    std::this_thread::sleep_for(timeout);
+    return false;
+  }
+  int sent() const { return sent_.load(); }
+private:
+  std::atomic<int> sent_{0};
+};
+
+// Silent driver blocking on a condition variable woken by a CancelWake hook
+class WakeableCan : public SilentCan {
+public:
+  bool recv_cancellable(CANProtocol::CANFrame&, milliseconds timeout,
+                        CancellationToken& cancel) override {
+    CancelWake wake(&cancel, [this] {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cv_.wait_for(lock, timeout, [&cancel] { return cancel.is_cancelled(); })) woken_++;
+    return false;
+  }
+  int woken() const { return woken_.load(); }
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<int> woken_{0};
+};
+
+static Timings slow_timings() {
+  Timings t;
+  t.p2 = milliseconds(5000);
+  t.p2_star = milliseconds(5000);
+  return t;
+}
+
+using test::wait_until;
+
+TEST(CancellationTest, TokenWakesWaitersAndHooks) {
+  CancellationToken token;
+  EXPECT_FALSE(token.wait_for(milliseconds(1)));
+
+  std::atomic<int> hooks{0};
+  const uint64_t id = token.add_wake_hook([&] { hooks++; });
+  std::thread canceller([&] {
+    std::this_thread::sleep_for(milliseconds(20));
+    token.cancel();
+  });
+  const auto start = clock_type::now();
+  EXPECT_TRUE(token.wait_for(milliseconds(5000)));
+  EXPECT_LT(clock_type::now() - start, std::chrono::seconds(1));
+  canceller.join();
+  EXPECT_EQ(hooks.load(), 1);
+  token.remove_wake_hook(id);
+
+  // Hooks registered on a cancelled token fire at once
+  { CancelWake late(&token, [&] { hooks++; }); }
+  EXPECT_EQ(hooks.load(), 2);
+
+  token.reset();
+  EXPECT_FALSE(token.is_cancelled());
+}
+
+TEST(CancellationTest, ScopesNestAndRestore) {
+  CancellationToken outer, inner;
+  EXPECT_EQ(CancelScope::current(), nullptr);
+  {
+    CancelScope a(&outer);
+    {
+      CancelScope b(&inner);
+      EXPECT_EQ(CancelScope::current(), &inner);
+      CancelScope c(nullptr);
+      EXPECT_EQ(CancelScope::current(), &inner);
+    }
+    EXPECT_EQ(CancelScope::current(), &outer);
+    outer.cancel();
+    EXPECT_TRUE(CancelScope::cancelled());
+  }
+  EXPECT_EQ(CancelScope::current(), nullptr);
+  EXPECT_FALSE(CancelScope::cancelled());
+}
+
+TEST(CancellationTest, CancelStopsIsoTpWait) {
+  SilentCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp, slow_timings());
+
+  CancellationToken token;
+  std::thread canceller([&] {
+    std::this_thread::sleep_for(milliseconds(30));
+    token.cancel();
+  });
+  const auto start = clock_type::now();
+  {
+    CancelScope scope(&token);
+    EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok);
+  }
+  EXPECT_LT(clock_type::now() - start, std::chrono::seconds(1));
+  canceller.join();
+  EXPECT_EQ(can.sent(), 1);
+
+  // Cancelled before sending: nothing reaches the bus
+  { CancelScope scope(&token); EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok); }
+  EXPECT_EQ(can.sent(), 1);
+  EXPECT_TRUE(client.transport_idle());
+}
+
+TEST(CancellationTest, DriverOverrideIsWokenByCancel) {
+  WakeableCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp, slow_timings());
+
+  CancellationToken token;
+  std::thread canceller([&] {
+    std::this_thread::sleep_for(milliseconds(30));
+    token.cancel();
+  });
+  const auto start = clock_type::now();
+  {
+    CancelScope scope(&token);
+    EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok);
+  }
+  EXPECT_LT(clock_type::now() - start, std::chrono::seconds(1));
+  canceller.join();
+  EXPECT_EQ(can.woken(), 1);
+}
+
+TEST(CancellationTest, CancelDropsQueuedExchange) {
+  SilentCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Timings t;
+  t.p2 = milliseconds(300);
+  Client client(tp, t);
+
+  std::thread holder([&] { client.read_data_by_identifier(0x0001); });
+  ASSERT_TRUE(wait_until([&] { return can.sent() == 1; }));
+
+  CancellationToken token;
+  std::thread canceller([&] {
+    std::this_thread::sleep_for(milliseconds(20));
+    token.cancel();
+  });
+  const auto start = clock_type::now();
+  {
+    CancelScope scope(&token);
+    EXPECT_FALSE(client.write_data_by_identifier(0x0002, {0x00}).ok);
+  }
+  EXPECT_LT(clock_type::now() - start, milliseconds(250));
+  canceller.join();
+  holder.join();
+  EXPECT_EQ(can.sent(), 1);
+}
+
+TEST(CancellationTest, AsyncCancelInterruptsRunningTask) {
+  SilentCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp, slow_timings());
+  AsyncClient async(client);
+  async.set_default_timeout(milliseconds(0));
+
+  std::promise<AsyncResult<std::vector<uint8_t>>> done;
+  auto future = done.get_future();
+  TaskHandle handle = async.read_did_async(0xF190, [&done](const auto& r) { done.set_value(r); });
+  ASSERT_TRUE(wait_until([&] { return can.sent() == 1; }));
+  EXPECT_EQ(async.get_status(handle), AsyncStatus::Running);
+
+  const auto start = clock_type::now();
+  EXPECT_TRUE(async.cancel(handle));
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  EXPECT_LT(clock_type::now() - start, std::chrono::seconds(1));
+  EXPECT_EQ(future.get().status, AsyncStatus::Cancelled);
+  ASSERT_TRUE(async.wait(handle, milliseconds(1000)));
+  EXPECT_EQ(async.get_status(handle), AsyncStatus::Cancelled);
+
+  // The worker's token is reset for the next task
+  std::promise<AsyncStatus> next;
+  async.read_did_async(0xF190, [&next](const auto& r) { next.set_value(r.status); },
+                       TaskOptions::within(milliseconds(50)));
+  EXPECT_EQ(next.get_future().get(), AsyncStatus::TimedOut);
+  EXPECT_EQ(can.sent(), 2);
+}
+
+TEST(CancellationTest, AsyncCancelWhileTaskStarts) {
+  WakeableCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp, slow_timings());
+  AsyncClient async(client);
+
+  // Cancel the moment the worker marks the task Running: it must already be
+  // reachable as a running task, never lost between the two states
+  for (int i = 0; i < 2000; ++i) {
+    std::promise<AsyncStatus> done;
+    auto future = done.get_future();
+    TaskHandle handle = async.read_did_async(0xF190, [&done](const auto& r) { done.set_value(r.status); });
+    while (async.get_status(handle) == AsyncStatus::Pending) {}
+    ASSERT_TRUE(async.cancel(handle)) << "iteration " << i;
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    EXPECT_EQ(future.get(), AsyncStatus::Cancelled);
+  }
+}
+
+TEST(CancellationTest, RunWithTimeoutBoundsExchangeWithoutThreads) {
+  SilentCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp, slow_timings());
+
+  bool ok = true;
+  const auto start = clock_type::now();
+  EXPECT_FALSE(run_with_timeout([&] { ok = client.read_data_by_identifier(0xF190).ok; },
+                                milliseconds(50)));
+  EXPECT_LT(clock_type::now() - start, std::chrono::seconds(1));
+  EXPECT_FALSE(ok);
+  // Nothing keeps using the client after the call returned
+  EXPECT_TRUE(client.transport_idle());
+  EXPECT_EQ(ExchangeScope::current(), clock_type::time_point::max());
+}
@@ -25,6 +25,15 @@ public:
     return false;
   }
   
+  bool send_suppressed(const std::vector<uint8_t>& tx, std::vector<uint8_t>& rx,
+                       std::chrono::milliseconds timeout) override {
+    // Listens for a negative response only, like isotp::Transport
+    last_request_ = tx;
+    if (fail_send_) return false;
+    if (!request_response(tx, rx, timeout)) rx.clear();
+    return true;
+  }
+  
   bool recv_unsolicited(std::vector<uint8_t>& rx, std::chrono::milliseconds) override {
     if (!unsolicited_.empty()) { rx = unsolicited_.front(); unsolicited_.pop(); return true; }
     return false;
@@ -33,14 +42,21 @@ public:
   void queue_response(const std::vector<uint8_t>& r) { responses_.push(r); }
   void queue_unsolicited(const std::vector<uint8_t>& m) { unsolicited_.push(m); }
   void set_fail_next(bool f) { fail_next_ = f; }
+  void set_fail_send(bool f) { fail_send_ = f; }
   const std::vector<uint8_t>& last_request() const { return last_request_; }
-  void reset() { while (!responses_.empty()) responses_.pop(); last_request_.clear(); fail_next_ = false; }
+  void reset() {
+    while (!responses_.empty()) responses_.pop();
+    last_request_.clear();
+    fail_next_ = false;
+    fail_send_ = false;
+  }
 
 private:
   Address addr_;
   std::queue<std::vector<uint8_t>> responses_, unsolicited_;
   std::vector<uint8_t> last_request_;
   bool fail_next_ = false;
+  bool fail_send_ = false;
 };
 
 class ClientTest : public ::testing::Test {
@@ -114,6 +130,60 @@ TEST_F(ClientTest, TesterPresent) {
   EXPECT_TRUE(result.ok);
 }
 
+TEST_F(ClientTest, SuppressedPositiveResponse) {
+  Client client(transport_);
+  auto result = client.tester_present(true);
+  EXPECT_TRUE(result.ok);  // Silence is the expected answer
+  EXPECT_EQ(transport_.last_request(), (std::vector<uint8_t>{0x3E, 0x80}));
+
+  // Negative responses are still reported
+  transport_.queue_response({0x7F, 0x85, 0x22});
+  result = client.exchange(SID::ControlDTCSetting, {0x82});
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(result.nrc.code, NegativeResponseCode::ConditionsNotCorrect);
+
+  // A request that never left is not mistaken for silence
+  transport_.set_fail_send(true);
+  result = client.tester_present(true);
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(result.nrc.code, NegativeResponseCode{});
+
+  // Without a subfunction there is no bit to suppress with
+  transport_.set_fail_send(false);
+  EXPECT_FALSE(client.exchange(SID::ReadDataByIdentifier, {0xF1, 0x90}).ok);
+}
+
+// A transport without its own send_suppressed() cannot tell silence from a
+// failed send, so a dead bus must not pass for a suppressed positive response
+TEST_F(ClientTest, SuppressedRequestOnDefaultTransport) {
+  class PlainTransport : public Transport {
+  public:
+    void set_address(const Address& a) override { addr_ = a; }
+    const Address& address() const override { return addr_; }
+    bool request_response(const std::vector<uint8_t>& tx, std::vector<uint8_t>& rx,
+                          std::chrono::milliseconds) override {
+      ++sent;
+      if (dead) return false;
+      rx = {0x7F, tx[0], 0x22};
+      return true;
+    }
+    Address addr_;
+    bool dead = true;
+    int sent = 0;
+  } plain;
+
+  Client client(plain);
+  auto result = client.tester_present(true);
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(plain.sent, 1);
+  EXPECT_EQ(result.nrc.code, NegativeResponseCode{});
+
+  plain.dead = false;
+  result = client.exchange(SID::CommunicationControl, {0x83, 0xFF});
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(result.nrc.code, NegativeResponseCode::ConditionsNotCorrect);
+}
+
 // SecurityAccess Tests
 TEST_F(ClientTest, SecurityAccessRequestSeed) {
   Client client(transport_);
@@ -203,8 +273,15 @@ TEST_F(ClientTest, RequestUpload) {
 TEST_F(ClientTest, TransferData) {
   Client client(transport_);
   transport_.queue_response({0x76, 0x01});
-  auto result = client.transfer_data(0x01, {0xDE, 0xAD});
+  auto result = client.transfer_data(0x01, {0xDE, 0xAD, 0xBE, 0xEF});
   EXPECT_TRUE(result.ok);
+  EXPECT_EQ(transport_.last_request(), (std::vector<uint8_t>{0x36, 0x01, 0xDE, 0xAD, 0xBE, 0xEF}));
+
+  // The reused request buffer carries nothing over from the longer block
+  const uint8_t tail[] = {0x42};
+  transport_.queue_response({0x76, 0x02});
+  EXPECT_TRUE(client.transfer_data(0x02, tail, sizeof(tail)).ok);
+  EXPECT_EQ(transport_.last_request(), (std::vector<uint8_t>{0x36, 0x02, 0x42}));
 }
 
 TEST_F(ClientTest, RequestTransferExit) {
@@ -0,0 +1,216 @@
+/**
+ * @file coalescing_test.cpp
+ * @brief Tests for single-flight coalescing of read-only requests (uds.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+
+// Transport that holds every request until released by the test
+class GatedTransport : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const int generation = generation_;
+      requests_.fetch_add(1);
+      cv_.wait(lock, [&] { return open_ || generation_ != generation; });
+      if (!open_) return false;
+    }
+    rx.clear();
+    rx.push_back(static_cast<uint8_t>(tx[0] + 0x40));
+    rx.insert(rx.end(), tx.begin() + 1, tx.end());
+    rx.push_back(0xAA);
+    return true;
+  }
+
+  void open() {
+    { std::lock_guard<std::mutex> lock(mutex_); open_ = true; }
+    cv_.notify_all();
+  }
+  // Requests waiting now get no response, as if their receive was aborted
+  void fail_pending() {
+    { std::lock_guard<std::mutex> lock(mutex_); ++generation_; }
+    cv_.notify_all();
+  }
+  int requests() const { return requests_.load(); }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = false;
+  int generation_ = 0;
+  std::atomic<int> requests_{0};
+};
+
+using test::wait_until;
+
+TEST(CoalescingTest, IdenticalReadsShareOneExchange) {
+  GatedTransport transport;
+  Client client(transport);
+  EXPECT_TRUE(client.request_coalescing());
+
+  constexpr int kThreads = 6;
+  std::atomic<int> ok_count{0};
+  std::vector<std::thread> threads;
+
+  threads.emplace_back([&]() {
+    auto r = client.read_data_by_identifier(0xF190);
+    if (r.ok && r.payload.size() == 3 && r.payload[2] == 0xAA) ok_count++;
+  });
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 1; }));
+
+  for (int i = 1; i < kThreads; ++i) {
+    threads.emplace_back([&]() {
+      auto r = client.read_data_by_identifier(0xF190);
+      if (r.ok && r.payload.size() == 3 && r.payload[2] == 0xAA) ok_count++;
+    });
+  }
+  ASSERT_TRUE(wait_until([&] { return client.coalesced_exchanges() == kThreads - 1; }));
+
+  transport.open();
+  for (auto& t : threads) t.join();
+
+  EXPECT_EQ(transport.requests(), 1);
+  EXPECT_EQ(ok_count.load(), kThreads);
+  EXPECT_EQ(client.coalesced_exchanges(), static_cast<uint64_t>(kThreads - 1));
+}
+
+TEST(CoalescingTest, DifferentPayloadsAreNotCoalesced) {
+  GatedTransport transport;
+  transport.open();
+  Client client(transport);
+
+  std::thread a([&]() { EXPECT_TRUE(client.read_data_by_identifier(0xF190).ok); });
+  std::thread b([&]() { EXPECT_TRUE(client.read_data_by_identifier(0xF18C).ok); });
+  a.join();
+  b.join();
+
+  EXPECT_EQ(transport.requests(), 2);
+  EXPECT_EQ(client.coalesced_exchanges(), 0u);
+}
+
+TEST(CoalescingTest, WritesAreNeverCoalesced) {
+  GatedTransport transport;
+  Client client(transport);
+
+  std::thread first([&]() { client.write_data_by_identifier(0xF190, {0x01}); });
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 1; }));
+  std::thread second([&]() { client.write_data_by_identifier(0xF190, {0x01}); });
+  // Queued behind the first exchange rather than joined to it
+  ASSERT_TRUE(wait_until([&] { return detail::queued_exchanges(transport) == 1; }));
+
+  transport.open();
+  first.join();
+  second.join();
+  EXPECT_EQ(transport.requests(), 2);
+  EXPECT_EQ(client.coalesced_exchanges(), 0u);
+}
+
+TEST(CoalescingTest, DisabledIssuesSeparateExchanges) {
+  GatedTransport transport;
+  Client client(transport);
+  client.set_request_coalescing(false);
+  EXPECT_FALSE(client.request_coalescing());
+
+  std::thread first([&]() { client.read_data_by_identifier(0xF190); });
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 1; }));
+  std::thread second([&]() { client.read_data_by_identifier(0xF190); });
+  // Queued behind the first exchange rather than joined to it
+  ASSERT_TRUE(wait_until([&] { return detail::queued_exchanges(transport) == 1; }));
+
+  transport.open();
+  first.join();
+  second.join();
+  EXPECT_EQ(transport.requests(), 2);
+  EXPECT_EQ(client.coalesced_exchanges(), 0u);
+}
+
+TEST(CoalescingTest, SequentialReadsAlwaysHitTheBus) {
+  GatedTransport transport;
+  transport.open();
+  Client client(transport);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(client.read_data_by_identifier(0xF190).ok);
+  }
+  EXPECT_EQ(transport.requests(), 3);
+  EXPECT_EQ(client.coalesced_exchanges(), 0u);
+}
+
+TEST(CoalescingTest, JoinerKeepsItsOwnDeadlineAndCancellation) {
+  GatedTransport transport;
+  Client client(transport);
+
+  std::thread leader([&]() { EXPECT_TRUE(client.read_data_by_identifier(0xF190).ok); });
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 1; }));
+
+  // A joiner whose deadline passes gives up without waiting for the leader
+  std::thread late([&]() {
+    ExchangeScope scope(std::chrono::steady_clock::now() + std::chrono::milliseconds(50));
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok);
+    EXPECT_TRUE(ExchangeScope::expired());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  });
+  late.join();
+  EXPECT_EQ(client.coalesced_exchanges(), 1u);
+
+  // A cancelled joiner returns at once
+  CancellationToken token;
+  std::thread cancelled([&]() {
+    CancelScope scope(&token);
+    EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok);
+  });
+  ASSERT_TRUE(wait_until([&] { return client.coalesced_exchanges() == 2; }));
+  token.cancel();
+  cancelled.join();
+
+  transport.open();
+  leader.join();
+  EXPECT_EQ(transport.requests(), 1);
+}
+
+TEST(CoalescingTest, CancelledLeaderDoesNotFailItsJoiners) {
+  GatedTransport transport;
+  Client client(transport);
+
+  CancellationToken token;
+  std::thread leader([&]() {
+    CancelScope scope(&token);
+    EXPECT_FALSE(client.read_data_by_identifier(0xF190).ok);
+  });
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 1; }));
+
+  std::vector<uint8_t> payload;
+  std::thread joiner([&]() {
+    auto r = client.read_data_by_identifier(0xF190);
+    EXPECT_TRUE(r.ok);
+    payload = r.payload;
+  });
+  ASSERT_TRUE(wait_until([&] { return client.coalesced_exchanges() == 1; }));
+
+  // The driver aborts the leader's receive on cancel; the joiner retries
+  token.cancel();
+  transport.fail_pending();
+  leader.join();
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 2; }));
+
+  transport.open();
+  joiner.join();
+  EXPECT_EQ(payload, (std::vector<uint8_t>{0xF1, 0x90, 0xAA}));
+}
@@ -0,0 +1,165 @@
+/**
+ * @file compression_test.cpp
+ * @brief Tests for the LZF codec, parallel image compression and compressed downloads (uds_compression.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_compression.hpp"
+#include "uds_block.hpp"
+#include "ecu_programming.hpp"
+#include "test_util.hpp"
+#include <random>
+
+using namespace uds;
+using namespace uds::compression;
+
+// Code-like sections with repeated instruction patterns, a random data
+// table and erased (0xFF) padding
+static std::vector<uint8_t> firmware_like(size_t size) {
+  std::mt19937 rng(42);
+  std::vector<uint8_t> image;
+  image.reserve(size);
+  const uint8_t ops[][4] = {{0x2D, 0xE9, 0xF0, 0x41}, {0x00, 0xBF, 0x70, 0x47},
+                            {0x4F, 0xF0, 0x00, 0x03}, {0xBD, 0xE8, 0xF0, 0x81}};
+  while (image.size() < size) {
+    switch (rng() % 4) {
+      case 0: image.insert(image.end(), 64 + rng() % 64, 0xFF); break;
+      case 1:
+        for (int i = 0; i < 32; ++i) image.push_back(static_cast<uint8_t>(rng()));
+        break;
+      default:
+        for (int i = 0; i < 64; ++i) {
+          const auto& op = ops[rng() % 4];
+          image.insert(image.end(), op, op + 4);
+          image.push_back(static_cast<uint8_t>(rng() % 8));
+        }
+    }
+  }
+  image.resize(size);
+  return image;
+}
+
+static std::vector<uint8_t> compress_all(const std::vector<uint8_t>& image, size_t chunk, unsigned threads) {
+  MemoryFirmwareSource source(image);
+  CompressedImage out;
+  EXPECT_TRUE(compress_image(source, LzfCompressor(), {chunk, threads}, out));
+  EXPECT_EQ(out.original_size, image.size());
+  return out.data;
+}
+
+TEST(CompressionTest, LzfRoundTripsEdgeCases) {
+  LzfCompressor lzf;
+  std::mt19937 rng(7);
+  std::vector<uint8_t> random(5000);
+  for (auto& b : random) b = static_cast<uint8_t>(rng());
+
+  const std::vector<std::vector<uint8_t>> inputs = {
+      {}, {0x42}, {0x42, 0x43}, std::vector<uint8_t>(10000, 0x00), random,
+      std::vector<uint8_t>{'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'x'}};
+  for (const auto& input : inputs) {
+    std::vector<uint8_t> packed, unpacked;
+    lzf.compress(input.data(), input.size(), 0, packed);
+    ASSERT_TRUE(lzf.decompress(packed.data(), packed.size(), input.size(), unpacked));
+    EXPECT_EQ(unpacked, input);
+  }
+
+  // Incompressible data grows by one byte per 32-byte literal run only
+  std::vector<uint8_t> packed;
+  lzf.compress(random.data(), random.size(), 0, packed);
+  EXPECT_LE(packed.size(), random.size() + (random.size() + 31) / 32);
+
+  // Long runs use overlapping matches of up to 264 bytes
+  packed.clear();
+  lzf.compress(inputs[3].data(), inputs[3].size(), 0, packed);
+  EXPECT_LT(packed.size(), 150u);
+}
+
+TEST(CompressionTest, LzfDecodesLiblzfStreams) {
+  // "abc" as literals, then a 9-byte match at distance 3
+  const std::vector<uint8_t> stream = {0x02, 'a', 'b', 'c', 0xE0, 0x00, 0x02};
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(LzfCompressor().decompress(stream.data(), stream.size(), 12, out));
+  EXPECT_EQ(std::string(out.begin(), out.end()), "abcabcabcabc");
+
+  // Reference before the start, truncation and size mismatch are errors
+  const std::vector<uint8_t> bad_ref = {0x00, 'a', 0x20, 0x05};
+  EXPECT_FALSE(LzfCompressor().decompress(bad_ref.data(), bad_ref.size(), 4, out));
+  EXPECT_FALSE(LzfCompressor().decompress(stream.data(), stream.size() - 1, 12, out));
+  EXPECT_FALSE(LzfCompressor().decompress(stream.data(), stream.size(), 11, out));
+}
+
+TEST(CompressionTest, ParallelChunksMatchSerialStream) {
+  const auto image = firmware_like(300000);
+  const auto serial = compress_all(image, 16 * 1024, 1);
+  const auto parallel = compress_all(image, 16 * 1024, 4);
+  EXPECT_EQ(parallel, serial);
+
+  std::vector<uint8_t> unpacked;
+  ASSERT_TRUE(LzfCompressor().decompress(parallel.data(), parallel.size(), image.size(), unpacked));
+  EXPECT_EQ(unpacked, image);
+  EXPECT_LT(parallel.size(), image.size() * 7 / 10);
+
+  // Sequential sources are read once, in order
+  size_t produced = 0;
+  GeneratorFirmwareSource generator(image.size(), [&](uint8_t* out, size_t length) {
+    std::copy(image.begin() + produced, image.begin() + produced + length, out);
+    produced += length;
+    return length;
+  });
+  CompressedImage from_generator;
+  size_t observed = 0;
+  ASSERT_TRUE(compress_image(generator, LzfCompressor(), {16 * 1024, 3}, from_generator,
+                             [&](ByteSpan block) { observed += block.size; }));
+  EXPECT_EQ(from_generator.data, serial);
+  EXPECT_EQ(observed, image.size());
+}
+
+TEST(CompressionTest, BlockUploadSendsCompressedStream) {
+  test::FlashEcu ecu({}, 0x1000);
+  Client client(ecu);
+  block::BlockTransferManager manager(client);
+  manager.set_data_format(0x02);  // encryptingMethod is kept
+  manager.set_compressor(std::make_shared<LzfCompressor>(), {8 * 1024, 2});
+  const auto image = firmware_like(40000);
+
+  auto result = manager.upload(0x1000, image);
+  ASSERT_TRUE(result.ok) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  EXPECT_EQ(result.uncompressed_bytes, image.size());
+  EXPECT_LT(result.bytes_transferred, image.size() * 7 / 10);
+  EXPECT_EQ(*result.crc32, block::calculate_crc32(image));
+  const auto requests = ecu.requests_with(0x35);
+  ASSERT_FALSE(requests.empty());
+  EXPECT_EQ(requests.front()[1], 0x12);
+}
+
+TEST(CompressionTest, ProgrammerDownloadsCompressedImage) {
+  test::FlashEcu ecu;
+  Client client(ecu);
+  const auto image = firmware_like(50000);
+  MemoryFirmwareSource firmware(image);
+
+  ProgrammingConfig config;
+  config.skip_security = true;
+  config.skip_erase = true;
+  config.perform_reset_after_flash = false;
+  config.inter_block_delay_ms = 0;
+  config.compressor = std::make_shared<LzfCompressor>();
+
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, config);
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  EXPECT_EQ(result.uncompressed_bytes, image.size());
+  EXPECT_EQ(result.total_bytes, ecu.bytes_received_);
+  EXPECT_LT(result.total_bytes, image.size() * 7 / 10);
+
+  // compressionMethod 1, uncompressed memorySize
+  const auto downloads = ecu.requests_with(0x34);
+  ASSERT_EQ(downloads.size(), 1u);
+  const auto& request = downloads.front();
+  EXPECT_EQ(request[1], 0x10);
+  const uint32_t memory_size = static_cast<uint32_t>(request[7]) << 24 | request[8] << 16 |
+                               request[9] << 8 | request[10];
+  EXPECT_EQ(memory_size, image.size());
+}
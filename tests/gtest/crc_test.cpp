@@ -0,0 +1,104 @@
+/**
+ * @file crc_test.cpp
+ * @brief Tests for the shared CRC engines (uds_crc.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_crc.hpp"
+#include "uds_block.hpp"
+#include "uds_memory.hpp"
+#include <random>
+#include <string>
+
+using namespace uds;
+using namespace uds::crc;
+
+namespace {
+
+const Engine kEngines[] = {Engine::Table, Engine::Slicing8, Engine::Slicing16, Engine::Clmul};
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& b : data) b = static_cast<uint8_t>(rng());
+    return data;
+}
+
+} // namespace
+
+TEST(CrcTest, CheckValues) {
+    const std::string check = "123456789";
+    const auto* data = reinterpret_cast<const uint8_t*>(check.data());
+    for (Engine engine : kEngines) {
+        SCOPED_TRACE(engine_name(engine));
+        EXPECT_EQ(crc32_update(kCrc32Init, data, check.size(), engine) ^ kCrc32XorOut, 0xCBF43926u);
+        EXPECT_EQ(crc32c_update(kCrc32Init, data, check.size(), engine) ^ kCrc32XorOut, 0xE3069283u);
+        EXPECT_EQ(crc16_ccitt_update(kCrc16CcittInit, data, check.size(), engine), 0x29B1);
+    }
+    EXPECT_EQ(crc32(data, 0), 0u);
+    EXPECT_EQ(crc16_ccitt(data, 0), 0xFFFF);
+}
+
+TEST(CrcTest, EnginesAgreeAtEveryLengthAndAlignment) {
+    // Lengths around the 16/64-byte strides and folding minimum, at odd offsets
+    const auto data = random_bytes(4096 + 64, 11);
+    for (size_t offset : {0, 1, 3, 7}) {
+        for (size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 127, 128, 129, 255, 1000, 4096}) {
+            const uint8_t* p = data.data() + offset;
+            const uint32_t ref32 = crc32_update(kCrc32Init, p, size, Engine::Table);
+            const uint32_t ref32c = crc32c_update(kCrc32Init, p, size, Engine::Table);
+            const uint16_t ref16 = crc16_ccitt_update(kCrc16CcittInit, p, size, Engine::Table);
+            for (Engine engine : kEngines) {
+                SCOPED_TRACE(std::string(engine_name(engine)) + " offset " + std::to_string(offset) +
+                             " size " + std::to_string(size));
+                EXPECT_EQ(crc32_update(kCrc32Init, p, size, engine), ref32);
+                EXPECT_EQ(crc32c_update(kCrc32Init, p, size, engine), ref32c);
+                EXPECT_EQ(crc16_ccitt_update(kCrc16CcittInit, p, size, engine), ref16);
+            }
+        }
+    }
+}
+
+TEST(CrcTest, StreamingMatchesOneShot) {
+    const auto data = random_bytes(100000, 5);
+    Crc32 c32;
+    Crc32C c32c;
+    Crc16Ccitt c16;
+    std::mt19937 rng(9);
+    for (size_t pos = 0; pos < data.size();) {
+        const size_t chunk = std::min<size_t>(rng() % 700, data.size() - pos);
+        c32.update(data.data() + pos, chunk);
+        c32c.update(data.data() + pos, chunk);
+        c16.update(data.data() + pos, chunk);
+        pos += chunk;
+    }
+    EXPECT_EQ(c32.value(), crc32(data));
+    EXPECT_EQ(c32c.value(), crc32c(data));
+    EXPECT_EQ(c16.value(), crc16_ccitt(data));
+
+    c32.reset();
+    c32.update(data);
+    EXPECT_EQ(c32.value(), crc32(data));
+}
+
+TEST(CrcTest, BlockAndMemoryShareTheEngine) {
+    const auto data = random_bytes(10000, 3);
+    const uint32_t expected = crc32(data);
+    EXPECT_EQ(block::calculate_crc32(data), expected);
+    EXPECT_EQ(memory::crc32(data), expected);
+
+    // Raw-register overloads continue where a previous chunk stopped
+    const std::vector<uint8_t> head(data.begin(), data.begin() + 4321);
+    const std::vector<uint8_t> tail(data.begin() + 4321, data.end());
+    EXPECT_EQ(block::calculate_crc32(tail, block::calculate_crc32(head, kCrc32Init)) ^ kCrc32XorOut,
+              expected);
+    EXPECT_EQ(memory::crc32(tail, memory::crc32(head, kCrc32Init)) ^ kCrc32XorOut, expected);
+}
+
+TEST(CrcTest, BestEngineIsSupported) {
+    EXPECT_TRUE(engine_supported(best_engine()));
+    EXPECT_TRUE(engine_supported(Engine::Slicing16));
+#if defined(__x86_64__)
+    EXPECT_EQ(best_engine() == Engine::Clmul, engine_supported(Engine::Clmul));
+#endif
+}
@@ -0,0 +1,209 @@
+/**
+ * @file delta_flash_test.cpp
+ * @brief Tests for delta flashing and FlashManifest (ecu_programming.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "ecu_programming.hpp"
+#include "uds_block.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace uds;
+
+namespace {
+
+constexpr uint32_t kBase = 0x1000;
+constexpr RoutineId kCrcRoutine = 0xF00F;
+
+std::vector<uint8_t> old_image() {
+  std::vector<uint8_t> image(10 * 1024);
+  for (size_t i = 0; i < image.size(); ++i) image[i] = static_cast<uint8_t>(i * 13 + (i >> 7));
+  return image;
+}
+
+// Calibration update touching sectors 2, 3 and 7 of 1 KB
+std::vector<uint8_t> new_image() {
+  auto image = old_image();
+  image[2 * 1024 + 10] ^= 0x01;
+  image[3 * 1024 + 1000] ^= 0x80;
+  image[7 * 1024] = 0x00;
+  return image;
+}
+
+ProgrammingConfig delta_config() {
+  ProgrammingConfig config;
+  config.start_address = kBase;
+  config.skip_security = true;
+  config.perform_reset_after_flash = false;
+  config.inter_block_delay_ms = 0;
+  config.delta_sector_size = 1024;
+  return config;
+}
+
+FlashManifest manifest_of(const std::vector<uint8_t>& image, uint32_t sector_size = 1024) {
+  MemoryFirmwareSource source(image);
+  FlashManifest manifest;
+  EXPECT_TRUE(FlashManifest::build(source, kBase, sector_size, manifest));
+  return manifest;
+}
+
+} // namespace
+
+TEST(DeltaFlashTest, ManifestRoundTripsThroughFile) {
+  std::vector<uint8_t> image(10000, 0x5A);
+  const auto manifest = manifest_of(image, 4096);
+  ASSERT_EQ(manifest.sector_count(), 3u);
+  EXPECT_EQ(manifest.sector_length(2), 10000u - 8192u);
+  EXPECT_EQ(manifest.sector_crcs[2],
+            block::calculate_crc32(std::vector<uint8_t>(image.begin() + 8192, image.end())));
+
+  const std::string path = "delta_flash_test.manifest";
+  ASSERT_TRUE(manifest.save(path));
+  FlashManifest loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.start_address, kBase);
+  EXPECT_EQ(loaded.sector_size, 4096u);
+  EXPECT_EQ(loaded.image_size, 10000u);
+  EXPECT_EQ(loaded.sector_crcs, manifest.sector_crcs);
+
+  {
+    std::ofstream out(path, std::ios::trunc);
+    out << "uds-flash-manifest 1 1000 4096 10000\n0\n";
+  }
+  EXPECT_FALSE(loaded.load(path));
+  EXPECT_EQ(loaded.sector_crcs, manifest.sector_crcs);
+  std::remove(path.c_str());
+}
+
+TEST(DeltaFlashTest, ManifestLimitsFlashToChangedSectors) {
+  test::FlashEcu ecu(old_image(), kBase);
+  Client client(ecu);
+  const auto image = new_image();
+  MemoryFirmwareSource firmware(image);
+  auto config = delta_config();
+  config.installed_manifest = manifest_of(old_image());
+
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, config);
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+
+  // Sectors 2-3 as one region, sector 7 as another
+  using Range = std::pair<uint32_t, uint32_t>;
+  const std::vector<Range> regions = {{kBase + 2048, 2048}, {kBase + 7168, 1024}};
+  EXPECT_EQ(ecu.erases_, regions);
+  EXPECT_EQ(ecu.downloads_, regions);
+  EXPECT_EQ(ecu.bytes_received_, 3072u);
+  EXPECT_EQ(ecu.crc_requests_, 0u);
+  EXPECT_EQ(result.sectors_total, 10u);
+  EXPECT_EQ(result.sectors_flashed, 3u);
+  EXPECT_EQ(result.total_bytes, 3072u);
+  EXPECT_EQ(result.bytes_transferred, 3072u);
+  ASSERT_TRUE(result.manifest.has_value());
+  EXPECT_EQ(result.manifest->sector_crcs, manifest_of(image).sector_crcs);
+}
+
+TEST(DeltaFlashTest, FailedFlashMarksTouchedSectorsUnknown) {
+  test::FlashEcu ecu(old_image(), kBase);
+  Client client(ecu);
+  const auto image = new_image();
+  MemoryFirmwareSource firmware(image);
+  auto config = delta_config();
+  config.installed_manifest = manifest_of(old_image());
+
+  // Sectors 2-3 are erased, then their download is rejected
+  ecu.fail_exits_ = 1;
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, config);
+  ASSERT_FALSE(result.success);
+  ASSERT_TRUE(result.manifest.has_value());
+  const auto old_crcs = manifest_of(old_image()).sector_crcs;
+  EXPECT_FALSE(result.manifest->sector_known(2));
+  EXPECT_FALSE(result.manifest->sector_known(3));
+  EXPECT_TRUE(result.manifest->sector_known(7));
+  EXPECT_EQ(result.manifest->sector_crcs[7], old_crcs[7]);
+  EXPECT_EQ(result.manifest->sector_crcs[0], old_crcs[0]);
+
+  // The unknown sectors survive a save/load round trip
+  const std::string path = "delta_flash_failed.manifest";
+  ASSERT_TRUE(result.manifest->save(path));
+  FlashManifest loaded;
+  ASSERT_TRUE(loaded.load(path));
+  std::remove(path.c_str());
+  EXPECT_FALSE(loaded.sector_known(2));
+  EXPECT_TRUE(loaded.sector_known(7));
+  EXPECT_EQ(loaded.sector_crcs[7], old_crcs[7]);
+
+  // Rolling back to the old image rewrites the erased sectors only
+  ecu.erases_.clear();
+  ecu.downloads_.clear();
+  const auto rollback = old_image();
+  MemoryFirmwareSource previous(rollback);
+  config.installed_manifest = loaded;
+  result = programmer.program_ecu(previous, config);
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_EQ(ecu.memory_, rollback);
+  using Range = std::pair<uint32_t, uint32_t>;
+  EXPECT_EQ(ecu.downloads_, (std::vector<Range>{{kBase + 2048, 2048}}));
+}
+
+TEST(DeltaFlashTest, RemoteCrcWhereManifestDoesNotApply) {
+  test::FlashEcu ecu(old_image(), kBase);
+  Client client(ecu);
+  const auto image = new_image();
+  MemoryFirmwareSource firmware(image);
+  auto config = delta_config();
+  config.installed_manifest = manifest_of(old_image(), 2048);  // Other layout
+  config.remote_crc = routine_crc_reader(client, kCrcRoutine);
+  ecu.crc_routine_ = kCrcRoutine;
+  config.compressor = std::make_shared<compression::LzfCompressor>();
+
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, config);
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  EXPECT_EQ(ecu.crc_requests_, 10u);
+  EXPECT_EQ(ecu.downloads_.size(), 2u);
+  EXPECT_EQ(result.sectors_flashed, 3u);
+  EXPECT_EQ(result.total_bytes, ecu.bytes_received_);
+}
+
+TEST(DeltaFlashTest, UnchangedImageIsNotDownloaded) {
+  test::FlashEcu ecu(old_image(), kBase);
+  Client client(ecu);
+  const auto image = old_image();
+  MemoryFirmwareSource firmware(image);
+  auto config = delta_config();
+  config.remote_crc = routine_crc_reader(client, kCrcRoutine);
+  ecu.crc_routine_ = kCrcRoutine;
+
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, config);
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_TRUE(ecu.erases_.empty());
+  EXPECT_TRUE(ecu.downloads_.empty());
+  EXPECT_EQ(result.sectors_flashed, 0u);
+  EXPECT_TRUE(result.manifest.has_value());
+}
+
+TEST(DeltaFlashTest, UnknownContentsFlashWholeImage) {
+  test::FlashEcu ecu(std::vector<uint8_t>(10 * 1024, 0x00), kBase);
+  Client client(ecu);
+  const auto image = new_image();
+  MemoryFirmwareSource firmware(image);
+
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, delta_config());
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  using Range = std::pair<uint32_t, uint32_t>;
+  EXPECT_EQ(ecu.downloads_, (std::vector<Range>{{kBase, 10 * 1024}}));
+
+  // Regions are read again after hashing, so a stream cannot be used
+  GeneratorFirmwareSource once(image.size(), [](uint8_t*, size_t length) { return length; });
+  result = programmer.program_ecu(once, delta_config());
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(ecu.downloads_.size(), 1u);
+}
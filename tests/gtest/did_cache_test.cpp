@@ -0,0 +1,347 @@
+/**
+ * @file did_cache_test.cpp
+ * @brief Tests for DIDCache and FlatDIDCache storage, eviction and concurrency (uds_cache.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_cache.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace uds;
+using namespace uds::cache;
+
+TEST(DIDCacheTest, PutGetInvalidate) {
+  DIDCache cache;
+  EXPECT_EQ(cache.shard_count(), 16u);
+
+  cache.put(0xF190, {0x01, 0x02});
+  ASSERT_TRUE(cache.get(0xF190).has_value());
+  EXPECT_EQ(*cache.get(0xF190), (std::vector<uint8_t>{0x01, 0x02}));
+  EXPECT_FALSE(cache.get(0xF191).has_value());
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_GT(cache.memory_usage(), 2u);
+
+  cache.invalidate(0xF190);
+  EXPECT_FALSE(cache.contains(0xF190));
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.memory_usage(), 0u);
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.invalidations, 1u);
+  EXPECT_EQ(stats.peak_entries, 1u);
+}
+
+TEST(DIDCacheTest, ShardCountRoundsUpToPowerOfTwo) {
+  CacheConfig config;
+  config.shard_count = 5;
+  EXPECT_EQ(DIDCache(config).shard_count(), 8u);
+  config.shard_count = 0;
+  EXPECT_EQ(DIDCache(config).shard_count(), 1u);
+}
+
+TEST(DIDCacheTest, SingleShardKeepsGlobalLru) {
+  CacheConfig config;
+  config.shard_count = 1;
+  config.max_entries = 3;
+  DIDCache cache(config);
+
+  cache.put(0x0001, {1});
+  cache.put(0x0002, {2});
+  cache.put(0x0003, {3});
+  ASSERT_TRUE(cache.get(0x0001));  // 0x0002 is now least recently used
+  cache.put(0x0004, {4});
+
+  EXPECT_TRUE(cache.contains(0x0001));
+  EXPECT_FALSE(cache.contains(0x0002));
+  EXPECT_TRUE(cache.contains(0x0003));
+  EXPECT_TRUE(cache.contains(0x0004));
+  EXPECT_EQ(cache.stats().evictions, 1u);
+}
+
+TEST(DIDCacheTest, LimitsApplyAcrossShards) {
+  CacheConfig config;
+  config.shard_count = 4;
+  config.max_entries = 64;
+  DIDCache cache(config);
+
+  for (uint16_t did = 0; did < 1000; ++did) cache.put(did, {0x00});
+  EXPECT_EQ(cache.size(), 64u);
+  EXPECT_EQ(cache.stats().evictions, 1000u - 64u);
+  EXPECT_EQ(cache.stats().peak_entries, 64u);
+  for (uint16_t did = 1000 - 64; did < 1000; ++did) EXPECT_TRUE(cache.contains(did));
+}
+
+TEST(DIDCacheTest, SmallLimitsAreHonoredWithManyShards) {
+  CacheConfig config;
+  config.max_entries = 4;
+  DIDCache small(config);
+  for (uint16_t did = 0; did < 32; ++did) small.put(did, {0x00});
+  EXPECT_EQ(small.size(), 4u);
+
+  config.max_entries = 16;
+  DIDCache exact(config);
+  for (uint16_t did = 0; did < 16; ++did) exact.put(did, {0x00});
+  EXPECT_EQ(exact.size(), 16u);
+  EXPECT_EQ(exact.stats().evictions, 0u);
+
+  // A payload may use the whole budget, not just one shard's share of it
+  config.max_entries = 1000;
+  config.max_memory_bytes = 16 * 1024;
+  DIDCache bounded(config);
+  bounded.put(0xF190, std::vector<uint8_t>(2000, 0xAA));
+  EXPECT_TRUE(bounded.contains(0xF190));
+
+  DIDCache large{CacheConfig()};
+  large.put(0xF191, std::vector<uint8_t>(100 * 1024, 0xBB));
+  EXPECT_TRUE(large.contains(0xF191));
+}
+
+TEST(DIDCacheTest, EvictionIsLeastRecentlyUsedAcrossShards) {
+  CacheConfig config;
+  config.max_entries = 3;
+  DIDCache cache(config);
+  ASSERT_EQ(cache.shard_count(), 16u);
+
+  cache.put(0x0001, {1});
+  cache.put(0x0002, {2});
+  cache.put(0x0003, {3});
+  ASSERT_TRUE(cache.get(0x0001));
+  cache.put(0x0004, {4});
+
+  EXPECT_TRUE(cache.contains(0x0001));
+  EXPECT_FALSE(cache.contains(0x0002));
+  EXPECT_TRUE(cache.contains(0x0003));
+  EXPECT_TRUE(cache.contains(0x0004));
+}
+
+TEST(DIDCacheTest, RangeInvalidationAndCleanupSpanShards) {
+  DIDCache cache;
+  for (uint16_t did = 0xF180; did < 0xF1A0; ++did) cache.put(did, {0x01});
+  cache.put(0x1234, {0x02}, std::chrono::milliseconds(0));
+
+  cache.invalidate_range(0xF180, 0xF18F);
+  EXPECT_EQ(cache.size(), 17u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  EXPECT_EQ(cache.cleanup_expired(), 1u);
+  EXPECT_EQ(cache.size(), 16u);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.memory_usage(), 0u);
+}
+
+TEST(DIDCacheTest, NonCacheableIsPerDid) {
+  DIDCache cache;
+  cache.put(0xF40C, {0x10});
+  cache.set_non_cacheable(0xF40C);
+  EXPECT_FALSE(cache.contains(0xF40C));
+  cache.put(0xF40C, {0x11});
+  EXPECT_FALSE(cache.get(0xF40C).has_value());
+  EXPECT_FALSE(cache.is_cacheable(0xF40C));
+  EXPECT_TRUE(cache.is_cacheable(0xF40D));
+}
+
+TEST(DIDCacheTest, ConcurrentReadersAndWriters) {
+  CacheConfig config;
+  config.max_entries = 256;
+  DIDCache cache(config);
+
+  std::atomic<int> bad{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 5000; ++i) {
+        const uint16_t did = static_cast<uint16_t>((i * 7 + t) % 512);
+        if (t % 2 == 0) {
+          cache.put(did, {static_cast<uint8_t>(did & 0xFF), static_cast<uint8_t>(did >> 8)});
+        } else if (auto v = cache.get(did)) {
+          if (v->size() != 2 || ((*v)[1] << 8 | (*v)[0]) != did) bad++;
+        }
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+
+  EXPECT_EQ(bad.load(), 0);
+  EXPECT_LE(cache.size(), 256u);
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.current_entries, cache.size());
+  EXPECT_EQ(stats.hits + stats.misses, 4u * 5000u);
+}
+
+TEST(DIDCacheTest, ViewsShareBytesAndOutliveEntries) {
+  auto cache = std::make_unique<DIDCache>();
+  cache->put(0xF190, {0x01, 0x02, 0x03});
+
+  auto view = cache->get_view(0xF190);
+  ASSERT_TRUE(view.has_value());
+  auto again = cache->get_view(0xF190);
+  EXPECT_EQ(view->data(), again->data());  // no copy
+  EXPECT_EQ(*view, (std::vector<uint8_t>{0x01, 0x02, 0x03}));
+
+  // Replaced, removed and destroyed: the borrowed bytes stay intact
+  cache->put(0xF190, {0x09});
+  EXPECT_EQ(*cache->get(0xF190), (std::vector<uint8_t>{0x09}));
+  cache->clear();
+  cache.reset();
+  EXPECT_EQ(view->to_vector(), (std::vector<uint8_t>{0x01, 0x02, 0x03}));
+  EXPECT_EQ(*again, *view);
+}
+
+TEST(DIDCacheTest, MemoryIsArenaChunksPlusEntryRecords) {
+  CacheConfig config;
+  config.shard_count = 1;
+  config.max_memory_bytes = 4 * (64 + sizeof(CacheEntry));
+  DIDCache cache(config);
+
+  // A 20-byte payload and its header share one 64-byte chunk
+  EXPECT_EQ(PayloadArena::chunk_bytes(20), 64u);
+  EXPECT_EQ(PayloadArena::chunk_bytes(4000), sizeof(PayloadChunk) + 4000);
+  cache.put(0x0001, std::vector<uint8_t>(20, 0x11));
+  EXPECT_EQ(cache.memory_usage(), 64 + sizeof(CacheEntry));
+
+  // The limit holds exactly: a fifth entry evicts the oldest
+  for (uint16_t did = 2; did <= 5; ++did) {
+    cache.put(did, std::vector<uint8_t>(20, 0x22));
+  }
+  EXPECT_EQ(cache.size(), 4u);
+  EXPECT_FALSE(cache.contains(0x0001));
+  EXPECT_EQ(cache.memory_usage(), config.max_memory_bytes);
+  EXPECT_EQ(cache.stats().reserved_memory, PayloadArena::kMinSlabBytes);
+
+  // Churn reuses freed chunks instead of reserving more
+  for (int round = 0; round < 100; ++round) {
+    cache.put(static_cast<uint16_t>(2 + round % 4), std::vector<uint8_t>(20 + round % 8, 0x33));
+  }
+  EXPECT_EQ(cache.stats().reserved_memory, PayloadArena::kMinSlabBytes);
+
+  // An entry larger than the whole budget is not cached
+  cache.put(0x1000, std::vector<uint8_t>(2048, 0x00));
+  EXPECT_FALSE(cache.contains(0x1000));
+
+  cache.clear();
+  EXPECT_EQ(cache.memory_usage(), 0u);
+}
+
+// ============================================================================
+// FlatDIDCache
+// ============================================================================
+
+TEST(FlatDIDCacheTest, PutGetAndExactMemory) {
+  FlatDIDCache cache;
+  EXPECT_EQ(cache.capacity(), 1000u);
+
+  cache.put(0xF190, std::vector<uint8_t>(17, 0x41));
+  cache.put(0xF18C, {0x01, 0x02, 0x03});
+  ASSERT_TRUE(cache.get(0xF190).has_value());
+  EXPECT_EQ(*cache.get(0xF190), std::vector<uint8_t>(17, 0x41));
+  EXPECT_EQ(*cache.get(0xF18C), (std::vector<uint8_t>{0x01, 0x02, 0x03}));
+  EXPECT_FALSE(cache.get(0xF191).has_value());
+
+  // Payload bytes plus one fixed slot record per entry
+  const size_t both = cache.memory_usage();
+  cache.invalidate(0xF18C);
+  const size_t one = cache.memory_usage();
+  EXPECT_EQ(both - one, 3 + (one - 17));
+  cache.put(0xF18C, {0x01, 0x02, 0x03});
+  EXPECT_EQ(cache.memory_usage(), both);
+
+  // A shrinking refresh is accounted exactly as well
+  cache.put(0xF190, {0x42});
+  EXPECT_EQ(cache.memory_usage(), both - 16);
+  EXPECT_EQ(*cache.get(0xF190), (std::vector<uint8_t>{0x42}));
+
+  cache.invalidate(0xF18C);
+  cache.invalidate(0xF190);
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.memory_usage(), 0u);
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 4u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.invalidations, 3u);
+  EXPECT_EQ(stats.peak_entries, 2u);
+}
+
+TEST(FlatDIDCacheTest, ClockGivesReferencedEntriesASecondChance) {
+  CacheConfig config;
+  config.max_entries = 3;
+  FlatDIDCache cache(config);
+
+  cache.put(0x0001, {1});
+  cache.put(0x0002, {2});
+  cache.put(0x0003, {3});
+  ASSERT_TRUE(cache.get(0x0001));
+  cache.put(0x0004, {4});
+
+  EXPECT_TRUE(cache.contains(0x0001));
+  EXPECT_FALSE(cache.contains(0x0002));
+  EXPECT_TRUE(cache.contains(0x0003));
+  EXPECT_TRUE(cache.contains(0x0004));
+  EXPECT_EQ(cache.stats().evictions, 1u);
+}
+
+TEST(FlatDIDCacheTest, MemoryLimitEvictsAndArenaCompacts) {
+  CacheConfig config;
+  config.max_entries = 64;
+  config.max_memory_bytes = 4096;
+  FlatDIDCache cache(config);
+
+  for (int round = 0; round < 50; ++round) {
+    for (uint16_t did = 0; did < 32; ++did) {
+      cache.put(did, std::vector<uint8_t>(64 + (round + did) % 64, static_cast<uint8_t>(did)));
+      ASSERT_LE(cache.memory_usage(), 4096u);
+    }
+  }
+  EXPECT_GT(cache.stats().evictions, 0u);
+  EXPECT_LE(cache.arena_bytes(), 4 * 4096u);
+
+  for (uint16_t did = 0; did < 32; ++did) {
+    if (auto v = cache.get(did)) {
+      ASSERT_FALSE(v->empty());
+      EXPECT_EQ(v->front(), did);
+      EXPECT_EQ(v->back(), did);
+    }
+  }
+
+  // An entry larger than the whole budget is not cached
+  cache.put(0x1000, std::vector<uint8_t>(8192, 0x00));
+  EXPECT_FALSE(cache.contains(0x1000));
+}
+
+TEST(FlatDIDCacheTest, PerDidSettingsRangesAndExpiry) {
+  FlatDIDCache cache;
+  cache.set_non_cacheable(0xF40C);
+  cache.put(0xF40C, {0x10});
+  EXPECT_FALSE(cache.contains(0xF40C));
+  EXPECT_FALSE(cache.is_cacheable(0xF40C));
+
+  cache.set_did_ttl(0x1234, std::chrono::milliseconds(0));
+  cache.put(0x1234, {0x02});
+  cache.set_did_policy(0x2345, ExpirationPolicy::Never);
+  cache.put(0x2345, {0x03}, std::chrono::milliseconds(0));
+  for (uint16_t did = 0xF180; did < 0xF1A0; ++did) cache.put(did, {0x01});
+
+  cache.invalidate_range(0xF180, 0xF18F);
+  EXPECT_EQ(cache.size(), 18u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  EXPECT_EQ(cache.cleanup_expired(), 1u);
+  EXPECT_TRUE(cache.contains(0x2345));
+  EXPECT_EQ(cache.get_multiple({0xF18F, 0xF190, 0xF19F}).size(), 2u);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.memory_usage(), 0u);
+  EXPECT_FALSE(cache.is_cacheable(0xF40C));
+}
+
+TEST(DIDCacheTest, EntryDataStillReadsAsVector) {
+  const CacheEntry entry({0x01, 0x02, 0x03}, std::chrono::milliseconds(1000), ExpirationPolicy::TimeToLive);
+  const std::vector<uint8_t> copy = entry.data;
+  EXPECT_EQ(copy, (std::vector<uint8_t>{0x01, 0x02, 0x03}));
+  EXPECT_TRUE(entry.data == copy);
+}
@@ -0,0 +1,184 @@
+/**
+ * @file firmware_source_test.cpp
+ * @brief Tests for FirmwareSource (uds_firmware.cpp) and the transfer loops reading from it
+ */
+
+#include <gtest/gtest.h>
+#include "uds_firmware.hpp"
+#include "uds_block.hpp"
+#include "uds_programming.hpp"
+#include "ecu_programming.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace uds;
+
+static std::vector<uint8_t> make_image(size_t size) {
+  std::vector<uint8_t> image(size);
+  for (size_t i = 0; i < size; ++i) image[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+  return image;
+}
+
+TEST(FirmwareSourceTest, MemoryAndMappedSourcesLendImageBytes) {
+  const auto image = make_image(10000);
+  MemoryFirmwareSource memory(image);
+  ByteSpan span;
+  ASSERT_TRUE(memory.read(4096, 100, span));
+  EXPECT_EQ(span.data, image.data() + 4096);
+  EXPECT_EQ(span.size, 100u);
+  EXPECT_FALSE(memory.read(9950, 100, span));
+
+  const std::string path = "firmware_source_test.bin";
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+  }
+  MappedFirmwareSource mapped;
+  EXPECT_FALSE(mapped.open("does_not_exist.bin"));
+  ASSERT_TRUE(mapped.open(path));
+  std::remove(path.c_str());  // The mapping stays valid
+  EXPECT_EQ(mapped.size(), image.size());
+  EXPECT_TRUE(mapped.seekable());
+  ASSERT_TRUE(mapped.read(9000, 1000, span));
+  EXPECT_TRUE(std::equal(span.begin(), span.end(), image.begin() + 9000));
+  EXPECT_FALSE(mapped.read(9001, 1000, span));
+  mapped.close();
+  EXPECT_FALSE(mapped.read(0, 1, span));
+}
+
+TEST(FirmwareSourceTest, SequentialSourcesReuseOneBuffer) {
+  const auto image = make_image(1000);
+  std::istringstream in(std::string(image.begin(), image.end()));
+  StreamFirmwareSource stream(in);
+  EXPECT_EQ(stream.size(), 1000u);
+  EXPECT_FALSE(stream.seekable());
+
+  ByteSpan first, span;
+  ASSERT_TRUE(stream.read(0, 400, first));
+  const uint8_t* buffer = first.data;
+  ASSERT_TRUE(stream.read(0, 400, span));  // Retried block
+  EXPECT_EQ(span.data, buffer);
+  EXPECT_FALSE(stream.read(800, 200, span));  // Skipped a block
+  ASSERT_TRUE(stream.read(400, 400, span));
+  EXPECT_EQ(span.data, buffer);
+  EXPECT_TRUE(std::equal(span.begin(), span.end(), image.begin() + 400));
+  ASSERT_TRUE(stream.read(800, 200, span));
+  EXPECT_TRUE(std::equal(span.begin(), span.end(), image.begin() + 800));
+  EXPECT_FALSE(stream.read(1000, 1, span));
+
+  size_t produced = 0;
+  GeneratorFirmwareSource generator(1000, [&](uint8_t* out, size_t length) {
+    for (size_t i = 0; i < length; ++i) out[i] = image[produced + i];
+    produced += length;
+    return length;
+  });
+  ASSERT_TRUE(generator.read(0, 600, span));
+  ASSERT_TRUE(generator.read(600, 400, span));
+  EXPECT_TRUE(std::equal(span.begin(), span.end(), image.begin() + 600));
+
+  GeneratorFirmwareSource short_generator(1000, [](uint8_t*, size_t length) { return length / 2; });
+  EXPECT_FALSE(short_generator.read(0, 100, span));
+}
+
+TEST(FirmwareSourceTest, ProgrammerStreamsMoreThan65535Blocks) {
+  test::FlashEcu ecu;
+  ecu.max_block_ = 0x0100;
+  Client client(ecu);
+  const auto image = make_image(70000 * 8 + 3);
+  size_t produced = 0;
+  GeneratorFirmwareSource firmware(image.size(), [&](uint8_t* out, size_t length) {
+    std::copy(image.begin() + produced, image.begin() + produced + length, out);
+    produced += length;
+    return length;
+  });
+
+  ProgrammingConfig config;
+  config.skip_security = true;
+  config.skip_erase = true;
+  config.perform_reset_after_flash = false;
+  config.inter_block_delay_ms = 0;
+  config.max_block_size = 8;
+
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu(firmware, config);
+  ASSERT_TRUE(result.success) << result.error_message;
+  EXPECT_EQ(result.total_blocks, 70001u);
+  EXPECT_EQ(result.blocks_transferred, 70001u);
+  EXPECT_EQ(ecu.memory_, image);
+}
+
+TEST(FirmwareSourceTest, SessionTransfersImageFromStream) {
+  test::FlashEcu ecu;
+  Client client(ecu);
+  const auto image = make_image(5000);
+  std::istringstream in(std::string(image.begin(), image.end()));
+  StreamFirmwareSource firmware(in, image.size());
+
+  ProgrammingSession session(client);
+  ASSERT_TRUE(session.request_download(0x00, {0x00, 0x00}, {0x13, 0x88}).ok);
+  auto status = session.transfer_image(firmware);
+  ASSERT_TRUE(status.ok) << status.message;
+  EXPECT_EQ(ecu.memory_, image);
+  EXPECT_EQ(ecu.transfers_, (image.size() + 0x0101) / 0x0102);
+}
+
+TEST(FirmwareSourceTest, BlockUploadVerifiesEverySourceKind) {
+  test::FlashEcu ecu({}, 0x1000);
+  Client client(ecu);
+  block::BlockTransferManager manager(client);
+  const auto image = make_image(3000);
+
+  // Seekable: read back and compared byte for byte
+  MemoryFirmwareSource memory(image);
+  auto result = manager.upload(0x1000, memory);
+  ASSERT_TRUE(result.ok) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  ASSERT_TRUE(result.crc32.has_value());
+  EXPECT_EQ(*result.crc32, block::calculate_crc32(image));
+
+  // Sequential: read back and checked against the CRC taken while sending
+  ecu.memory_.clear();
+  std::istringstream in(std::string(image.begin(), image.end()));
+  StreamFirmwareSource stream(in);
+  result = manager.upload(0x1000, stream);
+  ASSERT_TRUE(result.ok) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  EXPECT_EQ(*result.crc32, block::calculate_crc32(image));
+
+  // A corrupted read-back fails verification
+  ecu.memory_.clear();
+  std::istringstream in2(std::string(image.begin(), image.end()));
+  StreamFirmwareSource stream2(in2);
+  block::TransferConfig config;
+  config.verify_blocks = false;
+  ASSERT_TRUE(manager.upload(0x1000, stream2, config).ok);
+  ecu.memory_[100] ^= 0xFF;
+  EXPECT_FALSE(manager.verify_upload(0x1000, memory));
+}
+
+TEST(FirmwareSourceTest, SourceUploadResumesOnlyWithItsSource) {
+  test::FlashEcu ecu({}, 0x1000);
+  Client client(ecu);
+  block::BlockTransferManager manager(client);
+  const auto image = make_image(3000);
+  MemoryFirmwareSource memory(image);
+
+  // Cancel after the first block so the transfer stays resumable
+  block::CancellationToken cancel;
+  auto result = manager.upload(0x1000, memory, block::TransferConfig(),
+                               [&](const block::TransferProgress& p) {
+                                 if (p.current_block == 1) cancel.cancel();
+                               }, &cancel);
+  EXPECT_EQ(result.final_state, block::TransferState::Cancelled);
+  ASSERT_TRUE(manager.can_resume());
+
+  EXPECT_FALSE(manager.resume().ok);
+  const std::vector<uint8_t> other(10, 0x00);
+  MemoryFirmwareSource wrong(other);
+  EXPECT_FALSE(manager.resume(wrong).ok);
+  result = manager.resume(memory);
+  ASSERT_TRUE(result.ok) << result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+}
@@ -0,0 +1,268 @@
+/**
+ * @file flash_orchestrator_test.cpp
+ * @brief Tests for parallel multi-ECU flashing (flash_orchestrator.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "flash_orchestrator.hpp"
+#include "test_util.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+using namespace uds;
+
+namespace {
+
+using Frames = std::vector<std::vector<uint8_t>>;
+
+// What the ECUs on one simulated bus have in common: how many are in the
+// programming session, and a rendezvous that only opens if `parties` of
+// them enter it at the same time
+struct SimBus {
+  std::mutex mutex;
+  std::condition_variable changed;
+  int in_session = 0;
+  int max_in_session = 0;
+  int arrived = 0;
+  int parties = 1;
+
+  void enter() {
+    std::unique_lock<std::mutex> lock(mutex);
+    max_in_session = std::max(max_in_session, ++in_session);
+    ++arrived;
+    changed.notify_all();
+    changed.wait_for(lock, std::chrono::seconds(2), [&] { return arrived >= parties; });
+  }
+
+  void leave() {
+    std::lock_guard<std::mutex> lock(mutex);
+    --in_session;
+  }
+};
+
+// Flash ECU taking part in the SimBus programming-session rendezvous
+class BusEcu : public test::FlashEcu {
+public:
+  explicit BusEcu(SimBus& bus) : bus_(bus) {}
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds timeout) override {
+    if (tx[0] == 0x10 && tx[1] == 0x02) bus_.enter();
+    if (tx[0] == 0x11) bus_.leave();
+    return test::FlashEcu::request_response(tx, rx, timeout);
+  }
+
+private:
+  SimBus& bus_;
+};
+
+// Functional address 0x7DF: records requests, stays silent (suppressed
+// positive responses) unless told to refuse a service
+class FunctionalBus : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(tx);
+    if (tx[0] == refuse_sid_) {
+      rx = {0x7F, tx[0], 0x22};
+      return true;
+    }
+    return false;
+  }
+
+  bool send_suppressed(const std::vector<uint8_t>& tx, std::vector<uint8_t>& rx,
+                       std::chrono::milliseconds timeout) override {
+    if (dead_) return false;
+    if (!request_response(tx, rx, timeout)) rx.clear();  // Silence
+    return true;
+  }
+
+  bool recv_unsolicited(std::vector<uint8_t>&, std::chrono::milliseconds) override { return false; }
+
+  // Requests other than TesterPresent
+  Frames steps() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Frames out;
+    std::copy_if(requests_.begin(), requests_.end(), std::back_inserter(out),
+                 [](const std::vector<uint8_t>& r) { return r[0] != 0x3E; });
+    return out;
+  }
+
+  uint8_t refuse_sid_ = 0;
+  bool dead_ = false;  // Sends fail (bus off, no ECU acknowledges)
+
+private:
+  std::mutex mutex_;
+  Frames requests_;
+  Address addr_{AddressType::Functional, 0x7DF, 0x7E8};
+};
+
+std::vector<uint8_t> image_of(size_t size, uint8_t seed) {
+  std::vector<uint8_t> image(size);
+  for (size_t i = 0; i < size; ++i) image[i] = static_cast<uint8_t>(i * 7 + seed);
+  return image;
+}
+
+ProgrammingConfig job_config() {
+  ProgrammingConfig config;
+  config.skip_security = true;
+  config.skip_erase = true;
+  config.inter_block_delay_ms = 0;
+  return config;
+}
+
+} // namespace
+
+TEST(FlashOrchestratorTest, FlashesEcusInParallelWithSharedFunctionalSteps) {
+  SimBus sim;
+  sim.parties = 3;
+  FunctionalBus functional_transport;
+  Client functional(functional_transport);
+
+  std::vector<std::unique_ptr<BusEcu>> ecus;
+  std::vector<std::unique_ptr<Client>> clients;
+  std::vector<std::vector<uint8_t>> images;
+  std::vector<std::unique_ptr<MemoryFirmwareSource>> sources;
+  FlashOrchestrator orchestrator;
+  orchestrator.add_bus("PT-CAN", {0, 0, &functional});
+  for (uint8_t i = 0; i < 3; ++i) {
+    ecus.push_back(std::make_unique<BusEcu>(sim));
+    clients.push_back(std::make_unique<Client>(*ecus.back()));
+    images.push_back(image_of(3000 + i * 1000, i));
+    sources.push_back(std::make_unique<MemoryFirmwareSource>(images.back()));
+    orchestrator.add_job({"ECU" + std::to_string(i), clients.back().get(), sources.back().get(),
+                          job_config(), "PT-CAN"});
+  }
+
+  std::mutex progress_mutex;
+  std::vector<FlashProgress> updates;
+  orchestrator.set_progress_callback([&](const FlashProgress& progress) {
+    std::lock_guard<std::mutex> lock(progress_mutex);
+    updates.push_back(progress);
+  });
+
+  const FlashReport report = orchestrator.run();
+  ASSERT_TRUE(report.success) << format_flash_report(report);
+  EXPECT_EQ(sim.max_in_session, 3);
+
+  // Pre-steps once, functionally, before the jobs; post-steps after
+  const Frames expected = {{0x10, 0x83}, {0x85, 0x82}, {0x28, 0x83, 0xFF},
+                           {0x28, 0x80, 0xFF}, {0x85, 0x81}, {0x10, 0x81}};
+  EXPECT_EQ(functional_transport.steps(), expected);
+  ASSERT_EQ(report.buses.size(), 1u);
+  EXPECT_TRUE(report.buses[0].functional_presteps);
+
+  ASSERT_EQ(report.jobs.size(), 3u);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(ecus[i]->memory_, images[i]);
+    EXPECT_FALSE(ecus[i]->received(0x85, 0x02));
+    EXPECT_FALSE(ecus[i]->received(0x28, 0x03));
+    const auto& job = report.jobs[i];
+    EXPECT_EQ(job.name, "ECU" + std::to_string(i));
+    EXPECT_EQ(job.result.bytes_transferred, images[i].size());
+    EXPECT_TRUE(job.phases.count(ProgrammingState::TransferringData));
+    EXPECT_FALSE(job.phases.count(ProgrammingState::DisablingDTC));
+    EXPECT_FALSE(job.phases.count(ProgrammingState::Completed));
+  }
+
+  ASSERT_FALSE(updates.empty());
+  const auto& last = updates.back();
+  EXPECT_EQ(last.jobs_total, 3u);
+  EXPECT_EQ(last.jobs_succeeded, 3u);
+  EXPECT_EQ(last.jobs_running, 0u);
+  EXPECT_EQ(last.bytes_transferred, 3000u + 4000u + 5000u);
+  EXPECT_FLOAT_EQ(last.fraction(), 1.0f);
+}
+
+TEST(FlashOrchestratorTest, BusLimitsParallelJobsAndBandwidth) {
+  SimBus sim;
+  BusEcu ecu_a(sim), ecu_b(sim);
+  Client client_a(ecu_a), client_b(ecu_b);
+  const auto image_a = image_of(2000, 1), image_b = image_of(2000, 2);
+  MemoryFirmwareSource source_a(image_a), source_b(image_b);
+
+  FlashOrchestrator orchestrator;
+  orchestrator.add_bus("body", {20000, 1, nullptr});
+  orchestrator.add_job({"A", &client_a, &source_a, job_config(), "body"});
+  orchestrator.add_job({"B", &client_b, &source_b, job_config(), "body"});
+
+  const FlashReport report = orchestrator.run();
+  ASSERT_TRUE(report.success) << format_flash_report(report);
+  EXPECT_EQ(sim.max_in_session, 1);
+
+  // 4000 bytes at 20000 bytes/s, one job after the other
+  EXPECT_GE(report.elapsed.count(), 190);
+  const auto& first = report.jobs[0].queued < report.jobs[1].queued ? report.jobs[0] : report.jobs[1];
+  const auto& second = &first == &report.jobs[0] ? report.jobs[1] : report.jobs[0];
+  EXPECT_GE(second.queued.count(), 90);
+  EXPECT_GE(first.throttled.count(), 90);
+
+  // Without functional pre-steps the jobs disable DTC setting themselves
+  EXPECT_TRUE(ecu_a.received(0x85, 0x02));
+  EXPECT_TRUE(ecu_b.received(0x28, 0x03));
+}
+
+TEST(FlashOrchestratorTest, RefusedFunctionalStepFallsBackToPhysical) {
+  SimBus sim;
+  FunctionalBus functional_transport;
+  functional_transport.refuse_sid_ = 0x85;
+  Client functional(functional_transport);
+  BusEcu ecu(sim);
+  Client client(ecu);
+  const auto image = image_of(1000, 3);
+  MemoryFirmwareSource source(image);
+
+  FlashOrchestrator orchestrator;
+  orchestrator.add_bus("chassis", {0, 0, &functional});
+  orchestrator.add_job({"ABS", &client, &source, job_config(), "chassis"});
+  orchestrator.add_job({"EPS", &client, nullptr, job_config(), "chassis"});
+
+  const FlashReport report = orchestrator.run();
+  EXPECT_FALSE(report.success);
+  ASSERT_EQ(report.jobs.size(), 2u);
+  EXPECT_TRUE(report.jobs[0].result.success) << report.jobs[0].result.error_message;
+  EXPECT_FALSE(report.jobs[1].result.success);
+  EXPECT_EQ(ecu.memory_, image);
+
+  ASSERT_EQ(report.buses.size(), 1u);
+  EXPECT_FALSE(report.buses[0].functional_presteps);
+  EXPECT_NE(report.buses[0].error.find("ControlDTCSetting Off"), std::string::npos);
+  EXPECT_TRUE(ecu.received(0x85, 0x02));
+  EXPECT_TRUE(ecu.received(0x28, 0x03));
+
+  const std::string text = format_flash_report(report);
+  EXPECT_NE(text.find("ABS: OK"), std::string::npos);
+  EXPECT_NE(text.find("EPS: FAILED"), std::string::npos);
+}
+
+TEST(FlashOrchestratorTest, DeadFunctionalBusFallsBackToPhysical) {
+  SimBus sim;
+  FunctionalBus functional_transport;
+  functional_transport.dead_ = true;
+  Client functional(functional_transport);
+  BusEcu ecu(sim);
+  Client client(ecu);
+  const auto image = image_of(1000, 5);
+  MemoryFirmwareSource source(image);
+
+  FlashOrchestrator orchestrator;
+  orchestrator.add_bus("body", {0, 0, &functional});
+  orchestrator.add_job({"BCM", &client, &source, job_config(), "body"});
+
+  const FlashReport report = orchestrator.run();
+  ASSERT_EQ(report.buses.size(), 1u);
+  EXPECT_FALSE(report.buses[0].functional_presteps);
+  EXPECT_NE(report.buses[0].error.find("ExtendedSession could not be sent"), std::string::npos);
+  ASSERT_EQ(report.jobs.size(), 1u);
+  EXPECT_TRUE(report.jobs[0].result.success) << report.jobs[0].result.error_message;
+  EXPECT_EQ(ecu.memory_, image);
+  EXPECT_TRUE(ecu.received(0x85, 0x02));
+  EXPECT_TRUE(ecu.received(0x28, 0x03));
+}
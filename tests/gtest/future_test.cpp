@@ -0,0 +1,224 @@
+/**
+ * @file future_test.cpp
+ * @brief Tests for composable futures and FutureClient (uds_future.hpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "uds_future.hpp"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace uds;
+using namespace uds::async;
+using std::chrono::milliseconds;
+
+// ECU that echoes requests back as positive responses and logs the SIDs
+class EchoEcu : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sids_.push_back(tx[0]);
+    }
+    if (tx[0] == 0x22 && tx.size() >= 3 && tx[1] == 0xBA && tx[2] == 0xD0) {
+      rx = {0x7F, 0x22, 0x31};
+      return true;
+    }
+    rx = {static_cast<uint8_t>(tx[0] + 0x40)};
+    rx.insert(rx.end(), tx.begin() + 1, tx.end());
+    return true;
+  }
+
+  std::vector<uint8_t> sids() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sids_;
+  }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  std::vector<uint8_t> sids_;
+};
+
+TEST(FutureTest, ThenRunsOnFulfillingThread) {
+  Promise<int> promise;
+  std::thread::id ran_on;
+  auto doubled = promise.get_future().then([&](int v) {
+    ran_on = std::this_thread::get_id();
+    return v * 2;
+  });
+  EXPECT_FALSE(doubled.is_ready());
+
+  std::thread producer([&] { promise.set_value(21); });
+  const auto producer_id = producer.get_id();
+  producer.join();
+  EXPECT_EQ(ran_on, producer_id);
+  EXPECT_EQ(doubled.get(), 42);
+  EXPECT_FALSE(doubled.valid());
+}
+
+TEST(FutureTest, ReadyFutureContinuesInline) {
+  std::thread::id ran_on;
+  auto f = make_ready_future(std::string("vin")).then([&](std::string s) {
+    ran_on = std::this_thread::get_id();
+    return s.size();
+  });
+  EXPECT_EQ(ran_on, std::this_thread::get_id());
+  EXPECT_TRUE(f.is_ready());
+  EXPECT_EQ(f.get(), 3u);
+}
+
+TEST(FutureTest, FutureReturningContinuationIsFlattened) {
+  Promise<int> first;
+  Promise<std::string> second;
+  auto chained = first.get_future()
+      .then([&](int) { return second.get_future(); })
+      .then([](std::string s) { return s + "!"; });
+
+  first.set_value(1);
+  EXPECT_FALSE(chained.is_ready());
+  second.set_value("done");
+  EXPECT_EQ(chained.get(), "done!");
+}
+
+TEST(FutureTest, ExceptionsSkipContinuations) {
+  Promise<int> promise;
+  bool second_ran = false;
+  auto f = promise.get_future()
+      .then([](int) -> int { throw std::runtime_error("step failed"); })
+      .then([&](int v) { second_ran = true; return v; });
+  promise.set_value(1);
+  EXPECT_THROW(f.get(), std::runtime_error);
+  EXPECT_FALSE(second_ran);
+}
+
+TEST(FutureTest, AbandonedPromiseBreaksFuture) {
+  Future<int> f;
+  {
+    Promise<int> promise;
+    f = promise.get_future();
+    EXPECT_THROW(promise.get_future(), std::future_error);
+  }
+  ASSERT_TRUE(f.is_ready());
+  EXPECT_THROW(f.get(), std::future_error);
+}
+
+TEST(FutureTest, LargeCapturesAreSupported) {
+  std::array<uint64_t, 32> big{};
+  big[31] = 7;
+  auto f = make_ready_future(1).then([big](int v) { return v + static_cast<int>(big[31]); });
+  EXPECT_EQ(f.get(), 8);
+}
+
+TEST(FutureTest, WhenAllKeepsInputOrder) {
+  std::vector<Promise<int>> promises(4);
+  std::vector<Future<int>> futures;
+  for (auto& p : promises) futures.push_back(p.get_future());
+  auto all = when_all(std::move(futures));
+
+  for (int i = 3; i >= 0; --i) {
+    EXPECT_FALSE(all.is_ready());
+    promises[i].set_value(i * 10);
+  }
+  EXPECT_EQ(all.get(), (std::vector<int>{0, 10, 20, 30}));
+
+  EXPECT_TRUE(when_all(std::vector<Future<int>>{}).get().empty());
+}
+
+TEST(FutureTest, WhenAllTupleAndFailure) {
+  Promise<int> a;
+  Promise<std::string> b;
+  auto both = when_all(a.get_future(), b.get_future());
+  b.set_value("x");
+  a.set_value(5);
+  auto [num, str] = both.get();
+  EXPECT_EQ(num, 5);
+  EXPECT_EQ(str, "x");
+
+  Promise<int> ok, bad;
+  std::vector<Future<int>> futures;
+  futures.push_back(ok.get_future());
+  futures.push_back(bad.get_future());
+  auto all = when_all(std::move(futures));
+  bad.set_exception(std::make_exception_ptr(std::runtime_error("bus off")));
+  EXPECT_FALSE(all.is_ready());
+  ok.set_value(1);
+  EXPECT_THROW(all.get(), std::runtime_error);
+}
+
+TEST(FutureTest, WhenAnyTakesFirst) {
+  std::vector<Promise<int>> promises(3);
+  std::vector<Future<int>> futures;
+  for (auto& p : promises) futures.push_back(p.get_future());
+  auto any = when_any(std::move(futures));
+
+  promises[2].set_value(99);
+  promises[0].set_value(1);
+  auto [index, value] = any.get();
+  EXPECT_EQ(index, 2u);
+  EXPECT_EQ(value, 99);
+
+  EXPECT_THROW(when_any(std::vector<Future<int>>{}).get(), std::invalid_argument);
+}
+
+TEST(FutureTest, DiagnosticFlowRunsOnWorkers) {
+  EchoEcu ecu;
+  Client client(ecu);
+  AsyncClient async(client, 2);
+  FutureClient fc(async);
+
+  const auto caller = std::this_thread::get_id();
+  std::atomic<bool> on_caller{false};
+  auto note_thread = [&] { if (std::this_thread::get_id() == caller) on_caller = true; };
+
+  async.pause();  // Attach the whole chain before the first task completes
+  auto flow = fc.session_control(Session::ExtendedSession)
+      .then([&](AsyncResult<bool> r) {
+        note_thread();
+        EXPECT_TRUE(r.is_success());
+        return fc.security_access(0x01, [](const std::vector<uint8_t>& seed) { return seed; });
+      })
+      .then([&](AsyncResult<bool> r) {
+        note_thread();
+        EXPECT_TRUE(r.is_success());
+        return fc.read_did(0xF190);
+      })
+      .then([&](AsyncResult<std::vector<uint8_t>> r) {
+        note_thread();
+        return fc.write_did(0xF190, r.value);
+      });
+  async.resume();
+
+  ASSERT_TRUE(flow.wait_for(milliseconds(2000)));
+  EXPECT_TRUE(flow.get().value);
+  EXPECT_FALSE(on_caller.load());
+  EXPECT_EQ(ecu.sids(), (std::vector<uint8_t>{0x10, 0x27, 0x27, 0x22, 0x2E}));
+}
+
+TEST(FutureTest, FanOutReadsWithWhenAll) {
+  EchoEcu ecu;
+  Client client(ecu);
+  AsyncClient async(client, 4);
+  FutureClient fc(async);
+
+  std::vector<Future<AsyncResult<std::vector<uint8_t>>>> reads;
+  for (uint16_t did : {0xF186, 0xF190, 0xBAD0, 0xF18C}) reads.push_back(fc.read_did(did));
+  auto results = when_all(std::move(reads)).get();
+
+  ASSERT_EQ(results.size(), 4u);
+  EXPECT_TRUE(results[0].is_success());
+  EXPECT_EQ(results[1].value, (std::vector<uint8_t>{0xF1, 0x90}));
+  EXPECT_EQ(results[2].status, AsyncStatus::Failed);
+  EXPECT_EQ(results[2].nrc, NegativeResponseCode::RequestOutOfRange);
+  EXPECT_TRUE(results[3].is_success());
+}
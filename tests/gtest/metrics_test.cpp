@@ -0,0 +1,280 @@
+/**
+ * @file metrics_test.cpp
+ * @brief Tests for exchange latency histograms (uds_metrics.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "isotp.hpp"
+#include "uds_metrics.hpp"
+#include <queue>
+#include <thread>
+#include <cstring>
+
+using namespace uds;
+using namespace uds::metrics;
+
+// Mock Transport without frame timing
+class MetricsMockTransport : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>&,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    if (delay_.count() > 0) std::this_thread::sleep_for(delay_);
+    if (!responses_.empty()) { rx = responses_.front(); responses_.pop(); return true; }
+    return false;
+  }
+
+  void queue_response(const std::vector<uint8_t>& r) { responses_.push(r); }
+  void set_delay(std::chrono::milliseconds d) { delay_ = d; }
+
+private:
+  Address addr_;
+  std::queue<std::vector<uint8_t>> responses_;
+  std::chrono::milliseconds delay_{0};
+};
+
+// Mock CAN driver that replays queued frames after a delay
+class MetricsMockCan : public isotp::ICanDriver {
+public:
+  bool send(const CANProtocol::CANFrame&) override { return true; }
+  bool recv(CANProtocol::CANFrame& f, std::chrono::milliseconds timeout) override {
+    if (frames_.empty()) { std::this_thread::sleep_for(timeout); return false; }
+    auto next = frames_.front(); frames_.pop();
+    std::this_thread::sleep_for(next.second);
+    f = next.first;
+    return true;
+  }
+
+  void queue_sf(uint32_t id, const std::vector<uint8_t>& sdu, std::chrono::milliseconds delay) {
+    CANProtocol::CANFrame f{}; f.id = id; f.dlc = 8;
+    f.data[0] = static_cast<uint8_t>(sdu.size());
+    std::memcpy(&f.data[1], sdu.data(), sdu.size());
+    frames_.push({f, delay});
+  }
+
+private:
+  std::queue<std::pair<CANProtocol::CANFrame, std::chrono::milliseconds>> frames_;
+};
+
+// ============================================================================
+// LatencyHistogram Tests
+// ============================================================================
+
+TEST(LatencyHistogramTest, SmallValuesHaveExactBuckets) {
+  for (uint64_t v = 0; v < 8; ++v) {
+    EXPECT_EQ(LatencyHistogram::bucket_index(v), v);
+    EXPECT_EQ(LatencyHistogram::bucket_lower_bound(v), v);
+    EXPECT_EQ(LatencyHistogram::bucket_upper_bound(v), v);
+  }
+}
+
+TEST(LatencyHistogramTest, BucketBoundsContainValue) {
+  for (uint64_t v : {8ull, 9ull, 15ull, 16ull, 17ull, 100ull, 1000ull, 12345ull,
+                     1000000ull, 4294967295ull}) {
+    const size_t idx = LatencyHistogram::bucket_index(v);
+    EXPECT_LE(LatencyHistogram::bucket_lower_bound(idx), v) << v;
+    EXPECT_GE(LatencyHistogram::bucket_upper_bound(idx), v) << v;
+    // Relative bucket width stays within 12.5%
+    const double width = static_cast<double>(LatencyHistogram::bucket_upper_bound(idx) -
+                                             LatencyHistogram::bucket_lower_bound(idx) + 1);
+    EXPECT_LE(width / static_cast<double>(LatencyHistogram::bucket_lower_bound(idx)), 0.125 + 1e-9);
+  }
+}
+
+TEST(LatencyHistogramTest, HugeValuesClampToLastBucket) {
+  EXPECT_EQ(LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::kBucketCount - 1);
+  EXPECT_EQ(LatencyHistogram::bucket_index(1ull << 40), LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogramTest, SnapshotStatistics) {
+  LatencyHistogram h;
+  for (uint64_t v = 1; v <= 100; ++v) h.record_us(v * 10);
+
+  auto snap = h.snapshot();
+  EXPECT_EQ(snap.count, 100u);
+  EXPECT_EQ(snap.min_us, 10u);
+  EXPECT_EQ(snap.max_us, 1000u);
+  EXPECT_DOUBLE_EQ(snap.mean_us(), 505.0);
+
+  const uint64_t p50 = snap.percentile_us(50.0);
+  EXPECT_GE(p50, 500u);
+  EXPECT_LE(p50, 500u * 1125 / 1000);
+  EXPECT_EQ(snap.percentile_us(100.0), 1000u);
+  EXPECT_EQ(snap.percentile_us(0.0), 10u);
+}
+
+TEST(LatencyHistogramTest, RecordNanoseconds) {
+  LatencyHistogram h;
+  h.record(std::chrono::microseconds(250));
+  h.record(std::chrono::nanoseconds(-5)); // negative clamps to 0
+  auto snap = h.snapshot();
+  EXPECT_EQ(snap.count, 2u);
+  EXPECT_EQ(snap.max_us, 250u);
+  EXPECT_EQ(snap.min_us, 0u);
+}
+
+TEST(LatencyHistogramTest, EmptyAndReset) {
+  LatencyHistogram h;
+  EXPECT_EQ(h.snapshot().percentile_us(99.0), 0u);
+  h.record_us(42);
+  h.reset();
+  auto snap = h.snapshot();
+  EXPECT_EQ(snap.count, 0u);
+  EXPECT_EQ(snap.min_us, 0u);
+  EXPECT_EQ(snap.max_us, 0u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecording) {
+  LatencyHistogram h;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&h]() {
+      for (uint64_t i = 0; i < 10000; ++i) h.record_us(i % 500);
+    });
+  }
+  for (auto& t : threads) t.join();
+  EXPECT_EQ(h.count(), 40000u);
+  EXPECT_EQ(h.snapshot().count, 40000u);
+}
+
+// ============================================================================
+// ExchangeMetrics Tests
+// ============================================================================
+
+TEST(ExchangeMetricsTest, RecordsPerServiceAndEcu) {
+  ExchangeMetrics m;
+  ExchangeSample s{};
+  s.total = std::chrono::milliseconds(5);
+  s.ok = true;
+
+  m.record(0x22, 0x7E0, s);
+  m.record(0x22, 0x7E1, s);
+  s.ok = false;
+  m.record(0x2E, 0x7E0, s);
+
+  ASSERT_NE(m.service(0x22), nullptr);
+  EXPECT_EQ(m.service(0x22)->exchanges(), 2u);
+  EXPECT_EQ(m.service(0x2E)->failures(), 1u);
+  EXPECT_EQ(m.service(0x31), nullptr);
+
+  ASSERT_NE(m.ecu(0x7E0), nullptr);
+  EXPECT_EQ(m.ecu(0x7E0)->exchanges(), 2u);
+  EXPECT_EQ(m.ecu(0x7E1)->exchanges(), 1u);
+  EXPECT_EQ(m.ecu(0x7E2), nullptr);
+
+  EXPECT_EQ(m.services(), (std::vector<uint8_t>{0x22, 0x2E}));
+  EXPECT_EQ(m.ecus().size(), 2u);
+
+  m.reset();
+  EXPECT_TRUE(m.services().empty());
+}
+
+TEST(ExchangeMetricsTest, EcuTableOverflowIsCounted) {
+  ExchangeMetrics m;
+  ExchangeSample s{};
+  for (uint32_t id = 0; id < ExchangeMetrics::kMaxEcus + 3; ++id) {
+    m.record(0x3E, 0x700 + id, s);
+  }
+  EXPECT_EQ(m.ecus().size(), ExchangeMetrics::kMaxEcus);
+  EXPECT_EQ(m.dropped_ecu_samples(), 3u);
+  EXPECT_EQ(m.service(0x3E)->exchanges(), ExchangeMetrics::kMaxEcus + 3);
+}
+
+TEST(ExchangeMetricsTest, ConcurrentFirstUse) {
+  ExchangeMetrics m;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&m]() {
+      ExchangeSample s{};
+      for (uint32_t i = 0; i < 1000; ++i) m.record(static_cast<uint8_t>(i % 4), i % 16, s);
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  uint64_t total = 0;
+  for (uint8_t sid : m.services()) total += m.service(sid)->exchanges();
+  EXPECT_EQ(total, 8000u);
+  EXPECT_EQ(m.ecus().size(), 16u);
+}
+
+TEST(ExchangeMetricsTest, FormatContainsServices) {
+  ExchangeMetrics m;
+  ExchangeSample s{};
+  s.total = std::chrono::milliseconds(3);
+  m.record(0x22, 0x7E0, s);
+  const std::string text = format_metrics(m);
+  EXPECT_NE(text.find("SID 0x22"), std::string::npos);
+  EXPECT_NE(text.find("ECU 0x7E0"), std::string::npos);
+}
+
+// ============================================================================
+// Client Instrumentation Tests
+// ============================================================================
+
+TEST(ClientMetricsTest, DisabledByDefault) {
+  MetricsMockTransport t;
+  Client client(t);
+  EXPECT_EQ(client.metrics(), nullptr);
+  t.queue_response({0x7E, 0x00});
+  EXPECT_TRUE(client.tester_present(false).ok);
+}
+
+TEST(ClientMetricsTest, RecordsExchangeOutcome) {
+  MetricsMockTransport t;
+  t.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(t);
+  ExchangeMetrics m;
+  client.set_metrics(&m);
+
+  t.set_delay(std::chrono::milliseconds(5));
+  t.queue_response({0x62, 0xF1, 0x90, 'V'});
+  EXPECT_TRUE(client.read_data_by_identifier(0xF190).ok);
+  t.queue_response({0x7F, 0x22, 0x31});
+  EXPECT_FALSE(client.read_data_by_identifier(0xF191).ok);
+  EXPECT_FALSE(client.read_data_by_identifier(0xF192).ok); // no response queued
+
+  const auto* svc = m.service(0x22);
+  ASSERT_NE(svc, nullptr);
+  EXPECT_EQ(svc->exchanges(), 3u);
+  EXPECT_EQ(svc->failures(), 2u);
+  EXPECT_EQ(svc->timeouts(), 1u);
+
+  // Without frame timing the wire time is attributed to the ECU
+  auto think = svc->phase(Phase::EcuThink).snapshot();
+  EXPECT_GE(think.min_us, 4000u);
+  EXPECT_EQ(svc->phase(Phase::Tx).snapshot().max_us, 0u);
+
+  ASSERT_NE(m.ecu(0x7E0), nullptr);
+  EXPECT_EQ(m.ecu(0x7E0)->exchanges(), 3u);
+}
+
+TEST(ClientMetricsTest, IsoTpPendingPhase) {
+  MetricsMockCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp);
+  ExchangeMetrics m;
+  client.set_metrics(&m);
+
+  can.queue_sf(0x7E8, {0x7F, 0x31, 0x78}, std::chrono::milliseconds(5));
+  can.queue_sf(0x7E8, {0x71, 0x01, 0xFF, 0x00}, std::chrono::milliseconds(20));
+
+  auto r = client.routine_control(RoutineAction::Start, 0xFF00);
+  EXPECT_TRUE(r.ok);
+
+  uds::TransferTiming tt{};
+  EXPECT_TRUE(tp.last_transfer_timing(tt));
+  EXPECT_TRUE(tt.valid);
+
+  const auto* svc = m.service(0x31);
+  ASSERT_NE(svc, nullptr);
+  EXPECT_EQ(svc->pending_responses(), 1u);
+  EXPECT_GE(svc->phase(Phase::EcuThink).snapshot().max_us, 4000u);
+  EXPECT_GE(svc->phase(Phase::Pending).snapshot().max_us, 15000u);
+  EXPECT_GE(svc->phase(Phase::Total).snapshot().max_us,
+            svc->phase(Phase::Pending).snapshot().max_us);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file periodic_data_test.cpp
+ * @brief Tests for ECU-pushed periodic data (0x2A) reception and demultiplexing
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "isotp.hpp"
+#include "uds_async.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::async;
+using std::chrono::milliseconds;
+
+// ECU streaming periodic identifiers once configured with 0x2A:
+// fast = every 2 ms with a changing value, medium = every 10 ms, constant
+class StreamingEcu : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(tx);
+    if (tx[0] != 0x2A || tx.size() < 3) { rx = {0x7F, tx[0], 0x11}; return true; }
+    const auto mode = static_cast<PeriodicTransmissionMode>(tx[1]);
+    for (size_t i = 2; i < tx.size(); ++i) {
+      if (mode == PeriodicTransmissionMode::StopSending) streams_.erase(tx[i]);
+      else streams_[tx[i]] = Stream{mode, std::chrono::steady_clock::now(), 0};
+    }
+    rx = {0x6A};
+    return true;
+  }
+
+  bool recv_unsolicited(std::vector<uint8_t>& rx, std::chrono::milliseconds timeout) override {
+    const auto end = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = std::chrono::steady_clock::now();
+        for (auto& [pdid, stream] : streams_) {
+          if (now < stream.next) continue;
+          const bool fast = stream.mode == PeriodicTransmissionMode::SendAtFastRate;
+          stream.next = now + (fast ? milliseconds(2) : milliseconds(10));
+          rx = {0x6A, pdid, static_cast<uint8_t>(fast ? stream.count++ : 0x55)};
+          return true;
+        }
+      }
+      if (std::chrono::steady_clock::now() >= end) return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  std::vector<std::vector<uint8_t>> requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+  size_t streams() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+  }
+
+private:
+  struct Stream {
+    PeriodicTransmissionMode mode;
+    std::chrono::steady_clock::time_point next;
+    uint8_t count;
+  };
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  std::map<uint8_t, Stream> streams_;
+  std::vector<std::vector<uint8_t>> requests_;
+};
+
+using test::wait_until;
+
+TEST(PeriodicDataTest, MonitorDemultiplexesPushedIdentifiers) {
+  StreamingEcu ecu;
+  Client client(ecu);
+  PeriodicMonitor monitor(client);
+
+  std::atomic<int> fast_changes{0};
+  std::atomic<int> medium_changes{0};
+  std::atomic<uint16_t> fast_did{0};
+  monitor.add_periodic(0x01, PeriodicTransmissionMode::SendAtFastRate,
+                       [&](uint16_t did, const std::vector<uint8_t>& v) {
+                         fast_did = did;
+                         if (v.size() == 1) fast_changes++;
+                       });
+  monitor.add_periodic(0x02, PeriodicTransmissionMode::SendAtMediumRate,
+                       [&](uint16_t, const std::vector<uint8_t>&) { medium_changes++; });
+  monitor.start();
+
+  ASSERT_TRUE(wait_until([&] { return fast_changes.load() >= 20; }));
+  ASSERT_TRUE(wait_until([&] {
+    auto stats = monitor.periodic_stats(0x02);
+    return stats && stats->samples >= 3;
+  }));
+  monitor.stop();
+
+  EXPECT_EQ(fast_did.load(), 0xF201);
+  EXPECT_EQ(medium_changes.load(), 1);  // constant value: first sample only
+  auto fast = monitor.periodic_stats(0x01);
+  ASSERT_TRUE(fast.has_value());
+  EXPECT_GE(fast->samples, 20u);
+  EXPECT_GT(fast->rate_hz, 0.0);
+  EXPECT_GE(fast->max_interval, fast->mean_interval);
+  EXPECT_EQ(monitor.get_current_value(0xF202), (std::vector<uint8_t>{0x55}));
+
+  // One start request per rate, one stop for both; no polling requests
+  auto requests = ecu.requests();
+  ASSERT_EQ(requests.size(), 3u);
+  EXPECT_EQ(requests.back(), (std::vector<uint8_t>{0x2A, 0x04, 0x01, 0x02}));
+  EXPECT_EQ(ecu.streams(), 0u);
+}
+
+TEST(PeriodicDataTest, RemovePeriodicStopsStream) {
+  StreamingEcu ecu;
+  Client client(ecu);
+  PeriodicMonitor monitor(client);
+  monitor.start();
+
+  std::atomic<int> samples{0};
+  monitor.add_periodic(0x07, PeriodicTransmissionMode::SendAtFastRate,
+                       [&](uint16_t, const std::vector<uint8_t>&) { samples++; });
+  ASSERT_TRUE(wait_until([&] { return samples.load() >= 3; }));
+  monitor.remove_periodic(0x07);
+  EXPECT_EQ(ecu.streams(), 0u);
+  EXPECT_FALSE(monitor.periodic_stats(0x07).has_value());
+  monitor.stop();
+}
+
+// CAN driver whose ECU pushes a periodic frame right before each response
+class InterleavingCan : public isotp::ICanDriver {
+public:
+  bool send(const CANProtocol::CANFrame& f) override {
+    CANProtocol::CANFrame p; p.id = 0x7E8; p.dlc = 8;
+    p.data[0] = 0x03; p.data[1] = 0x6A; p.data[2] = 0x05; p.data[3] = 0x99;
+    rx_.push_back(p);
+
+    const uint8_t len = f.data[0] & 0x0F;
+    CANProtocol::CANFrame r; r.id = 0x7E8; r.dlc = 8;
+    r.data[0] = len;
+    r.data[1] = static_cast<uint8_t>(f.data[1] + 0x40);
+    std::memcpy(&r.data[2], &f.data[2], len - 1);
+    rx_.push_back(r);
+    return true;
+  }
+  bool recv(CANProtocol::CANFrame& f, std::chrono::milliseconds) override {
+    if (rx_.empty()) return false;
+    f = rx_.front(); rx_.pop_front();
+    return true;
+  }
+private:
+  std::deque<CANProtocol::CANFrame> rx_;
+};
+
+TEST(PeriodicDataTest, FramesInterleavedWithResponsesAreParked) {
+  InterleavingCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp);
+
+  auto r = client.read_data_by_identifier(0xF190);
+  ASSERT_TRUE(r.ok);
+  EXPECT_EQ(r.payload, (std::vector<uint8_t>{0xF1, 0x90}));
+
+  PeriodicDataMessage msg;
+  ASSERT_TRUE(client.receive_periodic_data(msg, milliseconds(0)));
+  EXPECT_EQ(msg.identifier, 0x05);
+  EXPECT_EQ(msg.data, (std::vector<uint8_t>{0x99}));
+  std::vector<uint8_t> pdu;
+  EXPECT_FALSE(client.pop_unsolicited(0x6A, pdu));
+}
@@ -0,0 +1,184 @@
+/**
+ * @file prefetch_test.cpp
+ * @brief Tests for access prediction and predictive prefetch in CachedClient (uds_cache.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_cache.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::cache;
+
+// ECU answering single and multi-DID ReadDataByIdentifier with one data
+// byte (the DID's low byte). Requests can be held until released.
+class GatedDidEcu : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    requests_++;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return open_; });
+    }
+    rx = {0x62};
+    for (size_t i = 1; i + 1 < tx.size(); i += 2) {
+      rx.push_back(tx[i]);
+      rx.push_back(tx[i + 1]);
+      rx.push_back(tx[i + 1]);
+    }
+    return true;
+  }
+
+  void set_open(bool open) {
+    { std::lock_guard<std::mutex> lock(mutex_); open_ = open; }
+    cv_.notify_all();
+  }
+  int requests() const { return requests_.load(); }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = true;
+  std::atomic<int> requests_{0};
+};
+
+using test::wait_until;
+
+// Read the sequence A, B, C `rounds` times, starting cold each round
+static void train(CachedClient& cached, int rounds) {
+  for (int r = 0; r < rounds; ++r) {
+    cached.cache().clear();
+    for (uint16_t did : {0x0A00, 0x0B00, 0x0C00}) {
+      ASSERT_TRUE(cached.read_did(did).ok);
+    }
+  }
+}
+
+TEST(PrefetchTest, PredictorLearnsTransitions) {
+  AccessPredictor predictor;
+  for (int i = 0; i < 4; ++i) {
+    predictor.observe(0x0A00);
+    predictor.observe(0x0B00);
+    predictor.observe(0x0C00);
+  }
+  predictor.observe(0x0A00);
+  predictor.observe(0x0D00);  // one-off detour
+
+  EXPECT_EQ(predictor.predict(0x0A00, 4, 0.3, 2), (std::vector<uint16_t>{0x0B00}));
+  EXPECT_EQ(predictor.predict(0x0A00, 4, 0.0, 1), (std::vector<uint16_t>{0x0B00, 0x0D00}));
+  EXPECT_EQ(predictor.predict(0x0B00, 4, 0.3, 2), (std::vector<uint16_t>{0x0C00}));
+  EXPECT_TRUE(predictor.predict(0x0E00, 4, 0.0, 1).empty());
+  EXPECT_EQ(predictor.tracked(), 3u);
+
+  predictor.reset();
+  EXPECT_EQ(predictor.tracked(), 0u);
+}
+
+TEST(PrefetchTest, PredictorKeepsFrequentSuccessors) {
+  AccessPredictor predictor;
+  for (int i = 0; i < 10; ++i) {
+    predictor.observe(0x0100);
+    predictor.observe(0x0200);
+  }
+  // Many one-off successors cannot push out the frequent one
+  for (uint16_t d = 0; d < 50; ++d) {
+    predictor.observe(0x0100);
+    predictor.observe(static_cast<uint16_t>(0x1000 + d));
+  }
+  EXPECT_EQ(predictor.predict(0x0100, 1, 0.0, 1).front(), 0x0200);
+}
+
+TEST(PrefetchTest, ReadPrefetchesLikelyNextDid) {
+  GatedDidEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+  train(cached, 2);  // learning works with prefetch disabled
+  cached.cache().clear();
+  cached.cache().reset_stats();
+
+  PrefetchConfig config;
+  config.enabled = true;
+  cached.set_prefetch(config);
+
+  ASSERT_TRUE(cached.read_did(0x0A00).ok);
+  ASSERT_TRUE(wait_until([&] { return cached.cache().contains(0x0B00); }));
+
+  // Served from the cache (reading B may already prefetch C on the bus)
+  const uint64_t misses = cached.cache().stats().misses;
+  auto b = cached.read_did(0x0B00);
+  ASSERT_TRUE(b.ok);
+  EXPECT_EQ(b.payload, (std::vector<uint8_t>{0x0B, 0x00, 0x00}));
+  EXPECT_EQ(cached.cache().stats().misses, misses);
+
+  // Reading B in turn prefetches C
+  ASSERT_TRUE(wait_until([&] { return cached.cache().contains(0x0C00); }));
+  auto stats = cached.cache().stats();
+  EXPECT_EQ(stats.prefetches, 2u);
+  EXPECT_EQ(stats.prefetch_hits, 1u);
+  EXPECT_DOUBLE_EQ(stats.prefetch_hit_rate(), 0.5);
+}
+
+TEST(PrefetchTest, WaitsForIdleBus) {
+  GatedDidEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+  train(cached, 2);
+  cached.cache().invalidate(0x0B00);
+  PrefetchConfig config;
+  config.enabled = true;
+  cached.set_prefetch(config);
+
+  // Occupy the bus with a foreground exchange
+  ecu.set_open(false);
+  const int before = ecu.requests() + 1;
+  std::thread busy([&] { client.read_data_by_identifier(0x0F00); });
+  ASSERT_TRUE(wait_until([&] { return ecu.requests() == before; }));
+
+  ASSERT_TRUE(cached.read_did(0x0A00).ok);  // cache hit, B predicted
+  EXPECT_EQ(cached.pending_prefetches(), 1u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_EQ(ecu.requests(), before);
+
+  ecu.set_open(true);
+  busy.join();
+  ASSERT_TRUE(wait_until([&] { return cached.cache().contains(0x0B00); }));
+  EXPECT_EQ(cached.pending_prefetches(), 0u);
+}
+
+TEST(PrefetchTest, BudgetLimitsPrefetchRequests) {
+  GatedDidEcu ecu;
+  Client client(ecu);
+  CachedClient cached(client);
+  train(cached, 2);
+
+  PrefetchConfig config;
+  config.enabled = true;
+  config.burst = 1.0;
+  config.requests_per_second = 0.01;
+  cached.set_prefetch(config);
+
+  cached.cache().clear();
+  ASSERT_TRUE(cached.read_did(0x0A00).ok);
+  ASSERT_TRUE(wait_until([&] { return cached.cache().contains(0x0B00); }));
+  ASSERT_TRUE(cached.read_did(0x0B00).ok);
+
+  // The single token is spent: C stays queued
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_FALSE(cached.cache().contains(0x0C00));
+  EXPECT_EQ(cached.pending_prefetches(), 1u);
+
+  config.enabled = false;
+  cached.set_prefetch(config);
+  EXPECT_EQ(cached.pending_prefetches(), 0u);
+}
@@ -0,0 +1,182 @@
+/**
+ * @file stale_revalidate_test.cpp
+ * @brief Tests for stale-while-revalidate reads in CachedClient (uds_cache.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds_cache.hpp"
+#include "test_util.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::cache;
+
+// Transport answering ReadDataByIdentifier with a per-request counter byte.
+// Requests can be held until released by the test.
+class CountingTransport : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    const uint8_t n = static_cast<uint8_t>(requests_.fetch_add(1) + 1);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return open_; });
+    }
+    rx = {static_cast<uint8_t>(tx[0] + 0x40)};
+    rx.insert(rx.end(), tx.begin() + 1, tx.end());
+    rx.push_back(n);
+    return true;
+  }
+
+  void set_open(bool open) {
+    { std::lock_guard<std::mutex> lock(mutex_); open_ = open; }
+    cv_.notify_all();
+  }
+  int requests() const { return requests_.load(); }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = true;
+  std::atomic<int> requests_{0};
+};
+
+using test::wait_until;
+
+static CacheConfig swr_config(std::chrono::milliseconds ttl, std::chrono::milliseconds max_staleness) {
+  CacheConfig config;
+  config.default_ttl = ttl;
+  config.max_staleness = max_staleness;
+  return config;
+}
+
+TEST(StaleRevalidateTest, StaleReadIsServedAndRefreshedOnce) {
+  CountingTransport transport;
+  Client client(transport);
+  CachedClient cached(client, swr_config(std::chrono::milliseconds(20), std::chrono::seconds(10)));
+  cached.cache().set_did_policy(0x0100, ExpirationPolicy::StaleWhileRevalidate);
+
+  auto first = cached.read_did(0x0100);
+  ASSERT_TRUE(first.ok);
+  EXPECT_EQ(first.payload.back(), 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+  // Past TTL: old value at once, a single refresh behind it
+  transport.set_open(false);
+  for (int i = 0; i < 5; ++i) {
+    auto r = cached.read_did(0x0100);
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(r.payload.back(), 1);
+  }
+  EXPECT_EQ(cached.pending_refreshes(), 1u);
+  EXPECT_EQ(cached.revalidation_stats().stale_served, 5u);
+
+  transport.set_open(true);
+  ASSERT_TRUE(wait_until([&] { return cached.pending_refreshes() == 0; }));
+  EXPECT_EQ(transport.requests(), 2);
+  EXPECT_EQ(cached.read_did(0x0100).payload.back(), 2);
+
+  auto stats = cached.revalidation_stats();
+  EXPECT_EQ(stats.refreshes, 1u);
+  EXPECT_EQ(stats.refresh_failures, 0u);
+  EXPECT_EQ(stats.stale_served, 5u);
+}
+
+TEST(StaleRevalidateTest, PastMaxStalenessBlocksOnTheBus) {
+  CountingTransport transport;
+  Client client(transport);
+  CachedClient cached(client, swr_config(std::chrono::milliseconds(5), std::chrono::milliseconds(5)));
+  cached.cache().set_did_policy(0x0100, ExpirationPolicy::StaleWhileRevalidate);
+
+  ASSERT_TRUE(cached.read_did(0x0100).ok);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  auto r = cached.read_did(0x0100);
+  ASSERT_TRUE(r.ok);
+  EXPECT_EQ(r.payload.back(), 2);
+  EXPECT_EQ(cached.revalidation_stats().stale_served, 0u);
+  EXPECT_EQ(cached.pending_refreshes(), 0u);
+}
+
+TEST(StaleRevalidateTest, PolicyIsPerDid) {
+  CountingTransport transport;
+  Client client(transport);
+  CachedClient cached(client, swr_config(std::chrono::milliseconds(5), std::chrono::seconds(10)));
+  cached.cache().set_did_policy(0x0100, ExpirationPolicy::StaleWhileRevalidate);
+
+  ASSERT_TRUE(cached.read_did(0x0100).ok);
+  ASSERT_TRUE(cached.read_did(0x0200).ok);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Plain TTL entry: expired, read synchronously
+  EXPECT_EQ(cached.read_did(0x0200).payload.back(), 3);
+  EXPECT_EQ(cached.revalidation_stats().stale_served, 0u);
+
+  auto both = cached.read_dids({0x0100, 0x0200});
+  EXPECT_EQ(both.size(), 2u);
+  EXPECT_EQ(both[0x0100].back(), 1);
+  EXPECT_EQ(cached.revalidation_stats().stale_served, 1u);
+  EXPECT_FALSE(cached.cache().contains(0x0100));  // stale is not "contained"
+}
+
+TEST(StaleRevalidateTest, WriteDiscardsInFlightRefresh) {
+  CountingTransport transport;
+  Client client(transport);
+  CachedClient cached(client, swr_config(std::chrono::milliseconds(5), std::chrono::seconds(10)));
+  cached.cache().set_did_policy(0x0100, ExpirationPolicy::StaleWhileRevalidate);
+
+  ASSERT_TRUE(cached.read_did(0x0100).ok);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  transport.set_open(false);
+  ASSERT_TRUE(cached.read_did(0x0100).ok);
+  ASSERT_TRUE(wait_until([&] { return transport.requests() == 2; }));
+
+  // The write queues behind the refresh, but has already bumped the epoch
+  std::thread writer([&] { cached.write_did(0x0100, {0xAB}); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  transport.set_open(true);
+  writer.join();
+  ASSERT_TRUE(wait_until([&] { return cached.pending_refreshes() == 0; }));
+
+  EXPECT_EQ(cached.revalidation_stats().refreshes_dropped, 1u);
+  EXPECT_EQ(*cached.cache().get(0x0100), (std::vector<uint8_t>{0xAB}));
+}
+
+TEST(StaleRevalidateTest, DestructorWaitsForRunningRefresh) {
+  CountingTransport transport;
+  Client client(transport);
+  std::thread opener;
+  {
+    CachedClient cached(client, swr_config(std::chrono::milliseconds(5), std::chrono::seconds(10)));
+    cached.cache().set_did_policy(0x0100, ExpirationPolicy::StaleWhileRevalidate);
+    cached.cache().set_did_policy(0x0200, ExpirationPolicy::StaleWhileRevalidate);
+    ASSERT_TRUE(cached.read_did(0x0100).ok);
+    ASSERT_TRUE(cached.read_did(0x0200).ok);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    transport.set_open(false);
+    ASSERT_TRUE(cached.read_did(0x0100).ok);
+    ASSERT_TRUE(cached.read_did(0x0200).ok);
+    ASSERT_TRUE(wait_until([&] { return transport.requests() == 3; }));
+    EXPECT_EQ(cached.pending_refreshes(), 2u);
+    // Release the bus while the destructor is waiting
+    opener = std::thread([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      transport.set_open(true);
+    });
+  }
+  opener.join();
+  // The queued refresh of 0x0200 was dropped, not sent
+  EXPECT_EQ(transport.requests(), 3);
+  EXPECT_TRUE(client.transport_idle());
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_util.hpp
+ * @brief Helpers and mocks shared by the gtest suites
+ */
+
+#ifndef TEST_UTIL_HPP
+#define TEST_UTIL_HPP
+
+#include "ecu_programming.hpp"
+#include "uds_block.hpp"
+#include "uds_compression.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace uds {
+namespace detail {
+// Exchanges waiting for the transport behind the one running (uds.cpp)
+size_t queued_exchanges(const Transport& transport);
+} // namespace detail
+} // namespace uds
+
+namespace test {
+
+// Poll pred every millisecond until it holds or timeout passes; returns its
+// final value
+inline bool wait_until(const std::function<bool()>& pred,
+                       std::chrono::milliseconds timeout = std::chrono::milliseconds(3000)) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return pred();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Programming ECU with a flat memory starting at `base`, for the suites that
+// flash or read back images. Addresses and sizes come from the requests'
+// [addressAndLengthFormatIdentifier][address][size] records:
+//  - 0x31 EraseMemory fills the range with 0xFF; crc_routine_ (if set)
+//    answers with the CRC32 of the range
+//  - 0x34/0x35 move the cursor to the address and offer max_block_
+//  - 0x36 with data writes at the cursor, without data reads from it;
+//    LZF streams (compressionMethod 1) are expanded at 0x37 instead
+//  - 0x37 is refused (NRC 0x72) while fail_exits_ > 0
+// Any other request gets a positive response echoing its subfunction.
+class FlashEcu : public uds::Transport {
+public:
+  using Frames = std::vector<std::vector<uint8_t>>;
+  using Range = std::pair<uint32_t, uint32_t>;
+
+  explicit FlashEcu(std::vector<uint8_t> memory = {}, uint32_t base = 0)
+      : memory_(std::move(memory)), base_(base) {}
+
+  void set_address(const uds::Address& addr) override { addr_ = addr; }
+  const uds::Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    requests_.push_back(tx);
+    Range range;
+    switch (tx[0]) {
+      case 0x10:
+        rx = {0x50, tx[1], 0x00, 0x32, 0x01, 0xF4};
+        return true;
+      case 0x31: {
+        rx = {0x71, tx[1], tx[2], tx[3]};
+        const uds::RoutineId rid = static_cast<uds::RoutineId>(tx[2] << 8 | tx[3]);
+        const bool erase = rid == uds::ProgrammingRoutineId::EraseMemory;
+        if (!(erase || (crc_routine_ != 0 && rid == crc_routine_)) || !parse_range(tx, 4, range)) {
+          return true;
+        }
+        if (range.first < base_ || range.first - base_ + range.second > memory_.size()) {
+          rx = {0x7F, 0x31, 0x31};
+          return true;
+        }
+        const auto begin = memory_.begin() + (range.first - base_);
+        if (erase) {
+          erases_.push_back(range);
+          std::fill_n(begin, range.second, 0xFF);
+        } else {
+          ++crc_requests_;
+          const uint32_t crc = uds::block::calculate_crc32(std::vector<uint8_t>(begin, begin + range.second));
+          rx.insert(rx.end(), {0x00, static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+                               static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)});
+        }
+        return true;
+      }
+      case 0x34:
+      case 0x35:
+        if (!parse_range(tx, 2, range) || range.first < base_) {
+          rx = {0x7F, tx[0], 0x31};
+          return true;
+        }
+        downloads_.push_back(range);
+        dfi_ = tx[1];
+        cursor_ = range.first - base_;
+        memory_size_ = range.second;
+        compressed_.clear();
+        rx = {static_cast<uint8_t>(tx[0] + 0x40), 0x20,
+              static_cast<uint8_t>(max_block_ >> 8), static_cast<uint8_t>(max_block_ & 0xFF)};
+        return true;
+      case 0x36:
+        ++transfers_;
+        rx = {0x76, tx[1]};
+        if (tx.size() > 2) {
+          bytes_received_ += tx.size() - 2;
+          if (dfi_ >> 4 == 0x1) {
+            compressed_.insert(compressed_.end(), tx.begin() + 2, tx.end());
+          } else {
+            write(tx.data() + 2, tx.size() - 2);
+          }
+        } else {
+          const size_t left = cursor_ < memory_.size() ? memory_.size() - cursor_ : 0;
+          const size_t n = std::min<size_t>(max_block_ - 2, left);
+          if (n > 0) rx.insert(rx.end(), memory_.begin() + cursor_, memory_.begin() + cursor_ + n);
+          cursor_ += n;
+        }
+        return true;
+      case 0x37:
+        if (fail_exits_ > 0) {
+          --fail_exits_;
+          rx = {0x7F, 0x37, 0x72};
+          return true;
+        }
+        if (dfi_ >> 4 == 0x1) {
+          std::vector<uint8_t> data;
+          if (!uds::compression::LzfCompressor().decompress(compressed_.data(), compressed_.size(),
+                                                            memory_size_, data)) {
+            rx = {0x7F, 0x37, 0x72};
+            return true;
+          }
+          write(data.data(), data.size());
+          compressed_.clear();
+        }
+        rx = {0x77};
+        return true;
+      default:
+        rx = {static_cast<uint8_t>(tx[0] + 0x40)};
+        if (tx.size() > 1) rx.push_back(tx[1]);
+        return true;
+    }
+  }
+
+  // Requests received with this SID
+  Frames requests_with(uint8_t sid) const {
+    Frames out;
+    std::copy_if(requests_.begin(), requests_.end(), std::back_inserter(out),
+                 [sid](const std::vector<uint8_t>& r) { return r[0] == sid; });
+    return out;
+  }
+
+  bool received(uint8_t sid, uint8_t sub) const {
+    return std::any_of(requests_.begin(), requests_.end(), [&](const std::vector<uint8_t>& r) {
+      return r.size() > 1 && r[0] == sid && r[1] == sub;
+    });
+  }
+
+  std::vector<uint8_t> memory_;
+  Frames requests_;
+  std::vector<Range> erases_;
+  std::vector<Range> downloads_;     // RequestDownload/RequestUpload ranges
+  size_t transfers_ = 0;             // TransferData requests
+  size_t bytes_received_ = 0;        // TransferData payload bytes as sent
+  size_t crc_requests_ = 0;
+  uint16_t max_block_ = 0x0102;      // maxNumberOfBlockLength offered
+  uds::RoutineId crc_routine_ = 0;   // 0: no CRC routine
+  int fail_exits_ = 0;               // Refuse this many RequestTransferExits
+
+private:
+  // [ALFI][address][size] record starting at tx[at]
+  static bool parse_range(const std::vector<uint8_t>& tx, size_t at, Range& range) {
+    if (tx.size() <= at) return false;
+    const size_t address_bytes = tx[at] & 0x0F;
+    const size_t size_bytes = tx[at] >> 4;
+    if (tx.size() < at + 1 + address_bytes + size_bytes) return false;
+    range = {0, 0};
+    for (size_t i = 0; i < address_bytes; ++i) range.first = range.first << 8 | tx[at + 1 + i];
+    for (size_t i = 0; i < size_bytes; ++i) {
+      range.second = range.second << 8 | tx[at + 1 + address_bytes + i];
+    }
+    return true;
+  }
+
+  void write(const uint8_t* data, size_t size) {
+    if (memory_.size() < cursor_ + size) memory_.resize(cursor_ + size);
+    std::copy(data, data + size, memory_.begin() + cursor_);
+    cursor_ += size;
+  }
+
+  uds::Address addr_{uds::AddressType::Physical, 0x7E0, 0x7E8};
+  uint32_t base_;
+  uint8_t dfi_ = 0;
+  size_t cursor_ = 0;
+  size_t memory_size_ = 0;
+  std::vector<uint8_t> compressed_;
+};
+
+} // namespace test
+
+#endif // TEST_UTIL_HPP
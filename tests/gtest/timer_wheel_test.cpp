@@ -0,0 +1,178 @@
+/**
+ * @file timer_wheel_test.cpp
+ * @brief Tests for the timer wheel (uds_timer_wheel.cpp) and PeriodicMonitor
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "uds_async.hpp"
+#include "uds_timer_wheel.hpp"
+#include "test_util.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::timer;
+using std::chrono::milliseconds;
+
+TEST(TimerWheelTest, FiresInOrderOfExpiry) {
+  const auto t0 = TimerWheel::Clock::now();
+  TimerWheel wheel(milliseconds(1), 8, t0);
+  wheel.schedule(t0 + milliseconds(5), 5);
+  wheel.schedule(t0 + milliseconds(2), 2);
+  wheel.schedule(t0 + milliseconds(30), 30);  // beyond one rotation
+  EXPECT_EQ(wheel.size(), 3u);
+
+  std::vector<uint64_t> fired;
+  EXPECT_EQ(wheel.advance(t0 + milliseconds(1), fired), 0u);
+  EXPECT_EQ(wheel.advance(t0 + milliseconds(5), fired), 2u);
+  EXPECT_EQ(fired, (std::vector<uint64_t>{2, 5}));
+
+  // Its slot (30 % 8) is passed at ticks 6, 14 and 22 without firing it
+  fired.clear();
+  EXPECT_EQ(wheel.advance(t0 + milliseconds(29), fired), 0u);
+  ASSERT_TRUE(wheel.next_wakeup().has_value());
+  EXPECT_EQ(*wheel.next_wakeup(), t0 + milliseconds(30));
+  EXPECT_EQ(wheel.advance(t0 + milliseconds(30), fired), 1u);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_FALSE(wheel.next_wakeup().has_value());
+}
+
+TEST(TimerWheelTest, LargeJumpFiresEverythingDue) {
+  const auto t0 = TimerWheel::Clock::now();
+  TimerWheel wheel(milliseconds(1), 16, t0);
+  for (uint64_t i = 0; i < 100; ++i) {
+    wheel.schedule(t0 + milliseconds(i * 7), i);
+  }
+  std::vector<uint64_t> fired;
+  EXPECT_EQ(wheel.advance(t0 + milliseconds(350), fired), 51u);
+  EXPECT_EQ(wheel.size(), 49u);
+}
+
+TEST(TimerWheelTest, CancelIsO1AndStaleIdsAreRejected) {
+  const auto t0 = TimerWheel::Clock::now();
+  TimerWheel wheel(milliseconds(1), 8, t0);
+  const TimerId a = wheel.schedule(t0 + milliseconds(3), 1);
+  const TimerId b = wheel.schedule(t0 + milliseconds(3), 2);
+  EXPECT_TRUE(wheel.cancel(a));
+  EXPECT_FALSE(wheel.cancel(a));
+  EXPECT_FALSE(wheel.cancel(kInvalidTimer));
+
+  std::vector<uint64_t> fired;
+  wheel.advance(t0 + milliseconds(3), fired);
+  EXPECT_EQ(fired, (std::vector<uint64_t>{2}));
+  EXPECT_FALSE(wheel.cancel(b));
+
+  // Node reuse must not revive the old ids
+  const TimerId c = wheel.schedule(t0 + milliseconds(10), 3);
+  EXPECT_NE(c, a);
+  EXPECT_NE(c, b);
+  EXPECT_FALSE(wheel.cancel(b));
+  EXPECT_TRUE(wheel.cancel(c));
+}
+
+TEST(TimerWheelTest, PastExpiryFiresOnNextAdvance) {
+  const auto t0 = TimerWheel::Clock::now();
+  TimerWheel wheel(milliseconds(1), 8, t0);
+  std::vector<uint64_t> fired;
+  wheel.advance(t0 + milliseconds(10), fired);
+  wheel.schedule(t0, 7);
+  wheel.advance(t0 + milliseconds(11), fired);
+  EXPECT_EQ(fired, (std::vector<uint64_t>{7}));
+}
+
+// ECU answering single- and multi-DID reads with a 1-byte counter per DID
+class CountingEcu : public Transport {
+public:
+  void set_address(const Address& addr) override { addr_ = addr; }
+  const Address& address() const override { return addr_; }
+
+  bool request_response(const std::vector<uint8_t>& tx,
+                        std::vector<uint8_t>& rx,
+                        std::chrono::milliseconds) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_++;
+    max_dids_ = std::max(max_dids_, (tx.size() - 1) / 2);
+    rx = {0x62};
+    for (size_t i = 1; i + 1 < tx.size(); i += 2) {
+      rx.push_back(tx[i]);
+      rx.push_back(tx[i + 1]);
+      rx.push_back(counter_++);
+    }
+    return true;
+  }
+
+  int requests() { std::lock_guard<std::mutex> lock(mutex_); return requests_; }
+  size_t max_dids() { std::lock_guard<std::mutex> lock(mutex_); return max_dids_; }
+
+private:
+  Address addr_{AddressType::Physical, 0x7E0, 0x7E8};
+  std::mutex mutex_;
+  int requests_ = 0;
+  size_t max_dids_ = 0;
+  uint8_t counter_ = 0;
+};
+
+using test::wait_until;
+
+TEST(PeriodicMonitorTest, DueDidsShareMultiDidRequests) {
+  CountingEcu ecu;
+  Client client(ecu);
+  async::PeriodicMonitor monitor(client);
+  monitor.set_max_dids_per_request(4);
+
+  std::atomic<int> changes{0};
+  for (uint16_t did = 0x0100; did < 0x0108; ++did) {
+    monitor.add_did(did, milliseconds(20), [&](uint16_t, const std::vector<uint8_t>& v) {
+      if (v.size() == 3) changes++;
+    });
+  }
+  monitor.start();
+  ASSERT_TRUE(wait_until([&] { return changes.load() >= 24; }));
+  monitor.stop();
+
+  EXPECT_EQ(ecu.max_dids(), 4u);
+  // Every poll round of 8 DIDs takes two requests
+  EXPECT_LE(ecu.requests(), changes.load() / 4 + 2);
+  EXPECT_TRUE(monitor.get_current_value(0x0100).has_value());
+}
+
+TEST(PeriodicMonitorTest, CallbackMayRemoveDids) {
+  CountingEcu ecu;
+  Client client(ecu);
+  async::PeriodicMonitor monitor(client);
+
+  std::atomic<int> calls{0};
+  monitor.add_did(0x0200, milliseconds(5), [&](uint16_t did, const std::vector<uint8_t>&) {
+    calls++;
+    monitor.remove_did(did);
+  });
+  monitor.start();
+  ASSERT_TRUE(wait_until([&] { return calls.load() == 1; }));
+  std::this_thread::sleep_for(milliseconds(30));
+  monitor.stop();
+
+  EXPECT_EQ(calls.load(), 1);
+  EXPECT_FALSE(monitor.get_current_value(0x0200).has_value());
+}
+
+TEST(PeriodicMonitorTest, ConcurrentAddRemoveIsSafe) {
+  CountingEcu ecu;
+  Client client(ecu);
+  async::PeriodicMonitor monitor(client);
+  monitor.start();
+
+  std::thread churn([&]() {
+    for (int i = 0; i < 500; ++i) {
+      const uint16_t did = static_cast<uint16_t>(0x0300 + (i % 16));
+      if (i % 3 == 2) monitor.remove_did(did);
+      else monitor.add_did(did, milliseconds(1 + i % 4), nullptr);
+    }
+  });
+  churn.join();
+  std::this_thread::sleep_for(milliseconds(20));
+  monitor.stop();
+  EXPECT_GT(monitor.read_requests(), 0u);
+}
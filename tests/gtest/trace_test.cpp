@@ -0,0 +1,177 @@
+/**
+ * @file trace_test.cpp
+ * @brief Tests for CAN/UDS trace capture (uds_trace.cpp)
+ */
+
+#include <gtest/gtest.h>
+#include "uds.hpp"
+#include "isotp.hpp"
+#include "uds_trace.hpp"
+#include "ecu_programming.hpp"
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <regex>
+#include <thread>
+
+using namespace uds;
+using namespace uds::trace;
+
+// CAN driver answering single-frame requests with a positive single frame
+class TraceEchoCan : public isotp::ICanDriver {
+public:
+  bool send(const CANProtocol::CANFrame& f) override {
+    const uint8_t len = f.data[0] & 0x0F;
+    CANProtocol::CANFrame r; r.id = 0x7E8; r.dlc = 8;
+    r.data[0] = len;
+    r.data[1] = static_cast<uint8_t>(f.data[1] + 0x40);
+    std::memcpy(&r.data[2], &f.data[2], len - 1);
+    rx_.push_back(r);
+    return true;
+  }
+  bool recv(CANProtocol::CANFrame& f, std::chrono::milliseconds) override {
+    if (rx_.empty()) return false;
+    f = rx_.front(); rx_.pop_front();
+    return true;
+  }
+private:
+  std::deque<CANProtocol::CANFrame> rx_;
+};
+
+class TraceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    Tracer::instance().set_enabled(true);
+    Tracer::instance().clear();
+  }
+  void TearDown() override {
+    Tracer::instance().set_enabled(true);
+    std::remove(path_.c_str());
+  }
+  std::string path_ = "trace_test.udstrace";
+};
+
+TEST_F(TraceTest, RingKeepsMostRecentRecords) {
+  TraceRing ring(5, 3);  // rounded up to 8
+  EXPECT_EQ(ring.capacity(), 8u);
+
+  for (uint8_t i = 0; i < 20; ++i) {
+    ring.write(RecordKind::UdsPdu, Direction::Tx, 0x7E0, &i, 1);
+  }
+  std::vector<TraceRecord> out;
+  ring.collect(out);
+  ASSERT_EQ(out.size(), 8u);
+  EXPECT_EQ(out.front().data[0], 12);
+  EXPECT_EQ(out.back().data[0], 19);
+  EXPECT_EQ(out.back().thread_index, 3);
+  EXPECT_EQ(ring.written(), 20u);
+}
+
+TEST_F(TraceTest, LongPduIsTruncated) {
+  TraceRing ring(4, 0);
+  std::vector<uint8_t> pdu(300, 0xAB);
+  ring.write(RecordKind::UdsPdu, Direction::Rx, 0x7E8, pdu.data(), pdu.size());
+  std::vector<TraceRecord> out;
+  ring.collect(out);
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0].length, 300);
+  EXPECT_EQ(out[0].captured, kMaxRecordData);
+  EXPECT_TRUE(out[0].truncated());
+}
+
+TEST_F(TraceTest, CapturesCanFramesAndPdus) {
+  TraceEchoCan can;
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp);
+
+  ASSERT_TRUE(client.read_data_by_identifier(0xF190).ok);
+
+  auto records = Tracer::instance().snapshot();
+  ASSERT_EQ(records.size(), 4u);
+  EXPECT_EQ(records[0].kind, RecordKind::UdsPdu);
+  EXPECT_EQ(records[0].direction, Direction::Tx);
+  EXPECT_EQ(records[0].data[0], 0x22);
+  EXPECT_EQ(records[1].kind, RecordKind::CanFrame);
+  EXPECT_EQ(records[1].can_id, 0x7E0u);
+  EXPECT_EQ(records[2].kind, RecordKind::CanFrame);
+  EXPECT_EQ(records[2].direction, Direction::Rx);
+  EXPECT_EQ(records[3].kind, RecordKind::UdsPdu);
+  EXPECT_EQ(records[3].data[0], 0x62);
+  for (size_t i = 1; i < records.size(); ++i) {
+    EXPECT_LE(records[i - 1].timestamp_ns, records[i].timestamp_ns);
+  }
+}
+
+TEST_F(TraceTest, DisabledRecordsNothing) {
+  Tracer::instance().set_enabled(false);
+  record_pdu(Direction::Tx, 0x7E0, {0x3E, 0x00});
+  EXPECT_TRUE(Tracer::instance().snapshot().empty());
+}
+
+TEST_F(TraceTest, RecordsFromExitedThreadsSurvive) {
+  std::thread worker([]() { record_pdu(Direction::Tx, 0x7E1, {0x10, 0x02}); });
+  worker.join();
+  record_pdu(Direction::Tx, 0x7E0, {0x10, 0x03});
+
+  auto records = Tracer::instance().snapshot();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_NE(records[0].thread_index, records[1].thread_index);
+}
+
+TEST_F(TraceTest, DumpAndLoadRoundTrip) {
+  CANProtocol::CANFrame f; f.id = 0x7E0; f.dlc = 8;
+  f.data[0] = 0x02; f.data[1] = 0x3E; f.data[2] = 0x00;
+  record_can(Direction::Tx, f);
+  record_pdu(Direction::Tx, 0x7E0, {0x3E, 0x00});
+
+  ASSERT_TRUE(Tracer::instance().dump(path_));
+
+  TraceFile file;
+  ASSERT_TRUE(load(path_, file));
+  ASSERT_EQ(file.records.size(), 2u);
+  EXPECT_EQ(file.records[0].can_id, 0x7E0u);
+  EXPECT_EQ(file.records[0].length, 8);
+  EXPECT_EQ(file.records[0].data[1], 0x3E);
+  EXPECT_EQ(file.records[1].kind, RecordKind::UdsPdu);
+  EXPECT_GT(file.wall_time_s(file.records[0]), 1.0e9);
+
+  const std::string candump = to_candump(file, "vcan0");
+  EXPECT_NE(candump.find("vcan0 7E0#023E000000000000"), std::string::npos);
+  EXPECT_EQ(candump.find("UDS"), std::string::npos);
+
+  const std::string asc = to_asc(file);
+  EXPECT_TRUE(std::regex_search(asc, std::regex(
+      "^date [A-Z][a-z]{2} [A-Z][a-z]{2} \\d{2} \\d{2}:\\d{2}:\\d{2}\\.\\d{3} [ap]m \\d{4}\n")))
+      << asc.substr(0, asc.find('\n'));
+  EXPECT_NE(asc.find("7E0             Tx   d 8 02 3E 00"), std::string::npos);
+  EXPECT_NE(asc.find("// "), std::string::npos);
+}
+
+TEST_F(TraceTest, LoadRejectsBadFiles) {
+  TraceFile file;
+  EXPECT_FALSE(load("does_not_exist.udstrace", file));
+
+  FILE* fp = std::fopen(path_.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  std::fputs("NOTATRACEFILE-NOTATRACEFILE-NOTATRACEFILE", fp);
+  std::fclose(fp);
+  EXPECT_FALSE(load(path_, file));
+}
+
+TEST_F(TraceTest, ProgrammerDumpsTraceOnFailure) {
+  TraceEchoCan can;  // session succeeds, security fails (no key calculator)
+  isotp::Transport tp(can);
+  tp.set_address({AddressType::Physical, 0x7E0, 0x7E8});
+  Client client(tp);
+
+  ProgrammingConfig config;
+  config.trace_dump_path = path_;
+  ECUProgrammer programmer(client);
+  auto result = programmer.program_ecu({0x01, 0x02, 0x03}, config);
+  EXPECT_FALSE(result.success);
+
+  TraceFile file;
+  ASSERT_TRUE(load(path_, file));
+  EXPECT_FALSE(file.records.empty());
+}
@@ -0,0 +1,76 @@
+/**
+ * @file uds_trace_convert.cpp
+ * @brief Convert binary UDS/CAN traces (uds_trace.hpp) to candump or ASC text
+ *
+ * Usage:
+ *   uds_trace_convert [--asc | --candump] [--interface NAME] <trace> [output]
+ *
+ * Without an output file the text is written to stdout.
+ */
+
+#include "uds_trace.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--asc | --candump] [--interface NAME] <trace> [output]\n"
+              << "  --candump         candump -L log format (default)\n"
+              << "  --asc             Vector ASC format (UDS PDUs as comments)\n"
+              << "  --interface NAME  Interface name for candump output (default: can0)\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool asc = false;
+    std::string interface = "can0";
+    std::string input;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--asc") {
+            asc = true;
+        } else if (arg == "--candump") {
+            asc = false;
+        } else if (arg == "--interface" && i + 1 < argc) {
+            interface = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else if (input.empty()) {
+            input = arg;
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (input.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    uds::trace::TraceFile trace;
+    if (!uds::trace::load(input, trace)) {
+        std::cerr << "Failed to read trace file: " << input << std::endl;
+        return 1;
+    }
+
+    const std::string text = asc ? uds::trace::to_asc(trace)
+                                 : uds::trace::to_candump(trace, interface);
+
+    if (output.empty()) {
+        std::cout << text;
+        return 0;
+    }
+
+    std::ofstream out(output);
+    if (!out || !(out << text)) {
+        std::cerr << "Failed to write output file: " << output << std::endl;
+        return 1;
+    }
+    std::cerr << "Converted " << trace.records.size() << " records to " << output << std::endl;
+    return 0;
+}